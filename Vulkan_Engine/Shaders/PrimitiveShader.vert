@@ -1,24 +1,13 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout (location = 0) out vec3 FragColor;
-
-vec2 positions[3] = vec2[]
-(
-	vec2(0.0f,-0.5f),
-	vec2(0.5f,0.5f),
-	vec2(-0.5f,0.5f)
-);
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec3 inColor;
 
-vec3 colors[3] = vec3[]
-(
-	vec3(1.0f,0.0f,0.0f),
-	vec3(0.0f,1.0f,0.0f),
-	vec3(0.0f,0.0f,1.0f)
-);
+layout (location = 0) out vec3 FragColor;
 
 void main()
 {
-	gl_Position = vec4(positions[gl_VertexIndex],0.0f,1.0f); //vulkan use gl_VertexIndex rather than gl_VertexID
-	FragColor = colors[gl_VertexIndex];
+	gl_Position = vec4(inPosition,0.0f,1.0f);
+	FragColor = inColor;
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+// ShaderArchiveTest.cpp : opens valid and malformed shader archives, CPU only (no Vulkan loader, no GPU).
+//
+// ShaderArchiveTest [SPIR-V directory]
+//   packs the shipped SPIR-V of the primitive shaders, checks the archive opens and finds them, then checks Open
+//   rejects copies with a corrupted header or entry : offsets and sizes whose sum wraps around must not pass
+#include "VShaderArchive.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+    int Failures = 0;
+
+    void Check(bool condition, const std::string& what)
+    {
+        if (condition) return;
+        std::cout << "FAILED : " << what << '\n';
+        Failures++;
+    }
+
+    std::vector<char> ReadFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    bool WriteFile(const std::string& path, const std::vector<char>& bytes)
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(file);
+    }
+
+    Vulkan_Engine::ShaderArchiveHeader GetHeader(const std::vector<char>& bytes)
+    {
+        Vulkan_Engine::ShaderArchiveHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        return header;
+    }
+
+    void SetHeader(std::vector<char>& bytes, const Vulkan_Engine::ShaderArchiveHeader& header)
+    {
+        std::memcpy(bytes.data(), &header, sizeof(header));
+    }
+
+    //first occupied slot of the table, the table of a valid archive has at least one
+    size_t FirstEntryOffset(const std::vector<char>& bytes)
+    {
+        Vulkan_Engine::ShaderArchiveHeader header = GetHeader(bytes);
+        for (uint32_t slot = 0; slot < header.tableSize; slot++)
+        {
+            size_t offset = static_cast<size_t>(header.tableOffset) + slot * sizeof(Vulkan_Engine::ShaderArchiveEntry);
+            Vulkan_Engine::ShaderArchiveEntry entry;
+            std::memcpy(&entry, bytes.data() + offset, sizeof(entry));
+            if (entry.nameLength != 0) return offset;
+        }
+        return 0;
+    }
+
+    //writes the corrupted copy and checks Open refuses it
+    void CheckRejected(const std::string& path, const std::vector<char>& bytes, const std::string& what)
+    {
+        if (!WriteFile(path, bytes)) {
+            Check(false, "writing " + path);
+            return;
+        }
+        Vulkan_Engine::VShaderArchive archive;
+        Check(!archive.Open(path), what + " is rejected");
+        Check(!archive.IsOpen(), what + " leaves the archive closed");
+    }
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string directory = argc > 1 ? argv[1] : "Shaders/SPIR-V";
+    if (!directory.empty() && directory.back() != '/' && directory.back() != '\\') directory.append("/");
+
+    const std::string shaderNames[] = { "PrimitiveShaderVert.spv", "PrimitiveShaderFrag.spv" };
+    std::vector<Vulkan_Engine::ShaderArchiveInput> inputs;
+    for (const auto& name : shaderNames)
+    {
+        Vulkan_Engine::ShaderArchiveInput input;
+        input.Name = name;
+        input.SpirV = ReadFile(directory + name);
+        if (input.SpirV.empty()) {
+            std::cout << "ERROR :: Failed to read " << directory + name << '\n';
+            return 1;
+        }
+        inputs.push_back(std::move(input));
+    }
+
+    std::string temporary = (std::filesystem::temp_directory_path() / "ShaderArchiveTest").string();
+    std::string archivePath = temporary + ".pak";
+    std::string corruptedPath = temporary + "-corrupted.pak";
+    if (!Vulkan_Engine::VShaderArchive::Pack(inputs, archivePath)) {
+        std::cout << "ERROR :: Failed to pack " << archivePath << '\n';
+        return 1;
+    }
+
+    {
+        Vulkan_Engine::VShaderArchive archive;
+        Check(archive.Open(archivePath), "the packed archive opens");
+        Check(archive.GetEntryCount() == 2, "entry count");
+        for (const auto& input : inputs)
+        {
+            const uint32_t* code = nullptr;
+            size_t codeSize = 0;
+            bool found = archive.Find(input.Name, code, codeSize);
+            Check(found && codeSize == input.SpirV.size() && std::memcmp(code, input.SpirV.data(), codeSize) == 0, input.Name + " is found");
+        }
+        const uint32_t* code = nullptr;
+        size_t codeSize = 0;
+        Check(!archive.Find("Missing.spv", code, codeSize), "a missing shader is not found");
+    }
+
+    const std::vector<char> bytes = ReadFile(archivePath);
+    const Vulkan_Engine::ShaderArchiveHeader header = GetHeader(bytes);
+    const uint64_t wrap = std::numeric_limits<uint64_t>::max();
+
+    std::vector<char> truncated(bytes.begin(), bytes.begin() + sizeof(Vulkan_Engine::ShaderArchiveHeader) - 1);
+    CheckRejected(corruptedPath, truncated, "a file shorter than the header");
+
+    std::vector<char> corrupted = bytes;
+    Vulkan_Engine::ShaderArchiveHeader badHeader = header;
+    badHeader.magic = 0;
+    SetHeader(corrupted, badHeader);
+    CheckRejected(corruptedPath, corrupted, "a wrong magic");
+
+    //aligned, and the end of the table wraps around to a small offset inside the file
+    corrupted = bytes;
+    badHeader = header;
+    badHeader.tableOffset = wrap - (alignof(Vulkan_Engine::ShaderArchiveEntry) - 1);
+    SetHeader(corrupted, badHeader);
+    CheckRejected(corruptedPath, corrupted, "a table offset wrapping around");
+
+    corrupted = bytes;
+    badHeader = header;
+    badHeader.tableSize = 1u << 31;
+    SetHeader(corrupted, badHeader);
+    CheckRejected(corruptedPath, corrupted, "a table larger than the file");
+
+    corrupted = bytes;
+    badHeader = header;
+    badHeader.entryCount = header.entryCount - 1;
+    SetHeader(corrupted, badHeader);
+    CheckRejected(corruptedPath, corrupted, "an entry count below the occupied slots");
+
+    size_t entryOffset = FirstEntryOffset(bytes);
+    Check(entryOffset != 0, "the packed table has an entry");
+    if (entryOffset != 0)
+    {
+        //dataOffset + dataSize wraps around to 0
+        corrupted = bytes;
+        Vulkan_Engine::ShaderArchiveEntry entry;
+        std::memcpy(&entry, corrupted.data() + entryOffset, sizeof(entry));
+        entry.dataOffset = wrap - 3;
+        entry.dataSize = 4;
+        std::memcpy(corrupted.data() + entryOffset, &entry, sizeof(entry));
+        CheckRejected(corruptedPath, corrupted, "a data offset wrapping around");
+
+        corrupted = bytes;
+        std::memcpy(&entry, corrupted.data() + entryOffset, sizeof(entry));
+        entry.dataSize = bytes.size();
+        std::memcpy(corrupted.data() + entryOffset, &entry, sizeof(entry));
+        CheckRejected(corruptedPath, corrupted, "a data size past the end of the file");
+
+        corrupted = bytes;
+        std::memcpy(&entry, corrupted.data() + entryOffset, sizeof(entry));
+        entry.nameOffset = static_cast<uint32_t>(bytes.size());
+        std::memcpy(corrupted.data() + entryOffset, &entry, sizeof(entry));
+        CheckRejected(corruptedPath, corrupted, "a name past the end of the file");
+    }
+
+    std::error_code error;
+    std::filesystem::remove(archivePath, error);
+    std::filesystem::remove(corruptedPath, error);
+
+    if (Failures) {
+        std::cout << Failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
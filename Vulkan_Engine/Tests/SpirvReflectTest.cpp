@@ -0,0 +1,131 @@
+// SpirvReflectTest.cpp : reflects the shipped SPIR-V of the primitive shaders, CPU only (no Vulkan loader, no GPU).
+//
+// SpirvReflectTest [SPIR-V directory]
+//   checks the execution model, the stage inputs and outputs, the vertex input built from them,
+//   the descriptor bindings and the push constants against PrimitiveShader.vert and PrimitiveShader.frag
+#include "VSpirvReflect.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+    //SPIR-V execution models
+    const uint32_t EXECUTION_MODEL_VERTEX = 0;
+    const uint32_t EXECUTION_MODEL_FRAGMENT = 4;
+
+    int Failures = 0;
+
+    void Check(bool condition, const std::string& what)
+    {
+        if (condition) return;
+        std::cout << "FAILED : " << what << '\n';
+        Failures++;
+    }
+
+    Vulkan_Engine::ShaderReflection ReflectFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file) throw std::runtime_error("ERROR :: Failed to open " + path);
+        std::vector<char> spirv((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        Vulkan_Engine::ShaderReflection reflection = Vulkan_Engine::VSpirvReflect::Reflect(spirv);
+        Vulkan_Engine::VSpirvReflect::Print(path, reflection);
+        return reflection;
+    }
+
+    void CheckVariable(const std::vector<Vulkan_Engine::ReflectedVariable>& variables, size_t index, const std::string& name,
+        uint32_t location, VkFormat format, uint32_t size)
+    {
+        if (index >= variables.size()) {
+            Check(false, name + " is reflected");
+            return;
+        }
+        const Vulkan_Engine::ReflectedVariable& variable = variables[index];
+        Check(variable.Name == name, name + " name, got " + variable.Name);
+        Check(variable.Location == location, name + " location");
+        Check(variable.Format == format, name + " format");
+        Check(variable.Size == size, name + " size");
+    }
+
+    void CheckVertexShader(const Vulkan_Engine::ShaderReflection& reflection)
+    {
+        Check(reflection.EntryPoint == "main", "vertex entry point");
+        Check(reflection.ExecutionModel == EXECUTION_MODEL_VERTEX, "vertex execution model");
+        Check(reflection.Stage == VK_SHADER_STAGE_VERTEX_BIT, "vertex stage");
+
+        //layout (location = 0) in vec2 inPosition; layout (location = 1) in vec3 inColor;
+        Check(reflection.Inputs.size() == 2, "vertex input count");
+        CheckVariable(reflection.Inputs, 0, "inPosition", 0, VK_FORMAT_R32G32_SFLOAT, 8);
+        CheckVariable(reflection.Inputs, 1, "inColor", 1, VK_FORMAT_R32G32B32_SFLOAT, 12);
+        //gl_Position is a built-in, only FragColor is listed
+        Check(reflection.Outputs.size() == 1, "vertex output count");
+        CheckVariable(reflection.Outputs, 0, "FragColor", 0, VK_FORMAT_R32G32B32_SFLOAT, 12);
+
+        Check(reflection.DescriptorBindings.empty(), "vertex descriptor bindings");
+        Check(reflection.PushConstants.empty(), "vertex push constants");
+        Check(reflection.SpecializationConstants.empty(), "vertex specialization constants");
+
+        //one interleaved buffer : position at offset 0, color at offset 8, 20 bytes per vertex
+        std::vector<VkVertexInputBindingDescription> bindings;
+        std::vector<VkVertexInputAttributeDescription> attributes;
+        Vulkan_Engine::VSpirvReflect::BuildVertexInput(reflection, bindings, attributes);
+        Check(bindings.size() == 1 && bindings[0].binding == 0 && bindings[0].stride == 20 && bindings[0].inputRate == VK_VERTEX_INPUT_RATE_VERTEX,
+            "vertex input binding");
+        Check(attributes.size() == 2, "vertex attribute count");
+        if (attributes.size() == 2) {
+            Check(attributes[0].location == 0 && attributes[0].binding == 0 && attributes[0].format == VK_FORMAT_R32G32_SFLOAT && attributes[0].offset == 0,
+                "inPosition attribute");
+            Check(attributes[1].location == 1 && attributes[1].binding == 0 && attributes[1].format == VK_FORMAT_R32G32B32_SFLOAT && attributes[1].offset == 8,
+                "inColor attribute");
+        }
+    }
+
+    void CheckFragmentShader(const Vulkan_Engine::ShaderReflection& reflection)
+    {
+        Check(reflection.EntryPoint == "main", "fragment entry point");
+        Check(reflection.ExecutionModel == EXECUTION_MODEL_FRAGMENT, "fragment execution model");
+        Check(reflection.Stage == VK_SHADER_STAGE_FRAGMENT_BIT, "fragment stage");
+
+        //layout (location = 0) in vec3 FragColor; layout (location = 0) out vec4 outColor;
+        Check(reflection.Inputs.size() == 1, "fragment input count");
+        CheckVariable(reflection.Inputs, 0, "FragColor", 0, VK_FORMAT_R32G32B32_SFLOAT, 12);
+        Check(reflection.Outputs.size() == 1, "fragment output count");
+        CheckVariable(reflection.Outputs, 0, "outColor", 0, VK_FORMAT_R32G32B32A32_SFLOAT, 16);
+
+        Check(reflection.DescriptorBindings.empty(), "fragment descriptor bindings");
+        Check(reflection.PushConstants.empty(), "fragment push constants");
+        Check(reflection.SpecializationConstants.empty(), "fragment specialization constants");
+    }
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string directory = argc > 1 ? argv[1] : "Shaders/SPIR-V";
+    if (!directory.empty() && directory.back() != '/' && directory.back() != '\\') directory.append("/");
+
+    try {
+        Vulkan_Engine::ShaderReflection vertex = ReflectFile(directory + "PrimitiveShaderVert.spv");
+        Vulkan_Engine::ShaderReflection fragment = ReflectFile(directory + "PrimitiveShaderFrag.spv");
+        CheckVertexShader(vertex);
+        CheckFragmentShader(fragment);
+
+        //the pipeline layout of the primitive shaders has no set and no push constant range
+        Vulkan_Engine::ReflectedPipelineLayout layout = Vulkan_Engine::VSpirvReflect::MergeLayouts({ vertex, fragment });
+        Check(layout.Sets.empty(), "merged descriptor sets");
+        Check(layout.PushConstants.empty(), "merged push constants");
+    }
+    catch (const std::exception& e) {
+        std::cout << e.what() << '\n';
+        return 1;
+    }
+
+    if (Failures) {
+        std::cout << Failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
@@ -0,0 +1,103 @@
+// JobBenchmark.cpp : throughput and tail latency of the engine job system against std::async.
+//
+// JobBenchmark [-t threads] [-r rounds] [--pin]
+//   fork/join : 1000 small jobs fanned out and joined, per round
+//   parallel for : 1M items in chunks of 1024, per round
+//   the latency of a round is the time from the first submit to the join returning
+#include "VJobSystem.h"
+
+#include <iostream>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+    const uint32_t FAN_OUT_JOBS = 1000;
+    const uint32_t PARALLEL_FOR_ITEMS = 1000000;
+    const uint32_t PARALLEL_FOR_GRAIN = 1024;
+
+    //a few hundred nanoseconds of work the optimizer cannot drop
+    float SmallWork(uint32_t seed)
+    {
+        float value = static_cast<float>(seed);
+        for (int i = 0; i < 64; i++) value = std::sqrt(value * 1.0001f + 1.0f);
+        return value;
+    }
+
+    void Report(const char* name, uint64_t itemsPerRound, std::vector<double> roundsMs)
+    {
+        std::sort(roundsMs.begin(), roundsMs.end());
+        double totalMs = 0.0;
+        for (double ms : roundsMs) totalMs += ms;
+        auto Percentile = [&](double p) { return roundsMs[std::min(roundsMs.size() - 1, static_cast<size_t>(p * roundsMs.size()))]; };
+
+        std::cout << name << "\t" << itemsPerRound * roundsMs.size() / (totalMs / 1000.0) / 1e6 << " M items/s\tp50 "
+            << Percentile(0.50) << " ms\tp99 " << Percentile(0.99) << " ms\tmax " << roundsMs.back() << " ms\n";
+    }
+
+    template<typename Function>
+    std::vector<double> TimeRounds(uint32_t rounds, Function&& round)
+    {
+        std::vector<double> roundsMs;
+        for (uint32_t i = 0; i < rounds; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            round();
+            roundsMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+        return roundsMs;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t rounds = 200;
+    bool pinThreads = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) threadCount = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) rounds = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--pin") == 0) pinThreads = true;
+        else {
+            std::cout << "usage : " << argv[0] << " [-t threads] [-r rounds] [--pin]\n";
+            return 1;
+        }
+    }
+
+    std::vector<float> results(PARALLEL_FOR_ITEMS);
+    Vulkan_Engine::VJobSystem jobs;
+    jobs.Start(threadCount, pinThreads);
+
+    std::cout << "\nfork/join : " << FAN_OUT_JOBS << " jobs per round, " << rounds << " rounds\n";
+    Report("job system", FAN_OUT_JOBS, TimeRounds(rounds, [&] {
+        Vulkan_Engine::JobCounter counter;
+        for (uint32_t i = 0; i < FAN_OUT_JOBS; i++) jobs.Submit([&results, i] { results[i] = SmallWork(i); }, &counter);
+        jobs.Wait(counter);
+    }));
+    Report("std::async", FAN_OUT_JOBS, TimeRounds(rounds, [&] {
+        std::vector<std::future<void>> futures;
+        futures.reserve(FAN_OUT_JOBS);
+        for (uint32_t i = 0; i < FAN_OUT_JOBS; i++) futures.push_back(std::async(std::launch::async, [&results, i] { results[i] = SmallWork(i); }));
+        for (auto& future : futures) future.get();
+    }));
+
+    std::cout << "\nparallel for : " << PARALLEL_FOR_ITEMS << " items in chunks of " << PARALLEL_FOR_GRAIN << ", " << rounds << " rounds\n";
+    auto Chunk = [&results](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; i++) results[i] = SmallWork(i); };
+    Report("job system", PARALLEL_FOR_ITEMS, TimeRounds(rounds, [&] { jobs.ParallelFor(PARALLEL_FOR_ITEMS, PARALLEL_FOR_GRAIN, Chunk); }));
+    //std::async gets one task per thread, a task per chunk would only measure thread creation
+    Report("std::async", PARALLEL_FOR_ITEMS, TimeRounds(rounds, [&] {
+        std::vector<std::future<void>> futures;
+        for (uint32_t thread = 0; thread < threadCount; thread++) {
+            uint32_t begin = static_cast<uint32_t>(uint64_t(PARALLEL_FOR_ITEMS) * thread / threadCount);
+            uint32_t end = static_cast<uint32_t>(uint64_t(PARALLEL_FOR_ITEMS) * (thread + 1) / threadCount);
+            futures.push_back(std::async(std::launch::async, Chunk, begin, end));
+        }
+        for (auto& future : futures) future.get();
+    }));
+
+    jobs.Stop();
+    return 0;
+}
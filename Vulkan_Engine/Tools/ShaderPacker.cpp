@@ -0,0 +1,75 @@
+// ShaderPacker.cpp : packs SPIR-V modules into the archive the engine maps at startup.
+//
+// ShaderPacker [-o Shaders/Shaders.pak] [-d Shaders/] shader...
+//   a .spv file is packed as is, under its file name
+//   any other file is a GLSL source of the shader directory (PrimitiveShader.vert...), built through the shader cache
+//   and packed under its source name, which is the name the engine looks it up with
+#include "VShaderArchive.h"
+#include "VShaderCompiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    std::string outputPath = "Shaders/Shaders.pak";
+    std::string shaderDirectory = "Shaders/";
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) outputPath = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) shaderDirectory = argv[++i];
+        else names.push_back(argv[i]);
+    }
+    if (!shaderDirectory.empty() && shaderDirectory.back() != '/' && shaderDirectory.back() != '\\') shaderDirectory.append("/");
+
+    if (names.empty()) {
+        std::cout << "usage : " << argv[0] << " [-o archive] [-d shader directory] shader...\n";
+        return 1;
+    }
+
+    std::vector<Vulkan_Engine::ShaderArchiveInput> inputs;
+    std::vector<Vulkan_Engine::ShaderBuildRequest> requests;
+    try {
+        for (const auto& name : names)
+        {
+            std::filesystem::path path(name);
+            if (path.extension() == ".spv")
+            {
+                std::ifstream file(name, std::ios::in | std::ios::binary);
+                if (!file.is_open()) throw std::runtime_error("ERROR :: COULD NOT LOAD THE FILE : " + name);
+                Vulkan_Engine::ShaderArchiveInput input;
+                input.Name = path.filename().string();
+                input.SpirV.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                inputs.push_back(std::move(input));
+            }
+            else if (path.has_extension()) requests.push_back({ name, path.extension().string().substr(1), "" });
+            else throw std::runtime_error("ERROR :: UNKNOWN SHADER TYPE : " + name);
+        }
+
+        if (!requests.empty())
+        {
+            Vulkan_Engine::VShaderCompiler compiler(shaderDirectory, shaderDirectory + "Cache/");
+            std::vector<Vulkan_Engine::ShaderBuildResult> results = compiler.Build(requests);
+            for (size_t i = 0; i < requests.size(); i++) inputs.push_back({ requests[i].Name, std::move(results[i].SpirV) });
+        }
+    }
+    catch (std::exception& e) {
+        std::cout << e.what() << '\n';
+        return 1;
+    }
+
+    if (!Vulkan_Engine::VShaderArchive::Pack(inputs, outputPath)) {
+        std::cout << "ERROR :: COULD NOT WRITE THE ARCHIVE : " << outputPath << " (duplicated name or SPIR-V size not a multiple of 4 ?)\n";
+        return 1;
+    }
+
+    size_t totalSize = 0;
+    for (const auto& input : inputs) {
+        std::cout << input.Name << "\t" << input.SpirV.size() << " bytes\n";
+        totalSize += input.SpirV.size();
+    }
+    std::cout << inputs.size() << " shaders, " << totalSize << " bytes of SPIR-V packed into " << outputPath << '\n';
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "VDescriptorSetLayoutCache.h"
+#include "VHash.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+VkDescriptorSetLayout Vulkan_Engine::VDescriptorSetLayoutCache::Get(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	std::vector<VkDescriptorSetLayoutBinding> canonical = bindings;
+	std::sort(canonical.begin(), canonical.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+	uint64_t hash = FNV1A_OFFSET_BASIS;
+	for (const auto& binding : canonical) {
+		uint32_t key[4] = { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags };
+		hash = HashFNV1a(key, sizeof(key), hash);
+	}
+
+	auto range = Layouts.equal_range(hash);
+	for (auto cached = range.first; cached != range.second; ++cached)
+	{
+		const std::vector<VkDescriptorSetLayoutBinding>& cachedBindings = cached->second.Bindings;
+		bool same = cachedBindings.size() == canonical.size();
+		for (size_t i = 0; same && i < canonical.size(); i++) {
+			same = cachedBindings[i].binding == canonical[i].binding && cachedBindings[i].descriptorType == canonical[i].descriptorType
+				&& cachedBindings[i].descriptorCount == canonical[i].descriptorCount && cachedBindings[i].stageFlags == canonical[i].stageFlags;
+		}
+		if (same) {
+			Reused++;
+			return cached->second.Layout;
+		}
+	}
+
+	VkDescriptorSetLayoutCreateInfo LayoutCreateInfo{};
+	LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	LayoutCreateInfo.bindingCount = static_cast<uint32_t>(canonical.size());
+	LayoutCreateInfo.pBindings = canonical.data();
+
+	VkDescriptorSetLayout Layout;
+	if (vkCreateDescriptorSetLayout(device, &LayoutCreateInfo, nullptr, &Layout) != VK_SUCCESS) {
+		throw std::runtime_error("ERROR :: Failed to create a descriptor set layout");
+	}
+
+	Layouts.insert(std::make_pair(hash, CachedLayout{ canonical, Layout }));
+	return Layout;
+}
+
+void Vulkan_Engine::VDescriptorSetLayoutCache::Destroy(VkDevice device)
+{
+	for (auto& cached : Layouts) vkDestroyDescriptorSetLayout(device, cached.second.Layout, nullptr);
+	Layouts.clear();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//descriptor set layouts are created once per distinct set of bindings and shared by every pipeline layout that uses them
+	class VDescriptorSetLayoutCache
+	{
+	public:
+
+		VkDescriptorSetLayout Get(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+		void Destroy(VkDevice device);
+
+		uint32_t GetLayoutCount() const { return static_cast<uint32_t>(Layouts.size()); }
+		uint32_t GetReuseCount() const { return Reused; }
+
+	private:
+
+		struct CachedLayout
+		{
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+			VkDescriptorSetLayout Layout;
+		};
+
+		std::multimap<uint64_t, CachedLayout> Layouts;
+		uint32_t Reused = 0;
+	};
+
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+//VK_KHR_dynamic_rendering declarations for the vendored 1.2.148 headers, which predate the extension (promoted in 1.3).
+//the layouts and values are the ones of the registry, newer headers declare the same names and take precedence.
+//the commands are never linked, VRender loads them with vkGetDeviceProcAddr when the device enables the extension
+
+#if !defined(VK_KHR_dynamic_rendering)
+
+#define VK_KHR_DYNAMIC_RENDERING_SPEC_VERSION 1
+#define VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME "VK_KHR_dynamic_rendering"
+
+constexpr VkStructureType VK_STRUCTURE_TYPE_RENDERING_INFO_KHR = static_cast<VkStructureType>(1000044000);
+constexpr VkStructureType VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR = static_cast<VkStructureType>(1000044001);
+constexpr VkStructureType VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR = static_cast<VkStructureType>(1000044002);
+constexpr VkStructureType VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR = static_cast<VkStructureType>(1000044003);
+constexpr VkStructureType VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR = static_cast<VkStructureType>(1000044004);
+
+typedef VkFlags VkRenderingFlagsKHR;
+constexpr VkRenderingFlagsKHR VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR = 0x00000001;
+constexpr VkRenderingFlagsKHR VK_RENDERING_SUSPENDING_BIT_KHR = 0x00000002;
+constexpr VkRenderingFlagsKHR VK_RENDERING_RESUMING_BIT_KHR = 0x00000004;
+
+typedef struct VkRenderingAttachmentInfoKHR {
+	VkStructureType sType;
+	const void* pNext;
+	VkImageView imageView;
+	VkImageLayout imageLayout;
+	VkResolveModeFlagBits resolveMode;
+	VkImageView resolveImageView;
+	VkImageLayout resolveImageLayout;
+	VkAttachmentLoadOp loadOp;
+	VkAttachmentStoreOp storeOp;
+	VkClearValue clearValue;
+} VkRenderingAttachmentInfoKHR;
+
+typedef struct VkRenderingInfoKHR {
+	VkStructureType sType;
+	const void* pNext;
+	VkRenderingFlagsKHR flags;
+	VkRect2D renderArea;
+	uint32_t layerCount;
+	uint32_t viewMask;
+	uint32_t colorAttachmentCount;
+	const VkRenderingAttachmentInfoKHR* pColorAttachments;
+	const VkRenderingAttachmentInfoKHR* pDepthAttachment;
+	const VkRenderingAttachmentInfoKHR* pStencilAttachment;
+} VkRenderingInfoKHR;
+
+typedef struct VkPipelineRenderingCreateInfoKHR {
+	VkStructureType sType;
+	const void* pNext;
+	uint32_t viewMask;
+	uint32_t colorAttachmentCount;
+	const VkFormat* pColorAttachmentFormats;
+	VkFormat depthAttachmentFormat;
+	VkFormat stencilAttachmentFormat;
+} VkPipelineRenderingCreateInfoKHR;
+
+typedef struct VkPhysicalDeviceDynamicRenderingFeaturesKHR {
+	VkStructureType sType;
+	void* pNext;
+	VkBool32 dynamicRendering;
+} VkPhysicalDeviceDynamicRenderingFeaturesKHR;
+
+typedef struct VkCommandBufferInheritanceRenderingInfoKHR {
+	VkStructureType sType;
+	const void* pNext;
+	VkRenderingFlagsKHR flags;
+	uint32_t viewMask;
+	uint32_t colorAttachmentCount;
+	const VkFormat* pColorAttachmentFormats;
+	VkFormat depthAttachmentFormat;
+	VkFormat stencilAttachmentFormat;
+	VkSampleCountFlagBits rasterizationSamples;
+} VkCommandBufferInheritanceRenderingInfoKHR;
+
+typedef void (VKAPI_PTR *PFN_vkCmdBeginRenderingKHR)(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR* pRenderingInfo);
+typedef void (VKAPI_PTR *PFN_vkCmdEndRenderingKHR)(VkCommandBuffer commandBuffer);
+
+#endif
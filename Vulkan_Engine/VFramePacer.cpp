@@ -0,0 +1,119 @@
+#include "VFramePacer.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+Vulkan_Engine::VFramePacer::VFramePacer()
+{
+	HConsole = Platform::GetConsole();
+}
+
+void Vulkan_Engine::VFramePacer::SetTargetFps(double fps)
+{
+	TargetFps = std::max(0.0, fps);
+	Period = TargetFps > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / TargetFps)) : Clock::duration(0);
+	//the next frame starts a new cadence
+	Deadline = Clock::time_point();
+}
+
+void Vulkan_Engine::VFramePacer::BeginFrame()
+{
+	Clock::time_point now = Clock::now();
+	if (Period.count() > 0)
+	{
+		//a frame more than one period late restarts the cadence instead of letting the next frames run back to back
+		if (Deadline == Clock::time_point() || now > Deadline + Period) Deadline = now;
+		else Deadline += Period;
+
+		if (now < Deadline)
+		{
+			auto spinMargin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(SpinMarginMs));
+			if (Deadline - now > spinMargin)
+			{
+				Platform::SleepPrecise(std::chrono::duration<double>(Deadline - now - spinMargin).count());
+				Clock::time_point woken = Clock::now();
+				SleepMs += std::chrono::duration<double, std::milli>(woken - now).count();
+				now = woken;
+			}
+			Clock::time_point spinStart = now;
+			while (now < Deadline) {
+				std::this_thread::yield();
+				now = Clock::now();
+			}
+			SpinMs += std::chrono::duration<double, std::milli>(now - spinStart).count();
+			OversleepMs += std::chrono::duration<double, std::milli>(now - Deadline).count();
+			LimitedFrames++;
+		}
+	}
+
+	Clock::time_point start = Clock::now();
+	if (Frames > 0)
+	{
+		double intervalMs = std::chrono::duration<double, std::milli>(start - FrameStart).count();
+		double delta = intervalMs - IntervalMean;
+		IntervalMean += delta / Frames;
+		IntervalM2 += delta * (intervalMs - IntervalMean);
+		MaxIntervalMs = std::max(MaxIntervalMs, intervalMs);
+	}
+	FrameStart = start;
+	InputSampled = false;
+	Frames++;
+}
+
+void Vulkan_Engine::VFramePacer::MarkInputSampled(Clock::time_point sampleTime)
+{
+	InputTime = sampleTime;
+	InputSampled = true;
+}
+
+void Vulkan_Engine::VFramePacer::MarkSubmitted()
+{
+	if (!InputSampled) return;
+	double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - InputTime).count();
+	InputToSubmitMs += latencyMs;
+	MaxInputToSubmitMs = std::max(MaxInputToSubmitMs, latencyMs);
+	Submits++;
+	InputSampled = false;
+}
+
+void Vulkan_Engine::VFramePacer::EndFrame()
+{
+	double cpuMs = std::chrono::duration<double, std::milli>(Clock::now() - FrameStart).count();
+	CpuMs += cpuMs;
+	MaxCpuMs = std::max(MaxCpuMs, cpuMs);
+}
+
+void Vulkan_Engine::VFramePacer::ResetStatistics()
+{
+	Frames = 0;
+	IntervalMean = IntervalM2 = MaxIntervalMs = 0.0;
+	CpuMs = MaxCpuMs = 0.0;
+	SleepMs = SpinMs = OversleepMs = 0.0;
+	LimitedFrames = 0;
+	Submits = 0;
+	InputToSubmitMs = MaxInputToSubmitMs = 0.0;
+	Deadline = Clock::time_point();
+}
+
+void Vulkan_Engine::VFramePacer::PrintStatistics()
+{
+	if (Frames < 2) return;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nFrame pacing statistics\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "frames : " << Frames << "\tlimiter : ";
+	if (TargetFps > 0.0) std::cout << TargetFps << " fps target, " << LimitedFrames << " frames held\n";
+	else std::cout << "off\n";
+	std::cout << "frame time : " << GetAverageFrameTime() << " ms average (" << (GetAverageFrameTime() > 0.0 ? 1000.0 / GetAverageFrameTime() : 0.0)
+		<< " fps)\t" << std::sqrt(GetFrameTimeVariance()) << " ms standard deviation, " << GetFrameTimeVariance() << " ms2 variance, "
+		<< MaxIntervalMs << " ms max\n";
+	std::cout << "CPU frame time : " << GetAverageCpuTime() << " ms average\t" << MaxCpuMs << " ms max\n";
+	if (LimitedFrames)
+		std::cout << "limiter : " << SleepMs / LimitedFrames << " ms slept\t" << SpinMs / LimitedFrames << " ms spun\t"
+			<< OversleepMs / LimitedFrames * 1000.0 << " us past the deadline, per held frame\n";
+	if (Submits)
+		std::cout << "input to submit : " << InputToSubmitMs / Submits << " ms average\t" << MaxInputToSubmitMs << " ms max\n";
+}
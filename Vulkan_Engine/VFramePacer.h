@@ -0,0 +1,70 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//CPU side frame pacing : caps the frame rate and measures where the frame time goes.
+	//the limiter sleeps with the OS timer until SpinMargin before the deadline, then spins the rest,
+	//sleeping alone oversleeps by the scheduler quantum and spinning alone burns a core
+	class VFramePacer
+	{
+	public:
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		VFramePacer();
+
+		//0 disables the limiter
+		void SetTargetFps(double fps);
+		double GetTargetFps() const { return TargetFps; }
+		void SetSpinMargin(double milliseconds) { SpinMarginMs = milliseconds; }
+
+		//waits for the deadline of the next frame, then starts it
+		void BeginFrame();
+		//the input the frame is built from was sampled at sampleTime, its recording starts next
+		void MarkInputSampled(Clock::time_point sampleTime = Clock::now());
+		//the frame is submitted to the GPU
+		void MarkSubmitted();
+		void EndFrame();
+
+		uint64_t GetFrameCount() const { return Frames; }
+		//milliseconds
+		double GetAverageFrameTime() const { return Frames > 1 ? IntervalMean : 0.0; }
+		double GetFrameTimeVariance() const { return Frames > 2 ? IntervalM2 / (Frames - 2) : 0.0; }
+		double GetAverageCpuTime() const { return Frames ? CpuMs / Frames : 0.0; }
+		void ResetStatistics();
+		void PrintStatistics();
+
+	private:
+
+		double TargetFps = 0.0;
+		double SpinMarginMs = 1.0;
+		Clock::duration Period{ 0 };
+		Clock::time_point Deadline;
+		Clock::time_point FrameStart;
+		Clock::time_point InputTime;
+		bool InputSampled = false;
+
+		//statistics, frame intervals go through Welford's running mean and variance
+		uint64_t Frames = 0;
+		double IntervalMean = 0.0;
+		double IntervalM2 = 0.0;
+		double MaxIntervalMs = 0.0;
+		double CpuMs = 0.0;
+		double MaxCpuMs = 0.0;
+		double SleepMs = 0.0;
+		double SpinMs = 0.0;
+		double OversleepMs = 0.0; //time past the deadline when the limiter returns
+		uint64_t LimitedFrames = 0;
+		uint64_t Submits = 0;
+		double InputToSubmitMs = 0.0;
+		double MaxInputToSubmitMs = 0.0;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Vulkan_Engine {
+
+	//upper bound of the runtime frames in flight setting
+	const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+	//one copy of some transient data per frame in flight, indexed by the frame slot (Current_Frame of the renderer).
+	//the copy of a slot may be reused once the previous frame submitted from that slot is complete
+	template<typename T>
+	class VFrameRing
+	{
+	public:
+
+		//frameCount is clamped to 1..MAX_FRAMES_IN_FLIGHT, every copy starts as value
+		void Resize(uint32_t frameCount, const T& value = T())
+		{
+			if (frameCount < 1) frameCount = 1;
+			if (frameCount > MAX_FRAMES_IN_FLIGHT) frameCount = MAX_FRAMES_IN_FLIGHT;
+			Frames.assign(frameCount, value);
+		}
+		void Clear() { Frames.clear(); }
+
+		uint32_t GetFrameCount() const { return static_cast<uint32_t>(Frames.size()); }
+		size_t Next(size_t frame) const { return (frame + 1) % Frames.size(); }
+
+		T& operator[](size_t frame) { return Frames[frame]; }
+		const T& operator[](size_t frame) const { return Frames[frame]; }
+		T* data() { return Frames.data(); }
+		typename std::vector<T>::iterator begin() { return Frames.begin(); }
+		typename std::vector<T>::iterator end() { return Frames.end(); }
+		typename std::vector<T>::const_iterator begin() const { return Frames.begin(); }
+		typename std::vector<T>::const_iterator end() const { return Frames.end(); }
+
+	private:
+
+		std::vector<T> Frames;
+	};
+
+};
@@ -0,0 +1,124 @@
+#include "VGeometry.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+Vulkan_Engine::VertexLayout& Vulkan_Engine::VertexLayout::Add(const std::string& name, uint32_t location, VkFormat format)
+{
+	Attributes.push_back({ name, location, format, Stride });
+	Stride += VGeometry::FormatSize(format);
+	return *this;
+}
+
+uint32_t Vulkan_Engine::VGeometry::FormatSize(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SNORM:
+	case VK_FORMAT_R8G8B8A8_UINT:
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+	case VK_FORMAT_R16G16_SFLOAT:
+	case VK_FORMAT_R16G16_UNORM:
+	case VK_FORMAT_R16G16_SNORM:
+	case VK_FORMAT_R32_SFLOAT:
+	case VK_FORMAT_R32_SINT:
+	case VK_FORMAT_R32_UINT: return 4;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+	case VK_FORMAT_R16G16B16A16_UNORM:
+	case VK_FORMAT_R16G16B16A16_SNORM:
+	case VK_FORMAT_R32G32_SFLOAT:
+	case VK_FORMAT_R32G32_SINT:
+	case VK_FORMAT_R32G32_UINT: return 8;
+	case VK_FORMAT_R32G32B32_SFLOAT:
+	case VK_FORMAT_R32G32B32_SINT:
+	case VK_FORMAT_R32G32B32_UINT: return 12;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+	case VK_FORMAT_R32G32B32A32_SINT:
+	case VK_FORMAT_R32G32B32A32_UINT: return 16;
+	default: return 0;
+	}
+}
+
+void Vulkan_Engine::VGeometry::BuildVertexInput(const VertexLayout& layout, const ShaderReflection& vertexReflection,
+	std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+	bindings.clear();
+	attributes.clear();
+
+	for (const auto& input : vertexReflection.Inputs)
+	{
+		const VertexAttribute* match = nullptr;
+		for (const auto& attribute : layout.Attributes)
+			if (attribute.Location == input.Location) match = &attribute;
+
+		//the format may differ (normalized bytes feeding a vec4...), the component count is the shader's business
+		if (match == nullptr)
+			throw std::runtime_error("ERROR :: the vertex layout has no attribute for the shader input " + input.Name + " (location " + std::to_string(input.Location) + ")");
+
+		VkVertexInputAttributeDescription attribute{};
+		attribute.binding = 0;
+		attribute.location = match->Location;
+		attribute.format = match->Format;
+		attribute.offset = match->Offset;
+		attributes.push_back(attribute);
+	}
+
+	if (attributes.empty()) return;
+
+	VkVertexInputBindingDescription binding{};
+	binding.binding = 0;
+	binding.stride = layout.Stride;
+	binding.inputRate = layout.InputRate;
+	bindings.push_back(binding);
+}
+
+VkIndexType Vulkan_Engine::VGeometry::SelectIndexType(uint32_t vertexCount)
+{
+	//primitive restart is off, so 0xFFFF is a valid 16 bits index
+	return vertexCount <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+std::vector<char> Vulkan_Engine::VGeometry::PackIndices(const std::vector<uint32_t>& indices, VkIndexType indexType)
+{
+	std::vector<char> data;
+	if (indexType == VK_INDEX_TYPE_UINT32)
+	{
+		data.resize(indices.size() * sizeof(uint32_t));
+		std::memcpy(data.data(), indices.data(), data.size());
+		return data;
+	}
+
+	data.resize(indices.size() * sizeof(uint16_t));
+	uint16_t* packed = reinterpret_cast<uint16_t*>(data.data());
+	for (size_t i = 0; i < indices.size(); i++) packed[i] = static_cast<uint16_t>(indices[i]);
+	return data;
+}
+
+void Vulkan_Engine::VGeometry::MakeGrid(uint32_t triangleCount, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+	uint32_t side = std::max(1u, static_cast<uint32_t>(std::lround(std::sqrt(triangleCount / 2.0))));
+	uint32_t rowVertices = side + 1;
+
+	vertices.clear();
+	vertices.reserve(size_t(rowVertices) * rowVertices * 5);
+	for (uint32_t y = 0; y < rowVertices; y++)
+		for (uint32_t x = 0; x < rowVertices; x++)
+		{
+			float u = float(x) / side, v = float(y) / side;
+			vertices.insert(vertices.end(), { u * 2.0f - 1.0f, v * 2.0f - 1.0f, u, v, 1.0f - u });
+		}
+
+	//y goes down in clip space, top left -> top right -> bottom right is clockwise on screen
+	indices.clear();
+	indices.reserve(size_t(side) * side * 6);
+	for (uint32_t y = 0; y < side; y++)
+		for (uint32_t x = 0; x < side; x++)
+		{
+			uint32_t topLeft = y * rowVertices + x;
+			uint32_t bottomLeft = topLeft + rowVertices;
+			indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft + 1, topLeft, bottomLeft + 1, bottomLeft });
+		}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VMemoryAllocator.h"
+#include "VSpirvReflect.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	struct VertexAttribute
+	{
+		std::string Name; //for error messages only, attributes are matched to the shader by location
+		uint32_t Location = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Offset = 0;
+	};
+
+	//memory layout of the vertices of a mesh, one interleaved vertex buffer
+	struct VertexLayout
+	{
+		uint32_t Stride = 0;
+		VkVertexInputRate InputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		std::vector<VertexAttribute> Attributes;
+
+		//appends an attribute right after the previous one
+		VertexLayout& Add(const std::string& name, uint32_t location, VkFormat format);
+	};
+
+	//vertex and index buffers of one mesh, 16 bits indices when every vertex can be addressed with them
+	struct Mesh
+	{
+		VkBuffer VertexBuffer = VK_NULL_HANDLE;
+		MemoryAllocation VertexMemory;
+		VkBuffer IndexBuffer = VK_NULL_HANDLE;
+		MemoryAllocation IndexMemory;
+		uint32_t VertexCount = 0;
+		uint32_t IndexCount = 0;
+		VkIndexType IndexType = VK_INDEX_TYPE_UINT16;
+	};
+
+	//CPU side of the geometry path, the buffers themselves are created and uploaded by the renderer
+	class VGeometry
+	{
+	public:
+
+		static uint32_t FormatSize(VkFormat format);
+
+		//vertex input of a pipeline drawing meshes of this layout with this vertex shader
+		//only the attributes the shader reads are declared, throws when the shader reads one the layout does not have
+		static void BuildVertexInput(const VertexLayout& layout, const ShaderReflection& vertexReflection,
+			std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes);
+
+		static VkIndexType SelectIndexType(uint32_t vertexCount);
+		//indices in the memory format of indexType
+		static std::vector<char> PackIndices(const std::vector<uint32_t>& indices, VkIndexType indexType);
+
+		//a screen covering grid of about triangleCount clockwise triangles, vertices are (vec2 position, vec3 color)
+		static void MakeGrid(uint32_t triangleCount, std::vector<float>& vertices, std::vector<uint32_t>& indices);
+	};
+
+};
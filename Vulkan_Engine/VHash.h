@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace Vulkan_Engine {
+
+	//FNV-1a 64 bits, pass the previous result as seed to hash several buffers as one
+	const uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+
+	inline uint64_t HashFNV1a(const void* data, size_t size, uint64_t seed = FNV1A_OFFSET_BASIS)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	inline uint64_t HashFNV1a(const std::string& text, uint64_t seed = FNV1A_OFFSET_BASIS)
+	{
+		return HashFNV1a(text.data(), text.size(), seed);
+	}
+
+};
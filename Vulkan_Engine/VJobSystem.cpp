@@ -0,0 +1,356 @@
+#include "VJobSystem.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+	//jobs a worker can keep in its own deque, the overflow goes to the shared queue
+	const uint32_t DEQUE_CAPACITY = 4096;
+	//failed searches before an idle worker goes to sleep
+	const uint32_t IDLE_SPINS = 64;
+
+	thread_local const Vulkan_Engine::VJobSystem* CurrentSystem = nullptr;
+	thread_local uint32_t CurrentWorker = UINT32_MAX;
+}
+
+Vulkan_Engine::VWorkStealingDeque::VWorkStealingDeque(uint32_t capacity)
+{
+	uint32_t size = 1;
+	while (size < capacity) size <<= 1;
+	Buffer.reset(new std::atomic<Job*>[size]);
+	Mask = size - 1;
+}
+
+bool Vulkan_Engine::VWorkStealingDeque::Push(Job* job)
+{
+	int64_t bottom = Bottom.load(std::memory_order_relaxed);
+	int64_t top = Top.load(std::memory_order_acquire);
+	if (bottom - top > Mask) return false;
+
+	Buffer[bottom & Mask].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Bottom.store(bottom + 1, std::memory_order_relaxed);
+	return true;
+}
+
+Vulkan_Engine::Job* Vulkan_Engine::VWorkStealingDeque::Pop()
+{
+	int64_t bottom = Bottom.load(std::memory_order_relaxed) - 1;
+	Bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = Top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		//empty
+		Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = Buffer[bottom & Mask].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		//last job, the thieves may be after it too
+		if (!Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+		Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Vulkan_Engine::Job* Vulkan_Engine::VWorkStealingDeque::Steal()
+{
+	int64_t top = Top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = Bottom.load(std::memory_order_acquire);
+	if (top >= bottom) return nullptr;
+
+	Job* job = Buffer[top & Mask].load(std::memory_order_relaxed);
+	if (!Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+	return job;
+}
+
+bool Vulkan_Engine::VWorkStealingDeque::IsEmpty() const
+{
+	return Top.load(std::memory_order_acquire) >= Bottom.load(std::memory_order_acquire);
+}
+
+Vulkan_Engine::VJobSystem::VJobSystem()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VJobSystem::~VJobSystem()
+{
+	Stop();
+}
+
+void Vulkan_Engine::VJobSystem::Start(uint32_t threadCount, bool pinThreads)
+{
+	if (IsRunning())
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: The job system is already running");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	threadCount = std::max(1u, threadCount);
+	PinThreads = pinThreads;
+	Stopping = false;
+	for (uint32_t worker = 0; worker < threadCount; worker++) Deques.emplace_back(new VWorkStealingDeque(DEQUE_CAPACITY));
+
+	CurrentSystem = this;
+	CurrentWorker = 0;
+	if (PinThreads) Platform::PinCurrentThread(0);
+	for (uint32_t worker = 1; worker < threadCount; worker++) Workers.emplace_back(&VJobSystem::WorkerLoop, this, worker);
+
+	Platform::SetConsoleColor(HConsole, 6);
+	std::cout << "job system : " << threadCount << " workers" << (PinThreads ? " pinned to their cores" : "") << "\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VJobSystem::Stop()
+{
+	if (!IsRunning()) return;
+
+	//the calling thread helps draining, the workers leave once nothing is queued
+	while (QueuedJobs.load(std::memory_order_acquire) > 0)
+	{
+		Job* job = FindJob(0);
+		if (job) Execute(job);
+		else std::this_thread::yield();
+	}
+	{
+		std::lock_guard<std::mutex> lock(SleepMutex);
+		Stopping = true;
+	}
+	WakeUp.notify_all();
+	for (auto& worker : Workers) worker.join();
+	Workers.clear();
+
+	//jobs submitted by the last jobs of the workers
+	while (Job* job = FindJob(0)) Execute(job);
+
+	PrintStatistics();
+
+	Deques.clear();
+	if (CurrentSystem == this)
+	{
+		CurrentSystem = nullptr;
+		CurrentWorker = UINT32_MAX;
+	}
+}
+
+void Vulkan_Engine::VJobSystem::ReleaseMainWorker()
+{
+	if (CurrentSystem == this && CurrentWorker == 0)
+	{
+		CurrentSystem = nullptr;
+		CurrentWorker = UINT32_MAX;
+	}
+}
+
+void Vulkan_Engine::VJobSystem::AcquireMainWorker()
+{
+	if (!IsRunning()) return;
+	CurrentSystem = this;
+	CurrentWorker = 0;
+	if (PinThreads) Platform::PinCurrentThread(0);
+}
+
+uint32_t Vulkan_Engine::VJobSystem::GetWorkerIndex() const
+{
+	return CurrentSystem == this ? CurrentWorker : UINT32_MAX;
+}
+
+void Vulkan_Engine::VJobSystem::Submit(std::function<void()> function, JobCounter* counter, JobCounter* dependency)
+{
+	if (!IsRunning())
+	{
+		//nothing to run it on, the dependency has run inline too
+		function();
+		return;
+	}
+
+	Job* job = new Job{ std::move(function), counter };
+	if (counter) counter->Pending.fetch_add(1, std::memory_order_acq_rel);
+
+	if (dependency)
+	{
+		//Finish takes the same lock before the last job drops the counter to 0, so a continuation is never lost
+		std::lock_guard<std::mutex> lock(dependency->ContinuationsMutex);
+		if (!dependency->IsDone())
+		{
+			dependency->Continuations.push_back(job);
+			return;
+		}
+	}
+	Enqueue(job);
+}
+
+void Vulkan_Engine::VJobSystem::Enqueue(Job* job)
+{
+	//counted before it is visible so a thief never drives QueuedJobs below 0
+	QueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+	uint32_t worker = GetWorkerIndex();
+	if (worker == UINT32_MAX || !Deques[worker]->Push(job))
+	{
+		std::lock_guard<std::mutex> lock(SharedMutex);
+		SharedJobs.push_back(job);
+		SharedCount.fetch_add(1, std::memory_order_release);
+	}
+
+	if (Sleeping.load(std::memory_order_seq_cst) > 0)
+	{
+		std::lock_guard<std::mutex> lock(SleepMutex);
+		WakeUp.notify_one();
+	}
+}
+
+Vulkan_Engine::Job* Vulkan_Engine::VJobSystem::FindJob(uint32_t worker)
+{
+	Job* job = Deques[worker]->Pop();
+
+	if (!job && SharedCount.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(SharedMutex);
+		if (!SharedJobs.empty())
+		{
+			job = SharedJobs.front();
+			SharedJobs.pop_front();
+			SharedCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (!job)
+	{
+		//oldest jobs of the others first, starting right after this worker to spread the thieves
+		uint32_t workerCount = GetWorkerCount();
+		for (uint32_t i = 1; i < workerCount && !job; i++)
+		{
+			job = Deques[(worker + i) % workerCount]->Steal();
+			if (job) StolenJobs.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (job) QueuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+	return job;
+}
+
+void Vulkan_Engine::VJobSystem::Execute(Job* job)
+{
+	try {
+		job->Function();
+	}
+	catch (const std::exception& e) {
+		//nobody to rethrow to, the counter still completes so waiters do not hang
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cerr << "ERROR :: job failed : " << e.what() << "\n";
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	catch (...) {
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cerr << "ERROR :: job failed\n";
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	ExecutedJobs.fetch_add(1, std::memory_order_relaxed);
+	if (job->Counter) Finish(*job->Counter);
+	delete job;
+}
+
+void Vulkan_Engine::VJobSystem::Finish(JobCounter& counter)
+{
+	//not the last job : nothing else to do, the counter must not be touched afterwards
+	uint32_t pending = counter.Pending.load(std::memory_order_relaxed);
+	while (pending > 1)
+		if (counter.Pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) return;
+
+	std::vector<Job*> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter.ContinuationsMutex);
+		if (counter.Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) ready.swap(counter.Continuations);
+	}
+	for (Job* job : ready) Enqueue(job);
+}
+
+void Vulkan_Engine::VJobSystem::Wait(JobCounter& counter)
+{
+	uint32_t worker = GetWorkerIndex();
+	while (!counter.IsDone())
+	{
+		Job* job = worker != UINT32_MAX ? FindJob(worker) : nullptr;
+		if (job) Execute(job);
+		else std::this_thread::yield();
+	}
+
+	//the last job may still be unlocking the counter in Finish
+	std::lock_guard<std::mutex> lock(counter.ContinuationsMutex);
+}
+
+void Vulkan_Engine::VJobSystem::ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& function)
+{
+	grain = std::max(1u, grain);
+	if (!IsRunning() || count <= grain)
+	{
+		if (count) function(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (uint32_t begin = 0; begin < count; begin += grain)
+	{
+		uint32_t end = std::min(count, begin + grain);
+		Submit([&function, begin, end] { function(begin, end); }, &counter);
+	}
+	Wait(counter);
+}
+
+void Vulkan_Engine::VJobSystem::WorkerLoop(uint32_t worker)
+{
+	CurrentSystem = this;
+	CurrentWorker = worker;
+	if (PinThreads && !Platform::PinCurrentThread(worker % std::max(1u, std::thread::hardware_concurrency())))
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cerr << "failed to pin job worker " << worker << "\n";
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	uint32_t idle = 0;
+	for (;;)
+	{
+		if (Job* job = FindJob(worker))
+		{
+			Execute(job);
+			idle = 0;
+			continue;
+		}
+		if (++idle < IDLE_SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(SleepMutex);
+		if (Stopping && QueuedJobs.load(std::memory_order_acquire) == 0) return;
+		Sleeping.fetch_add(1, std::memory_order_seq_cst);
+		WakeUp.wait(lock, [&] { return Stopping || QueuedJobs.load(std::memory_order_seq_cst) > 0; });
+		Sleeping.fetch_sub(1, std::memory_order_seq_cst);
+		idle = 0;
+	}
+}
+
+void Vulkan_Engine::VJobSystem::PrintStatistics()
+{
+	uint64_t executed = ExecutedJobs.load();
+	uint64_t stolen = StolenJobs.load();
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nJob system statistics\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "workers : " << GetWorkerCount() << (PinThreads ? " (pinned)" : "") << "\n";
+	std::cout << "jobs : " << executed << " executed\t" << stolen << " stolen ("
+		<< (executed ? 100.0 * stolen / executed : 0.0) << " %)\n";
+}
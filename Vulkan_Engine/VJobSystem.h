@@ -0,0 +1,123 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	struct Job;
+
+	//counts the unfinished jobs submitted with it, jobs depending on it are queued once it drops to 0.
+	//must outlive every job it counts and every job depending on it, VJobSystem::Wait is the safe way to know it is done
+	struct JobCounter
+	{
+		std::atomic<uint32_t> Pending{ 0 };
+		std::mutex ContinuationsMutex;
+		std::vector<Job*> Continuations;
+
+		bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	struct Job
+	{
+		std::function<void()> Function;
+		JobCounter* Counter = nullptr;
+	};
+
+	//bounded Chase-Lev work stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013)
+	//the owner pushes and pops at the bottom, any other thread steals from the top
+	class VWorkStealingDeque
+	{
+	public:
+
+		explicit VWorkStealingDeque(uint32_t capacity);
+
+		//owner only, false when full
+		bool Push(Job* job);
+		//owner only, nullptr when empty
+		Job* Pop();
+		//any thread, nullptr when empty or when another thief or the owner won the race
+		Job* Steal();
+		bool IsEmpty() const;
+
+	private:
+
+		alignas(64) std::atomic<int64_t> Top{ 0 };
+		alignas(64) std::atomic<int64_t> Bottom{ 0 };
+		std::unique_ptr<std::atomic<Job*>[]> Buffer;
+		int64_t Mask;
+	};
+
+	//engine job system : one deque per worker, idle workers steal from the others.
+	//the thread calling Start is worker 0 (until it hands it over), it runs jobs only while it waits (wait-while-helping).
+	//any other thread may submit and wait, its jobs go through a shared queue and it waits without helping
+	class VJobSystem
+	{
+	public:
+
+		VJobSystem();
+		~VJobSystem();
+
+		//threadCount workers including the calling thread, pinned to one core each when pinThreads
+		void Start(uint32_t threadCount, bool pinThreads);
+		//finishes the submitted jobs, then joins the workers. Called by the thread holding worker 0
+		void Stop();
+		//hands worker 0 over to another thread : the thread holding it releases it, then the other thread acquires it
+		//before its first Submit or Wait. The caller orders the two calls, starting or joining the other thread does
+		void ReleaseMainWorker();
+		void AcquireMainWorker();
+
+		//counter may be null. The job runs once dependency, when not null, has dropped to 0
+		void Submit(std::function<void()> function, JobCounter* counter, JobCounter* dependency = nullptr);
+		//runs the jobs of the calling worker (or steals) until counter drops to 0
+		void Wait(JobCounter& counter);
+		//function(begin, end) over [0, count) in chunks of grain items, returns once every chunk ran
+		void ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(Deques.size()); }
+		//index of the calling worker, UINT32_MAX on a thread that is not one
+		uint32_t GetWorkerIndex() const;
+		bool IsRunning() const { return !Deques.empty(); }
+		void PrintStatistics();
+
+	private:
+
+		void WorkerLoop(uint32_t worker);
+		void Enqueue(Job* job);
+		Job* FindJob(uint32_t worker);
+		void Execute(Job* job);
+		void Finish(JobCounter& counter);
+
+		std::vector<std::unique_ptr<VWorkStealingDeque>> Deques;
+		std::vector<std::thread> Workers;
+		bool PinThreads = false;
+
+		//jobs submitted from threads that are not workers, or that did not fit a full deque
+		std::mutex SharedMutex;
+		std::deque<Job*> SharedJobs;
+		std::atomic<uint32_t> SharedCount{ 0 };
+
+		//idle workers sleep once nothing is queued anywhere
+		std::atomic<int64_t> QueuedJobs{ 0 };
+		std::atomic<uint32_t> Sleeping{ 0 };
+		std::mutex SleepMutex;
+		std::condition_variable WakeUp;
+		std::atomic<bool> Stopping{ false };
+
+		//statistics
+		std::atomic<uint64_t> ExecutedJobs{ 0 };
+		std::atomic<uint64_t> StolenJobs{ 0 };
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
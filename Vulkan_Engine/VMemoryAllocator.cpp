@@ -0,0 +1,619 @@
+#include "VMemoryAllocator.h"
+
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+	//index of the highest / lowest set bit, value must not be 0
+	uint32_t HighestBit(uint64_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	uint32_t LowestBit(uint64_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+
+	uint32_t CountBits(uint32_t value)
+	{
+		uint32_t count = 0;
+		for (; value; value &= value - 1) count++;
+		return count;
+	}
+
+	VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//a free remainder smaller than this stays in the used node, it would only fragment the free lists
+	const VkDeviceSize MIN_SPLIT_SIZE = 256;
+	const VkDeviceSize LARGE_HEAP_SIZE = 1024ull * 1024 * 1024;
+	const VkDeviceSize LARGE_HEAP_BLOCK_SIZE = 256ull * 1024 * 1024;
+
+	double ToMB(VkDeviceSize size)
+	{
+		return size / (1024.0 * 1024.0);
+	}
+}
+
+Vulkan_Engine::VMemoryAllocator::VMemoryAllocator()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VMemoryAllocator::~VMemoryAllocator()
+{
+	Destroy();
+}
+
+void Vulkan_Engine::VMemoryAllocator::Create(VkPhysicalDevice physicalDevice, VkDevice device, bool dedicatedRequirements)
+{
+	PhysicalDevice = physicalDevice;
+	Device = device;
+	DedicatedRequirements = dedicatedRequirements;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(PhysicalDevice, &properties);
+	Limits = properties.limits;
+	vkGetPhysicalDeviceMemoryProperties(PhysicalDevice, &MemoryProperties);
+
+	//small heaps (integrated GPUs, the host visible window of dedicated GPUs) get smaller blocks
+	Pools.resize(MemoryProperties.memoryTypeCount * 2);
+	for (uint32_t memoryType = 0; memoryType < MemoryProperties.memoryTypeCount; memoryType++)
+	{
+		VkDeviceSize heapSize = MemoryProperties.memoryHeaps[MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+		for (uint32_t kind = 0; kind < 2; kind++)
+		{
+			Pool& pool = Pools[memoryType * 2 + kind];
+			pool.MemoryType = memoryType;
+			pool.Linear = kind == 1;
+			pool.BlockSize = heapSize <= LARGE_HEAP_SIZE ? AlignUp(heapSize / 8, 32) : LARGE_HEAP_BLOCK_SIZE;
+		}
+	}
+}
+
+void Vulkan_Engine::VMemoryAllocator::Destroy()
+{
+	if (Device == VK_NULL_HANDLE) return;
+
+	PrintStatistics();
+	if (LiveAllocations)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << "memory allocator : " << LiveAllocations << " allocations were not freed\n";
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	for (auto& pool : Pools)
+		for (auto& block : pool.Blocks) DestroyBlock(block);
+	Pools.clear();
+	Device = VK_NULL_HANDLE;
+}
+
+uint32_t Vulkan_Engine::VMemoryAllocator::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+{
+	//most preferred flags first, then the fewest flags nobody asked for (a plain DEVICE_LOCAL type over a HOST_VISIBLE one...)
+	uint32_t bestType = UINT32_MAX;
+	int bestScore = -1;
+	for (uint32_t memoryType = 0; memoryType < MemoryProperties.memoryTypeCount; memoryType++)
+	{
+		if (!(typeBits & (1u << memoryType))) continue;
+		VkMemoryPropertyFlags flags = MemoryProperties.memoryTypes[memoryType].propertyFlags;
+		if ((flags & required) != required) continue;
+
+		int score = static_cast<int>(CountBits(flags & preferred)) * 32 - static_cast<int>(CountBits(flags & ~(required | preferred)));
+		if (score > bestScore) {
+			bestScore = score;
+			bestType = memoryType;
+		}
+	}
+	return bestType;
+}
+
+bool Vulkan_Engine::VMemoryAllocator::IsMappable(uint32_t memoryType) const
+{
+	return (MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+Vulkan_Engine::VMemoryAllocator::Pool& Vulkan_Engine::VMemoryAllocator::GetPool(uint32_t memoryType, bool linear)
+{
+	//with a granularity of 1 linear and optimal resources may be neighbours, they share the blocks
+	return Pools[memoryType * 2 + ((linear && Limits.bufferImageGranularity > 1) ? 1 : 0)];
+}
+
+void Vulkan_Engine::VMemoryAllocator::MappingInsert(VkDeviceSize size, uint32_t& fl, uint32_t& sl)
+{
+	if (size < SL_COUNT) {
+		fl = 0;
+		sl = static_cast<uint32_t>(size);
+		return;
+	}
+	uint32_t highest = HighestBit(size);
+	sl = static_cast<uint32_t>(size >> (highest - SL_BITS)) ^ SL_COUNT;
+	fl = highest - SL_BITS + 1;
+}
+
+bool Vulkan_Engine::VMemoryAllocator::MappingSearch(VkDeviceSize size, uint32_t& fl, uint32_t& sl)
+{
+	//rounded up to the next list, so any node of the list found is big enough
+	if (size >= SL_COUNT)
+	{
+		VkDeviceSize round = (VkDeviceSize(1) << (HighestBit(size) - SL_BITS)) - 1;
+		if (size + round < size) return false;
+		size += round;
+	}
+	MappingInsert(size, fl, sl);
+	return fl < FL_COUNT;
+}
+
+uint32_t Vulkan_Engine::VMemoryAllocator::FindFreeNode(const Block& block, VkDeviceSize size)
+{
+	uint32_t fl, sl;
+	if (!MappingSearch(size, fl, sl)) return NO_NODE;
+
+	uint32_t slMap = block.SLBitmap[fl] & (~0u << sl);
+	if (!slMap)
+	{
+		uint64_t flMap = (fl + 1 < 64) ? block.FLBitmap & (~0ull << (fl + 1)) : 0;
+		if (!flMap) return NO_NODE;
+		fl = LowestBit(flMap);
+		slMap = block.SLBitmap[fl];
+	}
+	return block.FreeLists[fl][LowestBit(slMap)];
+}
+
+uint32_t Vulkan_Engine::VMemoryAllocator::NewNode(Block& block)
+{
+	if (!block.UnusedNodes.empty()) {
+		uint32_t node = block.UnusedNodes.back();
+		block.UnusedNodes.pop_back();
+		return node;
+	}
+	block.Nodes.push_back(Node{});
+	return static_cast<uint32_t>(block.Nodes.size() - 1);
+}
+
+void Vulkan_Engine::VMemoryAllocator::InsertFree(Block& block, uint32_t node)
+{
+	uint32_t fl, sl;
+	MappingInsert(block.Nodes[node].Size, fl, sl);
+
+	Node& freeNode = block.Nodes[node];
+	freeNode.Free = true;
+	freeNode.PrevFree = NO_NODE;
+	freeNode.NextFree = block.FreeLists[fl][sl];
+	if (freeNode.NextFree != NO_NODE) block.Nodes[freeNode.NextFree].PrevFree = node;
+	block.FreeLists[fl][sl] = node;
+	block.SLBitmap[fl] |= 1u << sl;
+	block.FLBitmap |= 1ull << fl;
+}
+
+void Vulkan_Engine::VMemoryAllocator::RemoveFree(Block& block, uint32_t node)
+{
+	uint32_t fl, sl;
+	MappingInsert(block.Nodes[node].Size, fl, sl);
+
+	Node& freeNode = block.Nodes[node];
+	if (freeNode.PrevFree != NO_NODE) block.Nodes[freeNode.PrevFree].NextFree = freeNode.NextFree;
+	else block.FreeLists[fl][sl] = freeNode.NextFree;
+	if (freeNode.NextFree != NO_NODE) block.Nodes[freeNode.NextFree].PrevFree = freeNode.PrevFree;
+	freeNode.Free = false;
+
+	if (block.FreeLists[fl][sl] == NO_NODE) {
+		block.SLBitmap[fl] &= ~(1u << sl);
+		if (!block.SLBitmap[fl]) block.FLBitmap &= ~(1ull << fl);
+	}
+}
+
+uint32_t Vulkan_Engine::VMemoryAllocator::UseNode(Block& block, uint32_t node, VkDeviceSize offset, VkDeviceSize size)
+{
+	RemoveFree(block, node);
+
+	//alignment padding in front becomes a free node, the physical neighbours of a free node are never free so nothing merges
+	if (offset > block.Nodes[node].Offset)
+	{
+		uint32_t padding = NewNode(block);
+		Node& used = block.Nodes[node];
+		Node& front = block.Nodes[padding];
+		front.Offset = used.Offset;
+		front.Size = offset - used.Offset;
+		front.PrevPhysical = used.PrevPhysical;
+		front.NextPhysical = node;
+		if (front.PrevPhysical != NO_NODE) block.Nodes[front.PrevPhysical].NextPhysical = padding;
+		used.PrevPhysical = padding;
+		used.Offset = offset;
+		used.Size -= front.Size;
+		InsertFree(block, padding);
+	}
+
+	if (block.Nodes[node].Size - size >= MIN_SPLIT_SIZE)
+	{
+		uint32_t remainder = NewNode(block);
+		Node& used = block.Nodes[node];
+		Node& back = block.Nodes[remainder];
+		back.Offset = used.Offset + size;
+		back.Size = used.Size - size;
+		back.PrevPhysical = node;
+		back.NextPhysical = used.NextPhysical;
+		if (back.NextPhysical != NO_NODE) block.Nodes[back.NextPhysical].PrevPhysical = remainder;
+		used.NextPhysical = remainder;
+		used.Size = size;
+		InsertFree(block, remainder);
+	}
+
+	block.UsedNodes++;
+	return node;
+}
+
+bool Vulkan_Engine::VMemoryAllocator::AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation& allocation)
+{
+	if (block.Memory == VK_NULL_HANDLE) return false;
+	if (alignment == 0) alignment = 1;
+
+	//the first fit for the size usually satisfies the alignment too, else look again with room for the worst padding
+	uint32_t node = FindFreeNode(block, size);
+	if (node != NO_NODE && AlignUp(block.Nodes[node].Offset, alignment) + size > block.Nodes[node].Offset + block.Nodes[node].Size) node = NO_NODE;
+	if (node == NO_NODE && alignment > 1) node = FindFreeNode(block, size + alignment - 1);
+	if (node == NO_NODE) return false;
+
+	node = UseNode(block, node, AlignUp(block.Nodes[node].Offset, alignment), size);
+	allocation.Memory = block.Memory;
+	allocation.Offset = block.Nodes[node].Offset;
+	allocation.Size = size;
+	allocation.Node = node;
+	allocation.Mapped = block.Mapped ? block.Mapped + allocation.Offset : nullptr;
+	BytesUsed += block.Nodes[node].Size;
+	return true;
+}
+
+bool Vulkan_Engine::VMemoryAllocator::CreateBlock(Pool& pool, VkDeviceSize minimumSize, uint32_t& blockIndex)
+{
+	if (DeviceMemoryCount >= Limits.maxMemoryAllocationCount) return false;
+
+	//when the heap is short on memory, try smaller blocks before giving up
+	VkMemoryAllocateInfo MemoryAllocateInfo{};
+	MemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	MemoryAllocateInfo.memoryTypeIndex = pool.MemoryType;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	for (VkDeviceSize size = pool.BlockSize; size >= minimumSize && memory == VK_NULL_HANDLE; size /= 2)
+	{
+		MemoryAllocateInfo.allocationSize = size;
+		if (vkAllocateMemory(Device, &MemoryAllocateInfo, nullptr, &memory) != VK_SUCCESS) memory = VK_NULL_HANDLE;
+	}
+	if (memory == VK_NULL_HANDLE) return false;
+
+	blockIndex = 0;
+	while (blockIndex < pool.Blocks.size() && pool.Blocks[blockIndex].Memory != VK_NULL_HANDLE) blockIndex++;
+	if (blockIndex == pool.Blocks.size()) pool.Blocks.emplace_back();
+
+	Block& block = pool.Blocks[blockIndex];
+	block.Memory = memory;
+	block.Size = MemoryAllocateInfo.allocationSize;
+	block.Mapped = nullptr;
+	if (IsMappable(pool.MemoryType))
+	{
+		void* mapped = nullptr;
+		if (vkMapMemory(Device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) == VK_SUCCESS) block.Mapped = static_cast<char*>(mapped);
+	}
+
+	block.Nodes.assign(1, Node{ 0, block.Size, NO_NODE, NO_NODE, NO_NODE, NO_NODE, false });
+	block.UnusedNodes.clear();
+	block.FLBitmap = 0;
+	std::memset(block.SLBitmap, 0, sizeof(block.SLBitmap));
+	std::memset(block.FreeLists, 0xFF, sizeof(block.FreeLists));
+	block.UsedNodes = 0;
+	InsertFree(block, 0);
+
+	DeviceMemoryCount++;
+	if (DeviceMemoryCount > PeakDeviceMemoryCount) PeakDeviceMemoryCount = DeviceMemoryCount;
+	BytesReserved += block.Size;
+	return true;
+}
+
+void Vulkan_Engine::VMemoryAllocator::DestroyBlock(Block& block)
+{
+	if (block.Memory == VK_NULL_HANDLE) return;
+
+	//freeing a mapped allocation unmaps it
+	vkFreeMemory(Device, block.Memory, nullptr);
+	DeviceMemoryCount--;
+	BytesReserved -= block.Size;
+	block.Memory = VK_NULL_HANDLE;
+	block.Mapped = nullptr;
+	block.Nodes.clear();
+	block.UnusedNodes.clear();
+}
+
+Vulkan_Engine::MemoryAllocation Vulkan_Engine::VMemoryAllocator::AllocateDedicated(uint32_t memoryType, VkDeviceSize size, const VkMemoryDedicatedAllocateInfo* dedicatedInfo)
+{
+	MemoryAllocation allocation;
+	if (DeviceMemoryCount >= Limits.maxMemoryAllocationCount) return allocation;
+
+	VkMemoryAllocateInfo MemoryAllocateInfo{};
+	MemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	MemoryAllocateInfo.pNext = dedicatedInfo;
+	MemoryAllocateInfo.allocationSize = size;
+	MemoryAllocateInfo.memoryTypeIndex = memoryType;
+	if (vkAllocateMemory(Device, &MemoryAllocateInfo, nullptr, &allocation.Memory) != VK_SUCCESS) {
+		allocation.Memory = VK_NULL_HANDLE;
+		return allocation;
+	}
+
+	allocation.Size = size;
+	allocation.MemoryType = memoryType;
+	if (IsMappable(memoryType) && vkMapMemory(Device, allocation.Memory, 0, VK_WHOLE_SIZE, 0, &allocation.Mapped) != VK_SUCCESS) allocation.Mapped = nullptr;
+
+	DeviceMemoryCount++;
+	if (DeviceMemoryCount > PeakDeviceMemoryCount) PeakDeviceMemoryCount = DeviceMemoryCount;
+	DedicatedAllocations++;
+	BytesDedicated += size;
+	return allocation;
+}
+
+Vulkan_Engine::MemoryAllocation Vulkan_Engine::VMemoryAllocator::AllocateMemory(const VkMemoryRequirements& requirements, bool linear, const MemoryUsage& usage, const VkMemoryDedicatedAllocateInfo* dedicatedInfo)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	//the best memory type first, then the next best ones when its heap is full
+	uint32_t typeBits = requirements.memoryTypeBits;
+	for (uint32_t memoryType = FindMemoryType(typeBits, usage.Required, usage.Preferred); memoryType != UINT32_MAX;
+		typeBits &= ~(1u << memoryType), memoryType = FindMemoryType(typeBits, usage.Required, usage.Preferred))
+	{
+		Pool& pool = GetPool(memoryType, linear);
+		MemoryAllocation allocation;
+
+		bool dedicated = usage.Dedicated || dedicatedInfo || requirements.size > pool.BlockSize / 2;
+		if (!dedicated)
+		{
+			for (uint32_t blockIndex = 0; blockIndex < pool.Blocks.size() && allocation.Memory == VK_NULL_HANDLE; blockIndex++) {
+				if (AllocateFromBlock(pool.Blocks[blockIndex], requirements.size, requirements.alignment, allocation)) allocation.Block = blockIndex;
+			}
+
+			uint32_t blockIndex;
+			if (allocation.Memory == VK_NULL_HANDLE && CreateBlock(pool, requirements.size + requirements.alignment, blockIndex)) {
+				if (AllocateFromBlock(pool.Blocks[blockIndex], requirements.size, requirements.alignment, allocation)) allocation.Block = blockIndex;
+			}
+
+			if (allocation.Memory != VK_NULL_HANDLE) {
+				allocation.Pool = static_cast<uint32_t>(&pool - Pools.data());
+				allocation.MemoryType = memoryType;
+			}
+		}
+
+		//no room for a new block, the resource may still fit alone
+		if (allocation.Memory == VK_NULL_HANDLE) allocation = AllocateDedicated(memoryType, requirements.size, dedicatedInfo);
+		if (allocation.Memory == VK_NULL_HANDLE) continue;
+
+		LiveAllocations++;
+		AllocationCount++;
+		return allocation;
+	}
+
+	Platform::SetConsoleColor(HConsole, 12);
+	throw std::runtime_error("ERROR :: FAILED TO ALLOCATE DEVICE MEMORY");
+}
+
+Vulkan_Engine::MemoryAllocation Vulkan_Engine::VMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, bool linear, const MemoryUsage& usage)
+{
+	return AllocateMemory(requirements, linear, usage, nullptr);
+}
+
+void Vulkan_Engine::VMemoryAllocator::Free(MemoryAllocation& allocation)
+{
+	if (allocation.Memory == VK_NULL_HANDLE) return;
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	if (allocation.Pool == UINT32_MAX)
+	{
+		vkFreeMemory(Device, allocation.Memory, nullptr);
+		DeviceMemoryCount--;
+		DedicatedAllocations--;
+		BytesDedicated -= allocation.Size;
+	}
+	else
+	{
+		Pool& pool = Pools[allocation.Pool];
+		Block& block = pool.Blocks[allocation.Block];
+		uint32_t node = allocation.Node;
+		BytesUsed -= block.Nodes[node].Size;
+		block.UsedNodes--;
+
+		//merge with the free physical neighbours
+		uint32_t previous = block.Nodes[node].PrevPhysical;
+		if (previous != NO_NODE && block.Nodes[previous].Free)
+		{
+			RemoveFree(block, previous);
+			block.Nodes[previous].Size += block.Nodes[node].Size;
+			block.Nodes[previous].NextPhysical = block.Nodes[node].NextPhysical;
+			if (block.Nodes[node].NextPhysical != NO_NODE) block.Nodes[block.Nodes[node].NextPhysical].PrevPhysical = previous;
+			block.UnusedNodes.push_back(node);
+			node = previous;
+		}
+		uint32_t next = block.Nodes[node].NextPhysical;
+		if (next != NO_NODE && block.Nodes[next].Free)
+		{
+			RemoveFree(block, next);
+			block.Nodes[node].Size += block.Nodes[next].Size;
+			block.Nodes[node].NextPhysical = block.Nodes[next].NextPhysical;
+			if (block.Nodes[next].NextPhysical != NO_NODE) block.Nodes[block.Nodes[next].NextPhysical].PrevPhysical = node;
+			block.UnusedNodes.push_back(next);
+		}
+		InsertFree(block, node);
+
+		//one empty block is kept per pool so alloc/free churn does not allocate device memory every time
+		if (block.UsedNodes == 0)
+		{
+			for (auto& other : pool.Blocks)
+			{
+				if (&other != &block && other.Memory != VK_NULL_HANDLE && other.UsedNodes == 0) {
+					DestroyBlock(block);
+					break;
+				}
+			}
+		}
+	}
+
+	LiveAllocations--;
+	FreeCount++;
+	allocation = MemoryAllocation{};
+}
+
+void Vulkan_Engine::VMemoryAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, const MemoryUsage& usage, VkBuffer& buffer, MemoryAllocation& allocation)
+{
+	if (vkCreateBuffer(Device, &createInfo, nullptr, &buffer) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: FAILED TO CREATE A BUFFER");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	VkMemoryRequirements MemoryRequirements;
+	VkMemoryDedicatedAllocateInfo DedicatedAllocateInfo{};
+	DedicatedAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+	DedicatedAllocateInfo.buffer = buffer;
+	bool dedicated = false;
+	if (DedicatedRequirements)
+	{
+		VkBufferMemoryRequirementsInfo2 RequirementsInfo{};
+		RequirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		RequirementsInfo.buffer = buffer;
+		VkMemoryDedicatedRequirements DedicatedMemoryRequirements{};
+		DedicatedMemoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 MemoryRequirements2{};
+		MemoryRequirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		MemoryRequirements2.pNext = &DedicatedMemoryRequirements;
+		vkGetBufferMemoryRequirements2(Device, &RequirementsInfo, &MemoryRequirements2);
+		MemoryRequirements = MemoryRequirements2.memoryRequirements;
+		dedicated = usage.Dedicated || DedicatedMemoryRequirements.prefersDedicatedAllocation || DedicatedMemoryRequirements.requiresDedicatedAllocation;
+	}
+	else vkGetBufferMemoryRequirements(Device, buffer, &MemoryRequirements);
+
+	try {
+		allocation = AllocateMemory(MemoryRequirements, true, usage, dedicated ? &DedicatedAllocateInfo : nullptr);
+	}
+	catch (std::exception&) {
+		vkDestroyBuffer(Device, buffer, nullptr);
+		buffer = VK_NULL_HANDLE;
+		Platform::SetConsoleColor(HConsole, 12);
+		throw;
+	}
+	vkBindBufferMemory(Device, buffer, allocation.Memory, allocation.Offset);
+}
+
+void Vulkan_Engine::VMemoryAllocator::CreateImage(const VkImageCreateInfo& createInfo, const MemoryUsage& usage, VkImage& image, MemoryAllocation& allocation)
+{
+	if (vkCreateImage(Device, &createInfo, nullptr, &image) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: FAILED TO CREATE AN IMAGE");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	VkMemoryRequirements MemoryRequirements;
+	VkMemoryDedicatedAllocateInfo DedicatedAllocateInfo{};
+	DedicatedAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+	DedicatedAllocateInfo.image = image;
+	bool dedicated = false;
+	if (DedicatedRequirements)
+	{
+		VkImageMemoryRequirementsInfo2 RequirementsInfo{};
+		RequirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		RequirementsInfo.image = image;
+		VkMemoryDedicatedRequirements DedicatedMemoryRequirements{};
+		DedicatedMemoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 MemoryRequirements2{};
+		MemoryRequirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		MemoryRequirements2.pNext = &DedicatedMemoryRequirements;
+		vkGetImageMemoryRequirements2(Device, &RequirementsInfo, &MemoryRequirements2);
+		MemoryRequirements = MemoryRequirements2.memoryRequirements;
+		dedicated = usage.Dedicated || DedicatedMemoryRequirements.prefersDedicatedAllocation || DedicatedMemoryRequirements.requiresDedicatedAllocation;
+	}
+	else vkGetImageMemoryRequirements(Device, image, &MemoryRequirements);
+
+	try {
+		allocation = AllocateMemory(MemoryRequirements, createInfo.tiling == VK_IMAGE_TILING_LINEAR, usage, dedicated ? &DedicatedAllocateInfo : nullptr);
+	}
+	catch (std::exception&) {
+		vkDestroyImage(Device, image, nullptr);
+		image = VK_NULL_HANDLE;
+		Platform::SetConsoleColor(HConsole, 12);
+		throw;
+	}
+	vkBindImageMemory(Device, image, allocation.Memory, allocation.Offset);
+}
+
+void Vulkan_Engine::VMemoryAllocator::DestroyBuffer(VkBuffer& buffer, MemoryAllocation& allocation)
+{
+	if (buffer != VK_NULL_HANDLE) vkDestroyBuffer(Device, buffer, nullptr);
+	buffer = VK_NULL_HANDLE;
+	Free(allocation);
+}
+
+void Vulkan_Engine::VMemoryAllocator::DestroyImage(VkImage& image, MemoryAllocation& allocation)
+{
+	if (image != VK_NULL_HANDLE) vkDestroyImage(Device, image, nullptr);
+	image = VK_NULL_HANDLE;
+	Free(allocation);
+}
+
+void Vulkan_Engine::VMemoryAllocator::PrintMemoryTypes()
+{
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nMemory heaps and types\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	for (uint32_t heap = 0; heap < MemoryProperties.memoryHeapCount; heap++)
+	{
+		std::cout << "heap " << heap << " : " << ToMB(MemoryProperties.memoryHeaps[heap].size) << " MB"
+			<< ((MemoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " device local" : "") << '\n';
+		for (uint32_t memoryType = 0; memoryType < MemoryProperties.memoryTypeCount; memoryType++)
+		{
+			if (MemoryProperties.memoryTypes[memoryType].heapIndex != heap) continue;
+			VkMemoryPropertyFlags flags = MemoryProperties.memoryTypes[memoryType].propertyFlags;
+			std::cout << "\ttype " << memoryType << " :";
+			if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) std::cout << " DEVICE_LOCAL";
+			if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) std::cout << " HOST_VISIBLE";
+			if (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) std::cout << " HOST_COHERENT";
+			if (flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) std::cout << " HOST_CACHED";
+			if (flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) std::cout << " LAZILY_ALLOCATED";
+			std::cout << "\tblock size : " << ToMB(Pools[memoryType * 2].BlockSize) << " MB\n";
+		}
+	}
+	std::cout << "maxMemoryAllocationCount : " << Limits.maxMemoryAllocationCount << "\tbufferImageGranularity : " << Limits.bufferImageGranularity << '\n';
+}
+
+void Vulkan_Engine::VMemoryAllocator::PrintStatistics()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	uint32_t blockCount = 0;
+	for (const auto& pool : Pools)
+		for (const auto& block : pool.Blocks) blockCount += block.Memory != VK_NULL_HANDLE;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nMemory allocator statistics\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "device memory objects : " << DeviceMemoryCount << " (peak " << PeakDeviceMemoryCount << ", limit " << Limits.maxMemoryAllocationCount << ")\t"
+		<< blockCount << " blocks, " << DedicatedAllocations << " dedicated\n";
+	std::cout << "allocations : " << LiveAllocations << " live\t" << AllocationCount << " allocated, " << FreeCount << " freed\n";
+	std::cout << "blocks : " << ToMB(BytesUsed) << " MB used of " << ToMB(BytesReserved) << " MB\tdedicated : " << ToMB(BytesDedicated) << " MB\n";
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//what a resource needs from its memory : every Required flag, as many Preferred flags as possible
+	struct MemoryUsage
+	{
+		VkMemoryPropertyFlags Required = 0;
+		VkMemoryPropertyFlags Preferred = 0;
+		bool Dedicated = false; //own VkDeviceMemory, for big render targets or resources that are often recreated
+	};
+
+	//a range of a VkDeviceMemory block, or a whole dedicated VkDeviceMemory
+	struct MemoryAllocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		uint32_t MemoryType = 0;
+		void* Mapped = nullptr;   //host visible memory stays mapped for its whole life
+		uint32_t Pool = UINT32_MAX; //UINT32_MAX for dedicated allocations
+		uint32_t Block = 0;
+		uint32_t Node = 0;
+	};
+
+	//device memory sub-allocator
+	//big VkDeviceMemory blocks are reserved per memory type and split with a TLSF (two level segregated fit) allocator,
+	//so thousands of resources only use a handful of the maxMemoryAllocationCount allocations the driver allows.
+	//when bufferImageGranularity is bigger than 1, linear (buffers, linear images) and optimal resources get separate blocks
+	class VMemoryAllocator
+	{
+	public:
+
+		VMemoryAllocator();
+		~VMemoryAllocator();
+
+		//dedicatedRequirements when the device is Vulkan 1.1, then vkGet*MemoryRequirements2 tells which resources want their own memory
+		void Create(VkPhysicalDevice physicalDevice, VkDevice device, bool dedicatedRequirements);
+		//prints the statistics, reports leaked allocations and frees every block
+		void Destroy();
+
+		//memory type with every required flag and the most preferred ones, UINT32_MAX when there is none
+		uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const;
+
+		//throws when no memory type fits or the device is out of memory
+		MemoryAllocation Allocate(const VkMemoryRequirements& requirements, bool linear, const MemoryUsage& usage);
+		void Free(MemoryAllocation& allocation);
+
+		//create the resource, allocate and bind its memory
+		void CreateBuffer(const VkBufferCreateInfo& createInfo, const MemoryUsage& usage, VkBuffer& buffer, MemoryAllocation& allocation);
+		void CreateImage(const VkImageCreateInfo& createInfo, const MemoryUsage& usage, VkImage& image, MemoryAllocation& allocation);
+		void DestroyBuffer(VkBuffer& buffer, MemoryAllocation& allocation);
+		void DestroyImage(VkImage& image, MemoryAllocation& allocation);
+
+		const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return MemoryProperties; }
+		uint32_t GetDeviceMemoryCount() const { return DeviceMemoryCount; }
+		uint32_t GetAllocationCount() const { return LiveAllocations; }
+		void PrintMemoryTypes();
+		void PrintStatistics();
+
+	private:
+
+		//TLSF index : first level is the power of two of the size, second level splits it in SL_COUNT ranges
+		static const uint32_t SL_BITS = 4;
+		static const uint32_t SL_COUNT = 1u << SL_BITS;
+		static const uint32_t FL_COUNT = 64 - SL_BITS;
+		static const uint32_t NO_NODE = UINT32_MAX;
+
+		//a range of a block, free or used, linked to its physical neighbours and, when free, to its free list
+		struct Node
+		{
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+			uint32_t PrevPhysical;
+			uint32_t NextPhysical;
+			uint32_t PrevFree;
+			uint32_t NextFree;
+			bool Free;
+		};
+
+		struct Block
+		{
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			VkDeviceSize Size = 0;
+			char* Mapped = nullptr;
+			std::vector<Node> Nodes;
+			std::vector<uint32_t> UnusedNodes; //recycled Nodes entries
+			uint64_t FLBitmap = 0;
+			uint32_t SLBitmap[FL_COUNT] = {};
+			uint32_t FreeLists[FL_COUNT][SL_COUNT];
+			uint32_t UsedNodes = 0;
+		};
+
+		//blocks of one memory type for one resource kind (linear or optimal)
+		struct Pool
+		{
+			uint32_t MemoryType = 0;
+			bool Linear = false;
+			VkDeviceSize BlockSize = 0;
+			std::vector<Block> Blocks; //a destroyed block leaves an entry with no memory, reused by the next block
+		};
+
+		static void MappingInsert(VkDeviceSize size, uint32_t& fl, uint32_t& sl);
+		static bool MappingSearch(VkDeviceSize size, uint32_t& fl, uint32_t& sl);
+		static uint32_t FindFreeNode(const Block& block, VkDeviceSize size);
+
+		uint32_t NewNode(Block& block);
+		void InsertFree(Block& block, uint32_t node);
+		void RemoveFree(Block& block, uint32_t node);
+		//splits [offset, offset+size) out of the free node, returns the used node
+		uint32_t UseNode(Block& block, uint32_t node, VkDeviceSize offset, VkDeviceSize size);
+		bool AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation& allocation);
+		bool CreateBlock(Pool& pool, VkDeviceSize minimumSize, uint32_t& blockIndex);
+		void DestroyBlock(Block& block);
+
+		MemoryAllocation AllocateDedicated(uint32_t memoryType, VkDeviceSize size, const VkMemoryDedicatedAllocateInfo* dedicatedInfo);
+		MemoryAllocation AllocateMemory(const VkMemoryRequirements& requirements, bool linear, const MemoryUsage& usage, const VkMemoryDedicatedAllocateInfo* dedicatedInfo);
+		Pool& GetPool(uint32_t memoryType, bool linear);
+		bool IsMappable(uint32_t memoryType) const;
+
+		VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
+		VkDevice Device = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties MemoryProperties{};
+		VkPhysicalDeviceLimits Limits{};
+		bool DedicatedRequirements = false;
+
+		std::mutex Mutex;
+		std::vector<Pool> Pools; //2 per memory type, linear and optimal
+
+		//statistics
+		uint32_t DeviceMemoryCount = 0;     //live VkDeviceMemory objects, blocks and dedicated allocations
+		uint32_t PeakDeviceMemoryCount = 0;
+		uint32_t LiveAllocations = 0;
+		uint32_t DedicatedAllocations = 0;
+		uint64_t AllocationCount = 0;
+		uint64_t FreeCount = 0;
+		VkDeviceSize BytesReserved = 0;     //memory held in blocks
+		VkDeviceSize BytesUsed = 0;         //sub-allocated from the blocks, with alignment padding
+		VkDeviceSize BytesDedicated = 0;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
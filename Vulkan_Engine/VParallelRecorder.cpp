@@ -0,0 +1,122 @@
+#include "VParallelRecorder.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+Vulkan_Engine::VParallelRecorder::VParallelRecorder()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VParallelRecorder::~VParallelRecorder()
+{
+	Stop();
+}
+
+void Vulkan_Engine::VParallelRecorder::Start(VkDevice device, uint32_t queueFamily, VJobSystem* jobs, uint32_t frameCount)
+{
+	Device = device;
+	Jobs = jobs;
+	uint32_t threadCount = std::max(1u, Jobs->GetWorkerCount());
+
+	VkCommandPoolCreateInfo PoolCreateInfo{};
+	PoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	PoolCreateInfo.queueFamilyIndex = queueFamily;
+	PoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	ThreadFrames.resize(threadCount, std::vector<ThreadFrame>(frameCount));
+	for (auto& frames : ThreadFrames)
+		for (auto& threadFrame : frames)
+			if (vkCreateCommandPool(Device, &PoolCreateInfo, nullptr, &threadFrame.Pool) != VK_SUCCESS)
+			{
+				Platform::SetConsoleColor(HConsole, 12);
+				throw std::runtime_error("ERROR :: Failed to create a recording thread command pool");
+				Platform::SetConsoleColor(HConsole, 15);
+			}
+
+	JobOutputs.resize(threadCount);
+	JobErrors.resize(threadCount);
+}
+
+void Vulkan_Engine::VParallelRecorder::Stop()
+{
+	//destroying a pool frees its command buffers
+	for (auto& frames : ThreadFrames)
+		for (auto& threadFrame : frames) vkDestroyCommandPool(Device, threadFrame.Pool, nullptr);
+	ThreadFrames.clear();
+}
+
+void Vulkan_Engine::VParallelRecorder::BeginFrame(uint32_t frame)
+{
+	//no recording job runs between two Record calls, submitting the jobs publishes the flags to the workers
+	CurrentFrame = frame;
+	for (auto& frames : ThreadFrames) frames[frame].ResetPending = true;
+}
+
+void Vulkan_Engine::VParallelRecorder::RecordChunk(uint32_t chunk)
+{
+	JobOutputs[chunk] = VK_NULL_HANDLE;
+	uint32_t first = static_cast<uint32_t>(uint64_t(JobDrawCount) * chunk / JobChunkCount);
+	uint32_t end = static_cast<uint32_t>(uint64_t(JobDrawCount) * (chunk + 1) / JobChunkCount);
+	if (first == end) return;
+
+	try {
+		//the pool of the worker running the chunk, the job system runs the jobs inline when it is stopped
+		uint32_t worker = Jobs->GetWorkerIndex();
+		ThreadFrame& threadFrame = ThreadFrames[worker < ThreadFrames.size() ? worker : 0][CurrentFrame];
+		if (threadFrame.ResetPending)
+		{
+			vkResetCommandPool(Device, threadFrame.Pool, 0);
+			threadFrame.Used = 0;
+			threadFrame.ResetPending = false;
+		}
+		if (threadFrame.Used == threadFrame.CommandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo AllocateInfo{};
+			AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			AllocateInfo.commandPool = threadFrame.Pool;
+			AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			AllocateInfo.commandBufferCount = 1;
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(Device, &AllocateInfo, &commandBuffer) != VK_SUCCESS)
+				throw std::runtime_error("ERROR :: Failed to allocate a secondary command buffer");
+			threadFrame.CommandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = threadFrame.CommandBuffers[threadFrame.Used++];
+
+		VkCommandBufferBeginInfo BeginInfo{};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		BeginInfo.pInheritanceInfo = JobInheritance;
+		if (vkBeginCommandBuffer(commandBuffer, &BeginInfo) != VK_SUCCESS)
+			throw std::runtime_error("ERROR :: Failed to begin a secondary command buffer");
+		(*JobRecord)(commandBuffer, first, end - first);
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("ERROR :: Failed to end a secondary command buffer");
+
+		JobOutputs[chunk] = commandBuffer;
+	}
+	catch (...) {
+		JobErrors[chunk] = std::current_exception();
+	}
+}
+
+void Vulkan_Engine::VParallelRecorder::Record(const VkCommandBufferInheritanceInfo& inheritance, uint32_t drawCount, uint32_t threadCount,
+	const RecordFunction& record, std::vector<VkCommandBuffer>& secondaries)
+{
+	threadCount = std::max(1u, std::min(threadCount, GetThreadCount()));
+	JobInheritance = &inheritance;
+	JobRecord = &record;
+	JobDrawCount = drawCount;
+	JobChunkCount = threadCount;
+	for (auto& error : JobErrors) error = nullptr;
+
+	JobCounter counter;
+	for (uint32_t chunk = 0; chunk < threadCount; chunk++) Jobs->Submit([this, chunk] { RecordChunk(chunk); }, &counter);
+	Jobs->Wait(counter);
+
+	for (uint32_t chunk = 0; chunk < threadCount; chunk++)
+		if (JobErrors[chunk]) std::rethrow_exception(JobErrors[chunk]);
+	for (uint32_t chunk = 0; chunk < threadCount; chunk++)
+		if (JobOutputs[chunk] != VK_NULL_HANDLE) secondaries.push_back(JobOutputs[chunk]);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VJobSystem.h"
+
+#include <vector>
+#include <functional>
+#include <exception>
+
+namespace Vulkan_Engine {
+
+	//records a draw list into secondary command buffers on the job system workers, for vkCmdExecuteCommands inside a render pass.
+	//every worker owns one command pool per frame in flight, so recording needs no lock and a frame resets its pools as a whole.
+	//the calling thread helps recording while it waits when it is a worker
+	class VParallelRecorder
+	{
+	public:
+
+		//records draws [first, first + count) of the draw list, the render pass state is inherited but nothing else is
+		using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)>;
+
+		VParallelRecorder();
+		~VParallelRecorder();
+
+		void Start(VkDevice device, uint32_t queueFamily, VJobSystem* jobs, uint32_t frameCount);
+		void Stop();
+
+		//the pools of frame are reset before their next use, the last submit of frame must be complete
+		void BeginFrame(uint32_t frame);
+		//splits drawCount draws in threadCount jobs (at most GetThreadCount()), one secondary command buffer per non empty chunk,
+		//appended to secondaries in draw order. Rethrows the first exception a recording job hit
+		void Record(const VkCommandBufferInheritanceInfo& inheritance, uint32_t drawCount, uint32_t threadCount,
+			const RecordFunction& record, std::vector<VkCommandBuffer>& secondaries);
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(ThreadFrames.size()); }
+
+	private:
+
+		struct ThreadFrame
+		{
+			VkCommandPool Pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> CommandBuffers; //kept across resets, reused in order
+			uint32_t Used = 0;
+			bool ResetPending = false;
+		};
+
+		void RecordChunk(uint32_t chunk);
+
+		VkDevice Device = VK_NULL_HANDLE;
+		VJobSystem* Jobs = nullptr;
+		std::vector<std::vector<ThreadFrame>> ThreadFrames; //[worker][frame]
+		uint32_t CurrentFrame = 0;
+
+		//current recording, written by the calling thread before the chunk jobs are submitted
+		const VkCommandBufferInheritanceInfo* JobInheritance = nullptr;
+		const RecordFunction* JobRecord = nullptr;
+		uint32_t JobDrawCount = 0;
+		uint32_t JobChunkCount = 0;
+		std::vector<VkCommandBuffer> JobOutputs; //[chunk]
+		std::vector<std::exception_ptr> JobErrors;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
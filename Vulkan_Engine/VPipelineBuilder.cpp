@@ -0,0 +1,160 @@
+#include "VPipelineBuilder.h"
+
+#include <chrono>
+#include <stdexcept>
+
+Vulkan_Engine::VPipelineBuilder::VPipelineBuilder()
+{
+}
+
+Vulkan_Engine::VPipelineBuilder::~VPipelineBuilder()
+{
+	Stop();
+}
+
+void Vulkan_Engine::VPipelineBuilder::Start(VkDevice device, VPipelineCache* cache, uint32_t threadCount, bool useCreationFeedback)
+{
+	Stop();
+
+	Device = device;
+	Cache = cache;
+	UseCreationFeedback = useCreationFeedback;
+	Stopping = false;
+
+	if (threadCount == 0) threadCount = 1;
+	for (uint32_t i = 0; i < threadCount; i++) {
+		Workers.emplace_back(&VPipelineBuilder::WorkerLoop, this);
+	}
+}
+
+void Vulkan_Engine::VPipelineBuilder::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(TasksMutex);
+		Stopping = true;
+	}
+	TasksCondition.notify_all();
+
+	//workers drain the queue before leaving, so every future handed out gets its value
+	for (auto& worker : Workers) worker.join();
+	Workers.clear();
+}
+
+std::future<VkPipeline> Vulkan_Engine::VPipelineBuilder::Submit(const PipelineDescription& description)
+{
+	std::packaged_task<VkPipeline()> task([this, description]() { return Compile(description); });
+	std::future<VkPipeline> result = task.get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(TasksMutex);
+		if (Workers.empty()) throw std::runtime_error("ERROR :: The pipeline builder has no worker thread");
+		Tasks.push(std::move(task));
+	}
+	TasksCondition.notify_one();
+
+	return result;
+}
+
+std::vector<std::future<VkPipeline>> Vulkan_Engine::VPipelineBuilder::Submit(const std::vector<PipelineDescription>& descriptions)
+{
+	std::vector<std::future<VkPipeline>> results;
+	results.reserve(descriptions.size());
+	for (const auto& description : descriptions) {
+		results.push_back(Submit(description));
+	}
+	return results;
+}
+
+VkPipeline Vulkan_Engine::VPipelineBuilder::Compile(const PipelineDescription& description)
+{
+	VkPipelineVertexInputStateCreateInfo VertexInputInfo{};
+	VertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(description.VertexBindings.size());
+	VertexInputInfo.pVertexBindingDescriptions = description.VertexBindings.data();
+	VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.VertexAttributes.size());
+	VertexInputInfo.pVertexAttributeDescriptions = description.VertexAttributes.data();
+
+	VkPipelineViewportStateCreateInfo ViewportState{};
+	ViewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	ViewportState.viewportCount = 1;
+	ViewportState.pViewports = &description.Viewport;
+	ViewportState.scissorCount = 1;
+	ViewportState.pScissors = &description.Scissor;
+
+	VkPipelineColorBlendStateCreateInfo ColorBlending = description.ColorBlending;
+	ColorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	ColorBlending.attachmentCount = static_cast<uint32_t>(description.ColorBlendAttachments.size());
+	ColorBlending.pAttachments = description.ColorBlendAttachments.data();
+
+	VkPipelineDynamicStateCreateInfo DynamicState{};
+	DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	DynamicState.dynamicStateCount = static_cast<uint32_t>(description.DynamicStates.size());
+	DynamicState.pDynamicStates = description.DynamicStates.data();
+
+	VkGraphicsPipelineCreateInfo PipelineCreationInfo{};
+	PipelineCreationInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	PipelineCreationInfo.stageCount = static_cast<uint32_t>(description.Stages.size());
+	PipelineCreationInfo.pStages = description.Stages.data();
+	PipelineCreationInfo.pVertexInputState = &VertexInputInfo;
+	PipelineCreationInfo.pInputAssemblyState = &description.InputAssembly;
+	PipelineCreationInfo.pViewportState = &ViewportState;
+	PipelineCreationInfo.pRasterizationState = &description.Rasterizer;
+	PipelineCreationInfo.pMultisampleState = &description.Multisampling;
+	PipelineCreationInfo.pDepthStencilState = description.UseDepthStencil ? &description.DepthStencil : nullptr;
+	PipelineCreationInfo.pColorBlendState = &ColorBlending;
+	PipelineCreationInfo.pDynamicState = description.DynamicStates.empty() ? nullptr : &DynamicState;
+	PipelineCreationInfo.layout = description.Layout;
+	PipelineCreationInfo.renderPass = description.RenderPass;
+	PipelineCreationInfo.subpass = description.Subpass;
+	PipelineCreationInfo.basePipelineHandle = VK_NULL_HANDLE;
+	PipelineCreationInfo.basePipelineIndex = -1;
+
+	//creation feedback tells whether the driver found the pipeline in the cache
+	VkPipelineCreationFeedbackEXT PipelineFeedback{};
+	std::vector<VkPipelineCreationFeedbackEXT> StagesFeedback(description.Stages.size());
+	VkPipelineCreationFeedbackCreateInfoEXT FeedbackCreateInfo{};
+	FeedbackCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+	FeedbackCreateInfo.pPipelineCreationFeedback = &PipelineFeedback;
+	FeedbackCreateInfo.pipelineStageCreationFeedbackCount = static_cast<uint32_t>(StagesFeedback.size());
+	FeedbackCreateInfo.pPipelineStageCreationFeedbacks = StagesFeedback.data();
+	if (UseCreationFeedback) PipelineCreationInfo.pNext = &FeedbackCreateInfo;
+
+	//without a render pass the pipeline is created for the attachment formats
+	VkPipelineRenderingCreateInfoKHR RenderingCreateInfo{};
+	if (description.RenderPass == VK_NULL_HANDLE)
+	{
+		RenderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		RenderingCreateInfo.pNext = PipelineCreationInfo.pNext;
+		RenderingCreateInfo.colorAttachmentCount = static_cast<uint32_t>(description.ColorFormats.size());
+		RenderingCreateInfo.pColorAttachmentFormats = description.ColorFormats.data();
+		RenderingCreateInfo.depthAttachmentFormat = description.DepthFormat;
+		PipelineCreationInfo.pNext = &RenderingCreateInfo;
+	}
+
+	VkPipeline Pipeline = VK_NULL_HANDLE;
+	auto creationStart = std::chrono::high_resolution_clock::now();
+	if (vkCreateGraphicsPipelines(Device, Cache ? Cache->Get() : VK_NULL_HANDLE, 1, &PipelineCreationInfo, nullptr, &Pipeline) != VK_SUCCESS) {
+		throw std::runtime_error("ERROR :: Failed to create the graphics pipeline");
+	}
+	auto creationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - creationStart);
+
+	if (Cache) Cache->RecordPipelineCreation(static_cast<uint64_t>(creationTime.count()), UseCreationFeedback ? &PipelineFeedback : nullptr);
+
+	return Pipeline;
+}
+
+void Vulkan_Engine::VPipelineBuilder::WorkerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<VkPipeline()> task;
+		{
+			std::unique_lock<std::mutex> lock(TasksMutex);
+			TasksCondition.wait(lock, [this]() { return Stopping || !Tasks.empty(); });
+			if (Tasks.empty()) return; //stopping and nothing left to build
+			task = std::move(Tasks.front());
+			Tasks.pop();
+		}
+		task(); //exceptions are stored in the future
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VPipelineCache.h"
+#include "VDynamicRendering.h"
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
+namespace Vulkan_Engine {
+
+	//self-contained description of a graphics pipeline, it owns every array VkGraphicsPipelineCreateInfo points to
+	//so it can be handed over to a worker thread. Shader modules, layout and render pass must outlive the build.
+	struct PipelineDescription
+	{
+		std::vector<VkPipelineShaderStageCreateInfo> Stages;
+		std::vector<VkVertexInputBindingDescription> VertexBindings;
+		std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+		VkPipelineInputAssemblyStateCreateInfo InputAssembly{};
+		VkViewport Viewport{};
+		VkRect2D Scissor{};
+		VkPipelineRasterizationStateCreateInfo Rasterizer{};
+		VkPipelineMultisampleStateCreateInfo Multisampling{};
+		bool UseDepthStencil = false;
+		VkPipelineDepthStencilStateCreateInfo DepthStencil{};
+		std::vector<VkPipelineColorBlendAttachmentState> ColorBlendAttachments;
+		VkPipelineColorBlendStateCreateInfo ColorBlending{};
+		std::vector<VkDynamicState> DynamicStates;
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		VkRenderPass RenderPass = VK_NULL_HANDLE;
+		uint32_t Subpass = 0;
+		//attachment formats of dynamic rendering, used when RenderPass is VK_NULL_HANDLE
+		std::vector<VkFormat> ColorFormats;
+		VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+	};
+
+	//pipeline build service, compiles batches of pipelines on a pool of worker threads sharing one pipeline cache
+	//(a VkPipelineCache not created with the externally synchronized flag may be used from several threads at once)
+	class VPipelineBuilder
+	{
+	public:
+
+		VPipelineBuilder();
+		~VPipelineBuilder();
+
+		//cache may be null, then pipelines are compiled without a pipeline cache
+		void Start(VkDevice device, VPipelineCache* cache, uint32_t threadCount, bool useCreationFeedback);
+		void Stop();
+
+		std::future<VkPipeline> Submit(const PipelineDescription& description);
+		std::vector<std::future<VkPipeline>> Submit(const std::vector<PipelineDescription>& descriptions);
+
+		//compiles on the calling thread, used by the serial path and by the workers
+		VkPipeline Compile(const PipelineDescription& description);
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(Workers.size()); }
+
+	private:
+
+		void WorkerLoop();
+
+		VkDevice Device = VK_NULL_HANDLE;
+		VPipelineCache* Cache = nullptr;
+		bool UseCreationFeedback = false;
+
+		//worker pool
+		std::vector<std::thread> Workers;
+		std::queue<std::packaged_task<VkPipeline()>> Tasks;
+		std::mutex TasksMutex;
+		std::condition_variable TasksCondition;
+		bool Stopping = false;
+	};
+
+};
@@ -0,0 +1,192 @@
+#include "VPipelineCache.h"
+#include "VHash.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+	const uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x43504556; // "VEPC"
+	const uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+}
+
+Vulkan_Engine::VPipelineCache::VPipelineCache()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VPipelineCache::~VPipelineCache()
+{
+	Destroy();
+}
+
+void Vulkan_Engine::VPipelineCache::Create(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path)
+{
+	Device = device;
+	Properties = properties;
+	Path = path;
+
+	std::vector<uint8_t> data;
+	LoadedFromDisk = LoadFromDisk(data);
+
+	VkPipelineCacheCreateInfo CacheCreateInfo{};
+	CacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	CacheCreateInfo.initialDataSize = LoadedFromDisk ? data.size() : 0;
+	CacheCreateInfo.pInitialData = LoadedFromDisk ? data.data() : nullptr;
+
+	if (vkCreatePipelineCache(Device, &CacheCreateInfo, nullptr, &Cache) != VK_SUCCESS)
+	{
+		//the driver may still reject a blob we considered valid, retry with an empty cache before giving up
+		CacheCreateInfo.initialDataSize = 0;
+		CacheCreateInfo.pInitialData = nullptr;
+		LoadedFromDisk = false;
+		if (vkCreatePipelineCache(Device, &CacheCreateInfo, nullptr, &Cache) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create the pipeline cache");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
+
+	Platform::SetConsoleColor(HConsole, 6);
+	if (LoadedFromDisk) std::cout << "\nPipeline cache : loaded " << data.size() << " bytes from " << Path << " (warm start)\n";
+	else std::cout << "\nPipeline cache : no valid cache in " << Path << " (cold start)\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VPipelineCache::Destroy()
+{
+	if (Cache == VK_NULL_HANDLE) return;
+
+	PrintStatistics();
+	Save();
+	vkDestroyPipelineCache(Device, Cache, nullptr);
+	Cache = VK_NULL_HANDLE;
+}
+
+bool Vulkan_Engine::VPipelineCache::Save()
+{
+	if (Cache == VK_NULL_HANDLE) return false;
+
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(Device, Cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) return false;
+	std::vector<uint8_t> data(dataSize);
+	if (vkGetPipelineCacheData(Device, Cache, &dataSize, data.data()) != VK_SUCCESS) return false;
+	data.resize(dataSize);
+
+	PipelineCacheFileHeader header{};
+	header.magic = PIPELINE_CACHE_FILE_MAGIC;
+	header.fileVersion = PIPELINE_CACHE_FILE_VERSION;
+	header.vendorID = Properties.vendorID;
+	header.deviceID = Properties.deviceID;
+	header.driverVersion = Properties.driverVersion;
+	std::memcpy(header.pipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = data.size();
+	header.dataHash = HashFNV1a(data.data(), data.size());
+	header.coldCreationTimeNs = LoadedFromDisk ? PreviousColdCreationTimeNs : CreationTimeNs.load();
+
+	std::string temporaryPath = Path + ".tmp";
+	{
+		std::ofstream cacheFile(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!cacheFile.is_open()) return false;
+		cacheFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		cacheFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+		cacheFile.flush();
+		if (!cacheFile.good())
+		{
+			cacheFile.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	if (!Platform::ReplaceFileAtomic(temporaryPath, Path))
+	{
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void Vulkan_Engine::VPipelineCache::RecordPipelineCreation(uint64_t creationTimeNs, const VkPipelineCreationFeedbackEXT* feedback)
+{
+	PipelinesCreated++;
+	CreationTimeNs += creationTimeNs;
+
+	if (feedback == nullptr || !(feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)) Unknown++;
+	else if (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) Hits++;
+	else Misses++;
+}
+
+void Vulkan_Engine::VPipelineCache::PrintStatistics()
+{
+	double creationMs = CreationTimeNs.load() / 1000000.0;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nPipeline cache statistics (" << (LoadedFromDisk ? "warm" : "cold") << " start)\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "pipelines created : " << PipelinesCreated.load() << " in " << creationMs << " ms\n";
+	std::cout << "cache hits : " << Hits.load() << "\tmisses : " << Misses.load();
+	if (Unknown.load()) std::cout << "\tunknown (no creation feedback) : " << Unknown.load();
+	std::cout << '\n';
+
+	if (LoadedFromDisk && PreviousColdCreationTimeNs)
+	{
+		double coldMs = PreviousColdCreationTimeNs / 1000000.0;
+		std::cout << "cold start : " << coldMs << " ms\twarm start : " << creationMs << " ms";
+		if (creationMs > 0.0) std::cout << "\t(" << coldMs / creationMs << "x)";
+		std::cout << '\n';
+	}
+}
+
+bool Vulkan_Engine::VPipelineCache::LoadFromDisk(std::vector<uint8_t>& data)
+{
+	std::ifstream cacheFile(Path, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!cacheFile.is_open()) return false;
+
+	size_t fileSize = (size_t)cacheFile.tellg();
+	if (fileSize < sizeof(PipelineCacheFileHeader)) return false;
+	cacheFile.seekg(0, std::ios::beg);
+
+	PipelineCacheFileHeader header{};
+	cacheFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!ValidateHeader(header) || header.dataSize != fileSize - sizeof(header)) return false;
+
+	data.resize(static_cast<size_t>(header.dataSize));
+	cacheFile.read(reinterpret_cast<char*>(data.data()), data.size());
+	if (!cacheFile.good() || HashFNV1a(data.data(), data.size()) != header.dataHash)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << "\nPipeline cache : " << Path << " is corrupted, ignoring it\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		return false;
+	}
+
+	//the driver's own header (VkPipelineCacheHeaderVersionOne) must describe the same device too
+	if (data.size() < 16 + VK_UUID_SIZE) return false;
+	uint32_t driverHeader[4];
+	std::memcpy(driverHeader, data.data(), sizeof(driverHeader));
+	if (driverHeader[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || driverHeader[2] != Properties.vendorID || driverHeader[3] != Properties.deviceID) return false;
+	if (std::memcmp(data.data() + 16, Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) return false;
+
+	PreviousColdCreationTimeNs = header.coldCreationTimeNs;
+	return true;
+}
+
+bool Vulkan_Engine::VPipelineCache::ValidateHeader(const PipelineCacheFileHeader& header)
+{
+	if (header.magic != PIPELINE_CACHE_FILE_MAGIC || header.fileVersion != PIPELINE_CACHE_FILE_VERSION) return false;
+
+	if (header.vendorID != Properties.vendorID || header.deviceID != Properties.deviceID || header.driverVersion != Properties.driverVersion
+		|| std::memcmp(header.pipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		Platform::SetConsoleColor(HConsole, 6);
+		std::cout << "\nPipeline cache : " << Path << " was produced by another device or driver, rebuilding it\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//on-disk file header written in front of the driver's pipeline cache data
+	//the driver blob is only reused when the device and driver it was produced by are the same
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t fileVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+		uint64_t coldCreationTimeNs; //pipeline creation time measured when the cache was built from scratch
+	};
+
+	class VPipelineCache
+	{
+	public:
+
+		VPipelineCache();
+		~VPipelineCache();
+
+		//loads the cache file when it exists and matches the device, otherwise starts with an empty cache
+		void Create(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path);
+		//saves the cache to disk then destroys it
+		void Destroy();
+		//writes to a temporary file then renames it over the cache file so a crash never leaves a truncated cache
+		bool Save();
+
+		VkPipelineCache Get() const { return Cache; }
+		bool IsWarm() const { return LoadedFromDisk; }
+
+		//feedback may be null when VK_EXT_pipeline_creation_feedback is not enabled
+		void RecordPipelineCreation(uint64_t creationTimeNs, const VkPipelineCreationFeedbackEXT* feedback);
+
+		uint32_t GetHits() const { return Hits; }
+		uint32_t GetMisses() const { return Misses; }
+		void PrintStatistics();
+
+	private:
+
+		bool LoadFromDisk(std::vector<uint8_t>& data);
+		bool ValidateHeader(const PipelineCacheFileHeader& header);
+
+		VkDevice Device = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties Properties{};
+		VkPipelineCache Cache = VK_NULL_HANDLE;
+		std::string Path;
+		bool LoadedFromDisk = false;
+
+		//statistics, updated from any thread that creates pipelines through the cache
+		std::atomic<uint32_t> Hits{ 0 };
+		std::atomic<uint32_t> Misses{ 0 };
+		std::atomic<uint32_t> Unknown{ 0 };
+		std::atomic<uint32_t> PipelinesCreated{ 0 };
+		std::atomic<uint64_t> CreationTimeNs{ 0 };
+		uint64_t PreviousColdCreationTimeNs = 0;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
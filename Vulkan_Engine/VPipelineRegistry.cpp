@@ -0,0 +1,377 @@
+#include "VPipelineRegistry.h"
+#include "VHash.h"
+
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+	//bit of a dynamic state in the mask : core states keep their value, extended dynamic state ones follow
+	int DynamicStateBit(VkDynamicState state)
+	{
+		if (state <= VK_DYNAMIC_STATE_STENCIL_REFERENCE) return static_cast<int>(state);
+		if (state >= VK_DYNAMIC_STATE_CULL_MODE_EXT && state <= VK_DYNAMIC_STATE_STENCIL_OP_EXT)
+			return 9 + static_cast<int>(state - VK_DYNAMIC_STATE_CULL_MODE_EXT);
+		return -1;
+	}
+
+	bool IsDynamic(uint32_t mask, VkDynamicState state)
+	{
+		int bit = DynamicStateBit(state);
+		return bit >= 0 && (mask & (1u << bit)) != 0;
+	}
+
+	//a dynamic topology only has to match the topology class of the pipeline
+	uint32_t TopologyClass(VkPrimitiveTopology topology)
+	{
+		switch (topology)
+		{
+		case VK_PRIMITIVE_TOPOLOGY_POINT_LIST: return 0;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY: return 1;
+		case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST: return 3;
+		default: return 2;
+		}
+	}
+
+	uint64_t PackOp(VkBlendOp op)
+	{
+		//advanced blend ops do not fit, they are marked here and hashed in StateHash
+		return op <= VK_BLEND_OP_MAX ? static_cast<uint64_t>(op) : 7;
+	}
+
+	uint64_t Mix(uint64_t hash, uint64_t value)
+	{
+		hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+
+	template<typename T>
+	uint64_t HashValue(const T& value, uint64_t seed)
+	{
+		return Vulkan_Engine::HashFNV1a(&value, sizeof(T), seed);
+	}
+}
+
+bool Vulkan_Engine::PipelineKey::operator==(const PipelineKey& other) const
+{
+	return ShaderHash == other.ShaderHash && VertexInputHash == other.VertexInputHash && RenderPassKey == other.RenderPassKey
+		&& LayoutKey == other.LayoutKey && RasterBits == other.RasterBits && BlendBits == other.BlendBits && StateHash == other.StateHash;
+}
+
+Vulkan_Engine::VPipelineRegistry::VPipelineRegistry()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VPipelineRegistry::~VPipelineRegistry()
+{
+	Destroy();
+}
+
+void Vulkan_Engine::VPipelineRegistry::Create(VkDevice device, uint32_t initialCapacity)
+{
+	Device = device;
+	uint32_t capacity = 8;
+	while (capacity < initialCapacity) capacity *= 2;
+	Slots.assign(capacity, Slot{});
+	Count = 0;
+	Hits = Misses = Probes = 0;
+	LongestProbe = 0;
+}
+
+void Vulkan_Engine::VPipelineRegistry::Destroy()
+{
+	if (Device == VK_NULL_HANDLE) return;
+
+	PrintStatistics();
+	for (VkPipeline pipeline : Clear()) vkDestroyPipeline(Device, pipeline, nullptr);
+	Slots.clear();
+	Device = VK_NULL_HANDLE;
+}
+
+uint64_t Vulkan_Engine::VPipelineRegistry::HashKey(const PipelineKey& key)
+{
+	//the fields are hashes or packed bits already, mixing them is enough
+	uint64_t hash = key.ShaderHash;
+	hash = Mix(hash, key.VertexInputHash);
+	hash = Mix(hash, key.RenderPassKey);
+	hash = Mix(hash, key.LayoutKey);
+	hash = Mix(hash, key.RasterBits);
+	hash = Mix(hash, key.BlendBits);
+	hash = Mix(hash, key.StateHash);
+	return hash ^ (hash >> 29);
+}
+
+uint32_t Vulkan_Engine::VPipelineRegistry::Probe(const PipelineKey& key, uint64_t hash, uint32_t& probeLength) const
+{
+	//linear probing, the table is never full so the loop always ends on an empty slot
+	uint32_t mask = static_cast<uint32_t>(Slots.size()) - 1;
+	for (uint32_t slot = static_cast<uint32_t>(hash) & mask;; slot = (slot + 1) & mask)
+	{
+		probeLength++;
+		const Slot& candidate = Slots[slot];
+		if (candidate.Pipeline == VK_NULL_HANDLE) return slot;
+		if (candidate.Hash == hash && candidate.Key == key) return slot;
+	}
+}
+
+VkPipeline Vulkan_Engine::VPipelineRegistry::Find(const PipelineKey& key) const
+{
+	if (Slots.empty()) return VK_NULL_HANDLE;
+	uint32_t probeLength = 0;
+	return Slots[Probe(key, HashKey(key), probeLength)].Pipeline;
+}
+
+void Vulkan_Engine::VPipelineRegistry::Insert(const PipelineKey& key, VkPipeline pipeline)
+{
+	if (pipeline == VK_NULL_HANDLE) return;
+	if (Slots.empty()) Slots.assign(8, Slot{});
+	if ((Count + 1) * 4 > Slots.size() * 3) Grow();
+
+	uint64_t hash = HashKey(key);
+	uint32_t probeLength = 0;
+	Slot& slot = Slots[Probe(key, hash, probeLength)];
+	if (slot.Pipeline == VK_NULL_HANDLE) Count++;
+	slot.Key = key;
+	slot.Hash = hash;
+	slot.Pipeline = pipeline;
+}
+
+void Vulkan_Engine::VPipelineRegistry::Grow()
+{
+	std::vector<Slot> previous(Slots.size() * 2, Slot{});
+	previous.swap(Slots);
+
+	uint32_t mask = static_cast<uint32_t>(Slots.size()) - 1;
+	for (const Slot& slot : previous)
+	{
+		if (slot.Pipeline == VK_NULL_HANDLE) continue;
+		uint32_t index = static_cast<uint32_t>(slot.Hash) & mask;
+		while (Slots[index].Pipeline != VK_NULL_HANDLE) index = (index + 1) & mask;
+		Slots[index] = slot;
+	}
+}
+
+std::vector<VkPipeline> Vulkan_Engine::VPipelineRegistry::Clear()
+{
+	std::vector<VkPipeline> pipelines;
+	pipelines.reserve(Count);
+	for (Slot& slot : Slots)
+	{
+		if (slot.Pipeline != VK_NULL_HANDLE) pipelines.push_back(slot.Pipeline);
+		slot = Slot{};
+	}
+	Count = 0;
+	return pipelines;
+}
+
+void Vulkan_Engine::VPipelineRegistry::PrintStatistics()
+{
+	uint64_t lookups = Hits + Misses;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nPipeline registry statistics\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "pipelines : " << Count << "\tslots : " << Slots.size() << '\n';
+	std::cout << "lookups : " << lookups << "\thits : " << Hits << "\tmisses (compiled) : " << Misses;
+	if (lookups) std::cout << "\thit rate : " << 100.0 * Hits / lookups << " %";
+	std::cout << '\n';
+	if (lookups) std::cout << "average probe length : " << double(Probes) / lookups << "\tlongest : " << LongestProbe << '\n';
+}
+
+uint32_t Vulkan_Engine::VPipelineRegistry::MakeDynamicStateMask(const std::vector<VkDynamicState>& dynamicStates)
+{
+	uint32_t mask = 0;
+	for (VkDynamicState state : dynamicStates)
+	{
+		int bit = DynamicStateBit(state);
+		if (bit >= 0) mask |= 1u << bit;
+	}
+	return mask;
+}
+
+uint64_t Vulkan_Engine::VPipelineRegistry::PackRasterBits(const VkPipelineInputAssemblyStateCreateInfo& inputAssembly, const VkPipelineRasterizationStateCreateInfo& rasterizer,
+	const VkPipelineDepthStencilStateCreateInfo& depthStencil, bool useDepthStencil, uint32_t dynamicStateMask)
+{
+	uint64_t topology = IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT) ? uint64_t(TopologyClass(inputAssembly.topology)) : uint64_t(inputAssembly.topology);
+	uint64_t cullMode = IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_CULL_MODE_EXT) ? 0 : rasterizer.cullMode;
+	uint64_t frontFace = IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_FRONT_FACE_EXT) ? 0 : rasterizer.frontFace;
+
+	uint64_t bits = 0;
+	bits |= (topology & 0xF);
+	bits |= uint64_t(inputAssembly.primitiveRestartEnable != VK_FALSE) << 4;
+	bits |= uint64_t(rasterizer.polygonMode & 0x3) << 5;
+	bits |= (cullMode & 0x3) << 7;
+	bits |= (frontFace & 0x1) << 9;
+	bits |= uint64_t(rasterizer.depthClampEnable != VK_FALSE) << 10;
+	bits |= uint64_t(rasterizer.rasterizerDiscardEnable != VK_FALSE) << 11;
+	bits |= uint64_t(rasterizer.depthBiasEnable != VK_FALSE) << 12;
+
+	//without a depth/stencil state the pipeline ignores all of it
+	if (useDepthStencil)
+	{
+		if (!IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT)) bits |= uint64_t(depthStencil.depthTestEnable != VK_FALSE) << 13;
+		if (!IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT)) bits |= uint64_t(depthStencil.depthWriteEnable != VK_FALSE) << 14;
+		if (!IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT)) bits |= uint64_t(depthStencil.depthCompareOp & 0x7) << 15;
+		if (!IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE_EXT)) bits |= uint64_t(depthStencil.depthBoundsTestEnable != VK_FALSE) << 18;
+		if (!IsDynamic(dynamicStateMask, VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT)) bits |= uint64_t(depthStencil.stencilTestEnable != VK_FALSE) << 19;
+		bits |= uint64_t(1) << 20;
+	}
+
+	bits |= uint64_t(dynamicStateMask) << 32;
+	return bits;
+}
+
+uint64_t Vulkan_Engine::VPipelineRegistry::HashRenderPass(const VkRenderPassCreateInfo& renderPassInfo)
+{
+	//only what render pass compatibility depends on : load/store ops and layouts are left out
+	uint64_t hash = HashValue(renderPassInfo.attachmentCount, FNV1A_OFFSET_BASIS);
+	for (uint32_t i = 0; i < renderPassInfo.attachmentCount; i++)
+	{
+		hash = HashValue(renderPassInfo.pAttachments[i].format, hash);
+		hash = HashValue(renderPassInfo.pAttachments[i].samples, hash);
+	}
+
+	auto hashReferences = [&hash](const VkAttachmentReference* references, uint32_t count) {
+		hash = HashValue(count, hash);
+		for (uint32_t i = 0; references && i < count; i++) hash = HashValue(references[i].attachment, hash);
+	};
+
+	hash = HashValue(renderPassInfo.subpassCount, hash);
+	for (uint32_t i = 0; i < renderPassInfo.subpassCount; i++)
+	{
+		const VkSubpassDescription& subpass = renderPassInfo.pSubpasses[i];
+		hash = HashValue(subpass.pipelineBindPoint, hash);
+		hashReferences(subpass.pInputAttachments, subpass.inputAttachmentCount);
+		hashReferences(subpass.pColorAttachments, subpass.colorAttachmentCount);
+		hashReferences(subpass.pResolveAttachments, subpass.pResolveAttachments ? subpass.colorAttachmentCount : 0);
+		hashReferences(subpass.pDepthStencilAttachment, subpass.pDepthStencilAttachment ? 1 : 0);
+	}
+
+	if (renderPassInfo.dependencyCount)
+		hash = HashFNV1a(renderPassInfo.pDependencies, renderPassInfo.dependencyCount * sizeof(VkSubpassDependency), hash);
+	return hash;
+}
+
+uint64_t Vulkan_Engine::VPipelineRegistry::HashAttachmentFormats(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat)
+{
+	//a different seed than HashRenderPass, a format list never matches a render pass
+	uint64_t hash = HashValue(colorFormats.size(), HashFNV1a("dynamic rendering"));
+	for (const auto& format : colorFormats) hash = HashValue(format, hash);
+	return HashValue(depthFormat, hash);
+}
+
+Vulkan_Engine::PipelineKey Vulkan_Engine::VPipelineRegistry::MakeKey(const PipelineDescription& description, uint64_t shaderHash, uint64_t renderPassKey)
+{
+	uint32_t dynamicMask = MakeDynamicStateMask(description.DynamicStates);
+
+	PipelineKey key{};
+	key.ShaderHash = shaderHash;
+	key.RenderPassKey = HashValue(description.Subpass, renderPassKey);
+	std::memcpy(&key.LayoutKey, &description.Layout, sizeof(description.Layout));
+	key.RasterBits = PackRasterBits(description.InputAssembly, description.Rasterizer, description.DepthStencil, description.UseDepthStencil, dynamicMask);
+
+	uint64_t vertexHash = HashValue(description.VertexBindings.size(), FNV1A_OFFSET_BASIS);
+	if (!description.VertexBindings.empty())
+		vertexHash = HashFNV1a(description.VertexBindings.data(), description.VertexBindings.size() * sizeof(VkVertexInputBindingDescription), vertexHash);
+	if (!description.VertexAttributes.empty())
+		vertexHash = HashFNV1a(description.VertexAttributes.data(), description.VertexAttributes.size() * sizeof(VkVertexInputAttributeDescription), vertexHash);
+	key.VertexInputHash = vertexHash;
+
+	//first attachment and multisampling, packed
+	const VkPipelineMultisampleStateCreateInfo& multisampling = description.Multisampling;
+	uint64_t samplesLog2 = 0;
+	while ((1u << samplesLog2) < static_cast<uint32_t>(multisampling.rasterizationSamples)) samplesLog2++;
+
+	uint64_t blend = 0;
+	if (!description.ColorBlendAttachments.empty())
+	{
+		const VkPipelineColorBlendAttachmentState& attachment = description.ColorBlendAttachments[0];
+		blend |= uint64_t(attachment.blendEnable != VK_FALSE);
+		if (attachment.blendEnable)
+		{
+			blend |= uint64_t(attachment.srcColorBlendFactor & 0x1F) << 1;
+			blend |= uint64_t(attachment.dstColorBlendFactor & 0x1F) << 6;
+			blend |= PackOp(attachment.colorBlendOp) << 11;
+			blend |= uint64_t(attachment.srcAlphaBlendFactor & 0x1F) << 14;
+			blend |= uint64_t(attachment.dstAlphaBlendFactor & 0x1F) << 19;
+			blend |= PackOp(attachment.alphaBlendOp) << 24;
+		}
+		blend |= uint64_t(attachment.colorWriteMask & 0xF) << 27;
+	}
+	blend |= (samplesLog2 & 0x7) << 31;
+	blend |= uint64_t(multisampling.sampleShadingEnable != VK_FALSE) << 34;
+	blend |= uint64_t(multisampling.alphaToCoverageEnable != VK_FALSE) << 35;
+	blend |= uint64_t(multisampling.alphaToOneEnable != VK_FALSE) << 36;
+	blend |= uint64_t(description.ColorBlending.logicOpEnable != VK_FALSE) << 37;
+	if (description.ColorBlending.logicOpEnable) blend |= uint64_t(description.ColorBlending.logicOp & 0xF) << 38;
+	blend |= uint64_t(description.ColorBlendAttachments.size() & 0xFF) << 48;
+	key.BlendBits = blend;
+
+	//the rest, only the parts that are not dynamic
+	uint64_t state = FNV1A_OFFSET_BASIS;
+	for (const auto& stage : description.Stages)
+	{
+		state = HashValue(stage.stage, state);
+		if (stage.pSpecializationInfo)
+		{
+			const VkSpecializationInfo& specialization = *stage.pSpecializationInfo;
+			if (specialization.mapEntryCount)
+				state = HashFNV1a(specialization.pMapEntries, specialization.mapEntryCount * sizeof(VkSpecializationMapEntry), state);
+			if (specialization.dataSize) state = HashFNV1a(specialization.pData, specialization.dataSize, state);
+		}
+	}
+	if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_VIEWPORT)) state = HashValue(description.Viewport, state);
+	if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_SCISSOR)) state = HashValue(description.Scissor, state);
+	if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_LINE_WIDTH)) state = HashValue(description.Rasterizer.lineWidth, state);
+	if (description.Rasterizer.depthBiasEnable && !IsDynamic(dynamicMask, VK_DYNAMIC_STATE_DEPTH_BIAS))
+	{
+		state = HashValue(description.Rasterizer.depthBiasConstantFactor, state);
+		state = HashValue(description.Rasterizer.depthBiasClamp, state);
+		state = HashValue(description.Rasterizer.depthBiasSlopeFactor, state);
+	}
+	if (multisampling.sampleShadingEnable) state = HashValue(multisampling.minSampleShading, state);
+	if (multisampling.pSampleMask) state = HashFNV1a(multisampling.pSampleMask, ((multisampling.rasterizationSamples + 31) / 32) * sizeof(VkSampleMask), state);
+
+	if (description.UseDepthStencil)
+	{
+		const VkPipelineDepthStencilStateCreateInfo& depthStencil = description.DepthStencil;
+		if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_DEPTH_BOUNDS))
+		{
+			state = HashValue(depthStencil.minDepthBounds, state);
+			state = HashValue(depthStencil.maxDepthBounds, state);
+		}
+		for (const VkStencilOpState* face : { &depthStencil.front, &depthStencil.back })
+		{
+			if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_STENCIL_OP_EXT))
+			{
+				state = HashValue(face->failOp, state);
+				state = HashValue(face->passOp, state);
+				state = HashValue(face->depthFailOp, state);
+				state = HashValue(face->compareOp, state);
+			}
+			if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK)) state = HashValue(face->compareMask, state);
+			if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_STENCIL_WRITE_MASK)) state = HashValue(face->writeMask, state);
+			if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_STENCIL_REFERENCE)) state = HashValue(face->reference, state);
+		}
+	}
+
+	if (!IsDynamic(dynamicMask, VK_DYNAMIC_STATE_BLEND_CONSTANTS))
+		state = HashFNV1a(description.ColorBlending.blendConstants, sizeof(description.ColorBlending.blendConstants), state);
+	for (size_t i = 0; i < description.ColorBlendAttachments.size(); i++)
+	{
+		const VkPipelineColorBlendAttachmentState& attachment = description.ColorBlendAttachments[i];
+		bool advanced = attachment.colorBlendOp > VK_BLEND_OP_MAX || attachment.alphaBlendOp > VK_BLEND_OP_MAX;
+		if (i > 0 || advanced) state = HashValue(attachment, state);
+	}
+
+	//dynamic states outside of the mask (vendor extensions...)
+	for (VkDynamicState dynamicState : description.DynamicStates)
+		if (DynamicStateBit(dynamicState) < 0) state = HashValue(dynamicState, state);
+
+	key.StateHash = state;
+	return key;
+}
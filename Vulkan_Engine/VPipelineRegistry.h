@@ -0,0 +1,110 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VPipelineBuilder.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//canonical, fixed size identity of a graphics pipeline
+	//state that is dynamic in the pipeline is left out, so descriptions only differing by it share one pipeline
+	struct PipelineKey
+	{
+		uint64_t ShaderHash;      //SPIR-V and entry point of every stage
+		uint64_t VertexInputHash;
+		uint64_t RenderPassKey;   //render pass compatibility (attachment formats and samples, subpasses) and subpass index, attachment formats with dynamic rendering
+		uint64_t LayoutKey;
+		uint64_t RasterBits;      //packed input assembly, rasterizer and depth/stencil bits, dynamic state mask
+		uint64_t BlendBits;       //packed blend state of the first attachment and multisampling bits
+		uint64_t StateHash;       //everything that does not fit the bits : static viewport/scissor, blend constants, other attachments...
+
+		bool operator==(const PipelineKey& other) const;
+	};
+
+	//pipeline state object registry, an open addressing hash table from PipelineKey to VkPipeline
+	//lookups never allocate, only a miss (compile + insert) may grow the table. Not thread safe, owned by the render thread.
+	class VPipelineRegistry
+	{
+	public:
+
+		VPipelineRegistry();
+		~VPipelineRegistry();
+
+		void Create(VkDevice device, uint32_t initialCapacity = 64);
+		//prints the statistics and destroys every registered pipeline
+		void Destroy();
+
+		//returns the registered pipeline, or VK_NULL_HANDLE, without touching the statistics
+		VkPipeline Find(const PipelineKey& key) const;
+		//a hit returns the registered pipeline, a miss calls compile() and registers what it returns
+		template<typename Compile>
+		VkPipeline Get(const PipelineKey& key, Compile&& compile);
+		void Insert(const PipelineKey& key, VkPipeline pipeline);
+		//unregisters every pipeline and hands them back, e.g. to be destroyed once the frames using them are done
+		std::vector<VkPipeline> Clear();
+
+		uint32_t GetCount() const { return Count; }
+		uint64_t GetHits() const { return Hits; }
+		uint64_t GetMisses() const { return Misses; }
+		void PrintStatistics();
+
+		//canonicalization
+		static PipelineKey MakeKey(const PipelineDescription& description, uint64_t shaderHash, uint64_t renderPassKey);
+		static uint32_t MakeDynamicStateMask(const std::vector<VkDynamicState>& dynamicStates);
+		static uint64_t PackRasterBits(const VkPipelineInputAssemblyStateCreateInfo& inputAssembly, const VkPipelineRasterizationStateCreateInfo& rasterizer,
+			const VkPipelineDepthStencilStateCreateInfo& depthStencil, bool useDepthStencil, uint32_t dynamicStateMask);
+		static uint64_t HashRenderPass(const VkRenderPassCreateInfo& renderPassInfo);
+		//what replaces the render pass key with dynamic rendering, the pipelines match the attachment formats only
+		static uint64_t HashAttachmentFormats(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat);
+
+	private:
+
+		struct Slot
+		{
+			PipelineKey Key;
+			uint64_t Hash;
+			VkPipeline Pipeline; //VK_NULL_HANDLE marks an empty slot
+		};
+
+		static uint64_t HashKey(const PipelineKey& key);
+		//index of the slot holding key, or of the empty slot where it would go
+		uint32_t Probe(const PipelineKey& key, uint64_t hash, uint32_t& probeLength) const;
+		void Grow();
+
+		VkDevice Device = VK_NULL_HANDLE;
+		std::vector<Slot> Slots;  //power of two size, at most 3/4 full
+		uint32_t Count = 0;
+
+		//statistics
+		uint64_t Hits = 0;
+		uint64_t Misses = 0;
+		uint64_t Probes = 0;      //slots looked at by the counted lookups
+		uint32_t LongestProbe = 0;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+	template<typename Compile>
+	VkPipeline VPipelineRegistry::Get(const PipelineKey& key, Compile&& compile)
+	{
+		uint64_t hash = HashKey(key);
+		uint32_t probeLength = 0;
+		uint32_t slot = Probe(key, hash, probeLength);
+		Probes += probeLength;
+		if (probeLength > LongestProbe) LongestProbe = probeLength;
+
+		if (Slots[slot].Pipeline != VK_NULL_HANDLE)
+		{
+			Hits++;
+			return Slots[slot].Pipeline;
+		}
+
+		Misses++;
+		VkPipeline pipeline = compile();
+		Insert(key, pipeline);
+		return pipeline;
+	}
+
+};
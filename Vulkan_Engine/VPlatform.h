@@ -0,0 +1,94 @@
+#pragma once
+
+//platform abstraction layer, everything that differs between Windows and Linux goes through here
+//the Win32 backend lives in VPlatformWin32.cpp and the Linux backend in VPlatformLinux.cpp, the window surface in VPlatformSurface.cpp
+//so that the rest links without the Vulkan loader and GLFW
+
+#if defined _WIN32
+#define NOMINMAX //avoid windows vc++ defined min/max funcs
+#define VK_USE_PLATFORM_WIN32_KHR
+#include <Windows.h>
+#endif
+//on linux no VK_USE_PLATFORM_* is needed, GLFW creates the xcb/xlib/wayland surface for us
+#include <vulkan/vulkan.h>
+
+#define GLFW_INCLUDE_VULKAN
+#if defined _WIN32
+#define GLFW_DLL
+#endif
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	namespace Platform {
+
+#if defined _WIN32
+		typedef HANDLE ConsoleHandle;
+		typedef HANDLE ProcessHandle;
+#else
+		typedef int ConsoleHandle; //file descriptor of the console output
+		typedef int ProcessHandle; //pid of the child process
+#endif
+
+		//read-only view of a whole file, the view stays valid until UnmapFile
+		struct MappedFile
+		{
+			const void* Data = nullptr;
+			size_t Size = 0;
+		};
+
+		//non-recursive watch of the files of one directory, must not move once started (the OS writes into it)
+		struct DirectoryWatch
+		{
+#if defined _WIN32
+			HANDLE Directory = INVALID_HANDLE_VALUE;
+			OVERLAPPED Overlapped{};
+			DWORD Buffer[1024];
+#else
+			int Notify = -1; //inotify instance
+#endif
+		};
+
+		//console
+		ConsoleHandle GetConsole();
+		//color uses the Win32 console attribute codes (15 white, 14 yellow, 12 red, 11 cyan, 9 blue, 6 dark yellow)
+		void SetConsoleColor(ConsoleHandle console, int color);
+
+		//surface
+		VkResult CreateSurface(VkInstance instance, GLFWwindow* window, VkSurfaceKHR* surface);
+
+		//processes, arguments[0] is the executable, searched in the PATH
+		bool StartProcess(const std::vector<std::string>& arguments, ProcessHandle& process);
+		//returns the exit code of the process, -1 when it could not be waited for
+		int WaitProcess(ProcessHandle process);
+		//runs the process to completion and collects its standard output, returns the exit code, -1 when it could not be started
+		int RunProcess(const std::vector<std::string>& arguments, std::string& output);
+
+		//files, replaces destination atomically with source
+		bool ReplaceFileAtomic(const std::string& source, const std::string& destination);
+		//maps the file read-only into the address space, fails on missing or empty files
+		bool MapFile(const std::string& path, MappedFile& mapping);
+		void UnmapFile(MappedFile& mapping);
+
+		//file watching, PollDirectoryChanges never blocks and returns the names of the files written since the last call
+		bool WatchDirectory(const std::string& directory, DirectoryWatch& watch);
+		std::vector<std::string> PollDirectoryChanges(DirectoryWatch& watch);
+		void CloseDirectoryWatch(DirectoryWatch& watch);
+
+		//threads, pins the calling thread to one logical core, false when the core does not exist or the OS refused
+		bool PinCurrentThread(uint32_t core);
+		//sleeps at least seconds with the finest timer the OS offers, it may still oversleep by the scheduler quantum
+		void SleepPrecise(double seconds);
+
+		//glslc executable used to build the shaders
+		std::string ShaderCompilerExecutable();
+
+		const char* GetPlatformName();
+	}
+
+};
@@ -0,0 +1,211 @@
+#include "VPlatform.h"
+
+#if defined __linux__
+
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+
+extern char** environ;
+
+Vulkan_Engine::Platform::ConsoleHandle Vulkan_Engine::Platform::GetConsole()
+{
+	return STDOUT_FILENO;
+}
+
+void Vulkan_Engine::Platform::SetConsoleColor(ConsoleHandle console, int color)
+{
+	//escape codes only make sense on a terminal, keep redirected logs clean
+	if (!isatty(console)) return;
+
+	if (color == 15 || color == 7)
+	{
+		std::cout << "\033[0m";
+		return;
+	}
+
+	//Win32 attributes store the color as (intensity, red, green, blue) bits, ANSI uses (blue, green, red)
+	int ansi = ((color & 4) ? 1 : 0) | (color & 2) | ((color & 1) ? 4 : 0);
+	std::cout << "\033[" << ((color & 8) ? 90 : 30) + ansi << 'm';
+}
+
+bool Vulkan_Engine::Platform::StartProcess(const std::vector<std::string>& arguments, ProcessHandle& process)
+{
+	std::vector<char*> argv;
+	for (const auto& argument : arguments) argv.push_back(const_cast<char*>(argument.c_str()));
+	argv.push_back(nullptr);
+
+	pid_t pid = 0;
+	if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0) return false;
+
+	process = pid;
+	return true;
+}
+
+int Vulkan_Engine::Platform::WaitProcess(ProcessHandle process)
+{
+	int status = 0;
+	if (waitpid(process, &status, 0) != process) return -1;
+	if (!WIFEXITED(status)) return -1;
+	return WEXITSTATUS(status);
+}
+
+int Vulkan_Engine::Platform::RunProcess(const std::vector<std::string>& arguments, std::string& output)
+{
+	std::vector<char*> argv;
+	for (const auto& argument : arguments) argv.push_back(const_cast<char*>(argument.c_str()));
+	argv.push_back(nullptr);
+
+	int pipeEnds[2];
+	if (pipe(pipeEnds) != 0) return -1;
+
+	//the child writes its standard output into the pipe, the read end stays with us
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, pipeEnds[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addclose(&actions, pipeEnds[0]);
+	posix_spawn_file_actions_addclose(&actions, pipeEnds[1]);
+
+	pid_t pid = 0;
+	int spawned = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	close(pipeEnds[1]);
+	if (spawned != 0)
+	{
+		close(pipeEnds[0]);
+		return -1;
+	}
+
+	char buffer[4096];
+	ssize_t length = 0;
+	while ((length = read(pipeEnds[0], buffer, sizeof(buffer))) != 0)
+	{
+		if (length < 0)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+		output.append(buffer, static_cast<size_t>(length));
+	}
+	close(pipeEnds[0]);
+
+	return WaitProcess(pid);
+}
+
+bool Vulkan_Engine::Platform::ReplaceFileAtomic(const std::string& source, const std::string& destination)
+{
+	return std::rename(source.c_str(), destination.c_str()) == 0;
+}
+
+bool Vulkan_Engine::Platform::MapFile(const std::string& path, MappedFile& mapping)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size <= 0)
+	{
+		close(file);
+		return false;
+	}
+
+	//the mapping keeps its own reference to the file, the descriptor is not needed anymore
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) return false;
+
+	mapping.Data = data;
+	mapping.Size = static_cast<size_t>(status.st_size);
+	return true;
+}
+
+void Vulkan_Engine::Platform::UnmapFile(MappedFile& mapping)
+{
+	if (mapping.Data) munmap(const_cast<void*>(mapping.Data), mapping.Size);
+	mapping = MappedFile{};
+}
+
+bool Vulkan_Engine::Platform::WatchDirectory(const std::string& directory, DirectoryWatch& watch)
+{
+	watch.Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch.Notify < 0) return false;
+
+	//editors either rewrite the file in place (close after write) or rename a new file over it (moved to)
+	if (inotify_add_watch(watch.Notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		CloseDirectoryWatch(watch);
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::string> Vulkan_Engine::Platform::PollDirectoryChanges(DirectoryWatch& watch)
+{
+	std::vector<std::string> names;
+	if (watch.Notify < 0) return names;
+
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(watch.Notify, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* position = buffer; position < buffer + length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+			if (event->len > 0) names.push_back(event->name);
+			position += sizeof(inotify_event) + event->len;
+		}
+	}
+	return names;
+}
+
+void Vulkan_Engine::Platform::CloseDirectoryWatch(DirectoryWatch& watch)
+{
+	if (watch.Notify >= 0) close(watch.Notify);
+	watch.Notify = -1;
+}
+
+bool Vulkan_Engine::Platform::PinCurrentThread(uint32_t core)
+{
+	if (core >= CPU_SETSIZE) return false;
+	cpu_set_t cores;
+	CPU_ZERO(&cores);
+	CPU_SET(core, &cores);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+}
+
+void Vulkan_Engine::Platform::SleepPrecise(double seconds)
+{
+	if (seconds <= 0.0) return;
+	//an absolute deadline, a signal interrupting the sleep does not stretch it
+	timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	int64_t nanoseconds = deadline.tv_nsec + static_cast<int64_t>(seconds * 1e9);
+	deadline.tv_sec += static_cast<time_t>(nanoseconds / 1000000000);
+	deadline.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR);
+}
+
+std::string Vulkan_Engine::Platform::ShaderCompilerExecutable()
+{
+	return "glslc";
+}
+
+const char* Vulkan_Engine::Platform::GetPlatformName()
+{
+	if (std::getenv("WAYLAND_DISPLAY") != nullptr) return "Linux (Wayland)";
+	if (std::getenv("DISPLAY") != nullptr) return "Linux (X11)";
+	return "Linux";
+}
+
+#endif
@@ -0,0 +1,33 @@
+#include "VPlatform.h"
+
+//the only part of the platform layer calling into the Vulkan loader and GLFW
+
+#if defined _WIN32
+
+#define GLFW_EXPOSE_NATIVE_WGL
+#define GLFW_EXPOSE_NATIVE_WIN32
+#include <GLFW/glfw3native.h>
+
+VkResult Vulkan_Engine::Platform::CreateSurface(VkInstance instance, GLFWwindow* window, VkSurfaceKHR* surface)
+{
+	//rather you can avoid this native implemetation and you glfwCreateWindowSurface function to create a surface
+	//the same way I did but it has a diffrent implementaion for each platform
+	VkWin32SurfaceCreateInfoKHR SurfaceCreateInfo{};
+	SurfaceCreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+	SurfaceCreateInfo.hwnd = glfwGetWin32Window(window);
+	SurfaceCreateInfo.hinstance = GetModuleHandle(nullptr);
+
+	//vkCreateWin32SurfaceKHR is an-extension-based function, but it is so commonly that is why it is in the standard
+	//it does not need to be loaded explicitly
+	return vkCreateWin32SurfaceKHR(instance, &SurfaceCreateInfo, nullptr, surface);
+}
+
+#else
+
+VkResult Vulkan_Engine::Platform::CreateSurface(VkInstance instance, GLFWwindow* window, VkSurfaceKHR* surface)
+{
+	//GLFW picks the xcb, xlib or wayland surface extension depending on the window system it was built/started with
+	return glfwCreateWindowSurface(instance, window, nullptr, surface);
+}
+
+#endif
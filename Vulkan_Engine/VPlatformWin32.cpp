@@ -0,0 +1,224 @@
+#include "VPlatform.h"
+
+#if defined _WIN32
+
+Vulkan_Engine::Platform::ConsoleHandle Vulkan_Engine::Platform::GetConsole()
+{
+	return GetStdHandle(STD_OUTPUT_HANDLE);
+}
+
+void Vulkan_Engine::Platform::SetConsoleColor(ConsoleHandle console, int color)
+{
+	SetConsoleTextAttribute(console, static_cast<WORD>(color));
+}
+
+bool Vulkan_Engine::Platform::StartProcess(const std::vector<std::string>& arguments, ProcessHandle& process)
+{
+	std::string commandLine;
+	for (const auto& argument : arguments) {
+		if (!commandLine.empty()) commandLine.append(" ");
+		commandLine.append("\"");
+		commandLine.append(argument);
+		commandLine.append("\"");
+	}
+
+	STARTUPINFOA StartupInfo{};
+	StartupInfo.cb = sizeof(StartupInfo);
+	PROCESS_INFORMATION ProcessInfo{};
+
+	if (!CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &StartupInfo, &ProcessInfo)) return false;
+
+	CloseHandle(ProcessInfo.hThread);
+	process = ProcessInfo.hProcess;
+	return true;
+}
+
+int Vulkan_Engine::Platform::WaitProcess(ProcessHandle process)
+{
+	if (WaitForSingleObject(process, INFINITE) != WAIT_OBJECT_0) return -1;
+	DWORD exitCode = 0;
+	if (!GetExitCodeProcess(process, &exitCode)) exitCode = static_cast<DWORD>(-1);
+	CloseHandle(process);
+	return static_cast<int>(exitCode);
+}
+
+int Vulkan_Engine::Platform::RunProcess(const std::vector<std::string>& arguments, std::string& output)
+{
+	std::string commandLine;
+	for (const auto& argument : arguments) {
+		if (!commandLine.empty()) commandLine.append(" ");
+		commandLine.append("\"");
+		commandLine.append(argument);
+		commandLine.append("\"");
+	}
+
+	//the child inherits the write end as its standard output, the read end stays with us
+	SECURITY_ATTRIBUTES Attributes{};
+	Attributes.nLength = sizeof(Attributes);
+	Attributes.bInheritHandle = TRUE;
+	HANDLE readPipe = nullptr;
+	HANDLE writePipe = nullptr;
+	if (!CreatePipe(&readPipe, &writePipe, &Attributes, 0)) return -1;
+	SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+	STARTUPINFOA StartupInfo{};
+	StartupInfo.cb = sizeof(StartupInfo);
+	StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+	StartupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+	StartupInfo.hStdOutput = writePipe;
+	StartupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+	PROCESS_INFORMATION ProcessInfo{};
+
+	BOOL started = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &StartupInfo, &ProcessInfo);
+	CloseHandle(writePipe);
+	if (!started)
+	{
+		CloseHandle(readPipe);
+		return -1;
+	}
+	CloseHandle(ProcessInfo.hThread);
+
+	char buffer[4096];
+	DWORD length = 0;
+	while (ReadFile(readPipe, buffer, sizeof(buffer), &length, nullptr) && length != 0) output.append(buffer, length);
+	CloseHandle(readPipe);
+
+	return WaitProcess(ProcessInfo.hProcess);
+}
+
+bool Vulkan_Engine::Platform::ReplaceFileAtomic(const std::string& source, const std::string& destination)
+{
+	//rename does not replace an existing file on Windows
+	return MoveFileExA(source.c_str(), destination.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+bool Vulkan_Engine::Platform::MapFile(const std::string& path, MappedFile& mapping)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	//the view keeps the file and the mapping object alive, both handles can be closed right away
+	HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (fileMapping == nullptr) return false;
+
+	void* data = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(fileMapping);
+	if (data == nullptr) return false;
+
+	mapping.Data = data;
+	mapping.Size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void Vulkan_Engine::Platform::UnmapFile(MappedFile& mapping)
+{
+	if (mapping.Data) UnmapViewOfFile(mapping.Data);
+	mapping = MappedFile{};
+}
+
+bool Vulkan_Engine::Platform::WatchDirectory(const std::string& directory, DirectoryWatch& watch)
+{
+	watch.Directory = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (watch.Directory == INVALID_HANDLE_VALUE) return false;
+
+	//the read stays pending until something changes, PollDirectoryChanges only looks at its result
+	watch.Overlapped = OVERLAPPED{};
+	if (!ReadDirectoryChangesW(watch.Directory, watch.Buffer, sizeof(watch.Buffer), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &watch.Overlapped, nullptr))
+	{
+		CloseDirectoryWatch(watch);
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::string> Vulkan_Engine::Platform::PollDirectoryChanges(DirectoryWatch& watch)
+{
+	std::vector<std::string> names;
+	if (watch.Directory == INVALID_HANDLE_VALUE) return names;
+
+	DWORD length = 0;
+	if (!GetOverlappedResult(watch.Directory, &watch.Overlapped, &length, FALSE)) return names;
+
+	const char* position = reinterpret_cast<const char*>(watch.Buffer);
+	while (length > 0)
+	{
+		const FILE_NOTIFY_INFORMATION* information = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(position);
+		if (information->Action == FILE_ACTION_MODIFIED || information->Action == FILE_ACTION_ADDED || information->Action == FILE_ACTION_RENAMED_NEW_NAME)
+		{
+			int nameLength = static_cast<int>(information->FileNameLength / sizeof(WCHAR));
+			int size = WideCharToMultiByte(CP_UTF8, 0, information->FileName, nameLength, nullptr, 0, nullptr, nullptr);
+			std::string name(size, '\0');
+			WideCharToMultiByte(CP_UTF8, 0, information->FileName, nameLength, &name[0], size, nullptr, nullptr);
+			names.push_back(name);
+		}
+		if (information->NextEntryOffset == 0) break;
+		position += information->NextEntryOffset;
+	}
+
+	//queue the next read
+	watch.Overlapped = OVERLAPPED{};
+	if (!ReadDirectoryChangesW(watch.Directory, watch.Buffer, sizeof(watch.Buffer), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &watch.Overlapped, nullptr))
+		CloseDirectoryWatch(watch);
+	return names;
+}
+
+void Vulkan_Engine::Platform::CloseDirectoryWatch(DirectoryWatch& watch)
+{
+	if (watch.Directory == INVALID_HANDLE_VALUE) return;
+	CancelIo(watch.Directory);
+	CloseHandle(watch.Directory);
+	watch.Directory = INVALID_HANDLE_VALUE;
+}
+
+bool Vulkan_Engine::Platform::PinCurrentThread(uint32_t core)
+{
+	//affinity masks only cover the first processor group
+	if (core >= sizeof(DWORD_PTR) * 8) return false;
+	return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+}
+
+void Vulkan_Engine::Platform::SleepPrecise(double seconds)
+{
+	if (seconds <= 0.0) return;
+	//Sleep rounds up to the 15.6 ms system tick, a high resolution waitable timer (Windows 10 1803+) does not.
+	//one timer per thread, older systems fall back to a regular waitable timer
+#if !defined CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+	thread_local HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	thread_local HANDLE fallbackTimer = timer ? nullptr : CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	HANDLE waitTimer = timer ? timer : fallbackTimer;
+
+	//negative due time is relative, in 100 ns units
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -static_cast<LONGLONG>(seconds * 1e7);
+	if (waitTimer && SetWaitableTimer(waitTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+		WaitForSingleObject(waitTimer, INFINITE);
+	else
+		Sleep(static_cast<DWORD>(seconds * 1000.0));
+}
+
+std::string Vulkan_Engine::Platform::ShaderCompilerExecutable()
+{
+	//the repository ships glslc.exe next to the shaders, prefer it over the one of the SDK
+	if (GetFileAttributesA("Shaders\\glslc.exe") != INVALID_FILE_ATTRIBUTES) return "Shaders\\glslc.exe";
+	return "glslc";
+}
+
+const char* Vulkan_Engine::Platform::GetPlatformName()
+{
+	return "Win32";
+}
+
+#endif
@@ -1,55 +1,81 @@
 #include "VRender.h"
 
-Vulkan_Engine::VRender::VRender()
+Vulkan_Engine::VRender::VRender(RENDER_MODE renderMode, bool pinJobThreads)
 {
 	pattern = DEVICE_PICKING_UP_PATTERN::USE_FIRST_SUITABLE_DEVICE;
-	HConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+	mode = renderMode;
+	HConsole = Platform::GetConsole();
+	Jobs.Start(std::max(1u, std::thread::hardware_concurrency()), pinJobThreads);
+	SceneVertexLayout.Add("inPosition", 0, VK_FORMAT_R32G32_SFLOAT).Add("inColor", 1, VK_FORMAT_R32G32B32_SFLOAT);
+
+	//headless mode has no window to present to, so the swapchain extension is neither required nor enabled
+	if (mode == RENDER_MODE::HEADLESS) VK_Device_Extensions.clear();
 
 	//ShowWindow(GetConsoleWindow(), SW_HIDE);
 	VulkanLoadingStatus[VULKAN_LOADING] = Initiliazer();
 	VulkanLoadingStatus[VALIDATION_LAYERS] = ValidationState();
-	VulkanLoadingStatus[GLFW_TEST] = GLFWsetter();
+	VulkanLoadingStatus[GLFW_TEST] = (mode == RENDER_MODE::HEADLESS) ? true : GLFWsetter();
 
 	CreateInstance(); 
 	SetupDebugMessenger();
-	CreateSurface(); //surface creation should take a place before physical device picking up, because it may affect the results if it is after
+	if (mode == RENDER_MODE::WINDOWED) CreateSurface(); //surface creation should take a place before physical device picking up, because it may affect the results if it is after
 	PickPhysicalDevice(VK_QUEUE_GRAPHICS_BIT);
 	CreateLogicalDevice();
-	CreateSwapChain();
+	CreateMemoryAllocator();
+	CreateUploadRing();
+	if (mode == RENDER_MODE::WINDOWED) CreateSwapChain();
+	else CreateOffscreenTargets();
 	CreateImageView();
 	CreateRenderPass();
+	CreatePipelineCache();
+	CreatePipelineBuilder();
 	CreateGraphicsPipeline();
 	CreateFrameBuffers();
 	CreateCommandPool();
-	CreateCommandBuffers();
-	CreateSemaphores();
-	CreateFences();
+	CreateSceneGeometry();
+	CreateFrameResources();
+	CreateTimelines();
+	StartShaderHotReload();
 }
 
 Vulkan_Engine::VRender::~VRender()
 {
+	StopShaderHotReload();
 
-	for (size_t smaphoreIndex = 0; smaphoreIndex < MAX_FRAMES_IN_FLIGHT; smaphoreIndex++) {
-		vkDestroySemaphore(LogicalDevice, RenderFinishedSemaphore[smaphoreIndex], nullptr);
-		vkDestroySemaphore(LogicalDevice, ImageAvailableSemaphore[smaphoreIndex], nullptr);
-		vkDestroyFence(LogicalDevice, inFlightFences[smaphoreIndex], nullptr);
-	}
+	DestroyFrameResources();
+	GraphicsTimeline.PrintStatistics();
+	GraphicsTimeline.Destroy();
+	Jobs.Stop();
 	vkDestroyCommandPool(LogicalDevice, CommandPool, nullptr);
-	for (auto& framebuffer : SwapChainFrameBuffers) vkDestroyFramebuffer(LogicalDevice, framebuffer, nullptr);
-	vkDestroyPipeline(LogicalDevice, GraphicsPipeline, nullptr);
+	FrameGraph.PrintStatistics("Frame");
+	FrameGraph.Destroy();
+	PipelineRegistry.Destroy();
 	vkDestroyPipelineLayout(LogicalDevice, PipelineLayout, nullptr);
-	vkDestroyRenderPass(LogicalDevice, RenderPass, nullptr);
+	DescriptorSetLayoutCache.Destroy(LogicalDevice);
+	PipelineBuilder.Stop();
+	PipelineCache.Destroy();
 	for (auto& ImageView : SwapChainImageViews) {
 		vkDestroyImageView(LogicalDevice, ImageView, nullptr);
 	}
-	vkDestroySwapchainKHR(LogicalDevice, VK_SwapChain, nullptr);
+	if (mode == RENDER_MODE::WINDOWED) vkDestroySwapchainKHR(LogicalDevice, VK_SwapChain, nullptr);
+	else
+	{
+		//offscreen images are owned by us, not by a swapchain
+		for (size_t i = 0; i < SwapChainImages.size(); i++) MemoryAllocator.DestroyImage(SwapChainImages[i], OffscreenImagesMemory[i]);
+	}
+	UploadRing.Destroy();
+	DestroyMesh(SceneMesh);
+	MemoryAllocator.Destroy();
 	vkDestroyDevice(LogicalDevice, nullptr); // device does not interact directly with the instance, that is why it is absent in the parameters
-	vkDestroySurfaceKHR(VK_Instance, VK_Surface, nullptr);
+	if (mode == RENDER_MODE::WINDOWED) vkDestroySurfaceKHR(VK_Instance, VK_Surface, nullptr);
 	if (enableValidationLayers)
 		DestroyDebugUtilsMessengerEXT(VK_Instance, debugMessenger, nullptr);
 	vkDestroyInstance(VK_Instance, nullptr);
-	glfwDestroyWindow(VK_Window);
-	glfwTerminate();
+	if (mode == RENDER_MODE::WINDOWED)
+	{
+		glfwDestroyWindow(VK_Window);
+		glfwTerminate();
+	}
 }
 
 VkResult Vulkan_Engine::VRender::CreateDebugUtilsMessengerEXT(const VkInstance& instance, VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger)
@@ -71,9 +97,9 @@ bool Vulkan_Engine::VRender::CheckValidationLayerSupport()
 	VK_AvailableValidationLayers.resize(LayersCount);
 	vkEnumerateInstanceLayerProperties(&LayersCount, VK_AvailableValidationLayers.data());
 
-	SetConsoleTextAttribute(HConsole, 14);
+	Platform::SetConsoleColor(HConsole, 14);
 	std::cout << "vulkan available validation layer\n\n";
-	SetConsoleTextAttribute(HConsole, 15);
+	Platform::SetConsoleColor(HConsole, 15);
 
 	for (auto& LayerProperties : VK_AvailableValidationLayers) {
 		std::cout << LayerProperties.layerName << '\t' << LayerProperties.description << '\t' << LayerProperties.implementationVersion << '\n';
@@ -97,9 +123,9 @@ bool Vulkan_Engine::VRender::CheckValidationLayerSupport()
 bool Vulkan_Engine::VRender::ValidationState()
 {
 	if (enableValidationLayers) {
-		SetConsoleTextAttribute(HConsole, 6);
+		Platform::SetConsoleColor(HConsole, 6);
 		std::cout << "Debug Mode : Enabled\n\n";
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 		return CheckValidationLayerSupport();
 	}
 	return true;
@@ -121,9 +147,9 @@ void Vulkan_Engine::VRender::SetupDebugMessenger()
 
 
 	if (CreateDebugUtilsMessengerEXT(VK_Instance, &VK_Messenger_CreateInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: Failed to set up debug messenger");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 
 
@@ -132,9 +158,9 @@ void Vulkan_Engine::VRender::SetupDebugMessenger()
 bool Vulkan_Engine::VRender::CheckExtensionsBeforeInstance()
 {
 	uint32_t VK_ExtensionsCount;
-	SetConsoleTextAttribute(HConsole, 14);
+	Platform::SetConsoleColor(HConsole, 14);
 	std::cout << "Vulkan extensions \n\n";
-	SetConsoleTextAttribute(HConsole, 15);
+	Platform::SetConsoleColor(HConsole, 15);
 	vkEnumerateInstanceExtensionProperties(nullptr, &VK_ExtensionsCount, nullptr);
 	VK_Available_Extensions.resize(VK_ExtensionsCount);
 	if (vkEnumerateInstanceExtensionProperties(nullptr, &VK_ExtensionsCount, VK_Available_Extensions.data()) != VK_SUCCESS) return false;
@@ -146,10 +172,11 @@ bool Vulkan_Engine::VRender::CheckExtensionsBeforeInstance()
 
 std::vector<const char*> Vulkan_Engine::VRender::GLFWGetRequiredExtension()
 {
-	uint32_t GLFW_VK_ExtensionCount;
-	const char** glfwExtensions;
+	uint32_t GLFW_VK_ExtensionCount = 0;
+	const char** glfwExtensions = nullptr;
 
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&GLFW_VK_ExtensionCount);
+	//GLFW is never initialized in headless mode, and no surface extension is needed there anyway
+	if (mode == RENDER_MODE::WINDOWED) glfwExtensions = glfwGetRequiredInstanceExtensions(&GLFW_VK_ExtensionCount);
 
 	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + GLFW_VK_ExtensionCount);
 
@@ -177,15 +204,23 @@ bool Vulkan_Engine::VRender::CheckDeviceExtensionSupport(VkPhysicalDevice device
 	return RequiredExtension.empty();
 }
 
+bool Vulkan_Engine::VRender::IsDeviceExtensionEnabled(const char* extensionName)
+{
+	for (const auto& extension : VK_Enabled_Device_Extensions) {
+		if (strcmp(extension, extensionName) == 0) return true;
+	}
+	return false;
+}
+
 void Vulkan_Engine::VRender::PickPhysicalDevice(VkQueueFlagBits bit)
 {
 	PhysicalDevice = VK_NULL_HANDLE;
 	uint32_t devices_count = 0;
 	vkEnumeratePhysicalDevices(VK_Instance, &devices_count, nullptr);
 	if (!devices_count) {
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: CANNOT FIND ANY GPU THAT SUPPORTS VULKAN");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 	VK_Phy_Devices.resize(devices_count);
 	vkEnumeratePhysicalDevices(VK_Instance, &devices_count, VK_Phy_Devices.data());
@@ -207,9 +242,9 @@ void Vulkan_Engine::VRender::PickPhysicalDevice(VkQueueFlagBits bit)
 			vkGetPhysicalDeviceProperties(PhysicalDevice, &VK_Phy_Device_Properties);
 			vkGetPhysicalDeviceFeatures(PhysicalDevice, &VK_Phy_Device_Features);
 
-			SetConsoleTextAttribute(HConsole, 14);
+			Platform::SetConsoleColor(HConsole, 14);
 			std::cout << "\nphysical device extensions : \n";
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 15);
 
 			for (const auto& extension : VK_Available_Device_Extensions) {
 				std::cout << extension.extensionName << '\t' << extension.specVersion << '\n';
@@ -218,9 +253,9 @@ void Vulkan_Engine::VRender::PickPhysicalDevice(VkQueueFlagBits bit)
 		}
 		else
 		{
-			SetConsoleTextAttribute(HConsole, 12);
+			Platform::SetConsoleColor(HConsole, 12);
 			throw std::runtime_error("ERROR :: CANNOT FIND A SUITABLE GPU FOR THE APPLICATION IN THIS DEVICE");
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 15);
 		}
 	}
 
@@ -231,17 +266,12 @@ void Vulkan_Engine::VRender::PickPhysicalDevice(VkQueueFlagBits bit)
 			if (isDeviceSuitable(device,bit)) {
 				PhysicalDevice = device;
 				VK_Phy_Device_QueueFamilies = FindQueueFamilies(device);
-				VkPhysicalDeviceMemoryProperties memInfo;
-				vkGetPhysicalDeviceMemoryProperties(device, &memInfo);
+				vkGetPhysicalDeviceProperties(PhysicalDevice, &VK_Phy_Device_Properties);
+				vkGetPhysicalDeviceFeatures(PhysicalDevice, &VK_Phy_Device_Features);
 
-				std::cout << std::endl << '\t' << memInfo.memoryHeapCount << std::endl;
-				std::cout << '\t' << memInfo.memoryHeaps->size << std::endl;
-				std::cout << '\t' << memInfo.memoryTypeCount << std::endl;
-				std::cout << '\t' << memInfo.memoryTypes->heapIndex << std::endl;
-
-				SetConsoleTextAttribute(HConsole, 14);
+				Platform::SetConsoleColor(HConsole, 14);
 				std::cout << "\n\nPhysical device extensions : \n\n";
-				SetConsoleTextAttribute(HConsole, 15);
+				Platform::SetConsoleColor(HConsole, 15);
 
 				for (const auto& extension : VK_Available_Device_Extensions) {
 					std::cout << extension.extensionName << '\t' << extension.specVersion << '\n';
@@ -251,9 +281,9 @@ void Vulkan_Engine::VRender::PickPhysicalDevice(VkQueueFlagBits bit)
 		}
 
 		if (PhysicalDevice == VK_NULL_HANDLE) {
-			SetConsoleTextAttribute(HConsole, 12);
+			Platform::SetConsoleColor(HConsole, 12);
 			throw std::runtime_error("ERROR :: CANNOT FIND A SUITABLE GPU FOR THE APPLICATION IN THIS DEVICE");
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 15);
 		}
 	}
 
@@ -262,11 +292,13 @@ void Vulkan_Engine::VRender::PickPhysicalDevice(VkQueueFlagBits bit)
 bool Vulkan_Engine::VRender::isDeviceSuitable(VkPhysicalDevice device, VkQueueFlagBits bit)
 {
 	//this function should be more dynamique and programmable
-	if (!CheckForQueueFamily(device, bit, true).isComplete()) return false;
+	if (!CheckForQueueFamily(device, bit, mode == RENDER_MODE::WINDOWED).isComplete()) return false;
 
 	if (!CheckDeviceExtensionSupport(device)) return false;
 
-	if (!QuerySwapChainSupport(device)) return false;
+	if (mode == RENDER_MODE::WINDOWED && !QuerySwapChainSupport(device)) return false;
+
+	if (!SupportsTimelineSemaphores(device)) return false;
 
 	VkPhysicalDeviceProperties device_properties;
 	VkPhysicalDeviceFeatures device_features;
@@ -276,7 +308,10 @@ bool Vulkan_Engine::VRender::isDeviceSuitable(VkPhysicalDevice device, VkQueueFl
 
 	
 
-	if ((device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ) && device_features.geometryShader) {
+	//software implementations (e.g. Mesa lavapipe) report a CPU device type, they are accepted only when running headless
+	bool isCpuDeviceAllowed = (mode == RENDER_MODE::HEADLESS && device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU);
+
+	if ((device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU || isCpuDeviceAllowed) && device_features.geometryShader) {
 		VK_Phy_Device_Properties = device_properties;
 		VK_Phy_Device_Features = device_features;
 		return true;
@@ -289,11 +324,13 @@ int Vulkan_Engine::VRender::RateDeviceSuitability(VkPhysicalDevice device, VkQue
 {
 	//this function should be more dynamique and programmable
 
-	if (!CheckForQueueFamily(device, bit, true).isComplete()) return 0;
+	if (!CheckForQueueFamily(device, bit, mode == RENDER_MODE::WINDOWED).isComplete()) return 0;
 
 	if (!CheckDeviceExtensionSupport(device)) return 0;
 
-	if (!QuerySwapChainSupport(device)) return 0;
+	if (mode == RENDER_MODE::WINDOWED && !QuerySwapChainSupport(device)) return 0;
+
+	if (!SupportsTimelineSemaphores(device)) return 0;
 
 	VkPhysicalDeviceProperties device_properties;
 	VkPhysicalDeviceFeatures device_features;
@@ -305,6 +342,7 @@ int Vulkan_Engine::VRender::RateDeviceSuitability(VkPhysicalDevice device, VkQue
 	// Discrete GPUs have a significant performance advantage
 	if (device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) score += 1000;
 	else if (device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) score += 250;
+	else if (mode == RENDER_MODE::HEADLESS && device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) score += 1;
 	 // Maximum possible size of textures affects graphics quality
 	score += device_properties.limits.maxImageDimension2D;
 	// Application can't function without geometry shaders
@@ -316,6 +354,21 @@ int Vulkan_Engine::VRender::RateDeviceSuitability(VkPhysicalDevice device, VkQue
 
 }
 
+bool Vulkan_Engine::VRender::SupportsTimelineSemaphores(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceProperties DeviceProperties;
+	vkGetPhysicalDeviceProperties(device, &DeviceProperties);
+	if (DeviceProperties.apiVersion < VK_API_VERSION_1_2) return false;
+
+	VkPhysicalDeviceVulkan12Features Vulkan12Features{};
+	Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	VkPhysicalDeviceFeatures2 DeviceFeatures2{};
+	DeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	DeviceFeatures2.pNext = &Vulkan12Features;
+	vkGetPhysicalDeviceFeatures2(device, &DeviceFeatures2);
+	return Vulkan12Features.timelineSemaphore == VK_TRUE;
+}
+
 std::vector<VkQueueFamilyProperties> Vulkan_Engine::VRender::FindQueueFamilies(VkPhysicalDevice device)
 {
 	uint32_t queueFamilyCount = 0;
@@ -329,31 +382,49 @@ Vulkan_Engine::QueueFamiliesIndices Vulkan_Engine::VRender::CheckForQueueFamily(
 {
 	QueueFamiliesIndices indices{};
 	std::vector<VkQueueFamilyProperties> device_queueFamily = FindQueueFamilies(device);
-	int i = 0;
-	for (const auto& queue_family : device_queueFamily) {
+	for (uint32_t i = 0; i < device_queueFamily.size(); i++) {
 
-		if (queue_family.queueFlags & bit) {
+		if (device_queueFamily[i].queueFlags & bit) {
 			indices.GraphicsFamily = i;
-			i++;
 			break;
 		}
 	}
+	if (!indices.GraphicsFamily.has_value()) return indices;
+
 	if (CheckForPresentQueue)
 	{
-		if (i >= device_queueFamily.size()) i = indices.GraphicsFamily.value(); // PresentQueueIndex must be less than queueFamilyCountProperty returned by the function in FindQueueFamilies
+		//the graphics family first, presenting from the queue that rendered avoids an ownership transfer of the image
 		VkBool32 PresentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, VK_Surface, &PresentSupport); //this may end up to be same queue as Graphics queue and we can explicity prefer them to be same for improved performance
-		if (PresentSupport) indices.PresentFamily = i;
+		vkGetPhysicalDeviceSurfaceSupportKHR(device, indices.GraphicsFamily.value(), VK_Surface, &PresentSupport);
+		if (PresentSupport) indices.PresentFamily = indices.GraphicsFamily;
+		for (uint32_t i = 0; i < device_queueFamily.size() && !indices.PresentFamily.has_value(); i++) {
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, VK_Surface, &PresentSupport);
+			if (PresentSupport) indices.PresentFamily = i;
+		}
+	}
+	else
+	{
+		indices.PresentFamily = indices.GraphicsFamily; //nothing is presented when no present queue is requested, the graphics queue stands for it
+	}
+
+	//a transfer only family is the DMA engine, its copies run next to the rendering instead of in between
+	indices.TransferFamily = indices.GraphicsFamily;
+	for (uint32_t i = 0; i < device_queueFamily.size(); i++) {
+		VkQueueFlags flags = device_queueFamily[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			indices.TransferFamily = i;
+			break;
+		}
 	}
 	return indices;
 }
 
 void Vulkan_Engine::VRender::CreateLogicalDevice()
 {
-	queueFamiliesindices = CheckForQueueFamily(PhysicalDevice, VK_QUEUE_GRAPHICS_BIT, true);
+	queueFamiliesindices = CheckForQueueFamily(PhysicalDevice, VK_QUEUE_GRAPHICS_BIT, mode == RENDER_MODE::WINDOWED);
 
 	std::vector<VkDeviceQueueCreateInfo> QueueCreateInfos;
-	std::set<uint32_t> UniqueQueueFamilies = { queueFamiliesindices.GraphicsFamily.value(),queueFamiliesindices.PresentFamily.value() };
+	std::set<uint32_t> UniqueQueueFamilies = { queueFamiliesindices.GraphicsFamily.value(),queueFamiliesindices.PresentFamily.value(),queueFamiliesindices.TransferFamily.value() };
 	float QueuePriority = 1.0f;
 	for (const auto& queue : UniqueQueueFamilies) {
 		VkDeviceQueueCreateInfo QueueCreateInfo{};
@@ -364,18 +435,76 @@ void Vulkan_Engine::VRender::CreateLogicalDevice()
 		QueueCreateInfos.push_back(QueueCreateInfo);
 	}
 
-	VkPhysicalDeviceFeatures Device_features{};//we can use the ones selected and stored in VK_Phy_Device_Features variable, but no need for now
+	VkPhysicalDeviceFeatures Device_features{};//only what is used is enabled from the ones selected and stored in VK_Phy_Device_Features
+	//pipeline statistics queries count the shaded fragments in the depth pre-pass benchmark
+	PipelineStatisticsQuery = VK_Phy_Device_Features.pipelineStatisticsQuery == VK_TRUE;
+	Device_features.pipelineStatisticsQuery = VK_Phy_Device_Features.pipelineStatisticsQuery;
+
+	//guaranteed by the device picking
+	VkPhysicalDeviceVulkan12Features Vulkan12Features{};
+	Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	Vulkan12Features.timelineSemaphore = VK_TRUE;
 
 	VkDeviceCreateInfo DeviceCreateInfo{};
 	DeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	DeviceCreateInfo.pNext = &Vulkan12Features;
 	DeviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(QueueCreateInfos.size());
 	DeviceCreateInfo.pQueueCreateInfos = QueueCreateInfos.data();
 	DeviceCreateInfo.pEnabledFeatures = &Device_features;
 
-	if (!VK_Device_Extensions.empty()) 
+	//required extensions are guaranteed by the device picking, optional ones are added when the picked device has them
+	CheckDeviceExtensionSupport(PhysicalDevice);
+	VK_Enabled_Device_Extensions = VK_Device_Extensions;
+	for (const auto& optionalExtension : VK_Optional_Device_Extensions) {
+		for (const auto& extension : VK_Available_Device_Extensions) {
+			if (strcmp(extension.extensionName, optionalExtension) == 0) {
+				VK_Enabled_Device_Extensions.push_back(optionalExtension);
+				break;
+			}
+		}
+	}
+
+	//VK_EXT_extended_dynamic_state does nothing until its feature is enabled too, drop the extension when the feature is missing
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT ExtendedDynamicStateFeatures{};
+	ExtendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+	if (IsDeviceExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceProperties DeviceProperties;
+		vkGetPhysicalDeviceProperties(PhysicalDevice, &DeviceProperties);
+		if (DeviceProperties.apiVersion >= VK_API_VERSION_1_1)
+		{
+			VkPhysicalDeviceFeatures2 DeviceFeatures2{};
+			DeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			DeviceFeatures2.pNext = &ExtendedDynamicStateFeatures;
+			vkGetPhysicalDeviceFeatures2(PhysicalDevice, &DeviceFeatures2);
+			ExtendedDynamicStateFeatures.pNext = nullptr;
+		}
+
+		if (ExtendedDynamicStateFeatures.extendedDynamicState) Vulkan12Features.pNext = &ExtendedDynamicStateFeatures;
+		else VK_Enabled_Device_Extensions.erase(std::find_if(VK_Enabled_Device_Extensions.begin(), VK_Enabled_Device_Extensions.end(),
+			[](const char* extension) { return strcmp(extension, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) == 0; }));
+	}
+
+	//same for VK_KHR_dynamic_rendering, core in Vulkan 1.3 but the instance asks for 1.2. The device picking guarantees vkGetPhysicalDeviceFeatures2
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR DynamicRenderingFeatures{};
+	DynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	if (IsDeviceExtensionEnabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceFeatures2 DeviceFeatures2{};
+		DeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		DeviceFeatures2.pNext = &DynamicRenderingFeatures;
+		vkGetPhysicalDeviceFeatures2(PhysicalDevice, &DeviceFeatures2);
+		DynamicRenderingFeatures.pNext = Vulkan12Features.pNext;
+
+		if (DynamicRenderingFeatures.dynamicRendering) Vulkan12Features.pNext = &DynamicRenderingFeatures;
+		else VK_Enabled_Device_Extensions.erase(std::find_if(VK_Enabled_Device_Extensions.begin(), VK_Enabled_Device_Extensions.end(),
+			[](const char* extension) { return strcmp(extension, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) == 0; }));
+	}
+
+	if (!VK_Enabled_Device_Extensions.empty()) 
 	{
-		DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(VK_Device_Extensions.size());
-		DeviceCreateInfo.ppEnabledExtensionNames = VK_Device_Extensions.data();
+		DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(VK_Enabled_Device_Extensions.size());
+		DeviceCreateInfo.ppEnabledExtensionNames = VK_Enabled_Device_Extensions.data();
 	}
 	else DeviceCreateInfo.enabledExtensionCount = 0;
 
@@ -390,40 +519,43 @@ void Vulkan_Engine::VRender::CreateLogicalDevice()
 
 	if (vkCreateDevice(PhysicalDevice, &DeviceCreateInfo, nullptr, &LogicalDevice) != VK_SUCCESS)
 	{
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: FAILD TO CREATE A LOGICAL DEVICE FROM THE PHYSICAL GPU");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 
+	LoadExtendedDynamicState();
+	LoadDynamicRendering();
+
 	vkGetDeviceQueue(LogicalDevice, queueFamiliesindices.GraphicsFamily.value(), 0, &VK_GraphicsQueue);
 	vkGetDeviceQueue(LogicalDevice, queueFamiliesindices.PresentFamily.value(), 0, &VK_PresentQueue);
 	if (VK_GraphicsQueue == VK_PresentQueue)
 	{
-		SetConsoleTextAttribute(HConsole, 6);
+		Platform::SetConsoleColor(HConsole, 6);
 		std::cout << "\nThe graphics and present queues are same\n\n";
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
+	vkGetDeviceQueue(LogicalDevice, queueFamiliesindices.TransferFamily.value(), 0, &VK_TransferQueue);
+	Platform::SetConsoleColor(HConsole, 6);
+	if (queueFamiliesindices.TransferFamily != queueFamiliesindices.GraphicsFamily)
+		std::cout << "Uploads run on the dedicated transfer queue family " << queueFamiliesindices.TransferFamily.value() << "\n\n";
+	else std::cout << "No dedicated transfer queue family, uploads run on the graphics queue\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
 }
 
 void Vulkan_Engine::VRender::CreateSurface()
 {
-	//rather you can avoid this native implemetation and you glfwCreateWindowSurface function to create a surface
-	//the same way I did but it has a diffrent implementaion for each platform
-	//for linux replace WIN32 in all surface related commands to XCB
-
-	VK_Surface_CreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-	VK_Surface_CreateInfo.hwnd = glfwGetWin32Window(VK_Window);
-	VK_Surface_CreateInfo.hinstance = GetModuleHandle(nullptr);
-
-	//vkCreateWin32SurfaceKHR is an-extension-based function, but it is so commonly that is why it is in the standard
-	//it does not need to be loaded explicitly
-	if (vkCreateWin32SurfaceKHR(VK_Instance, &VK_Surface_CreateInfo, nullptr, &VK_Surface) != VK_SUCCESS) 
+	//the native surface creation (Win32 / xcb / xlib / wayland) is done by the platform backend
+	if (Platform::CreateSurface(VK_Instance, VK_Window, &VK_Surface) != VK_SUCCESS) 
 	{
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: FAILED TO CREATE A SURFACE ON YOUR WINDOWING SYSTEM");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 
+	Platform::SetConsoleColor(HConsole, 6);
+	std::cout << "\nSurface created for platform : " << Platform::GetPlatformName() << "\n";
+	Platform::SetConsoleColor(HConsole, 15);
 }
 
 bool Vulkan_Engine::VRender::QuerySwapChainSupport(VkPhysicalDevice device)
@@ -463,10 +595,26 @@ VkSurfaceFormatKHR Vulkan_Engine::VRender::SelectSwapChainFormat(const std::vect
 
 VkPresentModeKHR Vulkan_Engine::VRender::SelectSwapChainPresentMode(const std::vector<VkPresentModeKHR>& availableModes)
 {
-	for (const auto& presentMode : availableModes) 
+	std::vector<VkPresentModeKHR> preferences;
+	switch (PresentPolicy)
 	{
-		if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR) return presentMode;
+	case PRESENT_POLICY::LOWEST_LATENCY:
+		preferences = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+		break;
+	case PRESENT_POLICY::VSYNC:
+		//FIFO, the fallback below : acquire blocks until a refresh frees an image, the CPU does not spin between refreshes
+		break;
+	case PRESENT_POLICY::CAPPED_FPS:
+		preferences = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+		break;
+	case PRESENT_POLICY::POWER_SAVE:
+		break;
 	}
+	for (const auto& preference : preferences)
+	{
+		if (std::find(availableModes.begin(), availableModes.end(), preference) != availableModes.end()) return preference;
+	}
+	//the only mode every implementation supports
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -478,7 +626,11 @@ VkExtent2D Vulkan_Engine::VRender::SelectSwapChainExtent(const VkSurfaceCapabili
 	}
 	else
 	{
-		VkExtent2D actualExtent = { 1080,720 };
+		//the surface takes the size of the swapchain, which is the size of the framebuffer of the window.
+		//only the main thread may query the window, the render thread goes by the last input snapshot
+		int width = CurrentInput.FramebufferWidth, height = CurrentInput.FramebufferHeight;
+		if (VK_Window && !RenderThreadRunning.load(std::memory_order_relaxed)) glfwGetFramebufferSize(VK_Window, &width, &height);
+		VkExtent2D actualExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
 		
 		actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
 		actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
@@ -486,6 +638,21 @@ VkExtent2D Vulkan_Engine::VRender::SelectSwapChainExtent(const VkSurfaceCapabili
 	}
 }
 
+VkFormat Vulkan_Engine::VRender::SelectDepthFormat(bool sampled)
+{
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM };
+	const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | (sampled ? VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT : 0);
+	for (const auto& candidate : candidates)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(PhysicalDevice, candidate, &properties);
+		if ((properties.optimalTilingFeatures & features) == features) return candidate;
+	}
+	Platform::SetConsoleColor(HConsole, 12);
+	throw std::runtime_error(sampled ? "ERROR :: No depth format can be sampled and used as a depth attachment" : "ERROR :: No depth format can be used as a depth attachment");
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
 void Vulkan_Engine::VRender::CreateSwapChain()
 {
 	format = SelectSwapChainFormat(SwapChainSupport.SurfaceFormats);
@@ -528,13 +695,14 @@ void Vulkan_Engine::VRender::CreateSwapChain()
 
 	VK_SwapChain_createInfo.clipped = VK_TRUE;
 
-	VK_SwapChain_createInfo.oldSwapchain = VK_NULL_HANDLE;
+	//the presentation engine may reuse the resources of the old swapchain, which stays valid until its frames are done
+	VK_SwapChain_createInfo.oldSwapchain = VK_SwapChain;
 
 	if (vkCreateSwapchainKHR(LogicalDevice, &VK_SwapChain_createInfo, nullptr, &VK_SwapChain) != VK_SUCCESS)
 	{
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: FAILED TO CREATE A SWAP CHAIN FOR THE SURFACE");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 
 	vkGetSwapchainImagesKHR(LogicalDevice, VK_SwapChain, &imageCount, nullptr);
@@ -543,6 +711,186 @@ void Vulkan_Engine::VRender::CreateSwapChain()
 
 }
 
+void Vulkan_Engine::VRender::FramebufferResizeCallback(GLFWwindow* window, int /*width*/, int /*height*/)
+{
+	//some platforms never report an out of date swapchain on resize, the flag makes sure it is recreated
+	VRender* render = static_cast<VRender*>(glfwGetWindowUserPointer(window));
+	if (!render) return;
+	//the callback runs inside the event poll, the new size is published with the next snapshot
+	render->ResizeSequence.store(render->InputSequence + 1);
+	render->FramebufferResized = true;
+}
+
+void Vulkan_Engine::VRender::RecreateSwapChain()
+{
+	//the flag is cleared before the size is read : a resize reported from then on sets it again and is applied by the next
+	//iteration, its snapshot may be newer than the one used. Some platforms never report OUT_OF_DATE after a resize
+	do
+	{
+		FramebufferResized.exchange(false);
+		const uint64_t resizeSequence = ResizeSequence.load();
+		//a minimized window has an empty framebuffer, no swapchain can be created before it is restored
+		int width = 0, height = 0;
+		if (RenderThreadRunning.load(std::memory_order_relaxed))
+		{
+			//the render thread must not touch the window, it waits for the snapshot published after the resize and of the restored window
+			CurrentInput = InputBuffer.Acquire();
+			while ((CurrentInput.Sequence < resizeSequence || CurrentInput.FramebufferWidth == 0 || CurrentInput.FramebufferHeight == 0) && !RenderThreadStop.load(std::memory_order_acquire)) {
+				Platform::SleepPrecise(0.01);
+				CurrentInput = InputBuffer.Acquire();
+			}
+			width = CurrentInput.FramebufferWidth;
+			height = CurrentInput.FramebufferHeight;
+		}
+		else
+		{
+			glfwGetFramebufferSize(VK_Window, &width, &height);
+			while ((width == 0 || height == 0) && !glfwWindowShouldClose(VK_Window)) {
+				glfwWaitEvents();
+				glfwGetFramebufferSize(VK_Window, &width, &height);
+			}
+		}
+		if (width == 0 || height == 0) return;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		VkFormat previousFormat = format.format;
+		QuerySwapChainSupport(PhysicalDevice);
+
+		//no vkDeviceWaitIdle, the frames already submitted keep the old swapchain, views, framebuffers and graph images until they are complete
+		RetiredFrameResources retired;
+		retired.SwapChain = VK_SwapChain;
+		retired.ImageViews = std::move(SwapChainImageViews);
+		retired.RetireFrame = GraphicsTimeline.GetLastSignaled();
+		SwapChainImageViews.clear();
+		for (const auto& image : SwapChainImages) StateTracker.ForgetImage(image);
+
+		CreateSwapChain();
+		if (format.format != previousFormat)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: The surface format changed, the render pass does not match the new swapchain");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		FrameGraph.Resize(extent, retired.Framebuffers, retired.ImageViews, retired.Images, retired.Memory);
+		retired.SwapChainGeneration = ++SwapChainGeneration;
+		SwapChainImagesAcquired.assign(SwapChainImages.size(), false);
+		UnacquiredSwapChainImages = static_cast<uint32_t>(SwapChainImages.size());
+		RetiredResources.push_back(std::move(retired));
+		CreateImageView();
+		CreateFrameBuffers();
+		//the images of the new swapchain were never rendered to
+		ImageFrames.assign(SwapChainImages.size(), 0);
+
+		//viewport and scissor are dynamic states, the pipelines stay as they are
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		scissor.extent = extent;
+
+		double stallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		SwapChainRecreations++;
+		SwapChainStallMs += stallMs;
+		MaxSwapChainStallMs = std::max(MaxSwapChainStallMs, stallMs);
+
+		Platform::SetConsoleColor(HConsole, 6);
+		std::cout << "swapchain recreated : " << extent.width << "x" << extent.height << ", " << SwapChainImages.size() << " images, "
+			<< stallMs << " ms stall\n";
+		Platform::SetConsoleColor(HConsole, 15);
+	} while (FramebufferResized.load());
+}
+
+void Vulkan_Engine::VRender::SetPresentPolicy(PRESENT_POLICY policy, double targetFps)
+{
+	PresentPolicy = policy;
+	if (targetFps <= 0.0) targetFps = policy == PRESENT_POLICY::CAPPED_FPS ? 60.0 : policy == PRESENT_POLICY::POWER_SAVE ? 30.0 : 0.0;
+	FramePacer.SetTargetFps(targetFps);
+
+	//headless frames are never presented, only the limiter applies
+	if (mode == RENDER_MODE::WINDOWED && VK_SwapChain != VK_NULL_HANDLE && SelectSwapChainPresentMode(SwapChainSupport.SurfacePresentMode) != presentMode)
+		RecreateSwapChain();
+
+	const char* policyNames[] = { "lowest latency", "vsync", "capped fps", "power save" };
+	Platform::SetConsoleColor(HConsole, 6);
+	std::cout << "present policy : " << policyNames[static_cast<int>(policy)];
+	if (mode == RENDER_MODE::WINDOWED)
+	{
+		switch (presentMode)
+		{
+		case VK_PRESENT_MODE_IMMEDIATE_KHR: std::cout << ", IMMEDIATE"; break;
+		case VK_PRESENT_MODE_MAILBOX_KHR: std::cout << ", MAILBOX"; break;
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR: std::cout << ", FIFO_RELAXED"; break;
+		default: std::cout << ", FIFO"; break;
+		}
+	}
+	if (targetFps > 0.0) std::cout << ", limited to " << targetFps << " fps";
+	std::cout << "\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VRender::CreateMemoryAllocator()
+{
+	//vkGet*MemoryRequirements2 and dedicated allocations are core in Vulkan 1.1
+	MemoryAllocator.Create(PhysicalDevice, LogicalDevice, VK_Phy_Device_Properties.apiVersion >= VK_API_VERSION_1_1);
+	MemoryAllocator.PrintMemoryTypes();
+}
+
+void Vulkan_Engine::VRender::CreateUploadRing()
+{
+	//one slot per possible frame in flight, the ring outlives changes of the frames in flight setting
+	UploadRing.Create(LogicalDevice, &MemoryAllocator, VK_TransferQueue, queueFamiliesindices.TransferFamily.value(), queueFamiliesindices.GraphicsFamily.value(),
+		MAX_FRAMES_IN_FLIGHT, UploadRingSize, UploadRingRequests);
+}
+
+VkFormat Vulkan_Engine::VRender::SelectOffscreenFormat()
+{
+	//same preference as the swapchain, then a format every implementation must support as a color attachment
+	VkFormat candidates[] = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_R8G8B8A8_UNORM };
+	for (const auto& candidate : candidates)
+	{
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(PhysicalDevice, candidate, &formatProperties);
+		if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) return candidate;
+	}
+	return VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+void Vulkan_Engine::VRender::CreateOffscreenTargets()
+{
+	format.format = SelectOffscreenFormat();
+	format.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+	extent = OffscreenExtent;
+	presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR; //unused, nothing is presented
+
+	//one image per possible frame in flight, frame slot i renders into image i, so waiting for the previous frame of a slot also guards its image
+	SwapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+	OffscreenImagesMemory.resize(MAX_FRAMES_IN_FLIGHT);
+
+	for (size_t i = 0; i < SwapChainImages.size(); i++)
+	{
+		VkImageCreateInfo ImageCreateInfo{};
+		ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		ImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		ImageCreateInfo.format = format.format;
+		ImageCreateInfo.extent = { extent.width, extent.height, 1 };
+		ImageCreateInfo.mipLevels = 1;
+		ImageCreateInfo.arrayLayers = 1;
+		ImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		ImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		ImageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //transfer source to allow reading the frames back
+		ImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		ImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		//render targets get their own memory, like swapchain images do
+		MemoryUsage usage;
+		usage.Required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		usage.Dedicated = true;
+		MemoryAllocator.CreateImage(ImageCreateInfo, usage, SwapChainImages[i], OffscreenImagesMemory[i]);
+	}
+
+	Platform::SetConsoleColor(HConsole, 6);
+	std::cout << "\nHeadless mode : " << SwapChainImages.size() << " offscreen images of " << extent.width << "x" << extent.height << "\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
 void Vulkan_Engine::VRender::CreateImageView()
 {
 	SwapChainImageViews.resize(SwapChainImages.size());
@@ -568,9 +916,9 @@ void Vulkan_Engine::VRender::CreateImageView()
 
 		if (vkCreateImageView(LogicalDevice, &ImageView_create_info, nullptr, &SwapChainImageViews[i]) != VK_SUCCESS) 
 		{
-			SetConsoleTextAttribute(HConsole, 12);
+			Platform::SetConsoleColor(HConsole, 12);
 			throw std::runtime_error("ERROR :: FAILED TO CREATE IMAGE VIEWS FOR SWAP CHAIN IMAGES ");
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 15);
 		}
 
 	}
@@ -580,153 +928,377 @@ void Vulkan_Engine::VRender::LoadCompileShaders()
 {
 	std::string shd[] = { "PrimitiveShader.vert" ,"PrimitiveShader.frag" };
 	std::string shdt[] = { "vert" ,"frag" };
-	int i = 0;
-	char chi = 'n';
-	std::cout << "Do you need to Load the shaders (y/n) : ";
-	//std::cin >> chi;
-	chi = 'y';
-	if (chi == 'y' || chi == 'Y')
-	{
-		while(i < 2)
-		//while (std::cin.get())
-		{
-			std::cout << "\nEnter the name of the shader(with extension), (quit) to quit: ";
-			std::string name;
-			//std::cin >> name;
-			name = shd[i];
-			if (name == "quit") break;
-			std::cout << "Enter the type of the shader (vert/frag/tcs/tes/geom/comp) : ";
-			std::string type;
-			//std::cin >> type;
-			type = shdt[i];
-			char ch = 'n';
-			std::cout << "Do you need to compile/recompile the shader (y/n) : ";
-			//std::cin >> ch;
-			ch = 'y';
-			if (ch == 'y' || ch == 'Y')
-			{
-				std::string command = "Shaders\\VulkanShaderCompiler.bat ";
-				command.append(name);
-				command.append(" ");
-				command.append(type);
-				system((const char*)command.c_str());
-			}
-			std::string path_to_glsl = "Shaders/";
-			std::string path_to_spirv = "Shaders/SPIR-V/";
-			std::vector<char> source[2];
-			path_to_glsl.append(name);
-			LoadShaderSource(path_to_glsl.c_str(), source[0]);
-			std::string::size_type pos = name.find('.');
-			std::string nameWEX = "";
-			if (pos != std::string::npos)
-			{
-				nameWEX = name.substr(0, pos);
-			}
-			path_to_spirv.append(nameWEX);
-			path_to_spirv.append(type);
-			path_to_spirv.append(".spv");
-			LoadShaderSource(path_to_spirv.c_str(), source[1]);
-
-			std::pair<std::vector<char>, std::vector<char>> GLSL_SPIRV_map;
-			std::pair pr = std::pair<std::vector<char>, std::vector<char>>(source[0], source[1]);
-			shaders.insert(std::pair<std::string, std::pair<std::vector<char>, std::vector<char>>>(name, pr));
-			i++;
+	ShaderRequests.clear();
+	for (int i = 0; i < 2; i++) {
+		ShaderRequests.push_back({ shd[i], shdt[i], ShaderCompileOptions });
+	}
+
+	//a packed archive holding every shader wins over the sources, modules are then created straight from the mapping
+	if (ShaderArchive.Open(ShaderArchivePath))
+	{
+		std::map<std::string, ShaderCode> archived;
+		for (int i = 0; i < 2; i++) {
+			ShaderCode code;
+			if (!ShaderArchive.Find(shd[i], code.Code, code.CodeSize)) break;
+			archived[shd[i]] = code;
 		}
 
+		Platform::SetConsoleColor(HConsole, 6);
+		if (archived.size() == 2) {
+			std::cout << "using the shader archive " << ShaderArchivePath << " (" << ShaderArchive.GetEntryCount() << " shaders), delete it to build the shaders from source\n";
+			Platform::SetConsoleColor(HConsole, 15);
+			shaders = std::move(archived);
+			return;
+		}
+		std::cout << ShaderArchivePath << " is missing shaders, building them from source\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		ShaderArchive.Close();
 	}
-	else {
-		SetConsoleTextAttribute(HConsole, 12);
-		throw std::runtime_error("PROGRAM HAS BEEN STOPED :: THE SHADERS ARE NOT LOADED");
-		SetConsoleTextAttribute(HConsole, 15);
+
+	//glslc only runs for the shaders whose source, includes or options changed since they were last built
+	const std::vector<ShaderBuildRequest>& requests = ShaderRequests;
+	std::vector<ShaderBuildResult> results = ShaderCompiler.Build(requests);
+	ShaderCompiler.PrintStatistics();
+
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		std::string path_to_glsl = "Shaders/";
+		path_to_glsl.append(requests[i].Name);
+
+		ShaderCode& code = shaders[requests[i].Name];
+		LoadShaderSource(path_to_glsl.c_str(), code.Source);
+		code.SpirV = std::move(results[i].SpirV);
+		code.Code = reinterpret_cast<const uint32_t*>(code.SpirV.data());
+		code.CodeSize = code.SpirV.size();
 	}
 }
 
 void Vulkan_Engine::VRender::PrintShadersMap()
 {
-	std::map<std::string, std::pair<std::vector<char>, std::vector<char>>>::reverse_iterator it = shaders.rbegin();
+	std::map<std::string, ShaderCode>::reverse_iterator it = shaders.rbegin();
 
-	SetConsoleTextAttribute(HConsole, 14);
+	Platform::SetConsoleColor(HConsole, 14);
 	std::cout << "\n\nShaders map contains:\n\n";
-	SetConsoleTextAttribute(HConsole, 11);
+	Platform::SetConsoleColor(HConsole, 11);
 
 	for (it = shaders.rbegin(); it != shaders.rend(); ++it)
 	{
-		SetConsoleTextAttribute(HConsole, 9);
+		Platform::SetConsoleColor(HConsole, 9);
 		std::cout << it->first << " \n\n ";
-		SetConsoleTextAttribute(HConsole, 11);
-		for (auto x : it->second.first) {
+		Platform::SetConsoleColor(HConsole, 11);
+		for (auto x : it->second.Source) {
 			std::cout << x;
 		}
+		if (it->second.Source.empty()) std::cout << "SPIR-V mapped from " << ShaderArchivePath << ", " << it->second.CodeSize << " bytes";
 
 		std::cout << '\n' << std::endl;
 	}
-	SetConsoleTextAttribute(HConsole, 15);
+	Platform::SetConsoleColor(HConsole, 15);
 }
 
-VkShaderModule Vulkan_Engine::VRender::CreateShaderModule(const char* ShaderName,const std::vector<char>& code)
+VkShaderModule Vulkan_Engine::VRender::CreateShaderModule(const char* ShaderName, const uint32_t* code, size_t codeSize)
 {
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+	createInfo.codeSize = codeSize;
+	createInfo.pCode = code;
 
 	VkShaderModule ShaderModule;
 
 	if (vkCreateShaderModule(LogicalDevice, &createInfo, nullptr, &ShaderModule) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		std::string errorMessage = "ERROR :: FAILED TO CREATE SHADER MODULE FOR ";
 		errorMessage.append(ShaderName);
 		errorMessage.append(" Shader");
 		throw std::runtime_error(errorMessage);
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 	return ShaderModule;
 }
 
 void Vulkan_Engine::VRender::CreateRenderPass()
 {
-	//Subpass Dependency
-	SubpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	SubpassDependency.dstSubpass = 0;
-	SubpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	SubpassDependency.srcAccessMask = 0;
-	SubpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	SubpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	//Attachment Description
-	ColorAttachment.format = format.format;
-	ColorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	ColorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	ColorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	ColorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	ColorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	ColorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	ColorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	//Attachment Reference
-	ColorAttachmentRef.attachment = 0;
-	ColorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	//Subpass
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &ColorAttachmentRef;
-
-	//Render Pass
-	RenderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	RenderPassCreateInfo.attachmentCount = 1;
-	RenderPassCreateInfo.pAttachments = &ColorAttachment;
-	RenderPassCreateInfo.subpassCount = 1;
-	RenderPassCreateInfo.pSubpasses = &subpass;
-	RenderPassCreateInfo.dependencyCount = 1;
-	RenderPassCreateInfo.pDependencies = &SubpassDependency;
-
-	if (vkCreateRenderPass(LogicalDevice, &RenderPassCreateInfo, nullptr, &RenderPass) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
-		throw std::runtime_error("ERROR :: FAILED TO CREATE RENDER PASSES");
-		SetConsoleTextAttribute(HConsole, 15);
+	FrameGraph.Create(LogicalDevice, &MemoryAllocator, &StateTracker);
+	if (DynamicRendering) FrameGraph.SetDynamicRendering(CmdBeginRendering, CmdEndRendering);
+
+	//the acquire semaphore waits at the color output stage, the image was last used there by the presentation engine.
+	//PRESENT_SRC_KHR layout belongs to the swapchain extension which is not enabled in headless mode
+	BackbufferResource = FrameGraph.ImportImage("backbuffer", format.format, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+		(mode == RENDER_MODE::WINDOWED) ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	//the depth buffer only lives during the frame, nothing is stored once the scene pass is done
+	DepthFormat = SelectDepthFormat(false);
+	BaseClearDepth.depthStencil = { 1.0f, 0 };
+	RenderGraphImageDescription DepthDescription;
+	DepthDescription.Format = DepthFormat;
+	SceneDepthResource = FrameGraph.CreateImage("depth", DepthDescription);
+
+	//with the pre-pass the depth is complete before the scene pass, which only tests against it
+	VRenderGraph::ExecuteFunction record = [this](VkCommandBuffer commandBuffer, const RenderGraphPassContext& context) { RecordScenePass(commandBuffer, context); };
+	DepthPass = UINT32_MAX;
+	if (DepthPrePass)
+	{
+		DepthPass = FrameGraph.AddPass("depth prepass", record);
+		FrameGraph.WriteDepth(DepthPass, SceneDepthResource, &BaseClearDepth);
+	}
+	ScenePass = FrameGraph.AddPass("scene", record);
+	FrameGraph.WriteColor(ScenePass, BackbufferResource, &BaseClearColor);
+	if (DepthPrePass) FrameGraph.ReadDepth(ScenePass, SceneDepthResource);
+	else FrameGraph.WriteDepth(ScenePass, SceneDepthResource, &BaseClearDepth);
+	FrameGraph.Compile(extent);
+
+	RenderPass = FrameGraph.GetRenderPass(ScenePass);
+	RenderPassKey = FrameGraph.GetRenderPassKey(ScenePass);
+}
+
+void Vulkan_Engine::VRender::RecordScenePass(VkCommandBuffer commandBuffer, const RenderGraphPassContext& context)
+{
+	bool depthOnly = context.Pass == DepthPass;
+	if (SceneThreads <= 1)
+	{
+		RecordDraws(commandBuffer, *SceneDrawList, 0, static_cast<uint32_t>(SceneDrawList->size()), depthOnly);
+		return;
+	}
+
+	VkCommandBufferInheritanceInfo InheritanceInfo{};
+	InheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	InheritanceInfo.renderPass = context.RenderPass;
+	InheritanceInfo.subpass = 0;
+	InheritanceInfo.framebuffer = context.Framebuffer;
+	//with dynamic rendering the secondaries inherit the attachment formats instead of a render pass
+	VkCommandBufferInheritanceRenderingInfoKHR RenderingInheritance{};
+	if (DynamicRendering)
+	{
+		const std::vector<VkFormat>& colorFormats = FrameGraph.GetColorFormats(context.Pass);
+		RenderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+		RenderingInheritance.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+		RenderingInheritance.colorAttachmentCount = static_cast<uint32_t>(colorFormats.size());
+		RenderingInheritance.pColorAttachmentFormats = colorFormats.data();
+		RenderingInheritance.depthAttachmentFormat = FrameGraph.GetDepthFormat(context.Pass);
+		RenderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		InheritanceInfo.pNext = &RenderingInheritance;
+	}
+
+	//the secondaries inherit the render pass only, each one binds the pipeline and sets the dynamic state again
+	std::vector<VkCommandBuffer> secondaries;
+	const std::vector<DrawCommand>& draws = *SceneDrawList;
+	ParallelRecorder.Record(InheritanceInfo, static_cast<uint32_t>(draws.size()), SceneThreads,
+		[&](VkCommandBuffer secondary, uint32_t first, uint32_t count) { RecordDraws(secondary, draws, first, count, depthOnly); }, secondaries);
+	if (!secondaries.empty()) vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+}
+
+void Vulkan_Engine::VRender::CreatePipelineCache()
+{
+	PipelineCache.Create(LogicalDevice, VK_Phy_Device_Properties, PipelineCachePath);
+}
+
+void Vulkan_Engine::VRender::CreatePipelineBuilder()
+{
+	uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+	PipelineBuilder.Start(LogicalDevice, &PipelineCache, threadCount, IsDeviceExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME));
+}
+
+Vulkan_Engine::PipelineDescription Vulkan_Engine::VRender::DescribeGraphicsPipeline()
+{
+	PipelineDescription description;
+	description.Stages.assign(shaderStageCreateInfos, shaderStageCreateInfos + ShaderStageCount);
+	description.VertexBindings.assign(VertexInputInfo.pVertexBindingDescriptions, VertexInputInfo.pVertexBindingDescriptions + VertexInputInfo.vertexBindingDescriptionCount);
+	description.VertexAttributes.assign(VertexInputInfo.pVertexAttributeDescriptions, VertexInputInfo.pVertexAttributeDescriptions + VertexInputInfo.vertexAttributeDescriptionCount);
+	description.InputAssembly = InputAssembly;
+	description.Viewport = viewport;
+	description.Scissor = scissor;
+	description.Rasterizer = Rasterizer;
+	description.Multisampling = multisampling;
+	description.UseDepthStencil = true;
+	description.DepthStencil = DepthStencil;
+	description.ColorBlendAttachments.assign(1, ColorBlendAttachment);
+	description.ColorBlending = ColorBlending;
+	description.DynamicStates = DynamicStates;
+	description.Layout = PipelineLayout;
+	description.RenderPass = RenderPass;
+	description.Subpass = 0;
+	description.ColorFormats = FrameGraph.GetColorFormats(ScenePass);
+	description.DepthFormat = FrameGraph.GetDepthFormat(ScenePass);
+	return description;
+}
+
+std::vector<VkShaderModule> Vulkan_Engine::VRender::CreateStageModules(PipelineDescription& description)
+{
+	std::vector<VkShaderModule> modules;
+	for (uint32_t stageIndex = 0; stageIndex < ShaderStageCount; stageIndex++) {
+		for (auto& stage : description.Stages) {
+			if (stage.stage != shaderStageCreateInfos[stageIndex].stage) continue;
+			const ShaderCode& code = shaders[ShaderStageNames[stageIndex]];
+			modules.push_back(CreateShaderModule(ShaderStageNames[stageIndex].c_str(), code.Code, code.CodeSize));
+			stage.module = modules.back();
+		}
+	}
+	return modules;
+}
+
+void Vulkan_Engine::VRender::LoadExtendedDynamicState()
+{
+	ExtendedDynamicState = IsDeviceExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+	if (ExtendedDynamicState)
+	{
+		CmdSetCullMode = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(LogicalDevice, "vkCmdSetCullModeEXT");
+		CmdSetFrontFace = (PFN_vkCmdSetFrontFaceEXT)vkGetDeviceProcAddr(LogicalDevice, "vkCmdSetFrontFaceEXT");
+		CmdSetPrimitiveTopology = (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(LogicalDevice, "vkCmdSetPrimitiveTopologyEXT");
+		CmdSetDepthTestEnable = (PFN_vkCmdSetDepthTestEnableEXT)vkGetDeviceProcAddr(LogicalDevice, "vkCmdSetDepthTestEnableEXT");
+		CmdSetDepthWriteEnable = (PFN_vkCmdSetDepthWriteEnableEXT)vkGetDeviceProcAddr(LogicalDevice, "vkCmdSetDepthWriteEnableEXT");
+		CmdSetDepthCompareOp = (PFN_vkCmdSetDepthCompareOpEXT)vkGetDeviceProcAddr(LogicalDevice, "vkCmdSetDepthCompareOpEXT");
+		ExtendedDynamicState = CmdSetCullMode && CmdSetFrontFace && CmdSetPrimitiveTopology && CmdSetDepthTestEnable && CmdSetDepthWriteEnable && CmdSetDepthCompareOp;
+	}
+
+	Platform::SetConsoleColor(HConsole, 6);
+	if (ExtendedDynamicState) std::cout << "dynamic state : viewport, scissor, cull mode, front face, topology and depth (VK_EXT_extended_dynamic_state)\n";
+	else std::cout << "dynamic state : viewport and scissor, the other states are baked into the pipelines\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VRender::LoadDynamicRendering()
+{
+	if (IsDeviceExtensionEnabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		CmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(LogicalDevice, "vkCmdBeginRenderingKHR");
+		CmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(LogicalDevice, "vkCmdEndRenderingKHR");
+		DynamicRendering = CmdBeginRendering && CmdEndRendering;
+	}
+
+	Platform::SetConsoleColor(HConsole, 6);
+	if (DynamicRendering) std::cout << "render passes : dynamic rendering from the image views (VK_KHR_dynamic_rendering)\n";
+	else std::cout << "render passes : cached VkRenderPass and VkFramebuffer objects\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VRender::RecordDynamicState(VkCommandBuffer commandBuffer, const RasterState& state)
+{
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	if (!ExtendedDynamicState) return;
+
+	CmdSetCullMode(commandBuffer, state.CullMode);
+	CmdSetFrontFace(commandBuffer, state.FrontFace);
+	CmdSetPrimitiveTopology(commandBuffer, state.Topology);
+	CmdSetDepthTestEnable(commandBuffer, state.DepthTestEnable);
+	CmdSetDepthWriteEnable(commandBuffer, state.DepthWriteEnable);
+	CmdSetDepthCompareOp(commandBuffer, state.DepthCompareOp);
+}
+
+uint64_t Vulkan_Engine::VRender::HashShaderProgram()
+{
+	uint64_t hash = FNV1A_OFFSET_BASIS;
+	for (uint32_t stageIndex = 0; stageIndex < ShaderStageCount; stageIndex++) {
+		const ShaderCode& code = shaders[ShaderStageNames[stageIndex]];
+		hash = HashFNV1a(code.Code, code.CodeSize, hash);
+		hash = HashFNV1a(ShaderReflections[stageIndex].EntryPoint, hash);
+	}
+	return hash;
+}
+
+Vulkan_Engine::PipelineKey Vulkan_Engine::VRender::MakePipelineKey(const RasterState& state)
+{
+	//everything but the RasterState is the same for all the pipelines, only its bits are packed again (nothing is allocated on the draw path)
+	PipelineKey key = BasePipelineKey;
+	if (ExtendedDynamicState) return key;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = InputAssembly;
+	VkPipelineRasterizationStateCreateInfo rasterizer = Rasterizer;
+	VkPipelineDepthStencilStateCreateInfo depthStencil = DepthStencil;
+	inputAssembly.topology = state.Topology;
+	rasterizer.cullMode = state.CullMode;
+	rasterizer.frontFace = state.FrontFace;
+	depthStencil.depthTestEnable = state.DepthTestEnable;
+	depthStencil.depthWriteEnable = state.DepthWriteEnable;
+	depthStencil.depthCompareOp = state.DepthCompareOp;
+	key.RasterBits = VPipelineRegistry::PackRasterBits(inputAssembly, rasterizer, depthStencil, true, DynamicStateMask);
+	return key;
+}
+
+VkPipeline Vulkan_Engine::VRender::GetGraphicsPipeline(const RasterState& state)
+{
+	return PipelineRegistry.Get(MakePipelineKey(state), [this, &state]() {
+		PipelineDescription description = DescribeGraphicsPipeline();
+		ApplyRasterState(description, state);
+		std::vector<VkShaderModule> modules = CreateStageModules(description);
+		return SubmitGraphicsPipeline(description, modules);
+	});
+}
+
+void Vulkan_Engine::VRender::ApplyRasterState(PipelineDescription& description, const RasterState& state)
+{
+	description.InputAssembly.topology = state.Topology;
+	description.Rasterizer.cullMode = state.CullMode;
+	description.Rasterizer.frontFace = state.FrontFace;
+	description.DepthStencil.depthTestEnable = state.DepthTestEnable;
+	description.DepthStencil.depthWriteEnable = state.DepthWriteEnable;
+	description.DepthStencil.depthCompareOp = state.DepthCompareOp;
+}
+
+Vulkan_Engine::RasterState Vulkan_Engine::VRender::MakeSceneRasterState() const
+{
+	//the pre-pass wrote the nearest depth of every pixel, only the fragment that wrote it passes EQUAL and it is shaded once
+	RasterState state = CurrentRasterState;
+	state.DepthWriteEnable = VK_FALSE;
+	state.DepthCompareOp = VK_COMPARE_OP_EQUAL;
+	return state;
+}
+
+void Vulkan_Engine::VRender::MakeDepthOnly(PipelineDescription& description)
+{
+	//the rasterizer writes the depth alone
+	description.Stages.erase(std::remove_if(description.Stages.begin(), description.Stages.end(),
+		[](const VkPipelineShaderStageCreateInfo& stage) { return stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT; }), description.Stages.end());
+	description.ColorBlendAttachments.clear();
+	description.RenderPass = FrameGraph.GetRenderPass(DepthPass);
+	description.ColorFormats = FrameGraph.GetColorFormats(DepthPass);
+	description.DepthFormat = FrameGraph.GetDepthFormat(DepthPass);
+}
+
+VkPipeline Vulkan_Engine::VRender::SubmitGraphicsPipeline(const PipelineDescription& description, std::vector<VkShaderModule>& modules)
+{
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	try {
+		pipeline = PipelineBuilder.Submit(description).get();
+	}
+	catch (std::exception&) {
+		for (auto& module : modules) vkDestroyShaderModule(LogicalDevice, module, nullptr);
+		Platform::SetConsoleColor(HConsole, 12);
+		throw;
+	}
+	for (auto& module : modules) vkDestroyShaderModule(LogicalDevice, module, nullptr);
+	return pipeline;
+}
+
+void Vulkan_Engine::VRender::ResolveScenePipelines(VkPipeline builtScenePipeline, VkPipeline builtDepthPipeline)
+{
+	SceneRasterState = CurrentRasterState;
+	DepthRasterState = CurrentRasterState;
+	if (DepthPass == UINT32_MAX)
+	{
+		//built for a pre-pass turned off meanwhile, they never drew anything
+		if (builtScenePipeline != VK_NULL_HANDLE) vkDestroyPipeline(LogicalDevice, builtScenePipeline, nullptr);
+		if (builtDepthPipeline != VK_NULL_HANDLE) vkDestroyPipeline(LogicalDevice, builtDepthPipeline, nullptr);
+		ScenePipeline = GraphicsPipeline;
+		DepthPipeline = VK_NULL_HANDLE;
+		return;
 	}
 
+	SceneRasterState = MakeSceneRasterState();
+	PipelineKey sceneKey = MakePipelineKey(SceneRasterState);
+	//a state already drawing EQUAL without writes shares its pipeline with GraphicsPipeline, the built copy never drew anything
+	if (builtScenePipeline != VK_NULL_HANDLE && PipelineRegistry.Find(sceneKey) != VK_NULL_HANDLE) vkDestroyPipeline(LogicalDevice, builtScenePipeline, nullptr);
+	else PipelineRegistry.Insert(sceneKey, builtScenePipeline);
+	ScenePipeline = GetGraphicsPipeline(SceneRasterState);
+
+	PipelineDescription description = DescribeGraphicsPipeline();
+	MakeDepthOnly(description);
+	PipelineKey key = VPipelineRegistry::MakeKey(description, HashShaderProgram(), FrameGraph.GetRenderPassKey(DepthPass));
+	PipelineRegistry.Insert(key, builtDepthPipeline);
+	DepthPipeline = PipelineRegistry.Get(key, [this, &description]() {
+		std::vector<VkShaderModule> modules = CreateStageModules(description);
+		return SubmitGraphicsPipeline(description, modules);
+	});
 }
 
 void Vulkan_Engine::VRender::CreateGraphicsPipeline()
@@ -734,34 +1306,66 @@ void Vulkan_Engine::VRender::CreateGraphicsPipeline()
 	LoadCompileShaders();
 	PrintShadersMap();
 
+	//the stage, entry point and interface of every shader come from its SPIR-V, not from its file name
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nShader reflection\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	ShaderReflections.clear();
+	ShaderStageNames.clear();
 	for (const auto& x : shaders) 
 	{
-		ShaderModules.push_back(CreateShaderModule(x.first.c_str(), x.second.second));
+		if (ShaderReflections.size() == sizeof(shaderStageCreateInfos) / sizeof(shaderStageCreateInfos[0])) break;
+		try {
+			ShaderReflections.push_back(VSpirvReflect::Reflect(x.second.Code, x.second.CodeSize / sizeof(uint32_t)));
+		}
+		catch (std::exception&) {
+			Platform::SetConsoleColor(HConsole, 12);
+			throw;
+		}
+		VSpirvReflect::Print(x.first, ShaderReflections.back());
+		ShaderStageNames.push_back(x.first);
+		ShaderModules.push_back(CreateShaderModule(x.first.c_str(), x.second.Code, x.second.CodeSize));
 	}
 
 	//shaders - programmable
-	shaderStageCreateInfos[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shaderStageCreateInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-	shaderStageCreateInfos[0].module = ShaderModules[1];
-	shaderStageCreateInfos[0].pName = "main";
+	ShaderStageCount = static_cast<uint32_t>(ShaderModules.size());
+	const ShaderReflection* VertexReflection = nullptr;
+	for (uint32_t stageIndex = 0; stageIndex < ShaderStageCount; stageIndex++)
+	{
+		shaderStageCreateInfos[stageIndex] = {};
+		shaderStageCreateInfos[stageIndex].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStageCreateInfos[stageIndex].stage = ShaderReflections[stageIndex].Stage;
+		shaderStageCreateInfos[stageIndex].module = ShaderModules[stageIndex];
+		shaderStageCreateInfos[stageIndex].pName = ShaderReflections[stageIndex].EntryPoint.c_str();
+		if (ShaderReflections[stageIndex].Stage == VK_SHADER_STAGE_VERTEX_BIT) VertexReflection = &ShaderReflections[stageIndex];
+	}
 
-	shaderStageCreateInfos[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shaderStageCreateInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	shaderStageCreateInfos[1].module = ShaderModules[0];
-	shaderStageCreateInfos[1].pName = "main";
+	if (VertexReflection == nullptr) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: The graphics pipeline has no vertex shader");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
 
 	//Fixed functions
 
 	//Vertex input state
+	//the attributes come from the mesh vertex layout, the shader decides which of them are read
+	try {
+		VGeometry::BuildVertexInput(SceneVertexLayout, *VertexReflection, VertexBindingDescriptions, VertexAttributeDescriptions);
+	}
+	catch (std::exception&) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw;
+	}
 	VertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	VertexInputInfo.vertexBindingDescriptionCount = 0;
-	VertexInputInfo.pVertexBindingDescriptions = nullptr;
-	VertexInputInfo.vertexAttributeDescriptionCount = 0;
-	VertexInputInfo.pVertexAttributeDescriptions = nullptr;
+	VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexBindingDescriptions.size());
+	VertexInputInfo.pVertexBindingDescriptions = VertexBindingDescriptions.data();
+	VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexAttributeDescriptions.size());
+	VertexInputInfo.pVertexAttributeDescriptions = VertexAttributeDescriptions.data();
 
 	//Input assembly
 	InputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	InputAssembly.topology = CurrentRasterState.Topology;
 	InputAssembly.primitiveRestartEnable = VK_FALSE;
 
 	//Viewport
@@ -791,13 +1395,24 @@ void Vulkan_Engine::VRender::CreateGraphicsPipeline()
 	Rasterizer.rasterizerDiscardEnable = VK_FALSE; // always discard the geometry through the rasterizer if it set to true
 	Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
 	Rasterizer.lineWidth = 1.0f;
-	Rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	Rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	Rasterizer.cullMode = CurrentRasterState.CullMode;
+	Rasterizer.frontFace = CurrentRasterState.FrontFace;
 	Rasterizer.depthBiasEnable = VK_FALSE;
 	Rasterizer.depthBiasConstantFactor = 0.0f;
 	Rasterizer.depthBiasClamp = 0.0f;
 	Rasterizer.depthBiasSlopeFactor = 0.0f;
 	
+	//Depth & Stencil testing, the nearest fragment is kept
+	CurrentRasterState.DepthTestEnable = VK_TRUE;
+	CurrentRasterState.DepthWriteEnable = VK_TRUE;
+	CurrentRasterState.DepthCompareOp = VK_COMPARE_OP_LESS;
+	DepthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	DepthStencil.depthTestEnable = CurrentRasterState.DepthTestEnable;
+	DepthStencil.depthWriteEnable = CurrentRasterState.DepthWriteEnable;
+	DepthStencil.depthCompareOp = CurrentRasterState.DepthCompareOp;
+	DepthStencil.depthBoundsTestEnable = VK_FALSE;
+	DepthStencil.stencilTestEnable = VK_FALSE;
+
 	//Multisampling
 	VK_Phy_Device_Features.samplerAnisotropy = VK_TRUE;
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
@@ -830,84 +1445,72 @@ void Vulkan_Engine::VRender::CreateGraphicsPipeline()
 	ColorBlending.blendConstants[3] = 0.0f;
 
 	//Dynamic States
-	DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	DynamicState.dynamicStateCount = 4;
-	DynamicState.pDynamicStates = DynamicStates;
+	//a dynamic viewport and scissor let an extent change reuse the pipeline, the extended states let one pipeline serve every RasterState
+	DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	if (ExtendedDynamicState) {
+		DynamicStates.insert(DynamicStates.end(), {
+			VK_DYNAMIC_STATE_CULL_MODE_EXT,
+			VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+			VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+			VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT
+		});
+	}
+	DynamicStateMask = VPipelineRegistry::MakeDynamicStateMask(DynamicStates);
 
 	//Pipeline Layout
+	//sets not used by any stage still need a (empty) layout when a higher set number is used
+	ReflectedPipelineLayout ReflectedLayout = VSpirvReflect::MergeLayouts(ShaderReflections);
+	DescriptorSetLayouts.clear();
+	uint32_t SetCount = ReflectedLayout.Sets.empty() ? 0 : ReflectedLayout.Sets.rbegin()->first + 1;
+	for (uint32_t setIndex = 0; setIndex < SetCount; setIndex++)
+		DescriptorSetLayouts.push_back(DescriptorSetLayoutCache.Get(LogicalDevice, ReflectedLayout.Sets[setIndex]));
+	PushConstantRanges = ReflectedLayout.PushConstants;
+	std::cout << "descriptor set layouts : " << DescriptorSetLayoutCache.GetLayoutCount() << " created, " << DescriptorSetLayoutCache.GetReuseCount() << " reused\n";
+
 	PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	PipelineLayoutCreateInfo.setLayoutCount = 0;
-	PipelineLayoutCreateInfo.pSetLayouts = nullptr;
-	PipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	PipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+	PipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(DescriptorSetLayouts.size());
+	PipelineLayoutCreateInfo.pSetLayouts = DescriptorSetLayouts.data();
+	PipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(PushConstantRanges.size());
+	PipelineLayoutCreateInfo.pPushConstantRanges = PushConstantRanges.data();
 
 	if (vkCreatePipelineLayout(LogicalDevice, &PipelineLayoutCreateInfo, nullptr, &PipelineLayout) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: Failed to create the pipeline layout");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 
-	PipelineCreationInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	PipelineCreationInfo.stageCount = 2;
-	PipelineCreationInfo.pStages = shaderStageCreateInfos;
-
-	PipelineCreationInfo.pVertexInputState = &VertexInputInfo;
-	PipelineCreationInfo.pInputAssemblyState = &InputAssembly;
-	PipelineCreationInfo.pViewportState = &ViewportState;
-	PipelineCreationInfo.pRasterizationState = &Rasterizer;
-	PipelineCreationInfo.pMultisampleState = &multisampling;
-	PipelineCreationInfo.pDepthStencilState = nullptr;
-	PipelineCreationInfo.pColorBlendState = &ColorBlending;
-	PipelineCreationInfo.pDynamicState = nullptr;
-	//PipelineCreationInfo.pDynamicState = &DynamicState;
-
-	PipelineCreationInfo.layout = PipelineLayout;
-	PipelineCreationInfo.renderPass = RenderPass;
-	PipelineCreationInfo.subpass = 0;
-
-	PipelineCreationInfo.basePipelineHandle = VK_NULL_HANDLE;
-	PipelineCreationInfo.basePipelineIndex = -1;
-
-	if (vkCreateGraphicsPipelines(LogicalDevice, VK_NULL_HANDLE, 1, &PipelineCreationInfo, nullptr, &GraphicsPipeline) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
-		throw std::runtime_error("ERROR :: Failed to create the graphics pipeline");
-		SetConsoleTextAttribute(HConsole, 15);
+	//the pipeline is compiled by the pipeline build service, this function only describes it
+	try {
+		PipelineDescription description = DescribeGraphicsPipeline();
+		BasePipelineKey = VPipelineRegistry::MakeKey(description, HashShaderProgram(), RenderPassKey);
+		GraphicsPipeline = PipelineBuilder.Submit(description).get();
+		PipelineRegistry.Create(LogicalDevice);
+		PipelineRegistry.Insert(MakePipelineKey(CurrentRasterState), GraphicsPipeline);
+		ResolveScenePipelines();
+	}
+	catch (std::exception&) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw;
 	}
 
 	for (auto& x : ShaderModules)
 		vkDestroyShaderModule(LogicalDevice, x, nullptr);
 
-	ShaderModules.~vector();
+	ShaderModules.clear();
 
 
 }
 
 void Vulkan_Engine::VRender::CreateFrameBuffers()
 {
-	SwapChainFrameBuffers.resize(SwapChainImageViews.size());
-	FrameBuffersCreateInfo.resize(SwapChainImageViews.size());
-
+	//the graph creates the framebuffer of a pass the first time it sees its images, one per swapchain image here so the
+	//first frames do not pay for it. Nothing to create with dynamic rendering
+	if (FrameGraph.IsDynamicRendering()) return;
 	for (size_t i = 0; i < SwapChainImageViews.size(); i++) {
-
-		VkImageView Attachments[] = { SwapChainImageViews[i] };
-		FrameBuffersCreateInfo[i].sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		FrameBuffersCreateInfo[i].renderPass = RenderPass;
-		FrameBuffersCreateInfo[i].attachmentCount = 1;
-		FrameBuffersCreateInfo[i].pAttachments = Attachments;
-		FrameBuffersCreateInfo[i].width = extent.width;
-		FrameBuffersCreateInfo[i].height = extent.height;
-		FrameBuffersCreateInfo[i].layers = 1;
-
-		if (vkCreateFramebuffer(LogicalDevice, &FrameBuffersCreateInfo[i], nullptr, &SwapChainFrameBuffers[i]) != VK_SUCCESS) 
-		{
-			SetConsoleTextAttribute(HConsole, 12);
-			std::string error_message = "ERROR :: Failed to create the FrameBuffer at the ImageView number : ";
-			std::string tmp = std::to_string(i);
-			char const* num = tmp.c_str();
-			error_message.append(num);
-			throw std::runtime_error(error_message);
-			SetConsoleTextAttribute(HConsole, 15);
-		}
+		FrameGraph.BindImport(BackbufferResource, SwapChainImages[i], SwapChainImageViews[i]);
+		FrameGraph.GetFramebuffer(ScenePass);
 	}
 }
 
@@ -920,147 +1523,422 @@ void Vulkan_Engine::VRender::CreateCommandPool()
 
 	if (vkCreateCommandPool(LogicalDevice, &CommandPoolCreateInfo, nullptr, &CommandPool) != VK_SUCCESS)
 	{
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: Failed to create the Command Pool");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
 }
 
-void Vulkan_Engine::VRender::CreateCommandBuffers()
+void Vulkan_Engine::VRender::UploadBuffer(VkBufferUsageFlags usage, const void* data, VkDeviceSize size, VkBuffer& buffer, MemoryAllocation& allocation)
 {
-	CommandBuffers.resize(SwapChainFrameBuffers.size());
-
-	CommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	CommandBufferAllocateInfo.commandPool = CommandPool;
-	CommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	CommandBufferAllocateInfo.commandBufferCount = (uint32_t)CommandBuffers.size();
-
-	if (vkAllocateCommandBuffers(LogicalDevice, &CommandBufferAllocateInfo, CommandBuffers.data()) != VK_SUCCESS)
+	VkBufferCreateInfo BufferCreateInfo{};
+	BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	BufferCreateInfo.size = size;
+	BufferCreateInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	MemoryUsage DeviceUsage;
+	DeviceUsage.Required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	MemoryAllocator.CreateBuffer(BufferCreateInfo, DeviceUsage, buffer, allocation);
+
+	//buffers bigger than the ring go through it in chunks, a flush in between when it is full
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	VUploadRing::GetReadAccess(usage, stage, access);
+	VkDeviceSize chunkSize = UploadRing.GetCapacity() / 4;
+	const char* bytes = static_cast<const char*>(data);
+	for (VkDeviceSize offset = 0; offset < size;)
 	{
-		SetConsoleTextAttribute(HConsole, 12);
-		throw std::runtime_error("ERROR :: Failed to allocate the command buffers");
-		SetConsoleTextAttribute(HConsole, 15);
+		VkDeviceSize copySize = std::min(chunkSize, size - offset);
+		if (UploadRing.Enqueue(buffer, offset, bytes + offset, copySize, stage, access)) {
+			offset += copySize;
+			continue;
+		}
+		FlushUploadsAndWait();
+		if (!UploadRing.Enqueue(buffer, offset, bytes + offset, copySize, stage, access))
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to stage a buffer upload in an empty upload ring");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		offset += copySize;
 	}
+	FlushUploadsAndWait();
+}
 
-	size_t i = 0;
-	for (auto& commandbuffer : CommandBuffers) {
-		VkCommandBufferBeginInfo BeginInfo{};
-		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-		BeginInfo.pInheritanceInfo = nullptr;
+void Vulkan_Engine::VRender::FlushUploadsAndWait()
+{
+	FrameUploads uploads = UploadRing.Flush(static_cast<uint32_t>(Current_Frame));
+	if (uploads.Semaphore == VK_NULL_HANDLE) return;
 
-		if (vkBeginCommandBuffer(commandbuffer, &BeginInfo) != VK_SUCCESS) {
-			SetConsoleTextAttribute(HConsole, 12);
-			throw std::runtime_error("ERROR :: Failed to begin a command buffer");
-			SetConsoleTextAttribute(HConsole, 15);
-		}
+	VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo{};
+	TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	TimelineSubmitInfo.waitSemaphoreValueCount = 1;
+	TimelineSubmitInfo.pWaitSemaphoreValues = &uploads.WaitValue;
 
-		VkRenderPassBeginInfo RenderPassBeginInfo{};
-		RenderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		RenderPassBeginInfo.renderPass = RenderPass;
-		RenderPassBeginInfo.framebuffer = SwapChainFrameBuffers[i];
+	VkSubmitInfo SubmitInfo{};
+	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	SubmitInfo.pNext = &TimelineSubmitInfo;
+	SubmitInfo.waitSemaphoreCount = 1;
+	SubmitInfo.pWaitSemaphores = &uploads.Semaphore;
+	SubmitInfo.pWaitDstStageMask = &uploads.WaitStage;
+	SubmitInfo.commandBufferCount = uploads.AcquireCommandBuffer != VK_NULL_HANDLE ? 1 : 0;
+	SubmitInfo.pCommandBuffers = &uploads.AcquireCommandBuffer;
+	if (vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to submit the upload acquire in the graphics queue");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	vkQueueWaitIdle(VK_GraphicsQueue);
+	UploadRing.WaitIdle();
+}
 
-		RenderPassBeginInfo.renderArea.offset = { 0,0 };
-		RenderPassBeginInfo.renderArea.extent = extent;
+void Vulkan_Engine::VRender::CreateMesh(const void* vertices, uint32_t vertexCount, const std::vector<uint32_t>& indices, Mesh& mesh)
+{
+	mesh.VertexCount = vertexCount;
+	mesh.IndexCount = static_cast<uint32_t>(indices.size());
+	mesh.IndexType = VGeometry::SelectIndexType(vertexCount);
+	std::vector<char> packedIndices = VGeometry::PackIndices(indices, mesh.IndexType);
 
-		VkClearValue ClearColor = BaseClearColor;
+	UploadBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices, VkDeviceSize(vertexCount) * SceneVertexLayout.Stride, mesh.VertexBuffer, mesh.VertexMemory);
+	UploadBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, packedIndices.data(), packedIndices.size(), mesh.IndexBuffer, mesh.IndexMemory);
+}
 
-		RenderPassBeginInfo.clearValueCount = 1;
-		RenderPassBeginInfo.pClearValues = &ClearColor;
+void Vulkan_Engine::VRender::DestroyMesh(Mesh& mesh)
+{
+	MemoryAllocator.DestroyBuffer(mesh.VertexBuffer, mesh.VertexMemory);
+	MemoryAllocator.DestroyBuffer(mesh.IndexBuffer, mesh.IndexMemory);
+	mesh.VertexCount = mesh.IndexCount = 0;
+}
 
-		vkCmdBeginRenderPass(commandbuffer, &RenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(commandbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GraphicsPipeline);
-		vkCmdDraw(commandbuffer, 3, 1, 0, 0);
+void Vulkan_Engine::VRender::CreateSceneGeometry()
+{
+	//the triangle the vertex shader used to hardcode : vec2 position, vec3 color
+	const float vertices[] = {
+		0.0f, -0.5f,	1.0f, 0.0f, 0.0f,
+		0.5f, 0.5f,		0.0f, 1.0f, 0.0f,
+		-0.5f, 0.5f,	0.0f, 0.0f, 1.0f
+	};
+	CreateMesh(vertices, 3, { 0, 1, 2 }, SceneMesh);
+	SceneDraws.assign(1, DrawCommand{ &SceneMesh });
+	SortFrontToBack(SceneDraws);
+}
 
-		vkCmdEndRenderPass(commandbuffer);
+void Vulkan_Engine::VRender::RecordMeshDraw(VkCommandBuffer commandBuffer, const Mesh& mesh)
+{
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh.VertexBuffer, &offset);
+	vkCmdBindIndexBuffer(commandBuffer, mesh.IndexBuffer, 0, mesh.IndexType);
+	vkCmdDrawIndexed(commandBuffer, mesh.IndexCount, 1, 0, 0, 0);
+}
 
-		if (vkEndCommandBuffer(commandbuffer) != VK_SUCCESS) 
+void Vulkan_Engine::VRender::RecordDraws(VkCommandBuffer commandBuffer, const std::vector<DrawCommand>& draws, uint32_t first, uint32_t count, bool depthOnly)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthOnly ? DepthPipeline : ScenePipeline);
+	RecordDynamicState(commandBuffer, depthOnly ? DepthRasterState : SceneRasterState);
+
+	//the shaders output z = 0, a draw at another depth gets a viewport whose depth range is that single value.
+	//both passes place a draw at the same depth, which is what the EQUAL test of the scene pass needs
+	VkViewport drawViewport = viewport;
+	const Mesh* boundMesh = nullptr;
+	for (uint32_t index = first; index < first + count; index++)
+	{
+		const DrawCommand& draw = draws[index];
+		if (draw.Depth != drawViewport.minDepth)
 		{
-			SetConsoleTextAttribute(HConsole, 12);
-			throw std::runtime_error("ERROR :: Failed to end a command buffer");
-			SetConsoleTextAttribute(HConsole, 15);
+			drawViewport.minDepth = draw.Depth;
+			drawViewport.maxDepth = draw.Depth;
+			vkCmdSetViewport(commandBuffer, 0, 1, &drawViewport);
 		}
-		i++;
+		if (draw.DrawMesh != boundMesh)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.DrawMesh->VertexBuffer, &offset);
+			vkCmdBindIndexBuffer(commandBuffer, draw.DrawMesh->IndexBuffer, 0, draw.DrawMesh->IndexType);
+			boundMesh = draw.DrawMesh;
+		}
+		vkCmdDrawIndexed(commandBuffer, draw.DrawMesh->IndexCount, draw.InstanceCount, 0, 0, draw.FirstInstance);
 	}
 }
 
-void Vulkan_Engine::VRender::CreateSemaphores()
+void Vulkan_Engine::VRender::SortFrontToBack(std::vector<DrawCommand>& draws)
 {
-	ImageAvailableSemaphore.resize(MAX_FRAMES_IN_FLIGHT);
-	RenderFinishedSemaphore.resize(MAX_FRAMES_IN_FLIGHT);
-	VkSemaphoreCreateInfo SemaphoreCreateInfo{};
-	SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-	for(size_t semaphoreIndex = 0 ; semaphoreIndex < MAX_FRAMES_IN_FLIGHT ; semaphoreIndex++)
-	if (vkCreateSemaphore(LogicalDevice, &SemaphoreCreateInfo, nullptr, &ImageAvailableSemaphore[semaphoreIndex]) != VK_SUCCESS
-		|| vkCreateSemaphore(LogicalDevice, &SemaphoreCreateInfo, nullptr, &RenderFinishedSemaphore[semaphoreIndex]) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
-		throw std::runtime_error("ERROR :: Failed to create the Semaphores");
-		SetConsoleTextAttribute(HConsole, 15);
-	}
+	std::stable_sort(draws.begin(), draws.end(), [](const DrawCommand& a, const DrawCommand& b) {
+		if (a.Depth != b.Depth) return a.Depth < b.Depth;
+		return std::less<const Mesh*>()(a.DrawMesh, b.DrawMesh);
+	});
 }
 
-void Vulkan_Engine::VRender::CreateFences()
+void Vulkan_Engine::VRender::CreateCommandBuffers()
 {
-	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-	ImagesInFlight.resize(SwapChainImages.size(), VK_NULL_HANDLE);
-	VkFenceCreateInfo FenceCreateInfo{};
-	FenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	FenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-	for (size_t index = 0; index < MAX_FRAMES_IN_FLIGHT; index++) {
-		if (vkCreateFence(LogicalDevice, &FenceCreateInfo, nullptr, &inFlightFences[index]) != VK_SUCCESS)
+	//one transient pool per frame in flight, reset as a whole once the previous frame of its slot is complete
+	FrameCommandPools.Resize(FramesInFlight, VK_NULL_HANDLE);
+	FrameCommandBuffers.Resize(FramesInFlight, VK_NULL_HANDLE);
+
+	VkCommandPoolCreateInfo FramePoolCreateInfo{};
+	FramePoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	FramePoolCreateInfo.queueFamilyIndex = queueFamiliesindices.GraphicsFamily.value();
+	FramePoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	CommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	CommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	CommandBufferAllocateInfo.commandBufferCount = 1;
+
+	for (size_t frame = 0; frame < FrameCommandPools.GetFrameCount(); frame++)
+	{
+		if (vkCreateCommandPool(LogicalDevice, &FramePoolCreateInfo, nullptr, &FrameCommandPools[frame]) != VK_SUCCESS)
 		{
-			SetConsoleTextAttribute(HConsole, 12);
-			throw std::runtime_error("ERROR :: Failed to create the Fences");
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create a frame command pool");
+			Platform::SetConsoleColor(HConsole, 15);
 		}
-	}
 
+		CommandBufferAllocateInfo.commandPool = FrameCommandPools[frame];
+		if (vkAllocateCommandBuffers(LogicalDevice, &CommandBufferAllocateInfo, &FrameCommandBuffers[frame]) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to allocate the command buffers");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
 }
 
-void Vulkan_Engine::VRender::DrawFrame()
+void Vulkan_Engine::VRender::RecordCommandBuffer(VkCommandBuffer commandbuffer, uint32_t imageIndex)
 {
+	VkCommandBufferBeginInfo BeginInfo{};
+	BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	BeginInfo.pInheritanceInfo = nullptr;
+
+	if (vkBeginCommandBuffer(commandbuffer, &BeginInfo) != VK_SUCCESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to begin a command buffer");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
 
-	vkWaitForFences(LogicalDevice, 1, &inFlightFences[Current_Frame], VK_TRUE, UINT32_MAX);
+	FrameGraph.BindImport(BackbufferResource, SwapChainImages[imageIndex], SwapChainImageViews[imageIndex]);
+	SceneDrawList = &SceneDraws;
+	SceneThreads = 1;
+	if (DepthPass != UINT32_MAX) FrameGraph.SetPassContents(DepthPass, VK_SUBPASS_CONTENTS_INLINE);
+	FrameGraph.SetPassContents(ScenePass, VK_SUBPASS_CONTENTS_INLINE);
+	FrameGraph.Execute(commandbuffer);
 
-	uint32_t imageIndex;
-	vkAcquireNextImageKHR(LogicalDevice, VK_SwapChain, UINT64_MAX, ImageAvailableSemaphore[Current_Frame], VK_NULL_HANDLE, &imageIndex);
+	if (vkEndCommandBuffer(commandbuffer) != VK_SUCCESS) 
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to end a command buffer");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+}
+
+void Vulkan_Engine::VRender::RecordParallel(VkCommandBuffer commandbuffer, uint32_t imageIndex, const std::vector<DrawCommand>& draws, uint32_t threadCount)
+{
+	FrameGraph.BindImport(BackbufferResource, SwapChainImages[imageIndex], SwapChainImageViews[imageIndex]);
+	SceneDrawList = &draws;
+	SceneThreads = threadCount;
+	if (DepthPass != UINT32_MAX) FrameGraph.SetPassContents(DepthPass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	FrameGraph.SetPassContents(ScenePass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	FrameGraph.Execute(commandbuffer);
+}
+
+void Vulkan_Engine::VRender::RecordFrame(uint32_t imageIndex)
+{
+	//the previous frame of the slot is complete, nothing recorded from this pool or from the recording threads pools is pending anymore
+	vkResetCommandPool(LogicalDevice, FrameCommandPools[Current_Frame], 0);
+	if (RecordingThreads <= 1)
+	{
+		RecordCommandBuffer(FrameCommandBuffers[Current_Frame], imageIndex);
+		StateTracker.EndFrame();
+		return;
+	}
+
+	ParallelRecorder.BeginFrame(static_cast<uint32_t>(Current_Frame));
+	VkCommandBuffer commandbuffer = FrameCommandBuffers[Current_Frame];
+	VkCommandBufferBeginInfo BeginInfo{};
+	BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandbuffer, &BeginInfo) != VK_SUCCESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to begin a command buffer");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	RecordParallel(commandbuffer, imageIndex, SceneDraws, RecordingThreads);
+	if (vkEndCommandBuffer(commandbuffer) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to end a command buffer");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	StateTracker.EndFrame();
+}
 
-	if (ImagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-		vkWaitForFences(LogicalDevice, 1, &ImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+void Vulkan_Engine::VRender::CreateSemaphores()
+{
+	ImageAvailableSemaphore.Resize(FramesInFlight, VK_NULL_HANDLE);
+	RenderFinishedSemaphore.Resize(FramesInFlight, VK_NULL_HANDLE);
+	VkSemaphoreCreateInfo SemaphoreCreateInfo{};
+	SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for(size_t semaphoreIndex = 0 ; semaphoreIndex < FramesInFlight ; semaphoreIndex++)
+	if (vkCreateSemaphore(LogicalDevice, &SemaphoreCreateInfo, nullptr, &ImageAvailableSemaphore[semaphoreIndex]) != VK_SUCCESS
+		|| vkCreateSemaphore(LogicalDevice, &SemaphoreCreateInfo, nullptr, &RenderFinishedSemaphore[semaphoreIndex]) != VK_SUCCESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to create the Semaphores");
+		Platform::SetConsoleColor(HConsole, 15);
 	}
+}
+
+void Vulkan_Engine::VRender::CreateTimelines()
+{
+	GraphicsTimeline.Create(LogicalDevice, "Graphics");
+	ImageFrames.assign(SwapChainImages.size(), 0);
+}
+
+void Vulkan_Engine::VRender::CreateFrameResources()
+{
+	CreateCommandBuffers();
+	ParallelRecorder.Start(LogicalDevice, queueFamiliesindices.GraphicsFamily.value(), &Jobs, FramesInFlight);
+	CreateSemaphores();
+	FrameValues.Resize(FramesInFlight, 0);
+	Current_Frame = 0;
+}
+
+void Vulkan_Engine::VRender::DestroyFrameResources()
+{
+	for (auto& semaphore : RenderFinishedSemaphore) vkDestroySemaphore(LogicalDevice, semaphore, nullptr);
+	for (auto& semaphore : ImageAvailableSemaphore) vkDestroySemaphore(LogicalDevice, semaphore, nullptr);
+	RenderFinishedSemaphore.Clear();
+	ImageAvailableSemaphore.Clear();
+	ParallelRecorder.Stop();
+	//destroying a pool frees its command buffer
+	for (auto& framePool : FrameCommandPools) vkDestroyCommandPool(LogicalDevice, framePool, nullptr);
+	FrameCommandPools.Clear();
+	FrameCommandBuffers.Clear();
+	FrameValues.Clear();
+}
+
+void Vulkan_Engine::VRender::SetDepthPrePass(bool enable)
+{
+	if (enable == DepthPrePass) return;
 
-	ImagesInFlight[imageIndex] = inFlightFences[Current_Frame];
+	//the graph, its render passes and its transient depth are rebuilt, the frames in flight may still use them
+	vkDeviceWaitIdle(LogicalDevice);
+	FrameGraph.Destroy();
+	DepthPrePass = enable;
+	CreateRenderPass();
+	CreateFrameBuffers();
+
+	//the render pass dependencies changed, so did the key of every pipeline drawing in the scene pass
+	try {
+		BasePipelineKey = VPipelineRegistry::MakeKey(DescribeGraphicsPipeline(), HashShaderProgram(), RenderPassKey);
+		GraphicsPipeline = GetGraphicsPipeline(CurrentRasterState);
+		ResolveScenePipelines();
+	}
+	catch (std::exception&) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw;
+	}
+}
+
+void Vulkan_Engine::VRender::SetFramesInFlight(uint32_t frameCount)
+{
+	frameCount = std::max(1u, std::min(frameCount, MAX_FRAMES_IN_FLIGHT));
+	if (frameCount == FramesInFlight) return;
+
+	//the binary semaphores of a slot may be waited on by a pending present, nothing may be in flight while they are destroyed
+	vkDeviceWaitIdle(LogicalDevice);
+	DestroyFrameResources();
+	FramesInFlight = frameCount;
+	CreateFrameResources();
+}
+
+void Vulkan_Engine::VRender::DrawFrame()
+{
+	ProcessShaderReloads();
+
+	if (mode == RENDER_MODE::HEADLESS) return DrawOffscreenFrame();
+
+	//the slot is free once the frame submitted from it FramesInFlight frames ago is complete
+	GraphicsTimeline.Wait(FrameValues[Current_Frame]);
+
+	uint32_t imageIndex;
+	VkResult acquireResult = vkAcquireNextImageKHR(LogicalDevice, VK_SwapChain, UINT64_MAX, ImageAvailableSemaphore[Current_Frame], VK_NULL_HANDLE, &imageIndex);
+	//nothing can be presented to an out of date swapchain, the frame is skipped. A suboptimal image is still presentable,
+	//the swapchain is recreated after the present
+	if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+		RecreateSwapChain();
+		return;
+	}
+	if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to acquire a swapchain image");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	//the swapchains retired before this one can go once all its images went through the presentation engine
+	if (UnacquiredSwapChainImages && !SwapChainImagesAcquired[imageIndex])
+	{
+		SwapChainImagesAcquired[imageIndex] = true;
+		if (--UnacquiredSwapChainImages == 0) AcquiredSwapChainGeneration = SwapChainGeneration;
+	}
+
+	//the image may still be rendered by a frame of another slot when the swapchain has more images than frames in flight
+	GraphicsTimeline.Wait(ImageFrames[imageIndex]);
+
+	//input is sampled once every wait of the frame is behind it, as late as possible before it is recorded
+	SampleInput();
+	RecordFrame(imageIndex);
+
+	//the uploads of the frame are copied while it waits for its image, the frame waits for them only where it reads them
+	FrameUploads uploads = UploadRing.Flush(static_cast<uint32_t>(Current_Frame));
+
+	uint64_t frame = GraphicsTimeline.Advance();
+	FrameValues[Current_Frame] = frame;
+	ImageFrames[imageIndex] = frame;
+
+	//binary semaphores ignore their value in VkTimelineSemaphoreSubmitInfo
+	VkSemaphore waitSemaphores[] = { ImageAvailableSemaphore[Current_Frame], uploads.Semaphore };
+	uint64_t waitValues[] = { 0, uploads.WaitValue };
+	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, uploads.WaitStage };
+	uint32_t waitCount = uploads.Semaphore != VK_NULL_HANDLE ? 2 : 1;
+	VkSemaphore signalSemaphores[] = { RenderFinishedSemaphore[Current_Frame], GraphicsTimeline.GetSemaphore() };
+	uint64_t signalValues[] = { 0, frame };
+
+	VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo{};
+	TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	TimelineSubmitInfo.waitSemaphoreValueCount = waitCount;
+	TimelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+	TimelineSubmitInfo.signalSemaphoreValueCount = 2;
+	TimelineSubmitInfo.pSignalSemaphoreValues = signalValues;
 
 	VkSubmitInfo SubmitInfo{};
 
 	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	SubmitInfo.pNext = &TimelineSubmitInfo;
 
-	VkSemaphore waitSemaphores[] = { ImageAvailableSemaphore[Current_Frame] };
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-
-	SubmitInfo.waitSemaphoreCount = 1;
+	SubmitInfo.waitSemaphoreCount = waitCount;
 	SubmitInfo.pWaitSemaphores = waitSemaphores;
 	SubmitInfo.pWaitDstStageMask = waitStages;
 
-	SubmitInfo.commandBufferCount = 1;
-	SubmitInfo.pCommandBuffers = &CommandBuffers[imageIndex];
+	//the ownership acquire runs first in the frame
+	VkCommandBuffer frameCommandBuffers[] = { uploads.AcquireCommandBuffer, FrameCommandBuffers[Current_Frame] };
+	bool acquire = uploads.AcquireCommandBuffer != VK_NULL_HANDLE;
+	SubmitInfo.commandBufferCount = acquire ? 2 : 1;
+	SubmitInfo.pCommandBuffers = acquire ? frameCommandBuffers : &frameCommandBuffers[1];
 
-	VkSemaphore signalSemaphores[] = { RenderFinishedSemaphore[Current_Frame] };
-	SubmitInfo.signalSemaphoreCount = 1;
+	SubmitInfo.signalSemaphoreCount = 2;
 	SubmitInfo.pSignalSemaphores = signalSemaphores;
 
-	vkResetFences(LogicalDevice, 1, &inFlightFences[Current_Frame]);
-
-	if (vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, inFlightFences[Current_Frame]) != VK_SUCCESS) {
-		SetConsoleTextAttribute(HConsole, 12);
+	if (vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error("ERROR :: Failed to submit the command buffer in the graphics queue");
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 	}
+	FramePacer.MarkSubmitted();
+	if (MainThreadInEvents.load(std::memory_order_relaxed)) SubmitsDuringEvents++;
 
 	PresentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	PresentInfo.waitSemaphoreCount = 1;
-	PresentInfo.pWaitSemaphores = signalSemaphores;
+	PresentInfo.pWaitSemaphores = &RenderFinishedSemaphore[Current_Frame];
 
 	VkSwapchainKHR SwapChains[] = { VK_SwapChain };
 	PresentInfo.swapchainCount = 1;
@@ -1068,13 +1946,349 @@ void Vulkan_Engine::VRender::DrawFrame()
 	PresentInfo.pImageIndices = &imageIndex;
 	PresentInfo.pResults = nullptr;
 
-	vkQueuePresentKHR(VK_PresentQueue, &PresentInfo);
+	VkResult presentResult = vkQueuePresentKHR(VK_PresentQueue, &PresentInfo);
+	if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR && presentResult != VK_ERROR_OUT_OF_DATE_KHR) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to present a swapchain image");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	if (ReloadLatencyPending) ReportShaderReloadLatency();
 
-	//vkQueueWaitIdle(VK_PresentQueue);
+	Current_Frame = FrameValues.Next(Current_Frame);
 
-	Current_Frame = (Current_Frame + 1) % MAX_FRAMES_IN_FLIGHT;
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || FramebufferResized) RecreateSwapChain();
+}
 
+void Vulkan_Engine::VRender::PublishInput()
+{
+	//main thread only, GLFW window functions must not be called from other threads
+	FrameInput& input = InputBuffer.GetWriteBuffer();
+	glfwGetCursorPos(VK_Window, &input.CursorX, &input.CursorY);
+	glfwGetFramebufferSize(VK_Window, &input.FramebufferWidth, &input.FramebufferHeight);
+	input.Sequence = ++InputSequence;
+	input.SampleTime = std::chrono::high_resolution_clock::now();
+	InputBuffer.Publish();
+}
 
+void Vulkan_Engine::VRender::SampleInput()
+{
+	//without a render thread the frame polls the events itself
+	if (!RenderThreadRunning.load(std::memory_order_relaxed))
+	{
+		glfwPollEvents();
+		PublishInput();
+	}
+
+	const FrameInput& input = InputBuffer.Acquire();
+	if (input.Sequence == CurrentInput.Sequence) StaleInputFrames++;
+	CurrentInput = input;
+	InputFrames++;
+	InputAgeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - input.SampleTime).count();
+	FramePacer.MarkInputSampled(input.SampleTime);
+}
+
+void Vulkan_Engine::VRender::RenderThreadLoop(std::exception_ptr& error)
+{
+	Jobs.AcquireMainWorker();
+	try {
+		while (!RenderThreadStop.load(std::memory_order_acquire)) {
+			FramePacer.BeginFrame();
+			DrawFrame();
+			FramePacer.EndFrame();
+		}
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+	//the main thread takes worker 0 back once it has joined
+	Jobs.ReleaseMainWorker();
+	RenderThreadStop = true;
+}
+
+void Vulkan_Engine::VRender::DrawOffscreenFrame()
+{
+	//the offscreen ring has exactly one image per frame in flight, waiting for the previous frame of the slot is enough
+	GraphicsTimeline.Wait(FrameValues[Current_Frame]);
+
+	uint32_t imageIndex = static_cast<uint32_t>(Current_Frame);
+	RecordFrame(imageIndex);
+	FrameUploads uploads = UploadRing.Flush(imageIndex);
+
+	uint64_t frame = GraphicsTimeline.Advance();
+	FrameValues[Current_Frame] = frame;
+	VkSemaphore timelineSemaphore = GraphicsTimeline.GetSemaphore();
+
+	VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo{};
+	TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	TimelineSubmitInfo.waitSemaphoreValueCount = uploads.Semaphore != VK_NULL_HANDLE ? 1 : 0;
+	TimelineSubmitInfo.pWaitSemaphoreValues = &uploads.WaitValue;
+	TimelineSubmitInfo.signalSemaphoreValueCount = 1;
+	TimelineSubmitInfo.pSignalSemaphoreValues = &frame;
+
+	VkSubmitInfo SubmitInfo{};
+	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	SubmitInfo.pNext = &TimelineSubmitInfo;
+	SubmitInfo.waitSemaphoreCount = uploads.Semaphore != VK_NULL_HANDLE ? 1 : 0;
+	SubmitInfo.pWaitSemaphores = &uploads.Semaphore;
+	SubmitInfo.pWaitDstStageMask = &uploads.WaitStage;
+	VkCommandBuffer frameCommandBuffers[] = { uploads.AcquireCommandBuffer, FrameCommandBuffers[Current_Frame] };
+	bool acquire = uploads.AcquireCommandBuffer != VK_NULL_HANDLE;
+	SubmitInfo.commandBufferCount = acquire ? 2 : 1;
+	SubmitInfo.pCommandBuffers = acquire ? frameCommandBuffers : &frameCommandBuffers[1];
+	SubmitInfo.signalSemaphoreCount = 1;
+	SubmitInfo.pSignalSemaphores = &timelineSemaphore;
+
+	if (vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to submit the command buffer in the graphics queue");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	if (ReloadLatencyPending) ReportShaderReloadLatency();
+
+	Current_Frame = FrameValues.Next(Current_Frame);
+}
+
+void Vulkan_Engine::VRender::StartShaderHotReload()
+{
+	//a packaged build running from the archive has no sources to watch, neither does a benchmark need a watcher
+	if (mode != RENDER_MODE::WINDOWED || ShaderArchive.IsOpen()) return;
+	ShaderHotReload.Start("Shaders/", ShaderRequests);
+}
+
+void Vulkan_Engine::VRender::StopShaderHotReload()
+{
+	ShaderHotReload.Stop();
+
+	if (PendingPipelineReload)
+	{
+		for (auto* pipeline : { &PendingPipelineReload->Pipeline, &PendingPipelineReload->ScenePipeline, &PendingPipelineReload->DepthPipeline })
+		{
+			if (!pipeline->valid()) continue;
+			try {
+				vkDestroyPipeline(LogicalDevice, pipeline->get(), nullptr);
+			}
+			catch (std::exception&) {}
+		}
+		for (auto& module : PendingPipelineReload->Modules) vkDestroyShaderModule(LogicalDevice, module, nullptr);
+		PendingPipelineReload.reset();
+	}
+	DestroyRetiredResources(true);
+}
+
+void Vulkan_Engine::VRender::ProcessShaderReloads()
+{
+	DestroyRetiredResources(false);
+
+	//rebuilt SPIR-V replaces the loaded one, the pipelines using it are rebuilt in the background
+	for (auto& reload : ShaderHotReload.TakeReloads())
+	{
+		ShaderCode& code = shaders[reload.Name];
+		code.SpirV = std::move(reload.SpirV);
+		code.Code = reinterpret_cast<const uint32_t*>(code.SpirV.data());
+		code.CodeSize = code.SpirV.size();
+
+		if (std::find(ShaderStageNames.begin(), ShaderStageNames.end(), reload.Name) == ShaderStageNames.end()) continue;
+		if (QueuedReloadNames.empty() || reload.ChangeTime < QueuedReloadChangeTime) QueuedReloadChangeTime = reload.ChangeTime;
+		QueuedReloadCompileMs = std::max(QueuedReloadCompileMs, reload.CompileMs);
+		if (std::find(QueuedReloadNames.begin(), QueuedReloadNames.end(), reload.Name) == QueuedReloadNames.end()) QueuedReloadNames.push_back(reload.Name);
+	}
+
+	//the swap waits for every variant of the reload, a pre-pass frame needs them all
+	auto IsBuilt = [](std::future<VkPipeline>& pipeline) { return !pipeline.valid() || pipeline.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+	if (PendingPipelineReload && IsBuilt(PendingPipelineReload->Pipeline) && IsBuilt(PendingPipelineReload->ScenePipeline) && IsBuilt(PendingPipelineReload->DepthPipeline))
+		SwapGraphicsPipeline();
+
+	//one rebuild at a time, edits made meanwhile are picked up by the next one
+	if (!PendingPipelineReload && !QueuedReloadNames.empty())
+		StartPipelineReload();
+}
+
+void Vulkan_Engine::VRender::StartPipelineReload()
+{
+	PendingPipelineReload.emplace();
+	PipelineReload& reload = *PendingPipelineReload;
+	reload.Names.swap(QueuedReloadNames);
+	reload.ChangeTime = QueuedReloadChangeTime;
+	reload.CompileMs = QueuedReloadCompileMs;
+	QueuedReloadCompileMs = 0.0;
+
+	int VertexStage = -1;
+	std::vector<VkVertexInputBindingDescription> reloadBindings = VertexBindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> reloadAttributes = VertexAttributeDescriptions;
+	try {
+		for (uint32_t stageIndex = 0; stageIndex < ShaderStageCount; stageIndex++)
+		{
+			const ShaderCode& code = shaders[ShaderStageNames[stageIndex]];
+			reload.Reflections.push_back(VSpirvReflect::Reflect(code.Code, code.CodeSize / sizeof(uint32_t)));
+			if (reload.Reflections.back().Stage != ShaderReflections[stageIndex].Stage)
+				throw std::runtime_error("ERROR :: " + ShaderStageNames[stageIndex] + " changed its shader stage");
+			if (reload.Reflections.back().Stage == VK_SHADER_STAGE_VERTEX_BIT) VertexStage = static_cast<int>(stageIndex);
+		}
+
+		//the pipeline layout is shared with everything already recorded, a reload can not change it
+		ReflectedPipelineLayout current = VSpirvReflect::MergeLayouts(ShaderReflections);
+		ReflectedPipelineLayout reloaded = VSpirvReflect::MergeLayouts(reload.Reflections);
+		auto SameBindings = [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+			return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+		};
+		auto SameRanges = [](const VkPushConstantRange& a, const VkPushConstantRange& b) {
+			return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+		};
+		bool sameLayout = current.Sets.size() == reloaded.Sets.size()
+			&& std::equal(current.PushConstants.begin(), current.PushConstants.end(), reloaded.PushConstants.begin(), reloaded.PushConstants.end(), SameRanges);
+		for (auto set = current.Sets.begin(); sameLayout && set != current.Sets.end(); ++set) {
+			auto other = reloaded.Sets.find(set->first);
+			sameLayout = other != reloaded.Sets.end() && std::equal(set->second.begin(), set->second.end(), other->second.begin(), other->second.end(), SameBindings);
+		}
+		if (!sameLayout) throw std::runtime_error("ERROR :: the descriptor sets or push constants changed, restart to apply the reload");
+		if (VertexStage >= 0) VGeometry::BuildVertexInput(SceneVertexLayout, reload.Reflections[VertexStage], reloadBindings, reloadAttributes);
+	}
+	catch (std::exception& e) {
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << "hot reload : " << e.what() << '\n';
+		Platform::SetConsoleColor(HConsole, 15);
+		PendingPipelineReload.reset();
+		return;
+	}
+
+	//same state as the running pipeline, only the shader stages and the vertex input they declare differ
+	PipelineDescription description = DescribeGraphicsPipeline();
+	for (uint32_t stageIndex = 0; stageIndex < ShaderStageCount; stageIndex++)
+	{
+		const ShaderCode& code = shaders[ShaderStageNames[stageIndex]];
+		reload.Modules.push_back(CreateShaderModule(ShaderStageNames[stageIndex].c_str(), code.Code, code.CodeSize));
+		description.Stages[stageIndex].module = reload.Modules.back();
+		description.Stages[stageIndex].pName = reload.Reflections[stageIndex].EntryPoint.c_str();
+	}
+	description.VertexBindings = reloadBindings;
+	description.VertexAttributes = reloadAttributes;
+
+	reload.SubmitTime = std::chrono::high_resolution_clock::now();
+	reload.Pipeline = PipelineBuilder.Submit(description);
+	if (DepthPass == UINT32_MAX) return;
+
+	//the pre-pass variants from the same stages, built in the background too. A state drawing EQUAL without writes already is the scene variant
+	RasterState sceneState = MakeSceneRasterState();
+	if (!(MakePipelineKey(sceneState) == MakePipelineKey(CurrentRasterState)))
+	{
+		PipelineDescription sceneDescription = description;
+		ApplyRasterState(sceneDescription, sceneState);
+		reload.ScenePipeline = PipelineBuilder.Submit(sceneDescription);
+	}
+	PipelineDescription depthDescription = description;
+	MakeDepthOnly(depthDescription);
+	reload.DepthPipeline = PipelineBuilder.Submit(depthDescription);
+}
+
+void Vulkan_Engine::VRender::SwapGraphicsPipeline()
+{
+	PipelineReload& reload = *PendingPipelineReload;
+
+	//the main pipeline and the pre-pass variants, swapped in together or not at all
+	VkPipeline pipeline = VK_NULL_HANDLE, scenePipeline = VK_NULL_HANDLE, depthPipeline = VK_NULL_HANDLE;
+	bool built = true;
+	std::pair<std::future<VkPipeline>*, VkPipeline*> results[] = {
+		{ &reload.Pipeline, &pipeline }, { &reload.ScenePipeline, &scenePipeline }, { &reload.DepthPipeline, &depthPipeline } };
+	for (auto& result : results)
+	{
+		if (!result.first->valid()) continue;
+		try {
+			*result.second = result.first->get();
+		}
+		catch (std::exception& e) {
+			Platform::SetConsoleColor(HConsole, 12);
+			std::cout << "hot reload : " << e.what() << '\n';
+			Platform::SetConsoleColor(HConsole, 15);
+			built = false;
+		}
+	}
+	double pipelineMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - reload.SubmitTime).count();
+	for (auto& module : reload.Modules) vkDestroyShaderModule(LogicalDevice, module, nullptr);
+
+	if (!built || pipeline == VK_NULL_HANDLE)
+	{
+		//the running pipelines stay, the variants that did build never drew anything
+		for (auto& result : results)
+			if (*result.second != VK_NULL_HANDLE) vkDestroyPipeline(LogicalDevice, *result.second, nullptr);
+	}
+	else
+	{
+		//frames already submitted keep using the old pipelines, they are destroyed once those frames are done
+		//the other variants were built from the old shaders, they are rebuilt on demand
+		RetiredFrameResources retired;
+		retired.Pipelines = PipelineRegistry.Clear();
+		retired.RetireFrame = GraphicsTimeline.GetLastSignaled();
+		RetiredResources.push_back(std::move(retired));
+		GraphicsPipeline = pipeline;
+
+		ShaderReflections = std::move(reload.Reflections);
+		for (uint32_t stageIndex = 0; stageIndex < ShaderStageCount; stageIndex++) {
+			shaderStageCreateInfos[stageIndex].pName = ShaderReflections[stageIndex].EntryPoint.c_str();
+			if (ShaderReflections[stageIndex].Stage != VK_SHADER_STAGE_VERTEX_BIT) continue;
+			VGeometry::BuildVertexInput(SceneVertexLayout, ShaderReflections[stageIndex], VertexBindingDescriptions, VertexAttributeDescriptions);
+			VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexBindingDescriptions.size());
+			VertexInputInfo.pVertexBindingDescriptions = VertexBindingDescriptions.data();
+			VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexAttributeDescriptions.size());
+			VertexInputInfo.pVertexAttributeDescriptions = VertexAttributeDescriptions.data();
+		}
+		BasePipelineKey = VPipelineRegistry::MakeKey(DescribeGraphicsPipeline(), HashShaderProgram(), RenderPassKey);
+		PipelineRegistry.Insert(MakePipelineKey(CurrentRasterState), GraphicsPipeline);
+		//the pipelines of the depth pre-pass were retired with the others, their replacements are already built
+		ResolveScenePipelines(scenePipeline, depthPipeline);
+
+		ReloadLatencyPending = true;
+		ReloadLatencyNames.clear();
+		for (const auto& name : reload.Names) ReloadLatencyNames.append(ReloadLatencyNames.empty() ? name : ", " + name);
+		ReloadChangeTime = reload.ChangeTime;
+		ReloadCompileMs = reload.CompileMs;
+		ReloadPipelineMs = pipelineMs;
+	}
+
+	PendingPipelineReload.reset();
+}
+
+void Vulkan_Engine::VRender::ReportShaderReloadLatency()
+{
+	//called right after the first frame drawn with the new pipeline was handed to the queue
+	double latencyMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - ReloadChangeTime).count();
+	ReloadLatencyPending = false;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nShader hot reload : " << ReloadLatencyNames << '\n';
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "glslc : " << ReloadCompileMs << " ms\tpipeline : " << ReloadPipelineMs << " ms\tchange to screen : " << latencyMs << " ms\n";
+}
+
+void Vulkan_Engine::VRender::DestroyRetiredResources(bool waitIdle)
+{
+	if (RetiredResources.empty()) return;
+	if (waitIdle) vkDeviceWaitIdle(LogicalDevice);
+
+	for (auto retired = RetiredResources.begin(); retired != RetiredResources.end();)
+	{
+		if (!waitIdle && !IsFrameComplete(retired->RetireFrame)) {
+			++retired;
+			continue;
+		}
+		for (auto& pipeline : retired->Pipelines) vkDestroyPipeline(LogicalDevice, pipeline, nullptr);
+		for (auto& framebuffer : retired->Framebuffers) vkDestroyFramebuffer(LogicalDevice, framebuffer, nullptr);
+		for (auto& imageView : retired->ImageViews) vkDestroyImageView(LogicalDevice, imageView, nullptr);
+		for (auto& image : retired->Images) vkDestroyImage(LogicalDevice, image, nullptr);
+		for (auto& memory : retired->Memory) MemoryAllocator.Free(memory);
+		retired->Pipelines.clear();
+		retired->Framebuffers.clear();
+		retired->ImageViews.clear();
+		retired->Images.clear();
+		retired->Memory.clear();
+
+		//the frame being complete does not mean its present was processed, the swapchain waits for the acquires of a newer one
+		if (retired->SwapChain != VK_NULL_HANDLE && !waitIdle && retired->SwapChainGeneration > AcquiredSwapChainGeneration) {
+			++retired;
+			continue;
+		}
+		if (retired->SwapChain != VK_NULL_HANDLE) vkDestroySwapchainKHR(LogicalDevice, retired->SwapChain, nullptr);
+		retired = RetiredResources.erase(retired);
+	}
 }
 
 bool Vulkan_Engine::VRender::GLFWsetter()
@@ -1085,11 +2299,15 @@ bool Vulkan_Engine::VRender::GLFWsetter()
 	}
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE,GLFW_FALSE);
+	glfwWindowHint(GLFW_RESIZABLE,GLFW_TRUE);
 
 	this->VK_Window = glfwCreateWindow(800,600,"Vulkan Render",nullptr,nullptr);
 
-	if (VK_Window) return true;
+	if (VK_Window) {
+		glfwSetWindowUserPointer(VK_Window, this);
+		glfwSetFramebufferSizeCallback(VK_Window, FramebufferResizeCallback);
+		return true;
+	}
 	else return false;
 }
 
@@ -1121,7 +2339,7 @@ void Vulkan_Engine::VRender::CreateInstance()
 	VK_AppInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	VK_AppInfo.pEngineName = "Vulkan Engine";
 	VK_AppInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	VK_AppInfo.apiVersion = VK_API_VERSION_1_0;
+	VK_AppInfo.apiVersion = VK_API_VERSION_1_2; //timeline semaphores, and vkGetPhysicalDeviceFeatures2 to query the features of the optional extensions
 
 
 	//Instance Info
@@ -1150,9 +2368,9 @@ void Vulkan_Engine::VRender::CreateInstance()
 	PrintGLFWExtensions(VK_Extensions);
 
 	if (static_cast<VkResult>(vkCreateInstance(&VK_CreateInfo, nullptr, &VK_Instance)) != VK_SUCCESS) {
-			SetConsoleTextAttribute(HConsole, 12);
+			Platform::SetConsoleColor(HConsole, 12);
 			throw std::runtime_error("ERROR :: Failed to create a vulkan instance");
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 15);
 	}
 
 
@@ -1163,20 +2381,993 @@ void Vulkan_Engine::VRender::Render()
 	for (size_t test_index = 0; test_index < (sizeof(VulkanLoadingStatus) / sizeof(VulkanLoadingStatus[0])); test_index++)
 	{
 		if (VulkanLoadingStatus[test_index] == TEST_FAILD) {
-			SetConsoleTextAttribute(HConsole, 12);
+			Platform::SetConsoleColor(HConsole, 12);
 			std::cout << "\nERROR :: Failed to Load the render successfully. Please check " << GetErrorName(test_index) << std::endl;
-			SetConsoleTextAttribute(HConsole, 15);
+			Platform::SetConsoleColor(HConsole, 15);
 			return;
 		}
 	}
-	while (!glfwWindowShouldClose(VK_Window)) {
+	//the main thread polls the window events and publishes input snapshots, the render thread builds and submits the frames
+	//from the newest snapshot. Neither waits for the other : a slow event (window drags block the event loop on some
+	//platforms) no longer holds back the GPU, and the main thread never waits on the GPU
+	FramePacer.ResetStatistics();
+	StateTracker.ResetStatistics();
+	EventPolls = InputFrames = StaleInputFrames = SubmitsDuringEvents = 0;
+	EventMs = MaxEventMs = InputAgeMs = 0.0;
+	PublishInput();
+
+	//the render thread records the frames, it takes worker 0 of the job system to help the recording jobs
+	Jobs.ReleaseMainWorker();
+	RenderThreadStop = false;
+	RenderThreadRunning = true;
+	std::exception_ptr renderError;
+	auto start = std::chrono::high_resolution_clock::now();
+	std::thread renderThread([this, &renderError]() { RenderThreadLoop(renderError); });
+
+	while (!glfwWindowShouldClose(VK_Window) && !RenderThreadStop.load(std::memory_order_acquire)) {
+		auto pollStart = std::chrono::high_resolution_clock::now();
+		MainThreadInEvents.store(true, std::memory_order_relaxed);
 		glfwPollEvents();
-		//glfwWaitEvents();
+		MainThreadInEvents.store(false, std::memory_order_relaxed);
+		double pollMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - pollStart).count();
+		EventPolls++;
+		EventMs += pollMs;
+		MaxEventMs = std::max(MaxEventMs, pollMs);
+
+		PublishInput();
+		Platform::SleepPrecise(InputPollInterval);
+	}
+
+	RenderThreadStop = true;
+	renderThread.join();
+	RenderThreadRunning = false;
+	Jobs.AcquireMainWorker();
+	double wallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	vkDeviceWaitIdle(LogicalDevice);
+	if (renderError) std::rethrow_exception(renderError);
+	FramePacer.PrintStatistics();
+	StateTracker.PrintStatistics();
+
+	if (EventPolls && InputFrames)
+	{
+		Platform::SetConsoleColor(HConsole, 14);
+		std::cout << "\nRender thread statistics\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		std::cout << "main thread : " << EventPolls << " event polls\t" << EventMs / EventPolls << " ms average, " << MaxEventMs << " ms longest\t"
+			<< EventMs / wallMs * 100.0 << " % busy\n";
+		std::cout << "render thread : " << FramePacer.GetFrameCount() << " frames\t" << FramePacer.GetAverageCpuTime() * FramePacer.GetFrameCount() / wallMs * 100.0
+			<< " % busy\t" << SubmitsDuringEvents << " submitted while the main thread was in the event loop\n";
+		std::cout << "input snapshots : " << InputAgeMs / InputFrames << " ms average age when recorded\t" << StaleInputFrames << " frames without a new one\n";
+	}
+
+	if (SwapChainRecreations)
+	{
+		Platform::SetConsoleColor(HConsole, 14);
+		std::cout << "\nSwapchain statistics\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		std::cout << "recreations : " << SwapChainRecreations << "\tstall : " << SwapChainStallMs / SwapChainRecreations << " ms average, "
+			<< MaxSwapChainStallMs << " ms max\n";
+	}
+
+}
+
+void Vulkan_Engine::VRender::RenderHeadless(uint32_t frameCount)
+{
+	for (size_t test_index = 0; test_index < (sizeof(VulkanLoadingStatus) / sizeof(VulkanLoadingStatus[0])); test_index++)
+	{
+		if (VulkanLoadingStatus[test_index] == TEST_FAILD) {
+			Platform::SetConsoleColor(HConsole, 12);
+			std::cout << "\nERROR :: Failed to Load the render successfully. Please check " << GetErrorName(test_index) << std::endl;
+			Platform::SetConsoleColor(HConsole, 15);
+			return;
+		}
+	}
+
+	FramePacer.ResetStatistics();
+	StateTracker.ResetStatistics();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t frame = 0; frame < frameCount; frame++) {
+		FramePacer.BeginFrame();
 		DrawFrame();
+		FramePacer.EndFrame();
+	}
+	vkDeviceWaitIdle(LogicalDevice);
+	auto end = std::chrono::high_resolution_clock::now();
+	FramePacer.PrintStatistics();
+	StateTracker.PrintStatistics();
+
+	double elapsedMs = std::chrono::duration<double, std::milli>(end - start).count();
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nHeadless render : " << frameCount << " frames in " << elapsedMs << " ms";
+	if (elapsedMs > 0.0) std::cout << " (" << (frameCount * 1000.0 / elapsedMs) << " fps)";
+	std::cout << "\n" << VK_Phy_Device_Properties.deviceName << "\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VRender::BenchmarkPipelineBuilds(uint32_t pipelineCount)
+{
+	//the shader modules of the main pipeline are already gone, build them again from the loaded SPIR-V
+	PipelineDescription description = DescribeGraphicsPipeline();
+	std::vector<VkShaderModule> modules = CreateStageModules(description);
+	std::vector<PipelineDescription> batch(pipelineCount, description);
+	std::vector<VkPipeline> pipelines(pipelineCount, VK_NULL_HANDLE);
+
+	//no pipeline cache here, every build pays the full compile cost
+	VPipelineBuilder builder;
+	auto DestroyPipelines = [&]() {
+		for (auto& pipeline : pipelines) vkDestroyPipeline(LogicalDevice, pipeline, nullptr);
+	};
+
+	builder.Start(LogicalDevice, nullptr, 1, false);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < pipelineCount; i++) pipelines[i] = builder.Compile(batch[i]);
+	double serialMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	builder.Stop();
+	DestroyPipelines();
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nPipeline build benchmark : " << pipelineCount << " pipelines\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "serial (main thread)\t" << serialMs << " ms\n";
+
+	uint32_t coreCount = std::max(1u, std::thread::hardware_concurrency());
+	std::set<uint32_t> threadCounts = { 1, std::min(4u, coreCount), coreCount };
+	for (const auto& threadCount : threadCounts) {
+		builder.Start(LogicalDevice, nullptr, threadCount, false);
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<std::future<VkPipeline>> results = builder.Submit(batch);
+		for (uint32_t i = 0; i < pipelineCount; i++) pipelines[i] = results[i].get();
+		double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		builder.Stop();
+		DestroyPipelines();
+
+		std::cout << threadCount << " worker thread(s)\t" << parallelMs << " ms";
+		if (parallelMs > 0.0) std::cout << "\t(" << serialMs / parallelMs << "x)";
+		std::cout << '\n';
+	}
+
+	for (auto& module : modules) vkDestroyShaderModule(LogicalDevice, module, nullptr);
+}
+
+void Vulkan_Engine::VRender::BenchmarkShaderLoading(const std::vector<uint32_t>& shaderCounts)
+{
+	//synthetic shader sets made of copies of the loaded modules, written once as loose .spv files and once as an archive
+	std::string directory = "Shaders/LoadBenchmark/";
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	std::vector<const ShaderCode*> sources;
+	for (const auto& x : shaders) sources.push_back(&x.second);
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nShader loading benchmark : file read + shader module creation\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "shaders\tper file (ms)\tarchive (ms)\n";
+
+	for (const auto& shaderCount : shaderCounts)
+	{
+		std::vector<ShaderArchiveInput> inputs(shaderCount);
+		for (uint32_t i = 0; i < shaderCount; i++) {
+			const ShaderCode* source = sources[i % sources.size()];
+			inputs[i].Name = "Shader" + std::to_string(i) + ".spv";
+			inputs[i].SpirV.assign(reinterpret_cast<const char*>(source->Code), reinterpret_cast<const char*>(source->Code) + source->CodeSize);
+			std::ofstream file(directory + inputs[i].Name, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(inputs[i].SpirV.data(), inputs[i].SpirV.size());
+		}
+		std::string archivePath = directory + "Shaders.pak";
+		if (!VShaderArchive::Pack(inputs, archivePath)) {
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to write the benchmark shader archive");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+
+		std::vector<VkShaderModule> modules;
+		auto DestroyModules = [&]() {
+			for (auto& module : modules) vkDestroyShaderModule(LogicalDevice, module, nullptr);
+			modules.clear();
+		};
+
+		//the path used before the archive : one stream per file, copied into a vector
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const auto& input : inputs) {
+			std::vector<char> code;
+			LoadShaderSource((directory + input.Name).c_str(), code);
+			modules.push_back(CreateShaderModule(input.Name.c_str(), reinterpret_cast<const uint32_t*>(code.data()), code.size()));
+		}
+		double perFileMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		DestroyModules();
+
+		start = std::chrono::high_resolution_clock::now();
+		{
+			VShaderArchive archive;
+			archive.Open(archivePath);
+			for (const auto& input : inputs) {
+				const uint32_t* code = nullptr;
+				size_t codeSize = 0;
+				if (archive.Find(input.Name, code, codeSize)) modules.push_back(CreateShaderModule(input.Name.c_str(), code, codeSize));
+			}
+		}
+		double archiveMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		DestroyModules();
+
+		std::cout << shaderCount << "\t" << perFileMs << "\t\t" << archiveMs << "\t(" << (archiveMs > 0.0 ? perFileMs / archiveMs : 0.0) << "x)\n";
+
+		for (const auto& input : inputs) std::filesystem::remove(directory + input.Name, error);
+		std::filesystem::remove(archivePath, error);
+	}
+
+	std::filesystem::remove(directory, error);
+	Platform::SetConsoleColor(HConsole, 6);
+	std::cout << "both paths read from the OS file cache, the difference is the per-file open/read/copy cost\n";
+	Platform::SetConsoleColor(HConsole, 15);
+}
+
+void Vulkan_Engine::VRender::ReportDynamicStateSavings()
+{
+	//every combination a scene could ask for, with baked state each one is a separate pipeline
+	const VkCullModeFlags cullModes[] = { VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT };
+	const VkFrontFace frontFaces[] = { VK_FRONT_FACE_CLOCKWISE, VK_FRONT_FACE_COUNTER_CLOCKWISE };
+	const VkPrimitiveTopology topologies[] = { VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP };
+	const VkBool32 depthTests[] = { VK_FALSE, VK_TRUE };
+	const VkCompareOp depthCompareOps[] = { VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL };
+
+	auto start = std::chrono::high_resolution_clock::now();
+	size_t pipelinesBefore = PipelineRegistry.GetCount();
+	uint64_t hitsBefore = PipelineRegistry.GetHits();
+	size_t requested = 0;
+	for (const auto& cullMode : cullModes)
+		for (const auto& frontFace : frontFaces)
+			for (const auto& topology : topologies)
+				for (const auto& depthTest : depthTests)
+					for (const auto& depthCompareOp : depthCompareOps)
+					{
+						RasterState state;
+						state.CullMode = cullMode;
+						state.FrontFace = frontFace;
+						state.Topology = topology;
+						state.DepthTestEnable = depthTest;
+						state.DepthWriteEnable = depthTest;
+						state.DepthCompareOp = depthCompareOp;
+						GetGraphicsPipeline(state);
+						requested++;
+					}
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	size_t created = PipelineRegistry.GetCount();
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nDynamic state : " << (ExtendedDynamicState ? "VK_EXT_extended_dynamic_state" : "viewport and scissor only") << "\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "raster states requested : " << requested << "\npipelines : " << created << " (" << created - pipelinesBefore << " built in " << elapsedMs << " ms)\n";
+	std::cout << "pipelines saved : " << requested - created << " (registry hits : " << PipelineRegistry.GetHits() - hitsBefore << ")\n";
+	std::cout << "viewport and scissor are dynamic, resizing the target needs no pipeline\n";
+}
+
+void Vulkan_Engine::VRender::BenchmarkMemoryChurn(uint32_t resourceCount, uint32_t operationCount)
+{
+	if (resourceCount == 0) return;
+
+	//memory requirements of real resources, then sizes spread like a scene : many small buffers, fewer big textures
+	VkBufferCreateInfo BufferCreateInfo{};
+	BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	BufferCreateInfo.size = 65536;
+	BufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VkBuffer buffer;
+	VkMemoryRequirements BufferRequirements;
+	if (vkCreateBuffer(LogicalDevice, &BufferCreateInfo, nullptr, &buffer) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: FAILED TO CREATE THE BENCHMARK BUFFER");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	vkGetBufferMemoryRequirements(LogicalDevice, buffer, &BufferRequirements);
+	vkDestroyBuffer(LogicalDevice, buffer, nullptr);
+
+	VkImageCreateInfo ImageCreateInfo{};
+	ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	ImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	ImageCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	ImageCreateInfo.extent = { 256, 256, 1 };
+	ImageCreateInfo.mipLevels = 1;
+	ImageCreateInfo.arrayLayers = 1;
+	ImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	ImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	ImageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	ImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	ImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImage image;
+	VkMemoryRequirements ImageRequirements;
+	if (vkCreateImage(LogicalDevice, &ImageCreateInfo, nullptr, &image) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: FAILED TO CREATE THE BENCHMARK IMAGE");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	vkGetImageMemoryRequirements(LogicalDevice, image, &ImageRequirements);
+	vkDestroyImage(LogicalDevice, image, nullptr);
+
+	std::mt19937 random(1234);
+	auto RandomRequest = [&](bool& linear) {
+		linear = random() % 4 != 0;
+		VkMemoryRequirements requirements = linear ? BufferRequirements : ImageRequirements;
+		uint32_t sizeLog2 = linear ? 8 + random() % 13 : 16 + random() % 7; //256 B to 1 MB, 64 KB to 4 MB
+		requirements.size = (VkDeviceSize(1) << sizeLog2) + (random() % (VkDeviceSize(1) << sizeLog2));
+		requirements.size = (requirements.size + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+		return requirements;
+	};
+
+	MemoryUsage usage;
+	usage.Preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nMemory churn benchmark : " << resourceCount << " live resources, " << operationCount << " free + allocate\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+
+	//sub-allocator
+	uint32_t memoryObjectsBefore = MemoryAllocator.GetDeviceMemoryCount();
+	std::vector<MemoryAllocation> allocations(resourceCount);
+	bool linear;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto& allocation : allocations) allocation = MemoryAllocator.Allocate(RandomRequest(linear), linear, usage);
+	double fillMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	uint32_t memoryObjects = MemoryAllocator.GetDeviceMemoryCount() - memoryObjectsBefore;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t operation = 0; operation < operationCount; operation++) {
+		MemoryAllocation& allocation = allocations[random() % resourceCount];
+		MemoryAllocator.Free(allocation);
+		allocation = MemoryAllocator.Allocate(RandomRequest(linear), linear, usage);
+	}
+	double churnMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	uint32_t peakMemoryObjects = MemoryAllocator.GetDeviceMemoryCount() - memoryObjectsBefore;
+	for (auto& allocation : allocations) MemoryAllocator.Free(allocation);
+
+	std::cout << "sub-allocator :\tfill " << fillMs << " ms\tchurn " << churnMs << " ms (" << (operationCount ? churnMs * 1000000.0 / operationCount : 0.0) << " ns per free + allocate)\n";
+	std::cout << "\t\tdevice memory objects : " << memoryObjects << " after the fill, " << peakMemoryObjects << " after the churn, for " << resourceCount << " resources\n";
+
+	//one vkAllocateMemory per resource, as many live resources as the allocation limit leaves room for
+	uint32_t limit = VK_Phy_Device_Properties.limits.maxMemoryAllocationCount;
+	uint32_t used = MemoryAllocator.GetDeviceMemoryCount() + 64; //headroom for the driver and the swapchain
+	uint32_t directCount = std::min(resourceCount, limit > used ? limit - used : 0);
+	uint32_t directOperations = std::min(operationCount, 10000u);
+	if (directCount == 0) {
+		std::cout << "direct :\t\tno room left under maxMemoryAllocationCount (" << limit << ")\n";
+		return;
+	}
+
+	random.seed(1234);
+	VkMemoryAllocateInfo MemoryAllocateInfo{};
+	MemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	std::vector<VkDeviceMemory> memories(directCount, VK_NULL_HANDLE);
+	auto AllocateDirect = [&](VkDeviceMemory& memory) {
+		VkMemoryRequirements requirements = RandomRequest(linear);
+		MemoryAllocateInfo.allocationSize = requirements.size;
+		MemoryAllocateInfo.memoryTypeIndex = MemoryAllocator.FindMemoryType(requirements.memoryTypeBits, usage.Required, usage.Preferred);
+		if (vkAllocateMemory(LogicalDevice, &MemoryAllocateInfo, nullptr, &memory) != VK_SUCCESS) memory = VK_NULL_HANDLE;
+	};
+
+	start = std::chrono::high_resolution_clock::now();
+	for (auto& memory : memories) AllocateDirect(memory);
+	fillMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t operation = 0; operation < directOperations; operation++) {
+		VkDeviceMemory& memory = memories[random() % directCount];
+		if (memory != VK_NULL_HANDLE) vkFreeMemory(LogicalDevice, memory, nullptr);
+		AllocateDirect(memory);
+	}
+	churnMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	uint32_t failed = 0;
+	for (auto& memory : memories) {
+		if (memory != VK_NULL_HANDLE) vkFreeMemory(LogicalDevice, memory, nullptr);
+		else failed++;
+	}
+
+	std::cout << "direct :\t\tfill " << fillMs << " ms\tchurn " << churnMs << " ms (" << (directOperations ? churnMs * 1000000.0 / directOperations : 0.0) << " ns per free + allocate)\n";
+	std::cout << "\t\tdevice memory objects : " << directCount << " (limit " << limit << ")";
+	if (directCount < resourceCount) std::cout << ", " << resourceCount - directCount << " resources would not fit";
+	if (failed) std::cout << ", " << failed << " allocations failed";
+	std::cout << '\n';
+}
+
+void Vulkan_Engine::VRender::BenchmarkGeometryThroughput(const std::vector<uint32_t>& triangleCounts, uint32_t frameCount)
+{
+	if (mode != RENDER_MODE::HEADLESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << "\nthe geometry benchmark renders into the offscreen images, run it with --headless\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		return;
+	}
+	vkDeviceWaitIdle(LogicalDevice);
+
+	VkCommandBufferAllocateInfo AllocateInfo{};
+	AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	AllocateInfo.commandPool = CommandPool;
+	AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	AllocateInfo.commandBufferCount = 1;
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nGeometry benchmark : indexed draws of a grid mesh, " << frameCount << " frames of " << extent.width << "x" << extent.height << "\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "triangles\tvertices\tindices\tframe (ms)\tMtriangles/s\n";
+
+	for (const auto& triangleCount : triangleCounts)
+	{
+		std::vector<float> vertices;
+		std::vector<uint32_t> indices;
+		VGeometry::MakeGrid(triangleCount, vertices, indices);
+		Mesh mesh;
+		CreateMesh(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(float) / SceneVertexLayout.Stride), indices, mesh);
+
+		//one command buffer submitted frameCount times, frames are only ordered by the barrier of the scene pass
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(LogicalDevice, &AllocateInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to allocate the benchmark command buffer");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		VkCommandBufferBeginInfo BeginInfo{};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		vkBeginCommandBuffer(commandBuffer, &BeginInfo);
+		FrameGraph.BindImport(BackbufferResource, SwapChainImages[0], SwapChainImageViews[0]);
+		FrameGraph.SetPassContents(ScenePass, VK_SUBPASS_CONTENTS_INLINE);
+		FrameGraph.BeginPass(commandBuffer, ScenePass);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GraphicsPipeline);
+		RecordDynamicState(commandBuffer, CurrentRasterState);
+		RecordMeshDraw(commandBuffer, mesh);
+		FrameGraph.EndPass(commandBuffer, ScenePass);
+		vkEndCommandBuffer(commandBuffer);
+
+		VkSubmitInfo SubmitInfo{};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &commandBuffer;
+
+		//one frame to warm up the caches and the driver
+		vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(VK_GraphicsQueue);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; frame++) vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(VK_GraphicsQueue);
+		double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		uint64_t triangles = mesh.IndexCount / 3;
+		std::cout << triangles << "\t\t" << mesh.VertexCount << "\t\t" << mesh.IndexCount << (mesh.IndexType == VK_INDEX_TYPE_UINT16 ? " x16" : " x32") << '\t'
+			<< elapsedMs / frameCount << "\t\t" << (elapsedMs > 0.0 ? triangles * frameCount / (elapsedMs * 1000.0) : 0.0) << '\n';
+
+		vkFreeCommandBuffers(LogicalDevice, CommandPool, 1, &commandBuffer);
+		DestroyMesh(mesh);
+	}
+}
+
+void Vulkan_Engine::VRender::BenchmarkCommandRecording(uint32_t commandBufferCount, uint32_t drawCount, uint32_t frameCount)
+{
+	vkDeviceWaitIdle(LogicalDevice);
+
+	//same recording with the two reset strategies : one vkResetCommandPool per frame on a transient pool,
+	//or a vkResetCommandBuffer per command buffer on a pool created with RESET_COMMAND_BUFFER
+	const char* names[] = { "pool reset (transient)", "per-buffer reset" };
+	VkCommandPoolCreateFlags poolFlags[] = { VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT };
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nCommand recording benchmark : " << commandBufferCount << " command buffers of " << drawCount << " draws per frame, "
+		<< frameCount << " frames\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "strategy\t\t\treset (us/frame)\trecord (us/frame)\tns/draw\n";
+
+	for (uint32_t strategy = 0; strategy < 2; strategy++)
+	{
+		VkCommandPoolCreateInfo PoolCreateInfo{};
+		PoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		PoolCreateInfo.queueFamilyIndex = queueFamiliesindices.GraphicsFamily.value();
+		PoolCreateInfo.flags = poolFlags[strategy];
+		VkCommandPool pool;
+		if (vkCreateCommandPool(LogicalDevice, &PoolCreateInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create the benchmark command pool");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		std::vector<VkCommandBuffer> commandBuffers(commandBufferCount);
+		VkCommandBufferAllocateInfo AllocateInfo{};
+		AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		AllocateInfo.commandPool = pool;
+		AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		AllocateInfo.commandBufferCount = commandBufferCount;
+		vkAllocateCommandBuffers(LogicalDevice, &AllocateInfo, commandBuffers.data());
+
+		VkCommandBufferBeginInfo BeginInfo{};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		FrameGraph.BindImport(BackbufferResource, SwapChainImages[0], SwapChainImageViews[0]);
+		FrameGraph.SetPassContents(ScenePass, VK_SUBPASS_CONTENTS_INLINE);
+
+		//nothing is submitted, the buffers are never pending and only the CPU side is measured. The first frame warms up the pool
+		double resetMs = 0.0, recordMs = 0.0;
+		for (uint32_t frame = 0; frame <= frameCount; frame++)
+		{
+			auto resetStart = std::chrono::high_resolution_clock::now();
+			if (strategy == 0) vkResetCommandPool(LogicalDevice, pool, 0);
+			else for (auto& commandBuffer : commandBuffers) vkResetCommandBuffer(commandBuffer, 0);
+			auto recordStart = std::chrono::high_resolution_clock::now();
+
+			for (auto& commandBuffer : commandBuffers)
+			{
+				vkBeginCommandBuffer(commandBuffer, &BeginInfo);
+				FrameGraph.BeginPass(commandBuffer, ScenePass);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GraphicsPipeline);
+				RecordDynamicState(commandBuffer, CurrentRasterState);
+				for (uint32_t draw = 0; draw < drawCount; draw++) RecordMeshDraw(commandBuffer, SceneMesh);
+				FrameGraph.EndPass(commandBuffer, ScenePass);
+				vkEndCommandBuffer(commandBuffer);
+			}
+			auto recordEnd = std::chrono::high_resolution_clock::now();
+
+			if (frame == 0) continue;
+			resetMs += std::chrono::duration<double, std::milli>(recordStart - resetStart).count();
+			recordMs += std::chrono::duration<double, std::milli>(recordEnd - recordStart).count();
+		}
+
+		double draws = double(frameCount) * commandBufferCount * drawCount;
+		std::cout << names[strategy] << "\t\t" << resetMs * 1000.0 / frameCount << "\t\t" << recordMs * 1000.0 / frameCount
+			<< "\t\t\t" << (draws > 0.0 ? (resetMs + recordMs) * 1e6 / draws : 0.0) << '\n';
+
+		vkDestroyCommandPool(LogicalDevice, pool, nullptr);
+	}
+}
+
+void Vulkan_Engine::VRender::BenchmarkParallelRecording(const std::vector<uint32_t>& drawCounts, uint32_t frameCount)
+{
+	vkDeviceWaitIdle(LogicalDevice);
+
+	//16 small meshes, the buffers change every 4 draws
+	std::vector<Mesh> meshes(16);
+	for (auto& mesh : meshes)
+	{
+		std::vector<float> vertices;
+		std::vector<uint32_t> indices;
+		VGeometry::MakeGrid(32, vertices, indices);
+		CreateMesh(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(float) / SceneVertexLayout.Stride), indices, mesh);
+	}
+	uint32_t maxDraws = drawCounts.empty() ? 0 : *std::max_element(drawCounts.begin(), drawCounts.end());
+	std::vector<DrawCommand> draws(maxDraws);
+	for (uint32_t index = 0; index < maxDraws; index++) draws[index].DrawMesh = &meshes[(index / 4) % meshes.size()];
+
+	VkCommandPoolCreateInfo PoolCreateInfo{};
+	PoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	PoolCreateInfo.queueFamilyIndex = queueFamiliesindices.GraphicsFamily.value();
+	PoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	VkCommandPool pool;
+	if (vkCreateCommandPool(LogicalDevice, &PoolCreateInfo, nullptr, &pool) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to create the benchmark command pool");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	VkCommandBufferAllocateInfo AllocateInfo{};
+	AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	AllocateInfo.commandPool = pool;
+	AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	AllocateInfo.commandBufferCount = 1;
+	VkCommandBuffer primary;
+	vkAllocateCommandBuffers(LogicalDevice, &AllocateInfo, &primary);
+	VkCommandBufferBeginInfo BeginInfo{};
+	BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threadCount = 1; threadCount < ParallelRecorder.GetThreadCount(); threadCount *= 2) threadCounts.push_back(threadCount);
+	threadCounts.push_back(ParallelRecorder.GetThreadCount());
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nParallel recording benchmark : ms to record a frame, " << frameCount << " frames, speedup against inline recording\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "draws\tinline";
+	for (const auto& threadCount : threadCounts) std::cout << '\t' << threadCount << (threadCount == 1 ? " thread" : " threads");
+	std::cout << '\n';
+
+	//nothing is submitted, only the CPU side is measured. Frame 0 warms up the pools
+	for (const auto& drawCount : drawCounts)
+	{
+		std::vector<DrawCommand> frameDraws(draws.begin(), draws.begin() + drawCount);
+		double inlineMs = 0.0;
+		for (uint32_t frame = 0; frame <= frameCount; frame++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			vkResetCommandPool(LogicalDevice, pool, 0);
+			vkBeginCommandBuffer(primary, &BeginInfo);
+			FrameGraph.BindImport(BackbufferResource, SwapChainImages[0], SwapChainImageViews[0]);
+			FrameGraph.SetPassContents(ScenePass, VK_SUBPASS_CONTENTS_INLINE);
+			FrameGraph.BeginPass(primary, ScenePass);
+			RecordDraws(primary, frameDraws, 0, drawCount);
+			FrameGraph.EndPass(primary, ScenePass);
+			vkEndCommandBuffer(primary);
+			if (frame > 0) inlineMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		inlineMs /= frameCount;
+		std::cout << drawCount << '\t' << inlineMs;
+
+		for (const auto& threadCount : threadCounts)
+		{
+			double parallelMs = 0.0;
+			for (uint32_t frame = 0; frame <= frameCount; frame++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				ParallelRecorder.BeginFrame(frame % FramesInFlight);
+				vkResetCommandPool(LogicalDevice, pool, 0);
+				vkBeginCommandBuffer(primary, &BeginInfo);
+				RecordParallel(primary, 0, frameDraws, threadCount);
+				vkEndCommandBuffer(primary);
+				if (frame > 0) parallelMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+			parallelMs /= frameCount;
+			std::cout << '\t' << parallelMs << " (x" << (parallelMs > 0.0 ? inlineMs / parallelMs : 0.0) << ')';
+		}
+		std::cout << '\n';
+	}
+
+	vkDestroyCommandPool(LogicalDevice, pool, nullptr);
+	for (auto& mesh : meshes) DestroyMesh(mesh);
+}
+
+void Vulkan_Engine::VRender::BenchmarkDepthPrePass(uint32_t layerCount, uint32_t frameCount)
+{
+	if (mode != RENDER_MODE::HEADLESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << "\nthe depth pre-pass benchmark renders into the offscreen images, run it with --headless\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		return;
+	}
+	vkDeviceWaitIdle(LogicalDevice);
+
+	//full screen layers between the near and the far plane, each one covers every pixel.
+	//drawn back to front every layer passes the depth test and is shaded over the previous one
+	layerCount = std::max(1u, layerCount);
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	VGeometry::MakeGrid(2, vertices, indices);
+	Mesh mesh;
+	CreateMesh(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(float) / SceneVertexLayout.Stride), indices, mesh);
+	std::vector<DrawCommand> frontToBack(layerCount);
+	for (uint32_t layer = 0; layer < layerCount; layer++)
+	{
+		frontToBack[layer].DrawMesh = &mesh;
+		frontToBack[layer].Depth = float(layer + 1) / float(layerCount + 1);
+	}
+	SortFrontToBack(frontToBack);
+	std::vector<DrawCommand> backToFront(frontToBack.rbegin(), frontToBack.rend());
+
+	//vertex and fragment shader invocations of the whole frame, both passes
+	VkQueryPool QueryPool = VK_NULL_HANDLE;
+	if (PipelineStatisticsQuery)
+	{
+		VkQueryPoolCreateInfo QueryPoolCreateInfo{};
+		QueryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		QueryPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		QueryPoolCreateInfo.queryCount = 1;
+		QueryPoolCreateInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		if (vkCreateQueryPool(LogicalDevice, &QueryPoolCreateInfo, nullptr, &QueryPool) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create the pipeline statistics query pool");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
+
+	VkCommandBufferAllocateInfo AllocateInfo{};
+	AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	AllocateInfo.commandPool = CommandPool;
+	AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	AllocateInfo.commandBufferCount = 2;
+
+	//the whole frame graph, with the pre-pass when it is on. The query is only in the buffer submitted once
+	auto RecordFrameGraph = [&](VkCommandBuffer commandBuffer, const std::vector<DrawCommand>& draws, bool query) {
+		VkCommandBufferBeginInfo BeginInfo{};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		vkBeginCommandBuffer(commandBuffer, &BeginInfo);
+		if (query)
+		{
+			vkCmdResetQueryPool(commandBuffer, QueryPool, 0, 1);
+			vkCmdBeginQuery(commandBuffer, QueryPool, 0, 0);
+		}
+		FrameGraph.BindImport(BackbufferResource, SwapChainImages[0], SwapChainImageViews[0]);
+		SceneDrawList = &draws;
+		SceneThreads = 1;
+		if (DepthPass != UINT32_MAX) FrameGraph.SetPassContents(DepthPass, VK_SUBPASS_CONTENTS_INLINE);
+		FrameGraph.SetPassContents(ScenePass, VK_SUBPASS_CONTENTS_INLINE);
+		FrameGraph.Execute(commandBuffer);
+		if (query) vkCmdEndQuery(commandBuffer, QueryPool, 0);
+		vkEndCommandBuffer(commandBuffer);
+	};
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nDepth pre-pass benchmark : " << layerCount << " full screen layers, " << frameCount << " frames of " << extent.width << "x" << extent.height << "\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	if (!PipelineStatisticsQuery) std::cout << "no pipeline statistics queries on this device, frame times only\n";
+	std::cout << "pre-pass\torder\t\tfragments\tper pixel\tvertices\tframe (ms)\n";
+
+	const bool prePasses[] = { false, false, true, true };
+	const std::vector<DrawCommand>* orders[] = { &backToFront, &frontToBack, &backToFront, &frontToBack };
+	const bool depthPrePass = DepthPrePass;
+	double pixels = double(extent.width) * extent.height;
+	uint64_t backToFrontFragments = 0, prePassFragments = 0;
+	for (uint32_t variant = 0; variant < 4; variant++)
+	{
+		SetDepthPrePass(prePasses[variant]);
+
+		VkCommandBuffer commandBuffers[2];
+		if (vkAllocateCommandBuffers(LogicalDevice, &AllocateInfo, commandBuffers) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to allocate the benchmark command buffers");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		RecordFrameGraph(commandBuffers[0], *orders[variant], false);
+		if (PipelineStatisticsQuery) RecordFrameGraph(commandBuffers[1], *orders[variant], true);
+
+		VkSubmitInfo SubmitInfo{};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.commandBufferCount = 1;
+
+		//the statistics frame warms up the caches and the driver too
+		SubmitInfo.pCommandBuffers = &commandBuffers[PipelineStatisticsQuery ? 1 : 0];
+		vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(VK_GraphicsQueue);
+		uint64_t statistics[2] = { 0, 0 }; //in bit order : vertex then fragment shader invocations
+		if (PipelineStatisticsQuery)
+			vkGetQueryPoolResults(LogicalDevice, QueryPool, 0, 1, sizeof(statistics), statistics, sizeof(statistics), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+		SubmitInfo.pCommandBuffers = &commandBuffers[0];
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; frame++) vkQueueSubmit(VK_GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(VK_GraphicsQueue);
+		double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (variant == 0) backToFrontFragments = statistics[1];
+		if (variant == 2) prePassFragments = statistics[1];
+		std::cout << (prePasses[variant] ? "yes" : "no") << "\t\t" << (orders[variant] == &backToFront ? "back to front" : "front to back") << '\t';
+		if (PipelineStatisticsQuery) std::cout << statistics[1] << "\t\t" << statistics[1] / pixels << "\t\t" << statistics[0] << "\t\t";
+		else std::cout << "-\t\t-\t\t-\t\t";
+		std::cout << (frameCount > 0 ? elapsedMs / frameCount : 0.0) << '\n';
+
+		vkFreeCommandBuffers(LogicalDevice, CommandPool, 2, commandBuffers);
+	}
+	if (PipelineStatisticsQuery && backToFrontFragments > 0)
+		std::cout << "the pre-pass shades " << 100.0 * prePassFragments / backToFrontFragments << "% of the back to front fragments\n";
+
+	SetDepthPrePass(depthPrePass);
+	if (QueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(LogicalDevice, QueryPool, nullptr);
+	DestroyMesh(mesh);
+}
+
+void Vulkan_Engine::VRender::BenchmarkUploads(uint32_t producerCount, VkDeviceSize totalBytes)
+{
+	if (mode != RENDER_MODE::HEADLESS) {
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << "\nthe upload benchmark drives the offscreen frame loop, run it with --headless\n";
+		Platform::SetConsoleColor(HConsole, 15);
+		return;
 	}
+	vkDeviceWaitIdle(LogicalDevice);
 
+	//every producer streams into its own part of the destination, uploads of 4 KB to 256 KB
+	const VkDeviceSize MIN_UPLOAD = 4 * 1024, MAX_UPLOAD = 256 * 1024;
+	VkDeviceSize regionSize = 16ull * 1024 * 1024;
+	VkBufferCreateInfo BufferCreateInfo{};
+	BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	BufferCreateInfo.size = regionSize * producerCount;
+	BufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	MemoryUsage DeviceUsage;
+	DeviceUsage.Required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	VkBuffer buffer;
+	MemoryAllocation allocation;
+	MemoryAllocator.CreateBuffer(BufferCreateInfo, DeviceUsage, buffer, allocation);
+	std::vector<char> source(static_cast<size_t>(MAX_UPLOAD), 0x5A);
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nUpload benchmark : " << producerCount << " producer threads, " << totalBytes / (1024 * 1024) << " MB through a "
+		<< UploadRing.GetCapacity() / (1024 * 1024) << " MB ring\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+
+	UploadRing.ResetStatistics();
+	std::atomic<uint32_t> finishedProducers{ 0 };
+	std::vector<std::thread> producers;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t producer = 0; producer < producerCount; producer++)
+	{
+		producers.emplace_back([&, producer]() {
+			std::mt19937 generator(producer);
+			std::uniform_int_distribution<VkDeviceSize> sizes(MIN_UPLOAD, MAX_UPLOAD);
+			VkDeviceSize offset = 0;
+			for (VkDeviceSize sent = 0; sent < totalBytes / producerCount;)
+			{
+				VkDeviceSize size = sizes(generator);
+				if (offset + size > regionSize) offset = 0;
+				//a full ring waits for the next frame to flush it
+				while (!UploadRing.Enqueue(buffer, producer * regionSize + offset, source.data(), size,
+					VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT)) std::this_thread::yield();
+				offset += size;
+				sent += size;
+			}
+			finishedProducers.fetch_add(1);
+		});
+	}
+
+	uint32_t frameCount = 0;
+	for (bool done = false; !done; frameCount++)
+	{
+		done = finishedProducers.load() == producerCount; //everything enqueued before this frame is flushed by it
+		DrawFrame();
+	}
 	vkDeviceWaitIdle(LogicalDevice);
+	UploadRing.WaitIdle();
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	for (auto& producer : producers) producer.join();
+
+	UploadStatistics statistics = UploadRing.GetStatistics();
+	double megabytes = statistics.Bytes / (1024.0 * 1024.0);
+	std::cout << "frames : " << frameCount << "\t" << megabytes / frameCount << " MB and " << double(statistics.Uploads) / frameCount << " uploads per frame\n";
+	std::cout << "wall clock : " << megabytes / (elapsedMs / 1000.0) << " MB/s\ttransfer queue : " << statistics.ThroughputMBs << " MB/s\n";
+	std::cout << "upload latency : " << statistics.AverageLatencyMs << " ms average, " << statistics.MaxLatencyMs << " ms max\t"
+		<< statistics.Rejected << " enqueues retried on a full ring\n";
+
+	MemoryAllocator.DestroyBuffer(buffer, allocation);
+}
 
+void Vulkan_Engine::VRender::BenchmarkFramesInFlight(uint32_t frameCount)
+{
+	uint32_t framesInFlight = FramesInFlight;
+	frameCount = std::max(1u, frameCount);
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nFrames in flight benchmark : " << frameCount << " frames each, " << (mode == RENDER_MODE::HEADLESS ? "offscreen" : "presented")
+		<< ", latency from the frame submit to the GPU completing it\n\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "frames in flight\tfps\tlatency average\tp99\tmax\n";
+
+	for (uint32_t frames = 1; frames <= MAX_FRAMES_IN_FLIGHT; frames++)
+	{
+		SetFramesInFlight(frames);
+		vkDeviceWaitIdle(LogicalDevice);
+
+		//a waiter thread stamps every frame the moment the timeline reaches it, the render loop stamps its submit
+		uint64_t firstFrame = GraphicsTimeline.GetLastSignaled() + 1;
+		std::vector<std::chrono::high_resolution_clock::time_point> submitTimes(frameCount), completeTimes(frameCount);
+		std::thread waiter([&]() {
+			for (uint32_t frame = 0; frame < frameCount; frame++)
+			{
+				while (GraphicsTimeline.GetLastSignaled() < firstFrame + frame) std::this_thread::yield();
+				GraphicsTimeline.Wait(firstFrame + frame);
+				completeTimes[frame] = std::chrono::high_resolution_clock::now();
+			}
+		});
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frameCount;)
+		{
+			uint64_t submitted = GraphicsTimeline.GetLastSignaled();
+			DrawFrame();
+			//a skipped frame (out of date swapchain) signals nothing
+			if (GraphicsTimeline.GetLastSignaled() != submitted) submitTimes[frame++] = std::chrono::high_resolution_clock::now();
+		}
+		waiter.join();
+		double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::vector<double> latencies(frameCount);
+		double totalMs = 0.0;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			//the GPU may finish a short frame before the render loop took its timestamp
+			latencies[frame] = std::max(0.0, std::chrono::duration<double, std::milli>(completeTimes[frame] - submitTimes[frame]).count());
+			totalMs += latencies[frame];
+		}
+		std::sort(latencies.begin(), latencies.end());
+		std::cout << frames << "\t\t\t" << frameCount * 1000.0 / elapsedMs << '\t' << totalMs / frameCount << " ms\t\t"
+			<< latencies[std::min<size_t>(frameCount - 1, frameCount * 99 / 100)] << " ms\t" << latencies.back() << " ms\n";
+	}
+
+	SetFramesInFlight(framesInFlight);
+}
+
+void Vulkan_Engine::VRender::ReportRenderGraph()
+{
+	const VkClearValue clearColor = { { { 0.0f, 0.0f, 0.0f, 0.0f } } };
+	VkClearValue clearDepth{};
+	clearDepth.depthStencil = { 1.0f, 0 };
+	const VkFormat depthFormat = SelectDepthFormat(true); //the shadow map and the g-buffer depth are sampled
+	const VkExtent2D frameExtent = { 1920, 1080 };
+	const VkExtent2D halfExtent = { frameExtent.width / 2, frameExtent.height / 2 };
+
+	auto start = std::chrono::high_resolution_clock::now();
+	//a tracker of its own, the counters of the frames stay apart
+	VStateTracker tracker;
+	VRenderGraph graph;
+	graph.Create(LogicalDevice, &MemoryAllocator, &tracker);
+	RenderGraphImageDescription shadowDescription;
+	shadowDescription.Format = depthFormat;
+	shadowDescription.Extent = { 2048, 2048 };
+	RenderGraphResource shadowMap = graph.CreateImage("shadow map", shadowDescription);
+	RenderGraphResource albedo = graph.CreateImage("albedo", { VK_FORMAT_R8G8B8A8_UNORM });
+	RenderGraphResource normals = graph.CreateImage("normals", { VK_FORMAT_R16G16B16A16_SFLOAT });
+	RenderGraphResource depth = graph.CreateImage("depth", { depthFormat });
+	RenderGraphResource ssao = graph.CreateImage("ssao", { VK_FORMAT_R8_UNORM });
+	RenderGraphResource hdr = graph.CreateImage("hdr", { VK_FORMAT_R16G16B16A16_SFLOAT });
+	RenderGraphResource bloomHalf = graph.CreateImage("bloom", { VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent });
+	RenderGraphResource bloomBlur = graph.CreateImage("bloom blur", { VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent });
+	RenderGraphResource debugView = graph.CreateImage("debug view", { VK_FORMAT_R8G8B8A8_UNORM });
+	RenderGraphResource backbuffer = graph.ImportImage("backbuffer", format.format, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+		(mode == RENDER_MODE::WINDOWED) ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	uint32_t pass = graph.AddPass("shadow", nullptr);
+	graph.WriteDepth(pass, shadowMap, &clearDepth);
+	pass = graph.AddPass("gbuffer", nullptr);
+	graph.WriteColor(pass, albedo, &clearColor);
+	graph.WriteColor(pass, normals, &clearColor);
+	graph.WriteDepth(pass, depth, &clearDepth);
+	pass = graph.AddPass("ssao", nullptr);
+	graph.ReadSampled(pass, normals);
+	graph.ReadSampled(pass, depth);
+	graph.WriteColor(pass, ssao);
+	pass = graph.AddPass("lighting", nullptr);
+	graph.ReadSampled(pass, albedo);
+	graph.ReadSampled(pass, normals);
+	graph.ReadSampled(pass, ssao);
+	graph.ReadSampled(pass, shadowMap);
+	graph.WriteColor(pass, hdr, &clearColor);
+	pass = graph.AddPass("bloom down", nullptr);
+	graph.ReadSampled(pass, hdr);
+	graph.WriteColor(pass, bloomHalf);
+	pass = graph.AddPass("bloom blur", nullptr);
+	graph.ReadSampled(pass, bloomHalf);
+	graph.WriteColor(pass, bloomBlur);
+	//nothing reads it, the pass is culled
+	pass = graph.AddPass("debug view", nullptr);
+	graph.ReadSampled(pass, normals);
+	graph.WriteColor(pass, debugView, &clearColor);
+	pass = graph.AddPass("tonemap", nullptr);
+	graph.ReadSampled(pass, hdr);
+	graph.ReadSampled(pass, bloomBlur);
+	graph.WriteColor(pass, backbuffer);
+	graph.Compile(frameExtent);
+	double compileMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	graph.PrintStatistics("Deferred 1920x1080");
+	std::cout << "compiled in " << compileMs << " ms, images and memory included\n";
+
+	//two frames with empty passes, the second starts from the state the first left. Never submitted
+	VkCommandBufferAllocateInfo AllocateInfo{};
+	AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	AllocateInfo.commandPool = CommandPool;
+	AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	AllocateInfo.commandBufferCount = 1;
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(LogicalDevice, &AllocateInfo, &commandBuffer) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to allocate the render graph report command buffer");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	VkCommandBufferBeginInfo BeginInfo{};
+	BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &BeginInfo);
+	for (uint32_t frame = 0; frame < 2; frame++)
+	{
+		graph.BindImport(backbuffer, SwapChainImages[frame % SwapChainImages.size()], SwapChainImageViews[frame % SwapChainImageViews.size()]);
+		graph.Execute(commandBuffer);
+		tracker.EndFrame();
+	}
+	vkEndCommandBuffer(commandBuffer);
+	vkFreeCommandBuffers(LogicalDevice, CommandPool, 1, &commandBuffer);
+	tracker.PrintStatistics();
+	graph.Destroy();
 }
 
 std::string Vulkan_Engine::VRender::GetErrorName(size_t index)
@@ -1201,9 +3392,9 @@ std::string Vulkan_Engine::VRender::GetErrorName(size_t index)
 
 void Vulkan_Engine::VRender::PrintGLFWExtensions(std::vector<const char*> vec)
 {
-	SetConsoleTextAttribute(HConsole, 14);
+	Platform::SetConsoleColor(HConsole, 14);
 	std::cout << "\n\nGLFW Vulkan required extensions \n\n";
-	SetConsoleTextAttribute(HConsole, 15);
+	Platform::SetConsoleColor(HConsole, 15);
 
 	for (auto& vec_element : vec) {
 		std::cout << vec_element << '\n';
@@ -1218,17 +3409,15 @@ bool Vulkan_Engine::VRender::LoadShaderSource(const char* path, std::string& src
 	if (!shaderFile.is_open()) {
 		std::string errorMessage = "ERROR :: COULD NOT LOAD THE FILE : ";
 		errorMessage.append(path);
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error(errorMessage);
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 		return false;
 	}
 	//std::cout << "\n\nSource code of : " << path << '\n\n';
 
 	std::string ver = "#version ";
-	char v[3] = {'1','2','0'};
-	_itoa_s(majorVersion * 100 + minorVersion * 10, v, 10);
-	ver.append(v,3);
+	ver.append(std::to_string(majorVersion * 100 + minorVersion * 10));
 
 	while (!shaderFile.eof()) {
 		char line[256];
@@ -1255,16 +3444,16 @@ bool Vulkan_Engine::VRender::LoadShaderSource(const char* path, std::vector<char
 	if (!shaderFile.is_open()) {
 		std::string errorMessage = "ERROR :: COULD NOT LOAD THE FILE : ";
 		errorMessage.append(path);
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error(errorMessage);
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 		return false;
 	}
 
 	size_t fileSize = (size_t)shaderFile.tellg();
 	src.resize(fileSize);
 
-	shaderFile.seekg(shaderFile._Seekbeg);
+	shaderFile.seekg(0, std::ios::beg);
 	shaderFile.read(src.data(), fileSize);
 
 	shaderFile.close();
@@ -1281,23 +3470,21 @@ bool Vulkan_Engine::VRender::LoadShaderSource(const char* path, std::vector<char
 	if (!shaderFile.is_open()) {
 		std::string errorMessage = "ERROR :: COULD NOT LOAD THE FILE : ";
 		errorMessage.append(path);
-		SetConsoleTextAttribute(HConsole, 12);
+		Platform::SetConsoleColor(HConsole, 12);
 		throw std::runtime_error(errorMessage);
-		SetConsoleTextAttribute(HConsole, 15);
+		Platform::SetConsoleColor(HConsole, 15);
 		return false;
 	}
 
 	//std::cout << "\n\nSource code of : " << path << '\n\n';
 
 	std::string ver = "#version ";
-	char v[3] = { '1','2','0' };
-	_itoa_s(majorVersion * 100 + minorVersion * 10, v, 10);
-	ver.append(v, 3);
+	ver.append(std::to_string(majorVersion * 100 + minorVersion * 10));
 
 	size_t fileSize = (size_t)shaderFile.tellg();
 	src.resize(fileSize);
 
-	shaderFile.seekg(shaderFile._Seekbeg);
+	shaderFile.seekg(0, std::ios::beg);
 	shaderFile.read(src.data(), fileSize);
 
 	shaderFile.close();
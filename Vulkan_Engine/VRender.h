@@ -1,27 +1,38 @@
 #pragma once
 
+#if defined _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 26812) 
+#endif
 
-#define NOMINMAX //avoid windows vc++ defined min/max funcs
-
-#define VK_USE_PLATFORM_WIN32_KHR
-#include <vulkan/vulkan.h>
-//#include <vulkan/vulkan.hpp>
-
-#define GLFW_INCLUDE_VULKAN
-#define GLFW_DLL
-#include <GLFW/glfw3.h>
-#define GLFW_EXPOSE_NATIVE_WGL
-#define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3native.h>
+//platform specific headers (Windows.h, vulkan.h, glfw3.h) come through the platform abstraction layer
+#include "VPlatform.h"
+#include "VPipelineCache.h"
+#include "VPipelineBuilder.h"
+#include "VPipelineRegistry.h"
+#include "VMemoryAllocator.h"
+#include "VGeometry.h"
+#include "VUploadRing.h"
+#include "VTimeline.h"
+#include "VFrameRing.h"
+#include "VFramePacer.h"
+#include "VStateTracker.h"
+#include "VRenderGraph.h"
+#include "VTripleBuffer.h"
+#include "VJobSystem.h"
+#include "VParallelRecorder.h"
+#include "VShaderCompiler.h"
+#include "VSpirvReflect.h"
+#include "VDescriptorSetLayoutCache.h"
+#include "VShaderArchive.h"
+#include "VShaderHotReload.h"
+#include "VHash.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 
-#include <Windows.h>
 #include <iostream>
 #include <vector>
 #include <cstring>
@@ -32,6 +43,12 @@
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <random>
+#include <atomic>
+#include <exception>
 
 #include<time.h>
 
@@ -47,6 +64,7 @@ struct QueueFamiliesIndices
 	//as to determine a value in uint32_t to be a non-value index, theorically might be a real value of the returned queue
 	std::optional<uint32_t> GraphicsFamily; 
 	std::optional<uint32_t> PresentFamily;
+	std::optional<uint32_t> TransferFamily; //transfer only family when the device has one, the graphics family otherwise
 	bool isComplete() {
 		return GraphicsFamily.has_value() && PresentFamily.has_value();
 	}
@@ -59,13 +77,88 @@ struct SwapChainSupportDetails
 	std::vector<VkPresentModeKHR> SurfacePresentMode;
 };
 
+//Code points either into SpirV or into the mapped shader archive, in the later case nothing is copied
+struct ShaderCode
+{
+	std::vector<char> Source; //GLSL, empty when the shader comes from the archive
+	std::vector<char> SpirV;  //empty when the shader comes from the archive
+	const uint32_t* Code = nullptr;
+	size_t CodeSize = 0; //bytes
+};
+
+//fixed function state of a draw, baked into the pipeline unless the device can set it dynamically
+//only 4 bytes members, hashed as raw memory
+struct RasterState
+{
+	VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace FrontFace = VK_FRONT_FACE_CLOCKWISE;
+	VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkBool32 DepthTestEnable = VK_FALSE;
+	VkBool32 DepthWriteEnable = VK_FALSE;
+	VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS;
+};
+
+//graphics pipeline rebuilt after a shader reload, swapped in at a frame boundary once compiled
+struct PipelineReload
+{
+	std::future<VkPipeline> Pipeline;
+	//with the depth pre-pass, the variants the frame draws with are built alongside : nothing is compiled at the swap
+	std::future<VkPipeline> ScenePipeline;
+	std::future<VkPipeline> DepthPipeline;
+	std::vector<VkShaderModule> Modules;
+	std::vector<ShaderReflection> Reflections; //owns the entry point names of the stages being compiled
+	std::vector<std::string> Names;            //reloaded shaders
+	std::chrono::high_resolution_clock::time_point ChangeTime;
+	std::chrono::high_resolution_clock::time_point SubmitTime;
+	double CompileMs = 0.0;
+};
+
+//one indexed draw of a whole mesh
+struct DrawCommand
+{
+	const Mesh* DrawMesh = nullptr;
+	uint32_t InstanceCount = 1;
+	uint32_t FirstInstance = 0;
+	float Depth = 0.0f; //0 nearest .. 1 farthest, the vertex shader outputs z = 0 and the viewport depth range places the draw
+};
+
+//what the main thread hands the render thread each time it has polled the window events
+struct FrameInput
+{
+	double CursorX = 0.0;
+	double CursorY = 0.0;
+	int FramebufferWidth = 0; //0 while the window is minimized
+	int FramebufferHeight = 0;
+	uint64_t Sequence = 0; //0 before the first poll
+	std::chrono::high_resolution_clock::time_point SampleTime;
+};
+
+//objects replaced while rendering, destroyed once RetireFrame, the last frame submitted with them, is complete
+struct RetiredFrameResources
+{
+	std::vector<VkPipeline> Pipelines;
+	VkSwapchainKHR SwapChain = VK_NULL_HANDLE;
+	std::vector<VkImageView> ImageViews;
+	std::vector<VkFramebuffer> Framebuffers;
+	std::vector<VkImage> Images;
+	std::vector<MemoryAllocation> Memory;
+	uint64_t RetireFrame = 0;
+	uint64_t SwapChainGeneration = 0; //generation of the swapchain replacing SwapChain
+};
+
 
 	class VRender
 	{
 	public:
 
+		//headless mode renders into a ring of device-local images, no window/surface/swapchain is created
+		enum class RENDER_MODE { WINDOWED, HEADLESS };
+		//what the present mode and the frame limiter are chosen for, see SetPresentPolicy
+		enum class PRESENT_POLICY { LOWEST_LATENCY, VSYNC, CAPPED_FPS, POWER_SAVE };
+
 		bool VulkanLoadingStatus[3];
-		VRender();
+		//pinJobThreads pins every job system worker to its own core
+		VRender(RENDER_MODE renderMode = RENDER_MODE::WINDOWED, bool pinJobThreads = false);
 		~VRender();
 
 		//callbacks
@@ -80,6 +173,8 @@ struct SwapChainSupportDetails
 			return VK_FALSE; //need to keep it false as it will abort the call that triggered the callback with VK_ERROR_VALIDATION_FAILED_EXT error if it is true, we use it to test validation only
 		}
 
+		static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
+
 
 	private:
 
@@ -104,11 +199,14 @@ struct SwapChainSupportDetails
 
 		//device extension's functions
 		bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+		bool IsDeviceExtensionEnabled(const char* extensionName);
 
 		//Physical devices functions
 		void PickPhysicalDevice(VkQueueFlagBits bit);
 		bool isDeviceSuitable(VkPhysicalDevice device, VkQueueFlagBits bit);
 		int RateDeviceSuitability(VkPhysicalDevice device, VkQueueFlagBits bit);
+		//frame synchronization is built on Vulkan 1.2 timeline semaphores
+		bool SupportsTimelineSemaphores(VkPhysicalDevice device);
 
 		//Queues
 		std::vector<VkQueueFamilyProperties> FindQueueFamilies(VkPhysicalDevice device);
@@ -125,7 +223,21 @@ struct SwapChainSupportDetails
 		VkSurfaceFormatKHR SelectSwapChainFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR  SelectSwapChainPresentMode(const std::vector<VkPresentModeKHR>& availableModes);
 		VkExtent2D SelectSwapChainExtent(const VkSurfaceCapabilitiesKHR& capabilities);
+		//first of D32_SFLOAT, D24_UNORM_S8_UINT, D16_UNORM usable as a depth attachment, and sampled in a shader when sampled is set
+		VkFormat SelectDepthFormat(bool sampled);
+		//hands the current swapchain, if any, to oldSwapchain
 		void CreateSwapChain();
+		//new swapchain, image views and framebuffers for the current window size, the old ones are retired until the frames
+		//using them are complete. Nothing else is rebuilt, the render pass and pipelines only depend on the format
+		void RecreateSwapChain();
+
+		//Device Memory
+		void CreateMemoryAllocator();
+		void CreateUploadRing();
+
+		//Offscreen targets (headless mode)
+		VkFormat SelectOffscreenFormat();
+		void CreateOffscreenTargets();
 
 		//SwapChain ImageViews
 		void CreateImageView();
@@ -138,10 +250,43 @@ struct SwapChainSupportDetails
 		void PrintShadersMap();
 
 		//Shaders Modules
-		VkShaderModule CreateShaderModule(const char* ShaderName, const std::vector<char>& code);
+		VkShaderModule CreateShaderModule(const char* ShaderName, const uint32_t* code, size_t codeSize);
 
 		//Render Passes
+		//builds and compiles the frame graph, RenderPass is the render pass of its scene pass
 		void CreateRenderPass();
+		//execute function of the scene pass and of the depth pre-pass, draws SceneDrawList inline or from secondaries recorded on SceneThreads threads
+		void RecordScenePass(VkCommandBuffer commandBuffer, const RenderGraphPassContext& context);
+
+		//Pipeline Cache
+		void CreatePipelineCache();
+
+		//Pipeline Builder
+		void CreatePipelineBuilder();
+		PipelineDescription DescribeGraphicsPipeline();
+		//the modules of the main pipeline are destroyed once it is built, other builds create them again from the loaded SPIR-V.
+		//stages the description dropped get no module
+		std::vector<VkShaderModule> CreateStageModules(PipelineDescription& description);
+
+		//Dynamic State
+		void LoadExtendedDynamicState();
+		//VK_KHR_dynamic_rendering when the device has it, else the frame graph keeps render pass and framebuffer objects
+		void LoadDynamicRendering();
+		void RecordDynamicState(VkCommandBuffer commandBuffer, const RasterState& state);
+		//registry key of the pipeline drawing with state, built on the stack from BasePipelineKey
+		PipelineKey MakePipelineKey(const RasterState& state);
+		uint64_t HashShaderProgram();
+		VkPipeline GetGraphicsPipeline(const RasterState& state);
+		static void ApplyRasterState(PipelineDescription& description, const RasterState& state);
+		//the scene pass after the pre-pass tests EQUAL without writing the depth
+		RasterState MakeSceneRasterState() const;
+		//what the pre-pass draws with : no fragment stage and no color attachment, in the render pass of the pre-pass
+		void MakeDepthOnly(PipelineDescription& description);
+		//compiles description, the modules are destroyed once it is built
+		VkPipeline SubmitGraphicsPipeline(const PipelineDescription& description, std::vector<VkShaderModule>& modules);
+		//pipelines and states of the scene pass and of the depth pre-pass for the current graph, after the graph or GraphicsPipeline changed.
+		//variants already built (by a hot reload) are registered instead of being compiled
+		void ResolveScenePipelines(VkPipeline builtScenePipeline = VK_NULL_HANDLE, VkPipeline builtDepthPipeline = VK_NULL_HANDLE);
 
 		//Graphics Pipline
 		void CreateGraphicsPipeline();
@@ -152,17 +297,54 @@ struct SwapChainSupportDetails
 		//Command Pool
 		void CreateCommandPool();
 
+		//Geometry
+		//device local buffer filled through the upload ring, waits for the copy
+		void UploadBuffer(VkBufferUsageFlags usage, const void* data, VkDeviceSize size, VkBuffer& buffer, MemoryAllocation& allocation);
+		void CreateMesh(const void* vertices, uint32_t vertexCount, const std::vector<uint32_t>& indices, Mesh& mesh);
+		void DestroyMesh(Mesh& mesh);
+		void CreateSceneGeometry();
+		void RecordMeshDraw(VkCommandBuffer commandBuffer, const Mesh& mesh);
+		//draws [first, first + count) of draws with the scene pipeline, or the depth only one, and the dynamic state.
+		//vertex and index buffers are only bound when the mesh changes, the viewport when the depth changes
+		void RecordDraws(VkCommandBuffer commandBuffer, const std::vector<DrawCommand>& draws, uint32_t first, uint32_t count, bool depthOnly = false);
+		//nearest first so early depth testing rejects what is hidden, the draws of a mesh stay together at equal depth
+		static void SortFrontToBack(std::vector<DrawCommand>& draws);
+		//flushes the upload ring outside of the frame loop and waits until the graphics queue owns the copies, device must be idle
+		void FlushUploadsAndWait();
+
 		//Command Buffers
 		void CreateCommandBuffers();
+		void RecordCommandBuffer(VkCommandBuffer commandbuffer, uint32_t imageIndex);
+		//render pass of imageIndex drawing draws from secondary command buffers recorded on threadCount threads
+		void RecordParallel(VkCommandBuffer commandbuffer, uint32_t imageIndex, const std::vector<DrawCommand>& draws, uint32_t threadCount);
+		//resets the pool of the current frame and records its command buffer for imageIndex, the previous frame of the slot must be complete
+		void RecordFrame(uint32_t imageIndex);
 
 		//Semaphores
 		void CreateSemaphores();
+		void CreateTimelines();
 
-		//Fences
-		void CreateFences();
+		//everything kept once per frame in flight : frame command pools, recording threads pools and binary semaphores
+		void CreateFrameResources();
+		void DestroyFrameResources();
 
 		//Draw Function
 		void DrawFrame();
+		void DrawOffscreenFrame();
+
+		//main/event thread and render thread, see Render
+		void PublishInput();
+		void SampleInput();
+		void RenderThreadLoop(std::exception_ptr& error);
+
+		//Shader hot reload, everything runs at the frame boundary at the start of DrawFrame
+		void StartShaderHotReload();
+		void StopShaderHotReload();
+		void ProcessShaderReloads();
+		void StartPipelineReload();
+		void SwapGraphicsPipeline();
+		void ReportShaderReloadLatency();
+		void DestroyRetiredResources(bool waitIdle);
 
 		//first steps functions
 		bool GLFWsetter();
@@ -176,7 +358,8 @@ struct SwapChainSupportDetails
 		GLFWwindow* VK_Window;
 		enum class DEVICE_PICKING_UP_PATTERN { USE_FIRST_SUITABLE_DEVICE, USE_BEST_RATED_SUITABLE_DEVICE };
 		DEVICE_PICKING_UP_PATTERN pattern;
-		const int MAX_FRAMES_IN_FLIGHT = 2;
+		RENDER_MODE mode;
+		uint32_t FramesInFlight = 2; //1..MAX_FRAMES_IN_FLIGHT, see SetFramesInFlight
 		size_t Current_Frame = 0;
 
 
@@ -190,24 +373,33 @@ struct SwapChainSupportDetails
 		std::vector<VkPhysicalDevice> VK_Phy_Devices;
 		VkPhysicalDeviceProperties VK_Phy_Device_Properties;
 		VkPhysicalDeviceFeatures VK_Phy_Device_Features;
+		bool PipelineStatisticsQuery = false; //enabled when the device has it, the depth pre-pass benchmark counts the shaded fragments with it
 		std::multimap<int, VkPhysicalDevice> rated_phy_devices_candidates;
 
 		//Queues
 		std::vector<VkQueueFamilyProperties> VK_Phy_Device_QueueFamilies;
 		VkQueue VK_GraphicsQueue;
 		VkQueue VK_PresentQueue;
+		VkQueue VK_TransferQueue;
 		QueueFamiliesIndices queueFamiliesindices;
 
 		//logical devices
 		VkDevice LogicalDevice;
 
+		//device memory, every buffer and image the renderer owns is sub-allocated from it
+		VMemoryAllocator MemoryAllocator;
+
+		//staging for every CPU to GPU copy, flushed once per frame
+		VUploadRing UploadRing;
+		VkDeviceSize UploadRingSize = 32ull * 1024 * 1024;
+		uint32_t UploadRingRequests = 4096;
+
 		//surfaces
 		VkSurfaceKHR VK_Surface;
 
 		//Structs
 		VkApplicationInfo VK_AppInfo{};
 		VkInstanceCreateInfo VK_CreateInfo{};
-		VkWin32SurfaceCreateInfoKHR VK_Surface_CreateInfo{};
 
 		//Vulkan Extensions
 		std::vector<VkExtensionProperties> VK_Available_Extensions;
@@ -218,14 +410,54 @@ struct SwapChainSupportDetails
 		std::vector<const char*> VK_Device_Extensions = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
+		//enabled only when the picked device supports them
+		std::vector<const char*> VK_Optional_Device_Extensions = {
+			VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+			VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+			VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
+		};
+		std::vector<const char*> VK_Enabled_Device_Extensions;
 
 		//SwapChain 
 		SwapChainSupportDetails SwapChainSupport;
-		VkSwapchainCreateInfoKHR VK_SwapChain_createInfo;
-		VkSwapchainKHR VK_SwapChain;
+		VkSwapchainCreateInfoKHR VK_SwapChain_createInfo{};
+		VkSwapchainKHR VK_SwapChain = VK_NULL_HANDLE;
+		std::atomic<bool> FramebufferResized{ false }; //set by the GLFW callback, the swapchain is recreated after the next present
+		uint32_t SwapChainRecreations = 0;
+		//a retired swapchain may still have presents pending once its frames are complete. It is destroyed after every image of
+		//a newer swapchain was acquired once, the presentation engine has processed the presents queued before them by then
+		uint64_t SwapChainGeneration = 0;
+		uint64_t AcquiredSwapChainGeneration = 0; //newest generation every image of which was acquired
+		std::vector<bool> SwapChainImagesAcquired;
+		uint32_t UnacquiredSwapChainImages = 0;
+		double SwapChainStallMs = 0.0;
+		double MaxSwapChainStallMs = 0.0;
 		VkSurfaceFormatKHR format;
 		VkExtent2D extent;
 		VkPresentModeKHR presentMode;
+		PRESENT_POLICY PresentPolicy = PRESENT_POLICY::VSYNC;
+
+		//frame limiter and frame time statistics of Render and RenderHeadless
+		VFramePacer FramePacer;
+
+		//input snapshots, written by the thread polling the window events and read by the thread recording the frames
+		VTripleBuffer<FrameInput> InputBuffer;
+		FrameInput CurrentInput; //snapshot of the frame being built
+		uint64_t InputSequence = 0;
+		std::atomic<uint64_t> ResizeSequence{ 0 }; //first snapshot carrying the size of the last resize
+		double InputPollInterval = 0.001; //seconds between two event polls of the main thread
+		std::atomic<bool> RenderThreadRunning{ false };
+		std::atomic<bool> RenderThreadStop{ false };
+		std::atomic<bool> MainThreadInEvents{ false };
+		//main thread statistics
+		uint64_t EventPolls = 0;
+		double EventMs = 0.0;
+		double MaxEventMs = 0.0;
+		//render thread statistics
+		uint64_t InputFrames = 0;
+		uint64_t StaleInputFrames = 0;
+		uint64_t SubmitsDuringEvents = 0;
+		double InputAgeMs = 0.0;
 
 		//SwapChain Images
 		std::vector<VkImage> SwapChainImages;
@@ -233,19 +465,40 @@ struct SwapChainSupportDetails
 		//SwapChain ImageViews
 		std::vector<VkImageView> SwapChainImageViews;
 
+		//Offscreen Images Memory (headless mode), the images themselves are kept in SwapChainImages
+		std::vector<MemoryAllocation> OffscreenImagesMemory;
+		VkExtent2D OffscreenExtent = { 800,600 };
+
 		//shaders source codes
-		std::map<std::string,std::pair<std::vector<char>,std::vector<char>>> shaders;
+		std::map<std::string, ShaderCode> shaders;
+
+		//Packed shader archive, when present it replaces the sources and the build cache
+		VShaderArchive ShaderArchive;
+		std::string ShaderArchivePath = "Shaders/Shaders.pak";
+
+		//Shaders build cache
+		VShaderCompiler ShaderCompiler;
+		std::string ShaderCompileOptions = "";
 
 		//Shaders Modules
 		std::vector<VkShaderModule> ShaderModules;
 
 		//Shader Stages Creation Info
 		VkPipelineShaderStageCreateInfo shaderStageCreateInfos[6];
+		uint32_t ShaderStageCount = 0;
+		std::vector<std::string> ShaderStageNames; //shader file of each stage
+		std::vector<ShaderReflection> ShaderReflections; //one per stage, owns the entry point names
 
 		//Fixed Functions State Creation Info
 
 		//Vertex input state
 		VkPipelineVertexInputStateCreateInfo VertexInputInfo{};
+		std::vector<VkVertexInputBindingDescription> VertexBindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> VertexAttributeDescriptions;
+		//vertex format of the meshes the graphics pipeline draws
+		VertexLayout SceneVertexLayout;
+		Mesh SceneMesh;
+		std::vector<DrawCommand> SceneDraws; //draw list of every frame
 
 		//Input assembly
 		VkPipelineInputAssemblyStateCreateInfo InputAssembly{};
@@ -275,56 +528,106 @@ struct SwapChainSupportDetails
 		VkPipelineColorBlendStateCreateInfo ColorBlending{};
 
 		//Dynamic State
-		VkDynamicState DynamicStates[4] = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH,
-			VK_DYNAMIC_STATE_BLEND_CONSTANTS,
-			VK_DYNAMIC_STATE_FRONT_FACE_EXT
-		};
-		VkPipelineDynamicStateCreateInfo DynamicState{};
+		//viewport and scissor are always dynamic, the RasterState fields only with VK_EXT_extended_dynamic_state
+		std::vector<VkDynamicState> DynamicStates;
+		bool ExtendedDynamicState = false;
+		PFN_vkCmdSetCullModeEXT CmdSetCullMode = nullptr;
+		PFN_vkCmdSetFrontFaceEXT CmdSetFrontFace = nullptr;
+		PFN_vkCmdSetPrimitiveTopologyEXT CmdSetPrimitiveTopology = nullptr;
+		PFN_vkCmdSetDepthTestEnableEXT CmdSetDepthTestEnable = nullptr;
+		PFN_vkCmdSetDepthWriteEnableEXT CmdSetDepthWriteEnable = nullptr;
+		PFN_vkCmdSetDepthCompareOpEXT CmdSetDepthCompareOp = nullptr;
+		bool DynamicRendering = false;
+		PFN_vkCmdBeginRenderingKHR CmdBeginRendering = nullptr;
+		PFN_vkCmdEndRenderingKHR CmdEndRendering = nullptr;
+		RasterState CurrentRasterState;
+		//what the passes of the frame draw with : the scene pass tests EQUAL without writing after the depth pre-pass
+		VkPipeline ScenePipeline = VK_NULL_HANDLE;
+		RasterState SceneRasterState;
+		VkPipeline DepthPipeline = VK_NULL_HANDLE; //vertex stage only, VK_NULL_HANDLE without the pre-pass
+		RasterState DepthRasterState;
+
+		//every graphics pipeline, deduplicated by PipelineKey. With extended dynamic state every RasterState shares one
+		VPipelineRegistry PipelineRegistry;
+		PipelineKey BasePipelineKey{};
+		uint32_t DynamicStateMask = 0;
 
 		//Pipeline Layout
 		VkPipelineLayout PipelineLayout;
 		VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo{};
+		VDescriptorSetLayoutCache DescriptorSetLayoutCache;
+		std::vector<VkDescriptorSetLayout> DescriptorSetLayouts;
+		std::vector<VkPushConstantRange> PushConstantRanges;
 
 		//Render Passes
-		//Attachment
-		VkAttachmentDescription ColorAttachment{};
-		VkAttachmentReference ColorAttachmentRef{};
-		//Subpasses
-		VkSubpassDescription subpass{};
-		//Render Pass -- need to be before VkPipelineLayout in a structure model
+		//layout, stages and access of the images, the frame graph barriers through it. Before the graph, destroyed after it
+		VStateTracker StateTracker;
+		//the frame graph owns the render passes and the framebuffers, the swapchain image is imported into it
+		VRenderGraph FrameGraph;
+		RenderGraphResource BackbufferResource = NO_RENDER_GRAPH_RESOURCE;
+		uint32_t ScenePass = 0;
+		//depth buffer of the scene, a transient of the graph. With the pre-pass DepthPass fills it before the scene pass
+		VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+		RenderGraphResource SceneDepthResource = NO_RENDER_GRAPH_RESOURCE;
+		bool DepthPrePass = false;
+		uint32_t DepthPass = UINT32_MAX; //UINT32_MAX without the pre-pass
+		const std::vector<DrawCommand>* SceneDrawList = nullptr;
+		uint32_t SceneThreads = 1;
+		//Render Pass -- need to be before VkPipelineLayout in a structure model. VK_NULL_HANDLE with dynamic rendering
 		VkRenderPass RenderPass{};
-		VkRenderPassCreateInfo RenderPassCreateInfo{};
-		//Subpasses Dependencies
-		VkSubpassDependency SubpassDependency{};
+		uint64_t RenderPassKey = 0; //compatibility hash, pipelines built for a compatible render pass are reused
+
+		//Pipeline Cache
+		VPipelineCache PipelineCache;
+		std::string PipelineCachePath = "PipelineCache.bin";
+
+		//Pipeline Builder
+		VPipelineBuilder PipelineBuilder;
 
 		//Graphics Pipeline Object
 		VkPipeline GraphicsPipeline;
-		VkGraphicsPipelineCreateInfo PipelineCreationInfo{};
 
-		//FrameBuffers
-		std::vector<VkFramebuffer> SwapChainFrameBuffers;
-		std::vector<VkFramebufferCreateInfo> FrameBuffersCreateInfo;
 
 		//Command Pool
 		VkCommandPool CommandPool;
 		VkCommandPoolCreateInfo CommandPoolCreateInfo{};
 
-		//Command Buffers
-		std::vector<VkCommandBuffer> CommandBuffers;
+		//Command Buffers, re-recorded every frame from the transient pool of the frame in flight
+		VFrameRing<VkCommandPool> FrameCommandPools;
+		VFrameRing<VkCommandBuffer> FrameCommandBuffers;
+		//engine wide CPU parallelism, the thread creating the renderer is worker 0
+		VJobSystem Jobs;
+		//secondary command buffers recorded by the job system workers, used for the frame when RecordingThreads > 1
+		VParallelRecorder ParallelRecorder;
+		uint32_t RecordingThreads = 1;
 		VkCommandBufferAllocateInfo CommandBufferAllocateInfo{};
 
 		//Clear Values
 		VkClearValue BaseClearColor = { 0.0f,0.0f,0.0f,1.0f };
-
-		//Semaphores
-		std::vector<VkSemaphore> ImageAvailableSemaphore;
-		std::vector<VkSemaphore> RenderFinishedSemaphore;
-
-		//fences
-		std::vector<VkFence> inFlightFences;
-		std::vector<VkFence> ImagesInFlight;
+		VkClearValue BaseClearDepth{}; //depth 1, set with the render pass
+
+		//binary Semaphores, the swapchain only works with those
+		VFrameRing<VkSemaphore> ImageAvailableSemaphore;
+		VFrameRing<VkSemaphore> RenderFinishedSemaphore;
+
+		//frame N signals value N on the graphics timeline, it replaces the in flight fences
+		VTimeline GraphicsTimeline;
+		VFrameRing<uint64_t> FrameValues; //last frame submitted from each frame in flight slot, 0 when none
+		std::vector<uint64_t> ImageFrames; //last frame rendering into each swapchain image, 0 when none
+
+		//Shader hot reload
+		VShaderHotReload ShaderHotReload;
+		std::vector<ShaderBuildRequest> ShaderRequests;
+		std::optional<PipelineReload> PendingPipelineReload;
+		std::vector<std::string> QueuedReloadNames;
+		std::chrono::high_resolution_clock::time_point QueuedReloadChangeTime;
+		double QueuedReloadCompileMs = 0.0;
+		std::vector<RetiredFrameResources> RetiredResources;
+		bool ReloadLatencyPending = false;
+		std::string ReloadLatencyNames;
+		std::chrono::high_resolution_clock::time_point ReloadChangeTime;
+		double ReloadCompileMs = 0.0;
+		double ReloadPipelineMs = 0.0;
 
 		//Presentation
 		VkPresentInfoKHR PresentInfo{};
@@ -344,11 +647,64 @@ struct SwapChainSupportDetails
 		std::vector<VkLayerProperties> VK_AvailableValidationLayers;
 
 		//Console
-		HANDLE HConsole;
+		Platform::ConsoleHandle HConsole;
 
 	public:
 
 		void Render();
+		void RenderHeadless(uint32_t frameCount);
+
+		//compares serial and parallel pipeline compilation with 1, 4 and all cores
+		void BenchmarkPipelineBuilds(uint32_t pipelineCount);
+		void BenchmarkShaderLoading(const std::vector<uint32_t>& shaderCounts);
+		void ReportDynamicStateSavings();
+		//alloc/free churn over resourceCount live resources, sub-allocator against one vkAllocateMemory per resource
+		void BenchmarkMemoryChurn(uint32_t resourceCount, uint32_t operationCount);
+		//indexed draws of grid meshes of each triangle count into an offscreen image, headless mode only
+		void BenchmarkGeometryThroughput(const std::vector<uint32_t>& triangleCounts, uint32_t frameCount);
+		//CPU cost of resetting and recording commandBufferCount command buffers per frame, pool reset against per-buffer reset
+		void BenchmarkCommandRecording(uint32_t commandBufferCount, uint32_t drawCount, uint32_t frameCount);
+		//recording time of drawCounts draws with 1 to all the threads against inline recording on one thread
+		void BenchmarkParallelRecording(const std::vector<uint32_t>& drawCounts, uint32_t frameCount);
+		//a depth only pass fills the depth buffer before the scene pass, which then shades only the visible fragments (EQUAL test).
+		//waits for the device to be idle and rebuilds the frame graph, between frames only. The benchmarks recording the scene pass
+		//by hand (geometry, command recording, parallel recording) expect it off
+		void SetDepthPrePass(bool enable);
+		bool IsDepthPrePass() const { return DepthPrePass; }
+		//fragment shader invocations and frame time of layerCount full screen layers drawn back to front, front to back and with the
+		//depth pre-pass, from pipeline statistics queries when the device has them. Headless mode only
+		void BenchmarkDepthPrePass(uint32_t layerCount, uint32_t frameCount);
+		//threads recording the frame draw list, 1 records it inline in the primary command buffer
+		void SetRecordingThreads(uint32_t threadCount) { RecordingThreads = std::max(1u, std::min(threadCount, ParallelRecorder.GetThreadCount())); }
+		//producerCount threads stream totalBytes through the upload ring while frames flush it, headless mode only
+		void BenchmarkUploads(uint32_t producerCount, VkDeviceSize totalBytes);
+		UploadStatistics GetUploadStatistics() const { return UploadRing.GetStatistics(); }
+
+		//frames are numbered from 1 in submission order, frame 0 is always complete
+		uint64_t GetSubmittedFrameCount() const { return GraphicsTimeline.GetLastSignaled(); }
+		//has the GPU finished frame, and every frame before it
+		bool IsFrameComplete(uint64_t frame) { return GraphicsTimeline.IsReached(frame); }
+		void WaitForFrame(uint64_t frame) { GraphicsTimeline.Wait(frame); }
+
+		//waits for the device to be idle and rebuilds the per frame resources for frameCount (1..MAX_FRAMES_IN_FLIGHT) frames in flight.
+		//1 frame gives the lowest latency, more frames let the CPU run ahead of the GPU
+		void SetFramesInFlight(uint32_t frameCount);
+		uint32_t GetFramesInFlight() const { return FramesInFlight; }
+		//frame rate and submit to completion latency with 1 to MAX_FRAMES_IN_FLIGHT frames in flight, frameCount frames each
+		void BenchmarkFramesInFlight(uint32_t frameCount);
+
+		//LOWEST_LATENCY : IMMEDIATE (tears), then MAILBOX, FIFO_RELAXED, no limiter
+		//VSYNC : FIFO, one frame per refresh without tearing, the presentation engine paces the CPU so no limiter
+		//CAPPED_FPS : MAILBOX or IMMEDIATE so the limiter alone sets the pace, targetFps defaults to 60
+		//POWER_SAVE : FIFO, the CPU and the GPU idle between refreshes, targetFps defaults to 30
+		//FIFO is the fallback of every policy. Recreates the swapchain when the present mode changes
+		void SetPresentPolicy(PRESENT_POLICY policy, double targetFps = 0.0);
+		PRESENT_POLICY GetPresentPolicy() const { return PresentPolicy; }
+		const VFramePacer& GetFramePacer() const { return FramePacer; }
+
+		//compiles a deferred frame (shadow, g-buffer, SSAO, lighting, bloom, tonemap) and prints its passes, barriers and transient memory,
+		//then records it twice and prints the barriers the state tracker issued
+		void ReportRenderGraph();
 
 		std::string GetErrorName(size_t index);
 
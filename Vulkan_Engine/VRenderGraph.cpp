@@ -0,0 +1,846 @@
+#include "VRenderGraph.h"
+#include "VPipelineRegistry.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+	const VkAccessFlags WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	const char* LoadOpName(VkAttachmentLoadOp op)
+	{
+		return op == VK_ATTACHMENT_LOAD_OP_CLEAR ? "CLEAR" : op == VK_ATTACHMENT_LOAD_OP_LOAD ? "LOAD" : "DONT_CARE";
+	}
+
+	const char* StoreOpName(VkAttachmentStoreOp op)
+	{
+		return op == VK_ATTACHMENT_STORE_OP_STORE ? "STORE" : "DONT_CARE";
+	}
+
+}
+
+Vulkan_Engine::VRenderGraph::VRenderGraph()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VRenderGraph::~VRenderGraph()
+{
+	Destroy();
+}
+
+void Vulkan_Engine::VRenderGraph::Create(VkDevice device, VMemoryAllocator* allocator, VStateTracker* tracker)
+{
+	Device = device;
+	Allocator = allocator;
+	Tracker = tracker;
+}
+
+void Vulkan_Engine::VRenderGraph::SetDynamicRendering(PFN_vkCmdBeginRenderingKHR beginRendering, PFN_vkCmdEndRenderingKHR endRendering)
+{
+	CmdBeginRendering = beginRendering;
+	CmdEndRendering = endRendering;
+	DynamicRendering = beginRendering && endRendering;
+}
+
+void Vulkan_Engine::VRenderGraph::Destroy()
+{
+	if (Device == VK_NULL_HANDLE) return;
+
+	DestroyFramebuffers(nullptr);
+	for (auto& resource : Resources)
+	{
+		if (resource.Imported) continue;
+		if (resource.View != VK_NULL_HANDLE) vkDestroyImageView(Device, resource.View, nullptr);
+		if (resource.Image != VK_NULL_HANDLE)
+		{
+			Tracker->ForgetImage(resource.Image);
+			vkDestroyImage(Device, resource.Image, nullptr);
+		}
+	}
+	if (TransientMemory.Memory != VK_NULL_HANDLE) Allocator->Free(TransientMemory);
+	for (auto& memory : SeparateMemory) Allocator->Free(memory);
+	SeparateMemory.clear();
+	for (auto& pass : Passes)
+		if (pass.RenderPass != VK_NULL_HANDLE) vkDestroyRenderPass(Device, pass.RenderPass, nullptr);
+
+	Resources.clear();
+	Passes.clear();
+	FinalUses.clear();
+	Statistics = RenderGraphStatistics();
+	DynamicRendering = false;
+	Device = VK_NULL_HANDLE;
+}
+
+Vulkan_Engine::RenderGraphResource Vulkan_Engine::VRenderGraph::CreateImage(const std::string& name, const RenderGraphImageDescription& description)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Description = description;
+	Resources.push_back(resource);
+	return static_cast<RenderGraphResource>(Resources.size() - 1);
+}
+
+Vulkan_Engine::RenderGraphResource Vulkan_Engine::VRenderGraph::ImportImage(const std::string& name, VkFormat format, VkPipelineStageFlags initialStage,
+	VkAccessFlags initialAccess, VkImageLayout finalLayout)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Description.Format = format;
+	resource.Imported = true;
+	resource.InitialStages = initialStage;
+	resource.InitialAccess = initialAccess;
+	resource.FinalLayout = finalLayout;
+	Resources.push_back(resource);
+	return static_cast<RenderGraphResource>(Resources.size() - 1);
+}
+
+uint32_t Vulkan_Engine::VRenderGraph::AddPass(const std::string& name, ExecuteFunction execute)
+{
+	Pass pass;
+	pass.Name = name;
+	pass.Execute = std::move(execute);
+	Passes.push_back(std::move(pass));
+	return static_cast<uint32_t>(Passes.size() - 1);
+}
+
+void Vulkan_Engine::VRenderGraph::AddUse(uint32_t pass, RenderGraphResource resource, UseType type, const VkClearValue* clear, VkPipelineStageFlags stages)
+{
+	if (pass >= Passes.size() || resource >= Resources.size())
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Render graph use of an unknown pass or resource");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	ResourceUse use;
+	use.Resource = resource;
+	use.Type = type;
+	use.Clear = clear != nullptr;
+	if (clear) use.ClearValue = *clear;
+	use.Stages = stages;
+	Passes[pass].Uses.push_back(use);
+
+	switch (type)
+	{
+	case UseType::COLOR_WRITE: Resources[resource].Usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; break;
+	case UseType::DEPTH_WRITE:
+	case UseType::DEPTH_READ: Resources[resource].Usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT; break;
+	case UseType::SAMPLED: Resources[resource].Usage |= VK_IMAGE_USAGE_SAMPLED_BIT; break;
+	case UseType::TRANSFER_SRC: Resources[resource].Usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; break;
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::WriteColor(uint32_t pass, RenderGraphResource resource, const VkClearValue* clear)
+{
+	AddUse(pass, resource, UseType::COLOR_WRITE, clear, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+}
+
+void Vulkan_Engine::VRenderGraph::WriteDepth(uint32_t pass, RenderGraphResource resource, const VkClearValue* clear)
+{
+	AddUse(pass, resource, UseType::DEPTH_WRITE, clear, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+}
+
+void Vulkan_Engine::VRenderGraph::ReadDepth(uint32_t pass, RenderGraphResource resource)
+{
+	AddUse(pass, resource, UseType::DEPTH_READ, nullptr, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+}
+
+void Vulkan_Engine::VRenderGraph::ReadSampled(uint32_t pass, RenderGraphResource resource, VkPipelineStageFlags stages)
+{
+	AddUse(pass, resource, UseType::SAMPLED, nullptr, stages);
+}
+
+void Vulkan_Engine::VRenderGraph::ReadTransfer(uint32_t pass, RenderGraphResource resource)
+{
+	AddUse(pass, resource, UseType::TRANSFER_SRC, nullptr, VK_PIPELINE_STAGE_TRANSFER_BIT);
+}
+
+void Vulkan_Engine::VRenderGraph::SetSideEffect(uint32_t pass)
+{
+	Passes[pass].SideEffect = true;
+}
+
+void Vulkan_Engine::VRenderGraph::GetUseState(const ResourceUse& use, VkImageLayout& layout, VkPipelineStageFlags& stages, VkAccessFlags& access)
+{
+	stages = use.Stages;
+	switch (use.Type)
+	{
+	case UseType::COLOR_WRITE:
+		layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (use.Clear ? 0 : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT);
+		break;
+	case UseType::DEPTH_WRITE:
+		layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		break;
+	case UseType::DEPTH_READ:
+		layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		break;
+	case UseType::SAMPLED:
+		layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		access = VK_ACCESS_SHADER_READ_BIT;
+		break;
+	case UseType::TRANSFER_SRC:
+		layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		access = VK_ACCESS_TRANSFER_READ_BIT;
+		break;
+	}
+}
+
+bool Vulkan_Engine::VRenderGraph::IsDepthFormat(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+VkImageAspectFlags Vulkan_Engine::VRenderGraph::GetAspectMask(VkFormat format, bool view)
+{
+	if (!IsDepthFormat(format)) return VK_IMAGE_ASPECT_COLOR_BIT;
+	bool stencil = format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+	return VK_IMAGE_ASPECT_DEPTH_BIT | (stencil && !view ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+}
+
+void Vulkan_Engine::VRenderGraph::Cull()
+{
+	//backwards from what must exist once the graph ran : the imported images and the side effects of passes.
+	//a pass lives when it writes something still needed, a clear ends the need for what earlier passes wrote
+	std::vector<bool> needed(Resources.size(), false);
+	for (size_t resource = 0; resource < Resources.size(); resource++) needed[resource] = Resources[resource].Imported;
+
+	for (size_t index = Passes.size(); index-- > 0;)
+	{
+		Pass& pass = Passes[index];
+		bool live = pass.SideEffect;
+		for (const auto& use : pass.Uses)
+			if ((use.Type == UseType::COLOR_WRITE || use.Type == UseType::DEPTH_WRITE) && needed[use.Resource]) live = true;
+		pass.Culled = !live;
+		if (!live) continue;
+
+		for (const auto& use : pass.Uses)
+			if ((use.Type == UseType::COLOR_WRITE || use.Type == UseType::DEPTH_WRITE) && use.Clear) needed[use.Resource] = false;
+		for (const auto& use : pass.Uses)
+			if (use.Type == UseType::DEPTH_READ || use.Type == UseType::SAMPLED || use.Type == UseType::TRANSFER_SRC) needed[use.Resource] = true;
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::DeriveBarriers()
+{
+	//lifetimes over the live passes. The last uses are every read since the last write or layout change, all of them
+	//are done before the memory is reused
+	std::vector<VkImageLayout> lastLayouts(Resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+	for (uint32_t index = 0; index < Passes.size(); index++)
+	{
+		if (Passes[index].Culled) continue;
+		for (const auto& use : Passes[index].Uses)
+		{
+			Resource& resource = Resources[use.Resource];
+			VkImageLayout layout;
+			VkPipelineStageFlags stages;
+			VkAccessFlags access;
+			GetUseState(use, layout, stages, access);
+			bool first = resource.FirstPass == UINT32_MAX;
+			if (first) resource.FirstPass = index;
+			bool overwrites = (access & WRITE_ACCESS) || layout != lastLayouts[use.Resource];
+			if (first || (resource.LastPass != index && overwrites))
+			{
+				resource.LastStages = 0;
+				resource.LastAccess = 0;
+			}
+			lastLayouts[use.Resource] = layout;
+			resource.LastPass = index;
+			resource.LastStages |= stages;
+			resource.LastAccess |= access;
+		}
+	}
+
+	//state of every resource before the graph. A transient image was last used by the previous frame, and its memory may
+	//have been used since by any transient image of disjoint lifetime : its first use waits for all of them.
+	//the frames share the queue, so the barrier of a frame also orders it after the previous frame
+	struct State
+	{
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags Stages = 0;
+		VkAccessFlags Access = 0;
+		bool HasContent = false;
+	};
+	std::vector<State> states(Resources.size());
+	for (size_t index = 0; index < Resources.size(); index++)
+	{
+		const Resource& resource = Resources[index];
+		State& state = states[index];
+		if (resource.FirstPass == UINT32_MAX) continue;
+		if (resource.Imported)
+		{
+			state.Stages = resource.InitialStages;
+			state.Access = resource.InitialAccess;
+		}
+		else for (const auto& other : Resources)
+		{
+			if (other.Imported || other.FirstPass == UINT32_MAX) continue;
+			bool disjoint = other.LastPass < resource.FirstPass || other.FirstPass > resource.LastPass;
+			if (&other != &resource && !disjoint) continue;
+			state.Stages |= other.LastStages;
+			state.Access |= other.LastAccess & WRITE_ACCESS;
+		}
+		Resources[index].InitialState = { VK_IMAGE_LAYOUT_UNDEFINED, state.Stages, state.Access };
+	}
+
+	//attachments in use order per resource, for the store ops
+	struct AttachmentUse
+	{
+		uint32_t Pass;
+		uint32_t Attachment; //UINT32_MAX when the use is not an attachment
+		bool ReadsContent;
+	};
+	std::vector<std::vector<AttachmentUse>> resourceUses(Resources.size());
+
+	Statistics.Dependencies = 0;
+	Statistics.PipelineBarriers = 0;
+	Statistics.ImageBarriers = 0;
+	for (uint32_t index = 0; index < Passes.size(); index++)
+	{
+		Pass& pass = Passes[index];
+		if (pass.Culled) continue;
+
+		VkSubpassDependency dependency{};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		for (const auto& use : pass.Uses)
+		{
+			Resource& resource = Resources[use.Resource];
+			State& state = states[use.Resource];
+			VkImageLayout layout;
+			VkPipelineStageFlags stages;
+			VkAccessFlags access;
+			GetUseState(use, layout, stages, access);
+
+			bool write = use.Type == UseType::COLOR_WRITE || use.Type == UseType::DEPTH_WRITE;
+			bool readsContent = !write || !use.Clear;
+			bool loadContent = readsContent && state.HasContent;
+			//the previous content is dropped with an UNDEFINED old layout when nothing reads it
+			VkImageLayout oldLayout = loadContent ? state.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			bool hazard = (state.Access & WRITE_ACCESS) || (access & WRITE_ACCESS) || oldLayout != layout;
+			VkPipelineStageFlags srcStages = state.Stages ? state.Stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+			TrackedUse tracked{ use.Resource, layout, stages, access, !loadContent };
+			if (hazard && (DynamicRendering || !IsAttachment(use.Type))) pass.BarrierCount++;
+
+			if (IsAttachment(use.Type))
+			{
+				uint32_t attachment = static_cast<uint32_t>(pass.Attachments.size());
+				VkAttachmentDescription description{};
+				description.format = resource.Description.Format;
+				description.samples = VK_SAMPLE_COUNT_1_BIT;
+				description.loadOp = use.Clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : loadContent ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				description.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE; //set below once the later uses are known
+				description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				description.initialLayout = oldLayout;
+				description.finalLayout = layout;
+				pass.Attachments.push_back(use.Resource);
+				pass.AttachmentDescriptions.push_back(description);
+				pass.ClearValues.push_back(use.ClearValue);
+
+				VkAttachmentReference reference{ attachment, layout };
+				if (use.Type == UseType::COLOR_WRITE)
+				{
+					pass.ColorReferences.push_back(reference);
+					pass.ColorFormats.push_back(resource.Description.Format);
+				}
+				else if (pass.HasDepth)
+				{
+					Platform::SetConsoleColor(HConsole, 12);
+					throw std::runtime_error("ERROR :: The render graph pass " + pass.Name + " has more than one depth attachment");
+					Platform::SetConsoleColor(HConsole, 15);
+				}
+				else
+				{
+					pass.DepthReference = reference;
+					pass.DepthFormat = resource.Description.Format;
+					pass.HasDepth = true;
+				}
+
+				//the render pass performs the layout transition, its external dependency carries the barrier.
+				//dynamic rendering has neither, the tracker barriers the attachment before the pass like the other uses
+				pass.AttachmentUses.push_back(tracked);
+				if (hazard && !DynamicRendering)
+				{
+					dependency.srcStageMask |= srcStages;
+					dependency.srcAccessMask |= state.Access & WRITE_ACCESS;
+					dependency.dstStageMask |= stages;
+					dependency.dstAccessMask |= access;
+					pass.HasDependency = true;
+				}
+				resourceUses[use.Resource].push_back({ index, attachment, readsContent });
+			}
+			else
+			{
+				pass.TrackedUses.push_back(tracked);
+				resourceUses[use.Resource].push_back({ index, UINT32_MAX, readsContent });
+			}
+
+			//reads in the same layout add up, the next write or layout change waits for every one of them
+			state.Layout = layout;
+			state.Stages = hazard ? stages : (state.Stages | stages);
+			state.Access = hazard ? access : (state.Access | access);
+			state.HasContent = state.HasContent || write;
+		}
+
+		if (pass.HasDependency)
+		{
+			pass.Dependency = dependency;
+			Statistics.Dependencies++;
+		}
+		if (pass.BarrierCount)
+		{
+			Statistics.PipelineBarriers++;
+			Statistics.ImageBarriers += pass.BarrierCount;
+		}
+	}
+
+	//an attachment is stored only when a later use reads it, or when it is imported and this is its last use
+	for (size_t index = 0; index < Resources.size(); index++)
+	{
+		const auto& uses = resourceUses[index];
+		Resource& resource = Resources[index];
+		for (size_t use = 0; use < uses.size(); use++)
+		{
+			if (uses[use].Attachment == UINT32_MAX) continue;
+			bool last = use + 1 == uses.size();
+			bool store = last ? resource.Imported : uses[use + 1].ReadsContent;
+			VkAttachmentDescription& description = Passes[uses[use].Pass].AttachmentDescriptions[uses[use].Attachment];
+			description.storeOp = store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			//the render pass also performs the transition to the final layout of an imported image
+			if (last && resource.Imported && resource.FinalLayout != VK_IMAGE_LAYOUT_UNDEFINED && !DynamicRendering) description.finalLayout = resource.FinalLayout;
+		}
+
+		//an imported image last used outside a render pass goes to its final layout after the last pass
+		if (resource.Imported && !uses.empty() && (uses.back().Attachment == UINT32_MAX || DynamicRendering) && resource.FinalLayout != VK_IMAGE_LAYOUT_UNDEFINED
+			&& resource.FinalLayout != states[index].Layout)
+			FinalUses.push_back({ static_cast<RenderGraphResource>(index), resource.FinalLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, false });
+	}
+	if (!FinalUses.empty())
+	{
+		Statistics.PipelineBarriers++;
+		Statistics.ImageBarriers += static_cast<uint32_t>(FinalUses.size());
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::CreateRenderPass(Pass& pass)
+{
+	if (pass.Attachments.empty()) return;
+	if (DynamicRendering)
+	{
+		//no render pass to be compatible with, a pipeline only has to match the attachment formats
+		pass.RenderPassKey = VPipelineRegistry::HashAttachmentFormats(pass.ColorFormats, pass.DepthFormat);
+		return;
+	}
+
+	VkSubpassDescription Subpass{};
+	Subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	Subpass.colorAttachmentCount = static_cast<uint32_t>(pass.ColorReferences.size());
+	Subpass.pColorAttachments = pass.ColorReferences.data();
+	Subpass.pDepthStencilAttachment = pass.HasDepth ? &pass.DepthReference : nullptr;
+
+	VkRenderPassCreateInfo RenderPassCreateInfo{};
+	RenderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	RenderPassCreateInfo.attachmentCount = static_cast<uint32_t>(pass.AttachmentDescriptions.size());
+	RenderPassCreateInfo.pAttachments = pass.AttachmentDescriptions.data();
+	RenderPassCreateInfo.subpassCount = 1;
+	RenderPassCreateInfo.pSubpasses = &Subpass;
+	RenderPassCreateInfo.dependencyCount = pass.HasDependency ? 1 : 0;
+	RenderPassCreateInfo.pDependencies = pass.HasDependency ? &pass.Dependency : nullptr;
+
+	if (vkCreateRenderPass(Device, &RenderPassCreateInfo, nullptr, &pass.RenderPass) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to create the render pass of the render graph pass " + pass.Name);
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	pass.RenderPassKey = VPipelineRegistry::HashRenderPass(RenderPassCreateInfo);
+	Statistics.RenderPasses++;
+}
+
+void Vulkan_Engine::VRenderGraph::Compile(VkExtent2D extent)
+{
+	Statistics = RenderGraphStatistics();
+	Statistics.Passes = static_cast<uint32_t>(Passes.size());
+
+	Cull();
+	FirstLivePass = UINT32_MAX;
+	for (uint32_t index = 0; index < Passes.size(); index++)
+	{
+		if (Passes[index].Culled) Statistics.CulledPasses++;
+		else
+		{
+			FirstLivePass = std::min(FirstLivePass, index);
+			LastLivePass = index;
+		}
+	}
+	DeriveBarriers();
+	for (auto& pass : Passes) if (!pass.Culled) CreateRenderPass(pass);
+	CreateTransients(extent);
+}
+
+void Vulkan_Engine::VRenderGraph::CreateTransients(VkExtent2D extent)
+{
+	Extent = extent;
+	std::vector<uint32_t> transients;
+	for (uint32_t index = 0; index < Resources.size(); index++)
+	{
+		Resource& resource = Resources[index];
+		resource.Extent = (resource.Description.Extent.width && resource.Description.Extent.height) ? resource.Description.Extent : extent;
+		if (resource.Imported || resource.FirstPass == UINT32_MAX) continue;
+
+		VkImageCreateInfo ImageCreateInfo{};
+		ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		ImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		ImageCreateInfo.format = resource.Description.Format;
+		ImageCreateInfo.extent = { resource.Extent.width, resource.Extent.height, 1 };
+		ImageCreateInfo.mipLevels = 1;
+		ImageCreateInfo.arrayLayers = 1;
+		ImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		ImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		ImageCreateInfo.usage = resource.Usage | resource.Description.ExtraUsage;
+		ImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		ImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (vkCreateImage(Device, &ImageCreateInfo, nullptr, &resource.Image) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create the render graph image " + resource.Name);
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		vkGetImageMemoryRequirements(Device, resource.Image, &resource.Requirements);
+		transients.push_back(index);
+	}
+
+	//greedy placement, biggest first : an image goes at the lowest offset where it overlaps no placed image alive at the same time
+	std::vector<uint32_t> order = transients;
+	std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return Resources[a].Requirements.size > Resources[b].Requirements.size; });
+	std::vector<uint32_t> placed;
+	VkDeviceSize heapSize = 0, alignment = 1, unaliased = 0;
+	uint32_t memoryTypeBits = UINT32_MAX;
+	for (const auto& index : order)
+	{
+		Resource& resource = Resources[index];
+		const VkMemoryRequirements& requirements = resource.Requirements;
+		auto alignUp = [&requirements](VkDeviceSize offset) { return (offset + requirements.alignment - 1) / requirements.alignment * requirements.alignment; };
+
+		std::vector<uint32_t> conflicts;
+		for (const auto& other : placed)
+			if (!(Resources[other].LastPass < resource.FirstPass || Resources[other].FirstPass > resource.LastPass)) conflicts.push_back(other);
+
+		std::vector<VkDeviceSize> candidates = { 0 };
+		for (const auto& other : conflicts) candidates.push_back(alignUp(Resources[other].MemoryOffset + Resources[other].Requirements.size));
+		VkDeviceSize best = UINT64_MAX;
+		for (const auto& candidate : candidates)
+		{
+			bool fits = true;
+			for (const auto& other : conflicts)
+			{
+				VkDeviceSize begin = Resources[other].MemoryOffset, end = begin + Resources[other].Requirements.size;
+				if (candidate < end && begin < candidate + requirements.size) fits = false;
+			}
+			if (fits) best = std::min(best, candidate);
+		}
+		resource.MemoryOffset = best;
+		placed.push_back(index);
+
+		heapSize = std::max(heapSize, best + requirements.size);
+		alignment = std::max(alignment, requirements.alignment);
+		memoryTypeBits &= requirements.memoryTypeBits;
+		unaliased += requirements.size;
+	}
+
+	MemoryUsage usage;
+	usage.Required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	usage.Dedicated = true;
+	if (!transients.empty() && memoryTypeBits != 0)
+	{
+		VkMemoryRequirements requirements{ heapSize, alignment, memoryTypeBits };
+		TransientMemory = Allocator->Allocate(requirements, false, usage);
+		for (const auto& index : transients)
+			vkBindImageMemory(Device, Resources[index].Image, TransientMemory.Memory, TransientMemory.Offset + Resources[index].MemoryOffset);
+	}
+	else
+	{
+		//no memory type suits every image, no aliasing
+		heapSize = unaliased;
+		for (const auto& index : transients)
+		{
+			SeparateMemory.push_back(Allocator->Allocate(Resources[index].Requirements, false, usage));
+			vkBindImageMemory(Device, Resources[index].Image, SeparateMemory.back().Memory, SeparateMemory.back().Offset);
+		}
+	}
+	Statistics.TransientImages = static_cast<uint32_t>(transients.size());
+	Statistics.TransientBytes = heapSize;
+	Statistics.UnaliasedTransientBytes = unaliased;
+
+	for (const auto& index : transients)
+	{
+		Resource& resource = Resources[index];
+		VkImageViewCreateInfo ViewCreateInfo{};
+		ViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		ViewCreateInfo.image = resource.Image;
+		ViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		ViewCreateInfo.format = resource.Description.Format;
+		ViewCreateInfo.subresourceRange = { GetAspectMask(resource.Description.Format, true), 0, 1, 0, 1 };
+		if (vkCreateImageView(Device, &ViewCreateInfo, nullptr, &resource.View) != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create the view of the render graph image " + resource.Name);
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
+
+	//every attachment of a render pass has the size of the render area
+	for (auto& pass : Passes)
+	{
+		if (pass.Culled || pass.Attachments.empty()) continue;
+		pass.Extent = Resources[pass.Attachments[0]].Extent;
+		for (const auto& attachment : pass.Attachments)
+			if (Resources[attachment].Extent.width != pass.Extent.width || Resources[attachment].Extent.height != pass.Extent.height)
+			{
+				Platform::SetConsoleColor(HConsole, 12);
+				throw std::runtime_error("ERROR :: The attachments of the render graph pass " + pass.Name + " differ in size");
+				Platform::SetConsoleColor(HConsole, 15);
+			}
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::DestroyFramebuffers(std::vector<VkFramebuffer>* retired)
+{
+	for (auto& pass : Passes)
+	{
+		for (auto& framebuffer : pass.Framebuffers)
+		{
+			if (retired) retired->push_back(framebuffer.second);
+			else vkDestroyFramebuffer(Device, framebuffer.second, nullptr);
+		}
+		pass.Framebuffers.clear();
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::Resize(VkExtent2D extent, std::vector<VkFramebuffer>& framebuffers, std::vector<VkImageView>& imageViews,
+	std::vector<VkImage>& images, std::vector<MemoryAllocation>& memory)
+{
+	DestroyFramebuffers(&framebuffers);
+	for (auto& resource : Resources)
+	{
+		if (resource.Imported || resource.Image == VK_NULL_HANDLE) continue;
+		Tracker->ForgetImage(resource.Image);
+		imageViews.push_back(resource.View);
+		images.push_back(resource.Image);
+		resource.View = VK_NULL_HANDLE;
+		resource.Image = VK_NULL_HANDLE;
+	}
+	if (TransientMemory.Memory != VK_NULL_HANDLE) memory.push_back(TransientMemory);
+	TransientMemory = MemoryAllocation();
+	memory.insert(memory.end(), SeparateMemory.begin(), SeparateMemory.end());
+	SeparateMemory.clear();
+
+	CreateTransients(extent);
+}
+
+void Vulkan_Engine::VRenderGraph::BindImport(RenderGraphResource resource, VkImage image, VkImageView view)
+{
+	Resources[resource].Image = image;
+	Resources[resource].View = view;
+}
+
+VkFramebuffer Vulkan_Engine::VRenderGraph::GetFramebuffer(uint32_t pass)
+{
+	Pass& graphPass = Passes[pass];
+	if (DynamicRendering) return VK_NULL_HANDLE;
+	std::vector<VkImageView> views;
+	for (const auto& attachment : graphPass.Attachments)
+	{
+		if (Resources[attachment].View == VK_NULL_HANDLE)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: The render graph image " + Resources[attachment].Name + " is not bound");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		views.push_back(Resources[attachment].View);
+	}
+
+	auto found = graphPass.Framebuffers.find(views);
+	if (found != graphPass.Framebuffers.end()) return found->second;
+
+	VkFramebufferCreateInfo FramebufferCreateInfo{};
+	FramebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	FramebufferCreateInfo.renderPass = graphPass.RenderPass;
+	FramebufferCreateInfo.attachmentCount = static_cast<uint32_t>(views.size());
+	FramebufferCreateInfo.pAttachments = views.data();
+	FramebufferCreateInfo.width = graphPass.Extent.width;
+	FramebufferCreateInfo.height = graphPass.Extent.height;
+	FramebufferCreateInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	if (vkCreateFramebuffer(Device, &FramebufferCreateInfo, nullptr, &framebuffer) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to create the framebuffer of the render graph pass " + graphPass.Name);
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	graphPass.Framebuffers[views] = framebuffer;
+	Statistics.Framebuffers++;
+	return framebuffer;
+}
+
+Vulkan_Engine::RenderGraphPassContext Vulkan_Engine::VRenderGraph::BeginPass(VkCommandBuffer commandBuffer, uint32_t pass)
+{
+	Pass& graphPass = Passes[pass];
+	//every frame starts from the state the graph was compiled for : the imported images as their last use left them,
+	//the transients with whatever the images sharing their memory did
+	if (pass == FirstLivePass)
+		for (const auto& resource : Resources)
+			if (resource.FirstPass != UINT32_MAX) Tracker->TrackImage(resource.Image, GetAspectMask(resource.Description.Format, false), 1, 1, resource.InitialState);
+
+	for (const auto& use : graphPass.TrackedUses) Tracker->UseImage(Resources[use.Resource].Image, use.Layout, use.Stages, use.Access, use.Discard);
+	if (DynamicRendering)
+		for (const auto& use : graphPass.AttachmentUses) Tracker->UseImage(Resources[use.Resource].Image, use.Layout, use.Stages, use.Access, use.Discard);
+	Tracker->Flush(commandBuffer);
+
+	RenderGraphPassContext context;
+	context.Pass = pass;
+	context.Extent = graphPass.Attachments.empty() ? Extent : graphPass.Extent;
+	if (graphPass.Attachments.empty()) return context;
+
+	if (DynamicRendering)
+	{
+		//color attachments first in reference order, then the depth attachment
+		RenderingAttachments.resize(graphPass.Attachments.size());
+		auto fillAttachment = [this, &graphPass](VkRenderingAttachmentInfoKHR& info, uint32_t attachment) {
+			const VkAttachmentDescription& description = graphPass.AttachmentDescriptions[attachment];
+			info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			info.imageView = Resources[graphPass.Attachments[attachment]].View;
+			info.imageLayout = description.finalLayout;
+			info.resolveMode = VK_RESOLVE_MODE_NONE;
+			info.loadOp = description.loadOp;
+			info.storeOp = description.storeOp;
+			info.clearValue = graphPass.ClearValues[attachment];
+		};
+		uint32_t colorCount = static_cast<uint32_t>(graphPass.ColorReferences.size());
+		for (uint32_t color = 0; color < colorCount; color++) fillAttachment(RenderingAttachments[color], graphPass.ColorReferences[color].attachment);
+		if (graphPass.HasDepth) fillAttachment(RenderingAttachments[colorCount], graphPass.DepthReference.attachment);
+
+		VkRenderingInfoKHR RenderingInfo{};
+		RenderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		RenderingInfo.flags = graphPass.Contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+		RenderingInfo.renderArea.offset = { 0,0 };
+		RenderingInfo.renderArea.extent = graphPass.Extent;
+		RenderingInfo.layerCount = 1;
+		RenderingInfo.colorAttachmentCount = colorCount;
+		RenderingInfo.pColorAttachments = RenderingAttachments.data();
+		RenderingInfo.pDepthAttachment = graphPass.HasDepth ? &RenderingAttachments[colorCount] : nullptr;
+		CmdBeginRendering(commandBuffer, &RenderingInfo);
+		return context;
+	}
+
+	context.RenderPass = graphPass.RenderPass;
+	context.Framebuffer = GetFramebuffer(pass);
+	VkRenderPassBeginInfo RenderPassBeginInfo{};
+	RenderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	RenderPassBeginInfo.renderPass = graphPass.RenderPass;
+	RenderPassBeginInfo.framebuffer = context.Framebuffer;
+	RenderPassBeginInfo.renderArea.offset = { 0,0 };
+	RenderPassBeginInfo.renderArea.extent = graphPass.Extent;
+	RenderPassBeginInfo.clearValueCount = static_cast<uint32_t>(graphPass.ClearValues.size());
+	RenderPassBeginInfo.pClearValues = graphPass.ClearValues.data();
+	vkCmdBeginRenderPass(commandBuffer, &RenderPassBeginInfo, graphPass.Contents);
+	return context;
+}
+
+void Vulkan_Engine::VRenderGraph::EndPass(VkCommandBuffer commandBuffer, uint32_t pass)
+{
+	Pass& graphPass = Passes[pass];
+	if (!graphPass.Attachments.empty())
+	{
+		if (DynamicRendering) CmdEndRendering(commandBuffer);
+		else
+		{
+			vkCmdEndRenderPass(commandBuffer);
+			//the render pass left its attachments in their final layouts
+			for (size_t attachment = 0; attachment < graphPass.Attachments.size(); attachment++)
+			{
+				const TrackedUse& use = graphPass.AttachmentUses[attachment];
+				Tracker->SynchronizedImageUse(Resources[use.Resource].Image, graphPass.AttachmentDescriptions[attachment].finalLayout, use.Stages, use.Access);
+			}
+		}
+	}
+
+	if (pass == LastLivePass && !FinalUses.empty())
+	{
+		for (const auto& use : FinalUses) Tracker->UseImage(Resources[use.Resource].Image, use.Layout, use.Stages, use.Access, use.Discard);
+		Tracker->Flush(commandBuffer);
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::Execute(VkCommandBuffer commandBuffer)
+{
+	for (uint32_t index = 0; index < Passes.size(); index++)
+	{
+		Pass& pass = Passes[index];
+		if (pass.Culled) continue;
+
+		RenderGraphPassContext context = BeginPass(commandBuffer, index);
+		if (pass.Execute) pass.Execute(commandBuffer, context);
+		EndPass(commandBuffer, index);
+	}
+}
+
+void Vulkan_Engine::VRenderGraph::PrintStatistics(const std::string& title)
+{
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\n" << title << " render graph\n";
+	Platform::SetConsoleColor(HConsole, 15);
+
+	for (const auto& pass : Passes)
+	{
+		std::cout << pass.Name << " :";
+		if (pass.Culled)
+		{
+			std::cout << " culled\n";
+			continue;
+		}
+		for (size_t attachment = 0; attachment < pass.Attachments.size(); attachment++)
+		{
+			const VkAttachmentDescription& description = pass.AttachmentDescriptions[attachment];
+			std::cout << ' ' << Resources[pass.Attachments[attachment]].Name << " (" << LoadOpName(description.loadOp) << '/' << StoreOpName(description.storeOp) << ')';
+		}
+		for (const auto& use : pass.Uses)
+			if (!IsAttachment(use.Type)) std::cout << " reads " << Resources[use.Resource].Name;
+		if (pass.BarrierCount) std::cout << "\t" << pass.BarrierCount << " image barriers";
+		if (pass.HasDependency) std::cout << "\tsubpass dependency";
+		std::cout << '\n';
+	}
+
+	const double MB = 1024.0 * 1024.0;
+	std::cout << "passes : " << Statistics.Passes << "\t" << Statistics.CulledPasses << " culled, ";
+	if (DynamicRendering) std::cout << "dynamic rendering, no render pass or framebuffer objects\n";
+	else std::cout << Statistics.RenderPasses << " render passes, " << Statistics.Framebuffers << " framebuffers created\n";
+	std::cout << "barriers : " << Statistics.Dependencies << " subpass dependencies\t" << Statistics.PipelineBarriers << " pipeline barriers with "
+		<< Statistics.ImageBarriers << " image barriers per frame\n";
+	std::cout << "transient images : " << Statistics.TransientImages << "\tpeak memory " << Statistics.TransientBytes / MB << " MB aliased, "
+		<< Statistics.UnaliasedTransientBytes / MB << " MB without aliasing";
+	if (Statistics.UnaliasedTransientBytes)
+		std::cout << " (" << 100.0 * (1.0 - double(Statistics.TransientBytes) / Statistics.UnaliasedTransientBytes) << " % saved)";
+	std::cout << '\n';
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VMemoryAllocator.h"
+#include "VStateTracker.h"
+#include "VDynamicRendering.h"
+
+#include <vector>
+#include <map>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//index of an image declared in a render graph
+	typedef uint32_t RenderGraphResource;
+	const RenderGraphResource NO_RENDER_GRAPH_RESOURCE = UINT32_MAX;
+
+	//transient image owned by the graph, its memory may be shared with images whose lifetimes do not overlap
+	struct RenderGraphImageDescription
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkExtent2D Extent = { 0,0 }; //0 takes the extent the graph is compiled for
+		VkImageUsageFlags ExtraUsage = 0; //on top of the usages the passes declare
+	};
+
+	//what the execute function of a pass gets, rendering is already begun when the pass has attachments.
+	//RenderPass and Framebuffer are VK_NULL_HANDLE with dynamic rendering
+	struct RenderGraphPassContext
+	{
+		uint32_t Pass = 0;
+		VkRenderPass RenderPass = VK_NULL_HANDLE;
+		VkFramebuffer Framebuffer = VK_NULL_HANDLE;
+		VkExtent2D Extent = { 0,0 };
+	};
+
+	struct RenderGraphStatistics
+	{
+		uint32_t Passes = 0;
+		uint32_t CulledPasses = 0;
+		uint32_t RenderPasses = 0;
+		uint32_t Framebuffers = 0; //created since Compile, every resize creates them again
+		uint32_t Dependencies = 0;     //external subpass dependencies carrying the attachment barriers
+		uint32_t PipelineBarriers = 0; //barrier points per frame derived at Compile, the state tracker records them
+		uint32_t ImageBarriers = 0;    //image memory barriers at those points
+		uint32_t TransientImages = 0;
+		VkDeviceSize TransientBytes = 0;        //memory of the transient images with aliasing
+		VkDeviceSize UnaliasedTransientBytes = 0; //one allocation per transient image
+	};
+
+	//frame graph : passes declare the images they read and write, Compile culls the passes nothing depends on,
+	//derives the layout transitions and the barriers between the passes, picks the attachment load/store ops and
+	//places the transient images of disjoint lifetimes in the same memory. Passes run in declaration order,
+	//which must be a valid order (a pass only reads what earlier passes wrote). The uses are replayed on a VStateTracker
+	//every frame, which records the barriers of each pass in one call.
+	//with dynamic rendering the passes begin straight from the image views : no VkRenderPass or VkFramebuffer
+	//is created, the attachment layout transitions become image barriers and pipelines match the attachment formats
+	class VRenderGraph
+	{
+	public:
+
+		using ExecuteFunction = std::function<void(VkCommandBuffer commandBuffer, const RenderGraphPassContext& context)>;
+
+		VRenderGraph();
+		~VRenderGraph();
+
+		void Create(VkDevice device, VMemoryAllocator* allocator, VStateTracker* tracker);
+		//before Compile, the passes are recorded with vkCmdBeginRenderingKHR instead of render pass objects
+		void SetDynamicRendering(PFN_vkCmdBeginRenderingKHR beginRendering, PFN_vkCmdEndRenderingKHR endRendering);
+		bool IsDynamicRendering() const { return DynamicRendering; }
+		//destroys the compiled graph, the device must be idle
+		void Destroy();
+
+		//building, before Compile
+		RenderGraphResource CreateImage(const std::string& name, const RenderGraphImageDescription& description);
+		//image owned by someone else (a swapchain image), bound every frame with BindImport. Its content is needed once the graph ran,
+		//it is left in finalLayout. initialStage/initialAccess are the last use before the graph, the graph waits for them
+		RenderGraphResource ImportImage(const std::string& name, VkFormat format, VkPipelineStageFlags initialStage, VkAccessFlags initialAccess, VkImageLayout finalLayout);
+		uint32_t AddPass(const std::string& name, ExecuteFunction execute);
+		//a write with a clear value clears the attachment, without one the attachment keeps what earlier passes wrote
+		void WriteColor(uint32_t pass, RenderGraphResource resource, const VkClearValue* clear = nullptr);
+		void WriteDepth(uint32_t pass, RenderGraphResource resource, const VkClearValue* clear = nullptr);
+		//depth test against a depth attachment without writing it
+		void ReadDepth(uint32_t pass, RenderGraphResource resource);
+		void ReadSampled(uint32_t pass, RenderGraphResource resource, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		void ReadTransfer(uint32_t pass, RenderGraphResource resource);
+		//the pass is never culled
+		void SetSideEffect(uint32_t pass);
+
+		//culls, derives the barriers, creates the render passes and the transient images for extent
+		void Compile(VkExtent2D extent);
+		//recreates the transient images and drops the framebuffers for a new extent, the replaced objects are handed
+		//to the caller, the frames in flight may still use them
+		void Resize(VkExtent2D extent, std::vector<VkFramebuffer>& framebuffers, std::vector<VkImageView>& imageViews,
+			std::vector<VkImage>& images, std::vector<MemoryAllocation>& memory);
+
+		//per frame, records every pass that was not culled with its barriers. The first pass resets the tracked state of the images
+		void BindImport(RenderGraphResource resource, VkImage image, VkImageView view);
+		void SetPassContents(uint32_t pass, VkSubpassContents contents) { Passes[pass].Contents = contents; }
+		void Execute(VkCommandBuffer commandBuffer);
+		//what Execute records around the execute function of a pass : the barriers before it and the begin of its rendering,
+		//then the end of its rendering and, after the last pass, the final barriers. For a pass recorded by hand
+		RenderGraphPassContext BeginPass(VkCommandBuffer commandBuffer, uint32_t pass);
+		void EndPass(VkCommandBuffer commandBuffer, uint32_t pass);
+
+		bool IsCulled(uint32_t pass) const { return Passes[pass].Culled; }
+		VkRenderPass GetRenderPass(uint32_t pass) const { return Passes[pass].RenderPass; }
+		//render pass compatibility hash of the pass, see VPipelineRegistry::HashRenderPass, or hash of its attachment formats with dynamic rendering
+		uint64_t GetRenderPassKey(uint32_t pass) const { return Passes[pass].RenderPassKey; }
+		//attachment formats of the pass, what a pipeline drawing in it is created for with dynamic rendering
+		const std::vector<VkFormat>& GetColorFormats(uint32_t pass) const { return Passes[pass].ColorFormats; }
+		VkFormat GetDepthFormat(uint32_t pass) const { return Passes[pass].DepthFormat; }
+		const std::vector<VkClearValue>& GetClearValues(uint32_t pass) const { return Passes[pass].ClearValues; }
+		//framebuffer of the pass for the images bound now, created on first use and kept until Resize or Destroy.
+		//VK_NULL_HANDLE with dynamic rendering
+		VkFramebuffer GetFramebuffer(uint32_t pass);
+
+		RenderGraphStatistics GetStatistics() const { return Statistics; }
+		//the compiled passes with their load/store ops, then the statistics
+		void PrintStatistics(const std::string& title);
+
+	private:
+
+		enum class UseType { COLOR_WRITE, DEPTH_WRITE, DEPTH_READ, SAMPLED, TRANSFER_SRC };
+
+		struct ResourceUse
+		{
+			RenderGraphResource Resource = NO_RENDER_GRAPH_RESOURCE;
+			UseType Type = UseType::SAMPLED;
+			bool Clear = false;
+			VkClearValue ClearValue{};
+			VkPipelineStageFlags Stages = 0;
+		};
+
+		//a use replayed on the state tracker
+		struct TrackedUse
+		{
+			RenderGraphResource Resource = NO_RENDER_GRAPH_RESOURCE;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags Stages = 0;
+			VkAccessFlags Access = 0;
+			bool Discard = false;
+		};
+
+		struct Resource
+		{
+			std::string Name;
+			RenderGraphImageDescription Description;
+			bool Imported = false;
+			VkPipelineStageFlags InitialStages = 0;
+			VkAccessFlags InitialAccess = 0;
+			VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageUsageFlags Usage = 0;
+
+			//compiled
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			VkPipelineStageFlags LastStages = 0;
+			VkAccessFlags LastAccess = 0;
+			//state before the first pass, with what the transients sharing its memory left
+			ResourceState InitialState;
+
+			//bound or created
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkExtent2D Extent = { 0,0 };
+			VkDeviceSize MemoryOffset = 0;
+			VkMemoryRequirements Requirements{};
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			ExecuteFunction Execute;
+			std::vector<ResourceUse> Uses;
+			bool SideEffect = false;
+			bool Culled = false;
+			VkSubpassContents Contents = VK_SUBPASS_CONTENTS_INLINE;
+
+			//compiled
+			std::vector<RenderGraphResource> Attachments; //framebuffer order
+			std::vector<VkAttachmentDescription> AttachmentDescriptions;
+			std::vector<VkAttachmentReference> ColorReferences;
+			VkAttachmentReference DepthReference{};
+			bool HasDepth = false;
+			std::vector<VkFormat> ColorFormats;
+			VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+			//barrier of the attachments, from the previous uses to the render pass
+			VkSubpassDependency Dependency{};
+			bool HasDependency = false;
+			std::vector<VkClearValue> ClearValues;
+			VkRenderPass RenderPass = VK_NULL_HANDLE;
+			uint64_t RenderPassKey = 0;
+			VkExtent2D Extent = { 0,0 };
+			//uses outside of the attachments, the tracker barriers them before the pass
+			std::vector<TrackedUse> TrackedUses;
+			//parallel to Attachments. With dynamic rendering they are barriered like the other uses, else the render pass synchronizes them
+			std::vector<TrackedUse> AttachmentUses;
+			uint32_t BarrierCount = 0; //image barriers derived at Compile
+			std::map<std::vector<VkImageView>, VkFramebuffer> Framebuffers;
+		};
+
+		static void GetUseState(const ResourceUse& use, VkImageLayout& layout, VkPipelineStageFlags& stages, VkAccessFlags& access);
+		static bool IsAttachment(UseType type) { return type == UseType::COLOR_WRITE || type == UseType::DEPTH_WRITE || type == UseType::DEPTH_READ; }
+		static bool IsDepthFormat(VkFormat format);
+		//depth and stencil for the layout transitions of a combined format, a view only sees the depth
+		static VkImageAspectFlags GetAspectMask(VkFormat format, bool view);
+		void AddUse(uint32_t pass, RenderGraphResource resource, UseType type, const VkClearValue* clear, VkPipelineStageFlags stages);
+		void Cull();
+		void DeriveBarriers();
+		void CreateRenderPass(Pass& pass);
+		void CreateTransients(VkExtent2D extent);
+		void DestroyFramebuffers(std::vector<VkFramebuffer>* retired);
+
+		VkDevice Device = VK_NULL_HANDLE;
+		VMemoryAllocator* Allocator = nullptr;
+		VStateTracker* Tracker = nullptr;
+		std::vector<Resource> Resources;
+		std::vector<Pass> Passes;
+		uint32_t FirstLivePass = 0;
+		uint32_t LastLivePass = 0;
+		VkExtent2D Extent = { 0,0 };
+
+		bool DynamicRendering = false;
+		PFN_vkCmdBeginRenderingKHR CmdBeginRendering = nullptr;
+		PFN_vkCmdEndRenderingKHR CmdEndRendering = nullptr;
+		std::vector<VkRenderingAttachmentInfoKHR> RenderingAttachments; //kept between passes, no allocation per frame
+
+		//one allocation for every transient image, when their memory types allow it
+		MemoryAllocation TransientMemory;
+		std::vector<MemoryAllocation> SeparateMemory;
+		//uses after the last pass, towards the final layouts of the imported images
+		std::vector<TrackedUse> FinalUses;
+
+		RenderGraphStatistics Statistics;
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
@@ -0,0 +1,168 @@
+#include "VShaderArchive.h"
+#include "VHash.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+Vulkan_Engine::VShaderArchive::~VShaderArchive()
+{
+	Close();
+}
+
+bool Vulkan_Engine::VShaderArchive::Open(const std::string& path)
+{
+	Close();
+	if (!Platform::MapFile(path, Mapping)) return false;
+
+	//every offset is checked once here so Find can trust the table. The offsets and sizes come from the file,
+	//the checks subtract from the mapping size instead of adding them so that no sum can wrap around
+	const ShaderArchiveHeader* header = GetHeader();
+	bool valid = Mapping.Size >= sizeof(ShaderArchiveHeader)
+		&& header->magic == SHADER_ARCHIVE_MAGIC
+		&& header->version == SHADER_ARCHIVE_VERSION
+		&& header->fileSize == Mapping.Size
+		&& header->tableSize != 0 && (header->tableSize & (header->tableSize - 1)) == 0
+		&& header->entryCount < header->tableSize
+		&& header->tableOffset % alignof(ShaderArchiveEntry) == 0
+		&& header->tableOffset <= Mapping.Size
+		&& header->tableSize <= (Mapping.Size - header->tableOffset) / sizeof(ShaderArchiveEntry);
+
+	//the occupied slots must match the header, a full table would leave the probing of a missing name nothing to stop on
+	uint32_t occupied = 0;
+	for (uint32_t slot = 0; valid && slot < header->tableSize; slot++)
+	{
+		const ShaderArchiveEntry& entry = GetTable()[slot];
+		if (entry.nameLength == 0) continue;
+		occupied++;
+		valid = entry.nameOffset <= Mapping.Size && entry.nameLength <= Mapping.Size - entry.nameOffset
+			&& entry.dataOffset % 4 == 0 && entry.dataSize % 4 == 0
+			&& entry.dataOffset <= Mapping.Size && entry.dataSize <= Mapping.Size - entry.dataOffset;
+	}
+	valid = valid && occupied == header->entryCount;
+
+	if (!valid) Close();
+	return valid;
+}
+
+void Vulkan_Engine::VShaderArchive::Close()
+{
+	Platform::UnmapFile(Mapping);
+}
+
+const Vulkan_Engine::ShaderArchiveEntry* Vulkan_Engine::VShaderArchive::GetTable() const
+{
+	return reinterpret_cast<const ShaderArchiveEntry*>(static_cast<const char*>(Mapping.Data) + GetHeader()->tableOffset);
+}
+
+bool Vulkan_Engine::VShaderArchive::Find(const std::string& name, const uint32_t*& code, size_t& codeSize) const
+{
+	if (!IsOpen() || name.empty()) return false;
+
+	const char* base = static_cast<const char*>(Mapping.Data);
+	const ShaderArchiveEntry* table = GetTable();
+	uint32_t mask = GetHeader()->tableSize - 1;
+	uint64_t hash = HashFNV1a(name);
+
+	//linear probing, Open checked the table has at least one empty slot to stop on. Never more probes than slots
+	uint32_t slot = static_cast<uint32_t>(hash) & mask;
+	for (uint32_t probe = 0; probe <= mask; probe++, slot = (slot + 1) & mask)
+	{
+		const ShaderArchiveEntry& entry = table[slot];
+		if (entry.nameLength == 0) return false;
+		if (entry.nameHash == hash && entry.nameLength == name.size() && std::memcmp(base + entry.nameOffset, name.data(), name.size()) == 0)
+		{
+			code = reinterpret_cast<const uint32_t*>(base + entry.dataOffset);
+			codeSize = static_cast<size_t>(entry.dataSize);
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t Vulkan_Engine::VShaderArchive::GetEntryCount() const
+{
+	return IsOpen() ? GetHeader()->entryCount : 0;
+}
+
+std::vector<std::string> Vulkan_Engine::VShaderArchive::GetNames() const
+{
+	std::vector<std::string> names;
+	if (!IsOpen()) return names;
+
+	const char* base = static_cast<const char*>(Mapping.Data);
+	for (uint32_t slot = 0; slot < GetHeader()->tableSize; slot++) {
+		const ShaderArchiveEntry& entry = GetTable()[slot];
+		if (entry.nameLength) names.emplace_back(base + entry.nameOffset, entry.nameLength);
+	}
+	return names;
+}
+
+bool Vulkan_Engine::VShaderArchive::Pack(const std::vector<ShaderArchiveInput>& shaders, const std::string& path)
+{
+	//at most half full, so probe sequences stay short
+	uint32_t tableSize = 2;
+	while (tableSize < shaders.size() * 2) tableSize *= 2;
+
+	std::vector<ShaderArchiveEntry> table(tableSize, ShaderArchiveEntry{});
+	std::string names;
+	std::vector<char> blobs;
+
+	uint64_t tableOffset = sizeof(ShaderArchiveHeader);
+	uint64_t namesOffset = tableOffset + uint64_t(tableSize) * sizeof(ShaderArchiveEntry);
+	for (const auto& shader : shaders) names.append(shader.Name);
+	uint64_t blobsOffset = (namesOffset + names.size() + 3) & ~uint64_t(3);
+
+	uint32_t nameOffset = static_cast<uint32_t>(namesOffset);
+	for (const auto& shader : shaders)
+	{
+		if (shader.Name.empty() || shader.SpirV.size() % 4 != 0) return false;
+
+		uint64_t hash = HashFNV1a(shader.Name);
+		uint32_t slot = static_cast<uint32_t>(hash) & (tableSize - 1);
+		while (table[slot].nameLength != 0) {
+			const ShaderArchiveEntry& other = table[slot];
+			if (other.nameHash == hash && names.compare(other.nameOffset - namesOffset, other.nameLength, shader.Name) == 0) return false; //duplicated name
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		ShaderArchiveEntry& entry = table[slot];
+		entry.nameHash = hash;
+		entry.nameOffset = nameOffset;
+		entry.nameLength = static_cast<uint32_t>(shader.Name.size());
+		entry.dataOffset = blobsOffset + blobs.size();
+		entry.dataSize = shader.SpirV.size();
+		nameOffset += entry.nameLength;
+		blobs.insert(blobs.end(), shader.SpirV.begin(), shader.SpirV.end());
+	}
+
+	ShaderArchiveHeader header{};
+	header.magic = SHADER_ARCHIVE_MAGIC;
+	header.version = SHADER_ARCHIVE_VERSION;
+	header.entryCount = static_cast<uint32_t>(shaders.size());
+	header.tableSize = tableSize;
+	header.tableOffset = tableOffset;
+	header.fileSize = blobsOffset + blobs.size();
+
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		const char padding[4] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(ShaderArchiveEntry));
+		file.write(names.data(), names.size());
+		file.write(padding, blobsOffset - namesOffset - names.size());
+		file.write(blobs.data(), blobs.size());
+		if (!file.good()) {
+			file.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	if (Platform::ReplaceFileAtomic(temporaryPath, path)) return true;
+	std::remove(temporaryPath.c_str());
+	return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//file layout : header | hash table of entries | names | SPIR-V blobs (4 bytes aligned)
+	const uint32_t SHADER_ARCHIVE_MAGIC = 0x41534556; //"VESA"
+	const uint32_t SHADER_ARCHIVE_VERSION = 1;
+
+	struct ShaderArchiveHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t tableSize;   //slots of the open addressing table, a power of two
+		uint64_t tableOffset;
+		uint64_t fileSize;
+	};
+
+	//an empty slot has a nameLength of 0
+	struct ShaderArchiveEntry
+	{
+		uint64_t nameHash;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint64_t dataOffset;
+		uint64_t dataSize;    //bytes
+	};
+
+	struct ShaderArchiveInput
+	{
+		std::string Name;
+		std::vector<char> SpirV;
+	};
+
+	//read-only, memory-mapped pack of SPIR-V modules
+	//the code returned by Find points into the mapping and can be handed to vkCreateShaderModule without any copy
+	class VShaderArchive
+	{
+	public:
+
+		VShaderArchive() = default;
+		~VShaderArchive();
+		VShaderArchive(const VShaderArchive&) = delete;
+		VShaderArchive& operator=(const VShaderArchive&) = delete;
+
+		//maps and validates the archive, a missing or malformed file leaves the archive closed
+		bool Open(const std::string& path);
+		void Close();
+		bool IsOpen() const { return Mapping.Data != nullptr; }
+
+		//codeSize is in bytes, returns false when the archive has no shader of that name
+		bool Find(const std::string& name, const uint32_t*& code, size_t& codeSize) const;
+
+		uint32_t GetEntryCount() const;
+		std::vector<std::string> GetNames() const;
+
+		//written to a temporary file then renamed over path
+		static bool Pack(const std::vector<ShaderArchiveInput>& shaders, const std::string& path);
+
+	private:
+
+		const ShaderArchiveHeader* GetHeader() const { return static_cast<const ShaderArchiveHeader*>(Mapping.Data); }
+		const ShaderArchiveEntry* GetTable() const;
+
+		Platform::MappedFile Mapping;
+	};
+
+};
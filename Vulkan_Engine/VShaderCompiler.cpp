@@ -0,0 +1,241 @@
+#include "VShaderCompiler.h"
+#include "VHash.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdio>
+#include <cctype>
+
+Vulkan_Engine::VShaderCompiler::VShaderCompiler(const std::string& shaderDirectory, const std::string& cacheDirectory)
+{
+	ShaderDirectory = shaderDirectory;
+	CacheDirectory = cacheDirectory;
+	HConsole = Platform::GetConsole();
+}
+
+std::vector<Vulkan_Engine::ShaderBuildResult> Vulkan_Engine::VShaderCompiler::Build(const std::vector<ShaderBuildRequest>& requests)
+{
+	auto buildStart = std::chrono::high_resolution_clock::now();
+
+	std::error_code error;
+	std::filesystem::create_directories(CacheDirectory, error);
+
+	struct PendingCompile
+	{
+		size_t RequestIndex;
+		Platform::ProcessHandle Process;
+		std::string TemporaryPath;
+		std::chrono::high_resolution_clock::time_point Start;
+	};
+
+	std::vector<ShaderBuildResult> results(requests.size());
+	std::vector<PendingCompile> pending;
+
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		results[i].Hash = HashShader(requests[i]);
+		std::string cachePath = GetCachePath(results[i].Hash);
+
+		if (ReadFile(cachePath, results[i].SpirV))
+		{
+			results[i].CacheHit = true;
+			Hits++;
+
+			//the compile time of the entry, recorded when it was built, is what this hit saved
+			std::ifstream timeFile(cachePath + ".ms");
+			double compileMs = 0.0;
+			if (timeFile >> compileMs) SavedCompileMs += compileMs;
+			continue;
+		}
+
+		Misses++;
+
+		//glslc stage names differ from the engine's ones for the tessellation stages
+		std::string stage = requests[i].Type;
+		if (stage == "tcs") stage = "tesc";
+		else if (stage == "tes") stage = "tese";
+
+		PendingCompile compile;
+		compile.RequestIndex = i;
+		compile.TemporaryPath = cachePath + ".tmp";
+
+		std::vector<std::string> arguments = { Platform::ShaderCompilerExecutable(), "-fshader-stage=" + stage };
+		std::istringstream options(requests[i].Options);
+		std::string option;
+		while (options >> option) arguments.push_back(option);
+		arguments.push_back(ShaderDirectory + requests[i].Name);
+		arguments.push_back("-o");
+		arguments.push_back(compile.TemporaryPath);
+
+		std::cout << "processing " << requests[i].Name << " ...\n";
+		compile.Start = std::chrono::high_resolution_clock::now();
+		if (Platform::StartProcess(arguments, compile.Process)) pending.push_back(compile);
+		else
+		{
+			Failures++;
+			Platform::SetConsoleColor(HConsole, 12);
+			std::cout << "could not start " << arguments[0] << " for " << requests[i].Name << '\n';
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
+
+	//all the misses are compiling at the same time, collect them
+	auto compileStart = std::chrono::high_resolution_clock::now();
+	for (auto& compile : pending)
+	{
+		int exitCode = Platform::WaitProcess(compile.Process);
+		double compileMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compile.Start).count();
+		std::string cachePath = GetCachePath(results[compile.RequestIndex].Hash);
+
+		if (exitCode == 0 && Platform::ReplaceFileAtomic(compile.TemporaryPath, cachePath) && ReadFile(cachePath, results[compile.RequestIndex].SpirV))
+		{
+			std::ofstream timeFile(cachePath + ".ms", std::ios::out | std::ios::trunc);
+			timeFile << compileMs;
+		}
+		else
+		{
+			Failures++;
+			std::remove(compile.TemporaryPath.c_str());
+			Platform::SetConsoleColor(HConsole, 12);
+			std::cout << "failed to compile " << requests[compile.RequestIndex].Name << '\n';
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
+	CompileMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count();
+
+	//a shader that could not be built falls back to the SPIR-V shipped with the sources
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		if (!results[i].SpirV.empty()) continue;
+
+		if (!ReadFile(GetPrebuiltPath(requests[i]), results[i].SpirV))
+		{
+			std::string errorMessage = "ERROR :: COULD NOT BUILD THE SHADER : ";
+			errorMessage.append(requests[i].Name);
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error(errorMessage);
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+		results[i].Prebuilt = true;
+		Platform::SetConsoleColor(HConsole, 6);
+		std::cout << "using the prebuilt " << GetPrebuiltPath(requests[i]) << '\n';
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	BuildMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count();
+
+	return results;
+}
+
+uint64_t Vulkan_Engine::VShaderCompiler::HashShader(const ShaderBuildRequest& request)
+{
+	std::string source;
+	std::set<std::string> visited;
+	CollectSource(ShaderDirectory + request.Name, source, visited);
+
+	uint64_t hash = HashFNV1a(source);
+	hash = HashFNV1a(request.Type, hash);
+	hash = HashFNV1a(request.Options, hash);
+	hash = HashFNV1a(GetCompilerIdentity(), hash);
+	return hash;
+}
+
+std::string Vulkan_Engine::VShaderCompiler::GetCachePath(uint64_t hash)
+{
+	std::ostringstream path;
+	path << CacheDirectory << std::hex << std::setw(16) << std::setfill('0') << hash << ".spv";
+	return path.str();
+}
+
+void Vulkan_Engine::VShaderCompiler::PrintStatistics()
+{
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nShader build cache\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "hits : " << Hits << "\tmisses : " << Misses;
+	if (Failures) std::cout << "\tfailures : " << Failures;
+	std::cout << "\nbuild time : " << BuildMs << " ms (glslc : " << CompileMs << " ms)\n";
+	if (Hits) std::cout << "glslc processes skipped : " << Hits << ", about " << SavedCompileMs << " ms saved\n";
+}
+
+void Vulkan_Engine::VShaderCompiler::CollectSource(const std::string& path, std::string& source, std::set<std::string>& visited)
+{
+	if (!visited.insert(path).second) return;
+
+	std::vector<char> content;
+	if (!ReadFile(path, content))
+	{
+		std::string errorMessage = "ERROR :: COULD NOT LOAD THE FILE : ";
+		errorMessage.append(path);
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error(errorMessage);
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	//the path is part of the key too, so moving an include changes the hash
+	source.append(path);
+	source.append(content.begin(), content.end());
+
+	std::string directory = std::filesystem::path(path).parent_path().string();
+	if (!directory.empty()) directory.append("/");
+
+	std::istringstream lines(std::string(content.begin(), content.end()));
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		size_t position = line.find_first_not_of(" \t");
+		if (position == std::string::npos || line.compare(position, 8, "#include") != 0) continue;
+
+		size_t open = line.find_first_of("\"<", position + 8);
+		if (open == std::string::npos) continue;
+		size_t close = line.find_first_of("\">", open + 1);
+		if (close == std::string::npos) continue;
+
+		std::string include = line.substr(open + 1, close - open - 1);
+		std::string includePath = directory + include;
+		if (!std::filesystem::exists(includePath)) includePath = ShaderDirectory + include;
+		CollectSource(includePath, source, visited);
+	}
+}
+
+bool Vulkan_Engine::VShaderCompiler::ReadFile(const std::string& path, std::vector<char>& content)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!file.is_open()) return false;
+
+	size_t fileSize = (size_t)file.tellg();
+	content.resize(fileSize);
+	file.seekg(0, std::ios::beg);
+	file.read(content.data(), fileSize);
+	return file.good() && fileSize > 0;
+}
+
+std::string Vulkan_Engine::VShaderCompiler::GetPrebuiltPath(const ShaderBuildRequest& request)
+{
+	std::string nameWEX = request.Name.substr(0, request.Name.find('.'));
+	std::string path = ShaderDirectory + "SPIR-V/" + nameWEX + request.Type + ".spv";
+	if (std::filesystem::exists(path) || request.Type.empty()) return path;
+
+	//the shipped files are named with a capitalized type (PrimitiveShaderVert.spv), which matters on case-sensitive file systems
+	std::string type = request.Type;
+	type[0] = static_cast<char>(toupper(type[0]));
+	return ShaderDirectory + "SPIR-V/" + nameWEX + type + ".spv";
+}
+
+const std::string& Vulkan_Engine::VShaderCompiler::GetCompilerIdentity()
+{
+	//the executable path alone stays the same across SDK updates, the version banner names glslc, shaderc and glslang
+	static const std::string identity = []()
+	{
+		std::string executable = Platform::ShaderCompilerExecutable();
+		std::string version;
+		if (Platform::RunProcess({ executable, "--version" }, version) != 0) version.clear();
+		return executable + '\n' + version;
+	}();
+	return identity;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	struct ShaderBuildRequest
+	{
+		std::string Name;    //file name inside the shader directory, e.g. PrimitiveShader.vert
+		std::string Type;    //vert/frag/tcs/tes/geom/comp
+		std::string Options; //extra glslc options, part of the cache key
+	};
+
+	struct ShaderBuildResult
+	{
+		std::vector<char> SpirV;
+		uint64_t Hash = 0;
+		bool CacheHit = false;
+		bool Prebuilt = false; //the build failed and SpirV is the one shipped with the sources
+	};
+
+	//content-addressed SPIR-V build cache
+	//the key hashes the GLSL source, every file it includes, the compile options and the glslc version, glslc only runs on a miss
+	class VShaderCompiler
+	{
+	public:
+
+		VShaderCompiler(const std::string& shaderDirectory = "Shaders/", const std::string& cacheDirectory = "Shaders/Cache/");
+
+		//misses are compiled by parallel glslc processes, hits never spawn a process
+		std::vector<ShaderBuildResult> Build(const std::vector<ShaderBuildRequest>& requests);
+
+		uint64_t HashShader(const ShaderBuildRequest& request);
+		std::string GetCachePath(uint64_t hash);
+
+		void PrintStatistics();
+
+	private:
+
+		//appends the source and, recursively, the #include'd files of path
+		void CollectSource(const std::string& path, std::string& source, std::set<std::string>& visited);
+		bool ReadFile(const std::string& path, std::vector<char>& content);
+		std::string GetPrebuiltPath(const ShaderBuildRequest& request);
+		//glslc --version output, queried once per run so an updated compiler misses the entries of the old one
+		static const std::string& GetCompilerIdentity();
+
+		std::string ShaderDirectory;
+		std::string CacheDirectory;
+
+		//statistics
+		uint32_t Hits = 0;
+		uint32_t Misses = 0;
+		uint32_t Failures = 0;
+		double SavedCompileMs = 0.0;  //compile time recorded by the hits when they were misses
+		double CompileMs = 0.0;       //wall time spent waiting on glslc
+		double BuildMs = 0.0;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
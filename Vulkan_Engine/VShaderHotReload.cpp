@@ -0,0 +1,125 @@
+#include "VShaderHotReload.h"
+
+#include <iostream>
+#include <stdexcept>
+
+Vulkan_Engine::VShaderHotReload::VShaderHotReload()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VShaderHotReload::~VShaderHotReload()
+{
+	Stop();
+}
+
+bool Vulkan_Engine::VShaderHotReload::Start(const std::string& shaderDirectory, const std::vector<ShaderBuildRequest>& shaders)
+{
+	Stop();
+	ShaderDirectory = shaderDirectory;
+	Shaders = shaders;
+	Compiler = VShaderCompiler(shaderDirectory, shaderDirectory + "Cache/");
+
+	BuiltHashes.clear();
+	try {
+		for (const auto& shader : Shaders) BuiltHashes[shader.Name] = Compiler.HashShader(shader);
+	}
+	catch (std::exception&) {
+		//no sources to watch, e.g. the shaders come from the archive of a packaged build
+		return false;
+	}
+
+	if (!Platform::WatchDirectory(ShaderDirectory, Watch)) return false;
+
+	Running = true;
+	Worker = std::thread(&VShaderHotReload::Run, this);
+
+	Platform::SetConsoleColor(HConsole, 6);
+	std::cout << "watching " << ShaderDirectory << " for shader changes\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	return true;
+}
+
+void Vulkan_Engine::VShaderHotReload::Stop()
+{
+	Running = false;
+	if (Worker.joinable()) Worker.join();
+	Platform::CloseDirectoryWatch(Watch);
+}
+
+std::vector<Vulkan_Engine::ShaderReload> Vulkan_Engine::VShaderHotReload::TakeReloads()
+{
+	std::lock_guard<std::mutex> lock(ReloadsMutex);
+	std::vector<ShaderReload> reloads;
+	reloads.swap(Reloads);
+	return reloads;
+}
+
+void Vulkan_Engine::VShaderHotReload::Run()
+{
+	while (Running)
+	{
+		if (Platform::PollDirectoryChanges(Watch).empty())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			continue;
+		}
+		auto changeTime = std::chrono::high_resolution_clock::now();
+
+		//editors often save in several writes, let them finish before reading the sources
+		std::this_thread::sleep_for(std::chrono::milliseconds(30));
+		Platform::PollDirectoryChanges(Watch);
+
+		Rebuild(changeTime);
+	}
+}
+
+void Vulkan_Engine::VShaderHotReload::Rebuild(std::chrono::high_resolution_clock::time_point changeTime)
+{
+	//any file of the directory may be included by a shader, the content hash tells which shaders really changed
+	std::vector<ShaderBuildRequest> requests;
+	std::vector<uint64_t> hashes;
+	for (const auto& shader : Shaders)
+	{
+		uint64_t hash = 0;
+		try {
+			hash = Compiler.HashShader(shader);
+		}
+		catch (std::exception&) {
+			continue; //the file is being replaced, the next event will pick it up
+		}
+		if (hash == BuiltHashes[shader.Name]) continue;
+		requests.push_back(shader);
+		hashes.push_back(hash);
+	}
+	if (requests.empty()) return;
+
+	auto compileStart = std::chrono::high_resolution_clock::now();
+	std::vector<ShaderBuildResult> results;
+	try {
+		results = Compiler.Build(requests);
+	}
+	catch (std::exception& e) {
+		Platform::SetConsoleColor(HConsole, 12);
+		std::cout << e.what() << '\n';
+		Platform::SetConsoleColor(HConsole, 15);
+		return;
+	}
+	double compileMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count();
+
+	std::lock_guard<std::mutex> lock(ReloadsMutex);
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		//a failed build falls back to the shipped SPIR-V, that is never what the user wants to see after an edit
+		if (results[i].Prebuilt)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			std::cout << "hot reload : " << requests[i].Name << " does not compile, keeping the current pipeline\n";
+			Platform::SetConsoleColor(HConsole, 15);
+			continue;
+		}
+
+		BuiltHashes[requests[i].Name] = hashes[i];
+		Reloads.push_back({ requests[i].Name, std::move(results[i].SpirV), changeTime, compileMs });
+	}
+}
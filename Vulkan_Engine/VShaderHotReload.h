@@ -0,0 +1,61 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VShaderCompiler.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+namespace Vulkan_Engine {
+
+	struct ShaderReload
+	{
+		std::string Name;
+		std::vector<char> SpirV;
+		std::chrono::high_resolution_clock::time_point ChangeTime; //when the file change was seen
+		double CompileMs = 0.0;
+	};
+
+	//watches the shader directory and rebuilds the changed shaders on its own thread
+	//the renderer collects the rebuilt SPIR-V at a frame boundary with TakeReloads, nothing here touches the device
+	class VShaderHotReload
+	{
+	public:
+
+		VShaderHotReload();
+		~VShaderHotReload();
+
+		//shaders holds the requests the shaders were built with, their current SPIR-V hash is what a change is compared to
+		bool Start(const std::string& shaderDirectory, const std::vector<ShaderBuildRequest>& shaders);
+		void Stop();
+		bool IsRunning() const { return Running; }
+
+		std::vector<ShaderReload> TakeReloads();
+
+	private:
+
+		void Run();
+		void Rebuild(std::chrono::high_resolution_clock::time_point changeTime);
+
+		std::string ShaderDirectory;
+		std::vector<ShaderBuildRequest> Shaders;
+		std::map<std::string, uint64_t> BuiltHashes;
+
+		//owned by the watcher thread
+		Platform::DirectoryWatch Watch;
+		VShaderCompiler Compiler;
+
+		std::thread Worker;
+		std::atomic<bool> Running{ false };
+		std::mutex ReloadsMutex;
+		std::vector<ShaderReload> Reloads;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
@@ -0,0 +1,556 @@
+#include "VSpirvReflect.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+	//the subset of the SPIR-V specification needed for reflection
+	const uint32_t SPIRV_MAGIC = 0x07230203;
+
+	enum SpirvOp : uint32_t {
+		OpName = 5, OpEntryPoint = 15,
+		OpTypeBool = 20, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23, OpTypeMatrix = 24, OpTypeImage = 25,
+		OpTypeSampler = 26, OpTypeSampledImage = 27, OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30, OpTypePointer = 32,
+		OpConstant = 43, OpSpecConstantTrue = 48, OpSpecConstantFalse = 49, OpSpecConstant = 50,
+		OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72
+	};
+
+	enum SpirvDecoration : uint32_t {
+		DecorationSpecId = 1, DecorationBlock = 2, DecorationBufferBlock = 3, DecorationArrayStride = 6, DecorationMatrixStride = 7,
+		DecorationBuiltIn = 11, DecorationLocation = 30, DecorationBinding = 33, DecorationDescriptorSet = 34, DecorationOffset = 35
+	};
+
+	enum SpirvStorageClass : uint32_t {
+		StorageClassUniformConstant = 0, StorageClassInput = 1, StorageClassUniform = 2, StorageClassOutput = 3,
+		StorageClassPushConstant = 9, StorageClassStorageBuffer = 12
+	};
+
+	const uint32_t DimBuffer = 5;
+	const uint32_t DimSubpassData = 6;
+
+	struct SpirvType
+	{
+		uint32_t Op = 0;
+		uint32_t Width = 0;          //int/float
+		uint32_t Signedness = 0;     //int
+		uint32_t ElementType = 0;    //vector/matrix/array/pointer/sampled image
+		uint32_t ElementCount = 0;   //vector components, matrix columns
+		uint32_t LengthId = 0;       //array
+		uint32_t StorageClass = 0;   //pointer
+		uint32_t Dim = 0;            //image
+		uint32_t Sampled = 0;        //image, 1 = sampled, 2 = storage
+		std::vector<uint32_t> Members;
+	};
+
+	struct SpirvDecorations
+	{
+		bool HasLocation = false, HasBinding = false, HasSet = false, HasSpecId = false;
+		uint32_t Location = 0, Binding = 0, Set = 0, SpecId = 0, ArrayStride = 0;
+		bool BuiltIn = false, Block = false, BufferBlock = false;
+	};
+
+	struct SpirvMemberDecorations
+	{
+		bool HasOffset = false;
+		uint32_t Offset = 0, MatrixStride = 0;
+		bool BuiltIn = false;
+	};
+
+	struct SpirvModule
+	{
+		std::map<uint32_t, std::string> Names;
+		std::map<uint32_t, SpirvDecorations> Decorations;
+		std::map<std::pair<uint32_t, uint32_t>, SpirvMemberDecorations> MemberDecorations;
+		std::map<uint32_t, SpirvType> Types;
+		std::map<uint32_t, uint64_t> Constants;
+		std::map<uint32_t, uint32_t> ConstantTypes;
+		std::vector<uint32_t> SpecConstants;
+		struct Variable { uint32_t Id, PointerType, StorageClass; };
+		std::vector<Variable> Variables;
+
+		const SpirvType& GetType(uint32_t id) const
+		{
+			auto type = Types.find(id);
+			if (type == Types.end()) throw std::runtime_error("ERROR :: SPIR-V reflection : unknown type id " + std::to_string(id));
+			return type->second;
+		}
+
+		std::string GetName(uint32_t id) const
+		{
+			auto name = Names.find(id);
+			return name == Names.end() ? std::string() : name->second;
+		}
+
+		uint32_t GetArrayLength(const SpirvType& type) const
+		{
+			auto length = Constants.find(type.LengthId);
+			return length == Constants.end() ? 1 : static_cast<uint32_t>(length->second);
+		}
+
+		uint32_t GetSize(uint32_t typeId) const
+		{
+			const SpirvType& type = GetType(typeId);
+			switch (type.Op)
+			{
+			case OpTypeBool: return 4;
+			case OpTypeInt:
+			case OpTypeFloat: return type.Width / 8;
+			case OpTypeVector: return type.ElementCount * GetSize(type.ElementType);
+			case OpTypeMatrix: return type.ElementCount * GetSize(type.ElementType);
+			case OpTypeArray:
+			{
+				auto decorations = Decorations.find(typeId);
+				uint32_t stride = (decorations != Decorations.end() && decorations->second.ArrayStride) ? decorations->second.ArrayStride : GetSize(type.ElementType);
+				return GetArrayLength(type) * stride;
+			}
+			case OpTypeStruct:
+			{
+				uint32_t size = 0, offset = 0;
+				for (uint32_t member = 0; member < type.Members.size(); member++) {
+					auto decorations = MemberDecorations.find(std::make_pair(typeId, member));
+					if (decorations != MemberDecorations.end() && decorations->second.HasOffset) offset = decorations->second.Offset;
+					uint32_t memberSize = GetSize(type.Members[member]);
+					const SpirvType& memberType = GetType(type.Members[member]);
+					if (memberType.Op == OpTypeMatrix && decorations != MemberDecorations.end() && decorations->second.MatrixStride)
+						memberSize = memberType.ElementCount * decorations->second.MatrixStride;
+					size = std::max(size, offset + memberSize);
+					offset += memberSize;
+				}
+				return size;
+			}
+			default: return 0; //runtime arrays, opaque types
+			}
+		}
+
+		bool IsBuiltIn(uint32_t variableId, uint32_t typeId) const
+		{
+			auto decorations = Decorations.find(variableId);
+			if (decorations != Decorations.end() && decorations->second.BuiltIn) return true;
+
+			//gl_PerVertex like blocks are built-in through their members
+			const SpirvType& type = GetType(typeId);
+			if (type.Op != OpTypeStruct) return false;
+			for (uint32_t member = 0; member < type.Members.size(); member++) {
+				auto memberDecorations = MemberDecorations.find(std::make_pair(typeId, member));
+				if (memberDecorations != MemberDecorations.end() && memberDecorations->second.BuiltIn) return true;
+			}
+			return false;
+		}
+	};
+
+	std::string ReadString(const uint32_t* words, uint32_t wordCount, uint32_t& consumedWords)
+	{
+		std::string text;
+		consumedWords = 0;
+		for (uint32_t i = 0; i < wordCount; i++) {
+			consumedWords++;
+			for (uint32_t byte = 0; byte < 4; byte++) {
+				char character = static_cast<char>((words[i] >> (byte * 8)) & 0xFF);
+				if (character == '\0') return text;
+				text.push_back(character);
+			}
+		}
+		return text;
+	}
+
+	VkShaderStageFlagBits GetStage(uint32_t executionModel)
+	{
+		switch (executionModel)
+		{
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		default: return VK_SHADER_STAGE_ALL;
+		}
+	}
+
+	VkFormat GetFormat(const SpirvModule& module, const SpirvType& type)
+	{
+		const SpirvType& scalar = (type.Op == OpTypeVector) ? module.GetType(type.ElementType) : type;
+		uint32_t components = (type.Op == OpTypeVector) ? type.ElementCount : 1;
+		if (components < 1 || components > 4) return VK_FORMAT_UNDEFINED;
+
+		static const VkFormat Float32[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static const VkFormat Float64[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+		static const VkFormat Int32[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static const VkFormat Uint32[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+		if (scalar.Op == OpTypeFloat && scalar.Width == 32) return Float32[components - 1];
+		if (scalar.Op == OpTypeFloat && scalar.Width == 64) return Float64[components - 1];
+		if (scalar.Op == OpTypeInt && scalar.Width == 32) return scalar.Signedness ? Int32[components - 1] : Uint32[components - 1];
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	void ParseModule(const uint32_t* words, size_t wordCount, SpirvModule& module, Vulkan_Engine::ShaderReflection& reflection)
+	{
+		if (wordCount < 5 || words[0] != SPIRV_MAGIC) throw std::runtime_error("ERROR :: SPIR-V reflection : not a SPIR-V module");
+
+		bool entryPointFound = false;
+		size_t position = 5;
+		while (position < wordCount)
+		{
+			uint32_t instructionWords = words[position] >> 16;
+			uint32_t opcode = words[position] & 0xFFFF;
+			if (instructionWords == 0 || position + instructionWords > wordCount) throw std::runtime_error("ERROR :: SPIR-V reflection : truncated instruction");
+			const uint32_t* operands = words + position + 1;
+			uint32_t operandCount = instructionWords - 1;
+			uint32_t consumed = 0;
+
+			switch (opcode)
+			{
+			case OpName:
+				if (operandCount >= 2) module.Names[operands[0]] = ReadString(operands + 1, operandCount - 1, consumed);
+				break;
+			case OpEntryPoint:
+				if (!entryPointFound && operandCount >= 3) {
+					entryPointFound = true;
+					reflection.ExecutionModel = operands[0];
+					reflection.Stage = GetStage(operands[0]);
+					reflection.EntryPoint = ReadString(operands + 2, operandCount - 2, consumed);
+				}
+				break;
+			case OpDecorate:
+				if (operandCount >= 2) {
+					SpirvDecorations& decorations = module.Decorations[operands[0]];
+					uint32_t literal = operandCount >= 3 ? operands[2] : 0;
+					switch (operands[1])
+					{
+					case DecorationLocation: decorations.HasLocation = true; decorations.Location = literal; break;
+					case DecorationBinding: decorations.HasBinding = true; decorations.Binding = literal; break;
+					case DecorationDescriptorSet: decorations.HasSet = true; decorations.Set = literal; break;
+					case DecorationSpecId: decorations.HasSpecId = true; decorations.SpecId = literal; break;
+					case DecorationArrayStride: decorations.ArrayStride = literal; break;
+					case DecorationBuiltIn: decorations.BuiltIn = true; break;
+					case DecorationBlock: decorations.Block = true; break;
+					case DecorationBufferBlock: decorations.BufferBlock = true; break;
+					default: break;
+					}
+				}
+				break;
+			case OpMemberDecorate:
+				if (operandCount >= 3) {
+					SpirvMemberDecorations& decorations = module.MemberDecorations[std::make_pair(operands[0], operands[1])];
+					uint32_t literal = operandCount >= 4 ? operands[3] : 0;
+					if (operands[2] == DecorationOffset) { decorations.HasOffset = true; decorations.Offset = literal; }
+					else if (operands[2] == DecorationMatrixStride) decorations.MatrixStride = literal;
+					else if (operands[2] == DecorationBuiltIn) decorations.BuiltIn = true;
+				}
+				break;
+			case OpTypeBool:
+			case OpTypeSampler:
+				module.Types[operands[0]].Op = opcode;
+				break;
+			case OpTypeInt:
+			case OpTypeFloat:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.Width = operands[1];
+				type.Signedness = (opcode == OpTypeInt && operandCount >= 3) ? operands[2] : 0;
+				break;
+			}
+			case OpTypeVector:
+			case OpTypeMatrix:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.ElementType = operands[1];
+				type.ElementCount = operands[2];
+				break;
+			}
+			case OpTypeImage:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.ElementType = operands[1];
+				type.Dim = operands[2];
+				type.Sampled = operandCount >= 7 ? operands[6] : 0;
+				break;
+			}
+			case OpTypeSampledImage:
+			case OpTypeRuntimeArray:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.ElementType = operands[1];
+				break;
+			}
+			case OpTypeArray:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.ElementType = operands[1];
+				type.LengthId = operands[2];
+				break;
+			}
+			case OpTypeStruct:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.Members.assign(operands + 1, operands + operandCount);
+				break;
+			}
+			case OpTypePointer:
+			{
+				SpirvType& type = module.Types[operands[0]];
+				type.Op = opcode;
+				type.StorageClass = operands[1];
+				type.ElementType = operands[2];
+				break;
+			}
+			case OpConstant:
+			case OpSpecConstant:
+			{
+				uint64_t value = operandCount >= 3 ? operands[2] : 0;
+				if (operandCount >= 4) value |= static_cast<uint64_t>(operands[3]) << 32;
+				module.Constants[operands[1]] = value;
+				module.ConstantTypes[operands[1]] = operands[0];
+				if (opcode == OpSpecConstant) module.SpecConstants.push_back(operands[1]);
+				break;
+			}
+			case OpSpecConstantTrue:
+			case OpSpecConstantFalse:
+				module.Constants[operands[1]] = (opcode == OpSpecConstantTrue) ? 1 : 0;
+				module.ConstantTypes[operands[1]] = operands[0];
+				module.SpecConstants.push_back(operands[1]);
+				break;
+			case OpVariable:
+				module.Variables.push_back({ operands[1], operands[0], operands[2] });
+				break;
+			default:
+				break;
+			}
+
+			position += instructionWords;
+		}
+
+		if (!entryPointFound) throw std::runtime_error("ERROR :: SPIR-V reflection : the module has no entry point");
+	}
+
+	VkDescriptorType GetDescriptorType(const SpirvModule& module, uint32_t storageClass, uint32_t typeId)
+	{
+		const SpirvType& type = module.GetType(typeId);
+		if (storageClass == StorageClassStorageBuffer) return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		if (storageClass == StorageClassUniform) {
+			auto decorations = module.Decorations.find(typeId);
+			bool bufferBlock = decorations != module.Decorations.end() && decorations->second.BufferBlock;
+			return bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		}
+
+		switch (type.Op)
+		{
+		case OpTypeSampler: return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case OpTypeSampledImage: return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case OpTypeImage:
+			if (type.Dim == DimBuffer) return type.Sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			if (type.Dim == DimSubpassData) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			return type.Sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		default: return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		}
+	}
+
+}
+
+Vulkan_Engine::ShaderReflection Vulkan_Engine::VSpirvReflect::Reflect(const uint32_t* words, size_t wordCount)
+{
+	ShaderReflection reflection;
+	SpirvModule module;
+	ParseModule(words, wordCount, module, reflection);
+
+	for (const auto& variable : module.Variables)
+	{
+		const SpirvType& pointer = module.GetType(variable.PointerType);
+		uint32_t typeId = pointer.ElementType;
+		auto decorations = module.Decorations.find(variable.Id);
+		SpirvDecorations variableDecorations = decorations == module.Decorations.end() ? SpirvDecorations{} : decorations->second;
+
+		switch (variable.StorageClass)
+		{
+		case StorageClassInput:
+		case StorageClassOutput:
+		{
+			if (module.IsBuiltIn(variable.Id, typeId) || !variableDecorations.HasLocation) break;
+			std::vector<ReflectedVariable>& list = (variable.StorageClass == StorageClassInput) ? reflection.Inputs : reflection.Outputs;
+
+			//a matrix takes one location per column
+			const SpirvType& type = module.GetType(typeId);
+			uint32_t locations = (type.Op == OpTypeMatrix) ? type.ElementCount : 1;
+			const SpirvType& locationType = (type.Op == OpTypeMatrix) ? module.GetType(type.ElementType) : type;
+			uint32_t locationTypeId = (type.Op == OpTypeMatrix) ? type.ElementType : typeId;
+			for (uint32_t column = 0; column < locations; column++) {
+				ReflectedVariable reflected;
+				reflected.Name = module.GetName(variable.Id);
+				reflected.Location = variableDecorations.Location + column;
+				reflected.Format = GetFormat(module, locationType);
+				reflected.Size = module.GetSize(locationTypeId);
+				list.push_back(reflected);
+			}
+			break;
+		}
+		case StorageClassPushConstant:
+		{
+			const SpirvType& type = module.GetType(typeId);
+			uint32_t offset = UINT32_MAX;
+			for (uint32_t member = 0; member < type.Members.size(); member++) {
+				auto memberDecorations = module.MemberDecorations.find(std::make_pair(typeId, member));
+				offset = std::min(offset, memberDecorations != module.MemberDecorations.end() ? memberDecorations->second.Offset : 0u);
+			}
+			if (offset == UINT32_MAX) offset = 0;
+			VkPushConstantRange range{};
+			range.stageFlags = reflection.Stage;
+			range.offset = offset;
+			range.size = module.GetSize(typeId) - offset;
+			reflection.PushConstants.push_back(range);
+			break;
+		}
+		case StorageClassUniformConstant:
+		case StorageClassUniform:
+		case StorageClassStorageBuffer:
+		{
+			ReflectedDescriptorBinding binding;
+			binding.Name = module.GetName(variable.Id);
+			binding.Set = variableDecorations.Set;
+			binding.Binding = variableDecorations.Binding;
+
+			//arrays of resources become descriptor counts, runtime sized arrays report 0
+			uint32_t resourceType = typeId;
+			while (module.GetType(resourceType).Op == OpTypeArray || module.GetType(resourceType).Op == OpTypeRuntimeArray) {
+				const SpirvType& array = module.GetType(resourceType);
+				binding.Count *= (array.Op == OpTypeArray) ? module.GetArrayLength(array) : 0;
+				resourceType = array.ElementType;
+			}
+
+			binding.Type = GetDescriptorType(module, variable.StorageClass, resourceType);
+			if (binding.Type == VK_DESCRIPTOR_TYPE_MAX_ENUM) break;
+			if (binding.Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || binding.Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) binding.Size = module.GetSize(resourceType);
+			reflection.DescriptorBindings.push_back(binding);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	for (const auto& specConstant : module.SpecConstants)
+	{
+		auto decorations = module.Decorations.find(specConstant);
+		if (decorations == module.Decorations.end() || !decorations->second.HasSpecId) continue;
+
+		ReflectedSpecializationConstant constant;
+		constant.Name = module.GetName(specConstant);
+		constant.SpecId = decorations->second.SpecId;
+		constant.Size = module.GetSize(module.ConstantTypes[specConstant]);
+		constant.DefaultValue = module.Constants[specConstant];
+		reflection.SpecializationConstants.push_back(constant);
+	}
+
+	auto byLocation = [](const ReflectedVariable& a, const ReflectedVariable& b) { return a.Location < b.Location; };
+	std::sort(reflection.Inputs.begin(), reflection.Inputs.end(), byLocation);
+	std::sort(reflection.Outputs.begin(), reflection.Outputs.end(), byLocation);
+	std::sort(reflection.DescriptorBindings.begin(), reflection.DescriptorBindings.end(), [](const ReflectedDescriptorBinding& a, const ReflectedDescriptorBinding& b) {
+		return a.Set != b.Set ? a.Set < b.Set : a.Binding < b.Binding;
+	});
+	std::sort(reflection.SpecializationConstants.begin(), reflection.SpecializationConstants.end(), [](const ReflectedSpecializationConstant& a, const ReflectedSpecializationConstant& b) {
+		return a.SpecId < b.SpecId;
+	});
+
+	return reflection;
+}
+
+Vulkan_Engine::ShaderReflection Vulkan_Engine::VSpirvReflect::Reflect(const std::vector<char>& spirv)
+{
+	//the bytes of a std::vector<char> are not guaranteed to be 4 bytes aligned, copy them into words
+	std::vector<uint32_t> words(spirv.size() / sizeof(uint32_t));
+	std::memcpy(words.data(), spirv.data(), words.size() * sizeof(uint32_t));
+	return Reflect(words.data(), words.size());
+}
+
+Vulkan_Engine::ReflectedPipelineLayout Vulkan_Engine::VSpirvReflect::MergeLayouts(const std::vector<ShaderReflection>& reflections)
+{
+	ReflectedPipelineLayout layout;
+
+	for (const auto& reflection : reflections)
+	{
+		for (const auto& binding : reflection.DescriptorBindings)
+		{
+			std::vector<VkDescriptorSetLayoutBinding>& set = layout.Sets[binding.Set];
+			auto existing = std::find_if(set.begin(), set.end(), [&](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding.Binding; });
+			if (existing != set.end())
+			{
+				if (existing->descriptorType != binding.Type) throw std::runtime_error("ERROR :: SPIR-V reflection : stages disagree on the type of set " + std::to_string(binding.Set) + " binding " + std::to_string(binding.Binding));
+				existing->stageFlags |= reflection.Stage;
+				existing->descriptorCount = std::max(existing->descriptorCount, binding.Count);
+				continue;
+			}
+
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding.Binding;
+			layoutBinding.descriptorType = binding.Type;
+			layoutBinding.descriptorCount = binding.Count;
+			layoutBinding.stageFlags = reflection.Stage;
+			layoutBinding.pImmutableSamplers = nullptr;
+			set.push_back(layoutBinding);
+		}
+
+		//stages sharing the same push constant block share a range, a stage may only appear in one range
+		for (const auto& range : reflection.PushConstants)
+		{
+			auto existing = std::find_if(layout.PushConstants.begin(), layout.PushConstants.end(), [&](const VkPushConstantRange& r) { return r.offset == range.offset && r.size == range.size; });
+			if (existing != layout.PushConstants.end()) existing->stageFlags |= range.stageFlags;
+			else layout.PushConstants.push_back(range);
+		}
+	}
+
+	for (auto& set : layout.Sets) {
+		std::sort(set.second.begin(), set.second.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+	}
+
+	return layout;
+}
+
+void Vulkan_Engine::VSpirvReflect::BuildVertexInput(const ShaderReflection& vertexReflection, std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+	bindings.clear();
+	attributes.clear();
+
+	uint32_t offset = 0;
+	for (const auto& input : vertexReflection.Inputs)
+	{
+		VkVertexInputAttributeDescription attribute{};
+		attribute.binding = 0;
+		attribute.location = input.Location;
+		attribute.format = input.Format;
+		attribute.offset = offset;
+		attributes.push_back(attribute);
+		offset += input.Size;
+	}
+
+	if (attributes.empty()) return;
+
+	VkVertexInputBindingDescription binding{};
+	binding.binding = 0;
+	binding.stride = offset;
+	binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	bindings.push_back(binding);
+}
+
+void Vulkan_Engine::VSpirvReflect::Print(const std::string& shaderName, const ShaderReflection& reflection)
+{
+	std::cout << shaderName << " : entry point " << reflection.EntryPoint << ", execution model " << reflection.ExecutionModel << '\n';
+	for (const auto& input : reflection.Inputs)
+		std::cout << "\tin  location " << input.Location << '\t' << input.Name << " (format " << input.Format << ", " << input.Size << " bytes)\n";
+	for (const auto& output : reflection.Outputs)
+		std::cout << "\tout location " << output.Location << '\t' << output.Name << " (format " << output.Format << ", " << output.Size << " bytes)\n";
+	for (const auto& binding : reflection.DescriptorBindings)
+		std::cout << "\tset " << binding.Set << " binding " << binding.Binding << '\t' << binding.Name << " (type " << binding.Type << ", count " << binding.Count << ")\n";
+	for (const auto& range : reflection.PushConstants)
+		std::cout << "\tpush constants offset " << range.offset << " size " << range.size << '\n';
+	for (const auto& constant : reflection.SpecializationConstants)
+		std::cout << "\tspecialization constant " << constant.SpecId << '\t' << constant.Name << " = " << constant.DefaultValue << '\n';
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//stage input/output variable, built-ins (gl_VertexIndex, gl_Position...) are not listed
+	struct ReflectedVariable
+	{
+		std::string Name;
+		uint32_t Location = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Size = 0; //bytes
+	};
+
+	struct ReflectedDescriptorBinding
+	{
+		std::string Name;
+		uint32_t Set = 0;
+		uint32_t Binding = 0;
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		uint32_t Count = 1;
+		uint32_t Size = 0; //block size for uniform/storage buffers
+	};
+
+	struct ReflectedSpecializationConstant
+	{
+		std::string Name;
+		uint32_t SpecId = 0;
+		uint32_t Size = 0;
+		uint64_t DefaultValue = 0;
+	};
+
+	struct ShaderReflection
+	{
+		std::string EntryPoint;
+		uint32_t ExecutionModel = 0;
+		VkShaderStageFlagBits Stage = VK_SHADER_STAGE_ALL;
+		std::vector<ReflectedVariable> Inputs;
+		std::vector<ReflectedVariable> Outputs;
+		std::vector<ReflectedDescriptorBinding> DescriptorBindings;
+		std::vector<VkPushConstantRange> PushConstants;
+		std::vector<ReflectedSpecializationConstant> SpecializationConstants;
+	};
+
+	//pipeline layout description merged from the reflection of all the stages of a pipeline
+	struct ReflectedPipelineLayout
+	{
+		std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>> Sets;
+		std::vector<VkPushConstantRange> PushConstants;
+	};
+
+	//minimal SPIR-V parser, pure CPU code working on the words of a .spv module : it does not call the Vulkan loader
+	class VSpirvReflect
+	{
+	public:
+
+		//throws std::runtime_error on a malformed module
+		static ShaderReflection Reflect(const uint32_t* words, size_t wordCount);
+		static ShaderReflection Reflect(const std::vector<char>& spirv);
+
+		static ReflectedPipelineLayout MergeLayouts(const std::vector<ShaderReflection>& reflections);
+
+		//one interleaved vertex buffer at binding 0, attributes ordered by location
+		static void BuildVertexInput(const ShaderReflection& vertexReflection,
+			std::vector<VkVertexInputBindingDescription>& bindings,
+			std::vector<VkVertexInputAttributeDescription>& attributes);
+
+		static void Print(const std::string& shaderName, const ShaderReflection& reflection);
+	};
+
+};
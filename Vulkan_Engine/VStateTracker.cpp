@@ -0,0 +1,285 @@
+#include "VStateTracker.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+	const VkAccessFlags WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+}
+
+Vulkan_Engine::VStateTracker::VStateTracker()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VStateTracker::SubresourceState Vulkan_Engine::VStateTracker::MakeState(const ResourceState& state)
+{
+	//a write still has to be made visible, reads only have to be waited for by the next write
+	SubresourceState subresource;
+	subresource.Layout = state.Layout;
+	if (state.Access & WRITE_ACCESS)
+	{
+		subresource.WriteStages = state.Stages;
+		subresource.WriteAccess = state.Access & WRITE_ACCESS;
+	}
+	else subresource.ReadStages = state.Stages;
+	return subresource;
+}
+
+void Vulkan_Engine::VStateTracker::TrackImage(VkImage image, VkImageAspectFlags aspect, uint32_t mipLevels, uint32_t arrayLayers, const ResourceState& state)
+{
+	ImageEntry& entry = Images[image];
+	entry.Aspect = aspect;
+	entry.MipLevels = std::max(mipLevels, 1u);
+	entry.ArrayLayers = std::max(arrayLayers, 1u);
+	entry.Subresources.assign(size_t(entry.MipLevels) * entry.ArrayLayers, MakeState(state));
+}
+
+void Vulkan_Engine::VStateTracker::ForgetImage(VkImage image)
+{
+	Images.erase(image);
+}
+
+void Vulkan_Engine::VStateTracker::TrackBuffer(VkBuffer buffer, const ResourceState& state)
+{
+	Buffers[buffer] = MakeState(state);
+}
+
+void Vulkan_Engine::VStateTracker::ForgetBuffer(VkBuffer buffer)
+{
+	Buffers.erase(buffer);
+}
+
+Vulkan_Engine::VStateTracker::ImageEntry& Vulkan_Engine::VStateTracker::GetImage(VkImage image)
+{
+	auto found = Images.find(image);
+	if (found == Images.end())
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: The state tracker has no state for this image, it must be tracked first");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	return found->second;
+}
+
+void Vulkan_Engine::VStateTracker::SetImageState(VkImage image, const ResourceState& state)
+{
+	ImageEntry& entry = GetImage(image);
+	std::fill(entry.Subresources.begin(), entry.Subresources.end(), MakeState(state));
+}
+
+void Vulkan_Engine::VStateTracker::SetBufferState(VkBuffer buffer, const ResourceState& state)
+{
+	Buffers[buffer] = MakeState(state);
+}
+
+bool Vulkan_Engine::VStateTracker::Transition(SubresourceState& state, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard,
+	PendingBarrier& barrier)
+{
+	bool write = (access & WRITE_ACCESS) != 0;
+	bool transition = state.Layout != layout;
+
+	if (!write && !transition)
+	{
+		//read after read, or a read of a write already visible to these stages : nothing to wait for
+		bool visible = (stages & ~state.VisibleStages) == 0 && (access & ~state.VisibleAccess) == 0;
+		if (state.WriteStages == 0 || visible)
+		{
+			state.ReadStages |= stages;
+			return false;
+		}
+		barrier.SrcStages = state.WriteStages;
+		barrier.SrcAccess = state.WriteAccess;
+		barrier.DstStages = stages;
+		barrier.DstAccess = access;
+		barrier.OldLayout = barrier.NewLayout = layout;
+		state.ReadStages |= stages;
+		state.VisibleStages |= stages;
+		state.VisibleAccess |= access;
+		return true;
+	}
+
+	//a write of data nobody used yet in the right layout waits for nothing
+	if (!transition && state.WriteStages == 0 && state.ReadStages == 0)
+	{
+		state.WriteStages = stages;
+		state.WriteAccess = access & WRITE_ACCESS;
+		return false;
+	}
+
+	//write after write, write after read (execution only, WriteAccess is 0 then) or a layout transition, which is a write too
+	barrier.SrcStages = (state.WriteStages | state.ReadStages) ? (state.WriteStages | state.ReadStages) : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+	barrier.SrcAccess = state.WriteAccess;
+	barrier.DstStages = stages;
+	barrier.DstAccess = access;
+	barrier.OldLayout = (transition && discard) ? VK_IMAGE_LAYOUT_UNDEFINED : state.Layout;
+	barrier.NewLayout = layout;
+
+	state.Layout = layout;
+	state.WriteStages = stages;
+	if (write)
+	{
+		state.WriteAccess = access & WRITE_ACCESS;
+		state.ReadStages = 0;
+		state.VisibleStages = 0;
+		state.VisibleAccess = 0;
+	}
+	else
+	{
+		//the transition is visible to the reads that waited for it, other stages chain on them
+		state.WriteAccess = 0;
+		state.ReadStages = stages;
+		state.VisibleStages = stages;
+		state.VisibleAccess = access;
+	}
+	return true;
+}
+
+bool Vulkan_Engine::VStateTracker::SameBarrier(const PendingBarrier& a, const PendingBarrier& b)
+{
+	return a.SrcStages == b.SrcStages && a.SrcAccess == b.SrcAccess && a.DstStages == b.DstStages && a.DstAccess == b.DstAccess &&
+		a.OldLayout == b.OldLayout && a.NewLayout == b.NewLayout;
+}
+
+void Vulkan_Engine::VStateTracker::UseImage(VkImage image, const VkImageSubresourceRange& range, VkImageLayout layout, VkPipelineStageFlags stages,
+	VkAccessFlags access, bool discard)
+{
+	ImageEntry& entry = GetImage(image);
+	uint32_t mipCount = range.levelCount == VK_REMAINING_MIP_LEVELS ? entry.MipLevels - range.baseMipLevel : range.levelCount;
+	uint32_t layerCount = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? entry.ArrayLayers - range.baseArrayLayer : range.layerCount;
+	if (range.baseMipLevel + mipCount > entry.MipLevels || range.baseArrayLayer + layerCount > entry.ArrayLayers)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Image use outside of the tracked subresources");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	//one barrier per subresource, then the whole range in one when they all came from the same state
+	size_t first = PendingImages.size();
+	bool uniform = true;
+	for (uint32_t mip = range.baseMipLevel; mip < range.baseMipLevel + mipCount; mip++)
+		for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layerCount; layer++)
+		{
+			PendingBarrier barrier;
+			if (!Transition(entry.Subresources[size_t(mip) * entry.ArrayLayers + layer], layout, stages, access, discard, barrier))
+			{
+				Statistics.SkippedUses++;
+				uniform = false;
+				continue;
+			}
+			barrier.Image = image;
+			barrier.Range = { range.aspectMask ? range.aspectMask : entry.Aspect, mip, 1, layer, 1 };
+			if (PendingImages.size() > first && !SameBarrier(PendingImages[first], barrier)) uniform = false;
+			PendingImages.push_back(barrier);
+		}
+
+	if (uniform && PendingImages.size() - first > 1)
+	{
+		PendingImages[first].Range = { range.aspectMask ? range.aspectMask : entry.Aspect, range.baseMipLevel, mipCount, range.baseArrayLayer, layerCount };
+		PendingImages.resize(first + 1);
+	}
+}
+
+void Vulkan_Engine::VStateTracker::UseImage(VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard)
+{
+	UseImage(image, { 0, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS }, layout, stages, access, discard);
+}
+
+void Vulkan_Engine::VStateTracker::SynchronizedImageUse(VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+	ImageEntry& entry = GetImage(image);
+	PendingBarrier barrier;
+	for (auto& subresource : entry.Subresources) Transition(subresource, layout, stages, access, false, barrier);
+}
+
+void Vulkan_Engine::VStateTracker::UseBuffer(VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+	//buffers have no layout, an untracked buffer starts with no pending use
+	PendingBarrier barrier;
+	if (!Transition(Buffers[buffer], VK_IMAGE_LAYOUT_UNDEFINED, stages, access, false, barrier))
+	{
+		Statistics.SkippedUses++;
+		return;
+	}
+	barrier.Buffer = buffer;
+	PendingBuffers.push_back(barrier);
+}
+
+void Vulkan_Engine::VStateTracker::Flush(VkCommandBuffer commandBuffer)
+{
+	if (!HasPendingBarriers()) return;
+
+	uint64_t barrierCount = PendingImages.size() + PendingBuffers.size();
+	Statistics.PipelineBarriers++;
+	Statistics.ImageBarriers += PendingImages.size();
+	Statistics.BufferBarriers += PendingBuffers.size();
+	for (const auto& pending : PendingImages) if (pending.OldLayout != pending.NewLayout) Statistics.Transitions++;
+	FrameBarriers += barrierCount;
+
+	//one vkCmdPipelineBarrier waits for the union of the source stages before the union of the destination stages
+	VkPipelineStageFlags srcStages = 0, dstStages = 0;
+	ImageBarriers.resize(PendingImages.size());
+	for (size_t index = 0; index < PendingImages.size(); index++)
+	{
+		const PendingBarrier& pending = PendingImages[index];
+		VkImageMemoryBarrier& barrier = ImageBarriers[index];
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = pending.SrcAccess;
+		barrier.dstAccessMask = pending.DstAccess;
+		barrier.oldLayout = pending.OldLayout;
+		barrier.newLayout = pending.NewLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = pending.Image;
+		barrier.subresourceRange = pending.Range;
+		srcStages |= pending.SrcStages;
+		dstStages |= pending.DstStages;
+	}
+	BufferBarriers.resize(PendingBuffers.size());
+	for (size_t index = 0; index < PendingBuffers.size(); index++)
+	{
+		const PendingBarrier& pending = PendingBuffers[index];
+		VkBufferMemoryBarrier& barrier = BufferBarriers[index];
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = pending.SrcAccess;
+		barrier.dstAccessMask = pending.DstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = pending.Buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		srcStages |= pending.SrcStages;
+		dstStages |= pending.DstStages;
+	}
+	vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 0, nullptr, static_cast<uint32_t>(BufferBarriers.size()), BufferBarriers.data(),
+		static_cast<uint32_t>(ImageBarriers.size()), ImageBarriers.data());
+	PendingImages.clear();
+	PendingBuffers.clear();
+}
+
+void Vulkan_Engine::VStateTracker::EndFrame()
+{
+	Statistics.Frames++;
+	Statistics.MaxBarriersPerFrame = std::max(Statistics.MaxBarriersPerFrame, FrameBarriers);
+	FrameBarriers = 0;
+}
+
+void Vulkan_Engine::VStateTracker::PrintStatistics()
+{
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nState tracker\n";
+	Platform::SetConsoleColor(HConsole, 15);
+
+	double frames = Statistics.Frames ? double(Statistics.Frames) : 1.0;
+	std::cout << "frames : " << Statistics.Frames << "\tpipeline barriers " << Statistics.PipelineBarriers / frames << " per frame\n";
+	std::cout << "image barriers : " << Statistics.ImageBarriers / frames << " per frame\t" << Statistics.Transitions / frames << " layout transitions\t"
+		<< Statistics.MaxBarriersPerFrame << " barriers at most in a frame\n";
+	std::cout << "buffer barriers : " << Statistics.BufferBarriers / frames << " per frame\n";
+	std::cout << "uses without barrier : " << Statistics.SkippedUses / frames << " per frame\n";
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//state of a resource as the tracker is told it, after a use outside of it (a render pass, a present, the previous frame)
+	struct ResourceState
+	{
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED; //ignored for buffers
+		VkPipelineStageFlags Stages = 0;
+		VkAccessFlags Access = 0;
+	};
+
+	struct StateTrackerStatistics
+	{
+		uint64_t Frames = 0;
+		uint64_t PipelineBarriers = 0; //vkCmdPipelineBarrier or vkCmdPipelineBarrier2KHR calls
+		uint64_t ImageBarriers = 0;
+		uint64_t BufferBarriers = 0;
+		uint64_t Transitions = 0;      //image barriers changing the layout
+		uint64_t SkippedUses = 0;      //uses that needed no barrier : same layout reads of visible data
+		uint64_t MaxBarriersPerFrame = 0;
+	};
+
+	//current layout, stages and access of every tracked image subresource and buffer. A use only queues the barrier it needs :
+	//nothing for a read of data already visible to its stages in the right layout, an execution dependency for a write after reads,
+	//a memory barrier with the layout transition otherwise. Flush records every queued barrier in one vkCmdPipelineBarrier.
+	//one recording thread at a time
+	class VStateTracker
+	{
+	public:
+
+		VStateTracker();
+
+		//registers an image, tracking it again only resets its state
+		void TrackImage(VkImage image, VkImageAspectFlags aspect, uint32_t mipLevels, uint32_t arrayLayers, const ResourceState& state = ResourceState());
+		void ForgetImage(VkImage image);
+		bool IsTracked(VkImage image) const { return Images.count(image) != 0; }
+		void TrackBuffer(VkBuffer buffer, const ResourceState& state = ResourceState());
+		void ForgetBuffer(VkBuffer buffer);
+
+		//the whole image or buffer was last used as state, nothing is queued
+		void SetImageState(VkImage image, const ResourceState& state);
+		void SetBufferState(VkBuffer buffer, const ResourceState& state);
+
+		//the next commands use range of image in layout. discard drops the content, the transition starts from UNDEFINED
+		void UseImage(VkImage image, const VkImageSubresourceRange& range, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard = false);
+		void UseImage(VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard = false);
+		void UseBuffer(VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags access);
+		//a use something else synchronized (the subpass dependency of a render pass), only the state follows it
+		void SynchronizedImageUse(VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access);
+
+		bool HasPendingBarriers() const { return !PendingImages.empty() || !PendingBuffers.empty(); }
+		//records the queued barriers, nothing when none is queued
+		void Flush(VkCommandBuffer commandBuffer);
+
+		//closes the counters of the frame recorded since the previous call
+		void EndFrame();
+		StateTrackerStatistics GetStatistics() const { return Statistics; }
+		void ResetStatistics() { Statistics = StateTrackerStatistics(); FrameBarriers = 0; }
+		void PrintStatistics();
+
+	private:
+
+		//what happened to a subresource since its last write
+		struct SubresourceState
+		{
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags WriteStages = 0;   //last write or layout transition, 0 when the content predates the tracking
+			VkAccessFlags WriteAccess = 0;
+			VkPipelineStageFlags ReadStages = 0;    //reads since then, a write waits for them
+			VkPipelineStageFlags VisibleStages = 0; //stages and accesses the last write was made visible to
+			VkAccessFlags VisibleAccess = 0;
+		};
+
+		struct ImageEntry
+		{
+			VkImageAspectFlags Aspect = 0;
+			uint32_t MipLevels = 1;
+			uint32_t ArrayLayers = 1;
+			std::vector<SubresourceState> Subresources; //mip major
+		};
+
+		//a barrier with its own stages, merged into one vkCmdPipelineBarrier by Flush
+		struct PendingBarrier
+		{
+			VkPipelineStageFlags SrcStages = 0;
+			VkAccessFlags SrcAccess = 0;
+			VkPipelineStageFlags DstStages = 0;
+			VkAccessFlags DstAccess = 0;
+			VkImageLayout OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageLayout NewLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageSubresourceRange Range{};
+			VkBuffer Buffer = VK_NULL_HANDLE;
+		};
+
+		static SubresourceState MakeState(const ResourceState& state);
+		//updates state for the use and fills barrier, false when the use needs no barrier
+		static bool Transition(SubresourceState& state, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access, bool discard, PendingBarrier& barrier);
+		static bool SameBarrier(const PendingBarrier& a, const PendingBarrier& b);
+		ImageEntry& GetImage(VkImage image);
+
+		std::unordered_map<VkImage, ImageEntry> Images;
+		std::unordered_map<VkBuffer, SubresourceState> Buffers;
+		std::vector<PendingBarrier> PendingImages;
+		std::vector<PendingBarrier> PendingBuffers;
+		//kept between flushes, no allocation per barrier
+		std::vector<VkImageMemoryBarrier> ImageBarriers;
+		std::vector<VkBufferMemoryBarrier> BufferBarriers;
+
+		StateTrackerStatistics Statistics;
+		uint64_t FrameBarriers = 0;
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
@@ -0,0 +1,104 @@
+#include "VTimeline.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <chrono>
+
+Vulkan_Engine::VTimeline::VTimeline()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VTimeline::~VTimeline()
+{
+	Destroy();
+}
+
+void Vulkan_Engine::VTimeline::Create(VkDevice device, const std::string& name)
+{
+	Device = device;
+	Name = name;
+	LastSignaled = 0;
+	Completed = 0;
+
+	VkSemaphoreTypeCreateInfo TypeCreateInfo{};
+	TypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	TypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	TypeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo SemaphoreCreateInfo{};
+	SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	SemaphoreCreateInfo.pNext = &TypeCreateInfo;
+	if (vkCreateSemaphore(Device, &SemaphoreCreateInfo, nullptr, &Semaphore) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to create the " + Name + " timeline semaphore");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+}
+
+void Vulkan_Engine::VTimeline::Destroy()
+{
+	if (Semaphore == VK_NULL_HANDLE) return;
+	vkDestroySemaphore(Device, Semaphore, nullptr);
+	Semaphore = VK_NULL_HANDLE;
+	Device = VK_NULL_HANDLE;
+}
+
+uint64_t Vulkan_Engine::VTimeline::GetCompletedValue()
+{
+	uint64_t value = 0;
+	if (vkGetSemaphoreCounterValue(Device, Semaphore, &value) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to read the " + Name + " timeline, the device is lost");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	//several threads may read it, the cache only moves forward
+	uint64_t completed = Completed.load(std::memory_order_relaxed);
+	while (completed < value && !Completed.compare_exchange_weak(completed, value, std::memory_order_release, std::memory_order_relaxed));
+	return value;
+}
+
+bool Vulkan_Engine::VTimeline::IsReached(uint64_t value)
+{
+	if (Completed.load(std::memory_order_acquire) >= value) return true;
+	return GetCompletedValue() >= value;
+}
+
+void Vulkan_Engine::VTimeline::Wait(uint64_t value)
+{
+	Waits.fetch_add(1, std::memory_order_relaxed);
+	if (IsReached(value)) return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	VkSemaphoreWaitInfo WaitInfo{};
+	WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	WaitInfo.semaphoreCount = 1;
+	WaitInfo.pSemaphores = &Semaphore;
+	WaitInfo.pValues = &value;
+	if (vkWaitSemaphores(Device, &WaitInfo, UINT64_MAX) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to wait on the " + Name + " timeline, the device is lost");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	GetCompletedValue();
+
+	BlockedWaits.fetch_add(1, std::memory_order_relaxed);
+	BlockedMicroseconds.fetch_add(static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count()), std::memory_order_relaxed);
+}
+
+void Vulkan_Engine::VTimeline::PrintStatistics()
+{
+	uint64_t waits = Waits.load();
+	uint64_t blockedWaits = BlockedWaits.load();
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\n" << Name << " timeline statistics\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "value : " << GetLastSignaled() << " signaled\t" << Completed.load() << " completed\n";
+	std::cout << "CPU waits : " << waits << "\t" << blockedWaits << " blocked, " << BlockedMicroseconds.load() / 1000.0 << " ms total\n";
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "VPlatform.h"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//one timeline semaphore per queue : every submit signals the next value, so "has the queue reached value N"
+	//is one counter read and a CPU wait is a wait on an exact value, without a fence per submit
+	class VTimeline
+	{
+	public:
+
+		VTimeline();
+		~VTimeline();
+
+		//name is only used in the statistics and the error messages
+		void Create(VkDevice device, const std::string& name);
+		void Destroy();
+
+		VkSemaphore GetSemaphore() const { return Semaphore; }
+		//value the next submit on the queue signals, call once per signaling submit right before it
+		uint64_t Advance() { return LastSignaled.fetch_add(1, std::memory_order_acq_rel) + 1; }
+		uint64_t GetLastSignaled() const { return LastSignaled.load(std::memory_order_acquire); }
+
+		//thread safe, the counter is only read from the device when the cached value is behind value
+		bool IsReached(uint64_t value);
+		uint64_t GetCompletedValue();
+		//blocks until the queue reaches value, throws on device loss. 0 is always reached
+		void Wait(uint64_t value);
+
+		void PrintStatistics();
+
+	private:
+
+		VkDevice Device = VK_NULL_HANDLE;
+		VkSemaphore Semaphore = VK_NULL_HANDLE;
+		std::string Name;
+		std::atomic<uint64_t> LastSignaled{ 0 };
+		std::atomic<uint64_t> Completed{ 0 };
+
+		//statistics
+		std::atomic<uint64_t> Waits{ 0 };
+		std::atomic<uint64_t> BlockedWaits{ 0 };
+		std::atomic<uint64_t> BlockedMicroseconds{ 0 };
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//lock free single writer / single reader triple buffer : the writer fills its own copy and publishes it,
+	//the reader always gets the newest published copy. Neither side ever waits for the other, a copy the reader
+	//did not pick up in time is overwritten
+	template<typename T>
+	class VTripleBuffer
+	{
+	public:
+
+		//writer only, the copy to fill before Publish. It holds an older copy, every field must be written
+		T& GetWriteBuffer() { return Slots[WriteIndex].Value; }
+		//writer only, swaps the filled copy with the middle one
+		void Publish()
+		{
+			uint32_t previous = Middle.exchange(WriteIndex | NEW_BIT, std::memory_order_acq_rel);
+			WriteIndex = previous & INDEX_MASK;
+		}
+
+		//reader only, true when a copy was published since the last Acquire
+		bool HasNew() const { return (Middle.load(std::memory_order_relaxed) & NEW_BIT) != 0; }
+		//reader only, the newest published copy, or the one of the previous call when nothing new was published.
+		//valid until the next Acquire
+		const T& Acquire()
+		{
+			if (HasNew())
+			{
+				uint32_t previous = Middle.exchange(ReadIndex, std::memory_order_acq_rel);
+				ReadIndex = previous & INDEX_MASK;
+			}
+			return Slots[ReadIndex].Value;
+		}
+
+	private:
+
+		static const uint32_t INDEX_MASK = 3;
+		static const uint32_t NEW_BIT = 4;
+
+		//each copy on its own cache line, the two sides never share one
+		struct alignas(64) Slot
+		{
+			T Value{};
+		};
+
+		Slot Slots[3];
+		alignas(64) std::atomic<uint32_t> Middle{ 1 };
+		alignas(64) uint32_t WriteIndex = 0;
+		alignas(64) uint32_t ReadIndex = 2;
+	};
+
+};
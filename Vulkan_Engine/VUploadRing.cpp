@@ -0,0 +1,408 @@
+#include "VUploadRing.h"
+
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+	//copy offsets stay aligned for memcpy and for optimalBufferCopyOffsetAlignment on every known device
+	const VkDeviceSize RING_ALIGNMENT = 256;
+
+	VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	double ToMB(uint64_t size)
+	{
+		return size / (1024.0 * 1024.0);
+	}
+
+	double ElapsedMs(std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+Vulkan_Engine::VUploadRing::VUploadRing()
+{
+	HConsole = Platform::GetConsole();
+}
+
+Vulkan_Engine::VUploadRing::~VUploadRing()
+{
+	Destroy();
+}
+
+void Vulkan_Engine::VUploadRing::Create(VkDevice device, VMemoryAllocator* allocator, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily,
+	uint32_t frameCount, VkDeviceSize capacity, uint32_t maxRequests)
+{
+	Device = device;
+	Allocator = allocator;
+	TransferQueue = transferQueue;
+	TransferFamily = transferFamily;
+	GraphicsFamily = graphicsFamily;
+	Capacity = AlignUp(capacity, RING_ALIGNMENT);
+
+	VkBufferCreateInfo BufferCreateInfo{};
+	BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	BufferCreateInfo.size = Capacity;
+	BufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	MemoryUsage StagingUsage;
+	StagingUsage.Required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	StagingUsage.Dedicated = true;
+	Allocator->CreateBuffer(BufferCreateInfo, StagingUsage, Buffer, Memory);
+	Mapped = static_cast<char*>(Memory.Mapped);
+
+	uint64_t requestCount = 1;
+	while (requestCount < maxRequests) requestCount <<= 1;
+	Requests.reset(new RequestCell[requestCount]);
+	for (uint64_t position = 0; position < requestCount; position++) Requests[position].Sequence.store(position, std::memory_order_relaxed);
+	RequestMask = requestCount - 1;
+
+	VkCommandPoolCreateInfo CommandPoolCreateInfo{};
+	CommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	CommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	CommandPoolCreateInfo.queueFamilyIndex = TransferFamily;
+	VkResult result = vkCreateCommandPool(Device, &CommandPoolCreateInfo, nullptr, &TransferCommandPool);
+	if (result == VK_SUCCESS && IsDedicatedTransfer())
+	{
+		CommandPoolCreateInfo.queueFamilyIndex = GraphicsFamily;
+		result = vkCreateCommandPool(Device, &CommandPoolCreateInfo, nullptr, &AcquireCommandPool);
+	}
+	if (result != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to create the upload command pools");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+
+	Slots.resize(frameCount);
+	VkCommandBufferAllocateInfo AllocateInfo{};
+	AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	AllocateInfo.commandBufferCount = 1;
+	for (auto& slot : Slots)
+	{
+		AllocateInfo.commandPool = TransferCommandPool;
+		result = vkAllocateCommandBuffers(Device, &AllocateInfo, &slot.TransferCommandBuffer);
+		if (result == VK_SUCCESS && IsDedicatedTransfer())
+		{
+			AllocateInfo.commandPool = AcquireCommandPool;
+			result = vkAllocateCommandBuffers(Device, &AllocateInfo, &slot.AcquireCommandBuffer);
+		}
+		if (result != VK_SUCCESS)
+		{
+			Platform::SetConsoleColor(HConsole, 12);
+			throw std::runtime_error("ERROR :: Failed to create the upload frame resources");
+			Platform::SetConsoleColor(HConsole, 15);
+		}
+	}
+	Timeline.Create(Device, "Transfer");
+}
+
+void Vulkan_Engine::VUploadRing::Destroy()
+{
+	if (Device == VK_NULL_HANDLE) return;
+
+	WaitIdle();
+	PrintStatistics();
+
+	Timeline.Destroy();
+	Slots.clear();
+	vkDestroyCommandPool(Device, TransferCommandPool, nullptr);
+	if (AcquireCommandPool != VK_NULL_HANDLE) vkDestroyCommandPool(Device, AcquireCommandPool, nullptr);
+	TransferCommandPool = AcquireCommandPool = VK_NULL_HANDLE;
+	Allocator->DestroyBuffer(Buffer, Memory);
+	Mapped = nullptr;
+	Requests.reset();
+	Device = VK_NULL_HANDLE;
+}
+
+bool Vulkan_Engine::VUploadRing::ReserveRange(VkDeviceSize size, uint64_t& rangeBegin, uint64_t& rangeEnd, VkDeviceSize& offset)
+{
+	//Head and every range stay RING_ALIGNMENT aligned, a range that would cross the end of the buffer starts over at 0
+	VkDeviceSize alignedSize = AlignUp(size, RING_ALIGNMENT);
+	uint64_t head = Head.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		VkDeviceSize headOffset = head % Capacity;
+		uint64_t start = headOffset + alignedSize > Capacity ? head + (Capacity - headOffset) : head;
+		uint64_t end = start + alignedSize;
+		if (end - Tail.load(std::memory_order_acquire) > Capacity) return false;
+		if (Head.compare_exchange_weak(head, end, std::memory_order_relaxed))
+		{
+			rangeBegin = head;
+			rangeEnd = end;
+			offset = start % Capacity;
+			return true;
+		}
+	}
+}
+
+bool Vulkan_Engine::VUploadRing::Enqueue(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+	VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	if (size == 0 || size > Capacity) {
+		Rejected.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	//claim a request cell first, a cell claimed for a range that does not fit is published as cancelled
+	uint64_t position = EnqueuePosition.load(std::memory_order_relaxed);
+	RequestCell* cell;
+	for (;;)
+	{
+		cell = &Requests[position & RequestMask];
+		int64_t difference = static_cast<int64_t>(cell->Sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(position);
+		if (difference == 0) {
+			if (EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+		}
+		else if (difference < 0) {
+			Rejected.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else position = EnqueuePosition.load(std::memory_order_relaxed);
+	}
+
+	UploadRequest& request = cell->Request;
+	request = UploadRequest{};
+	VkDeviceSize offset;
+	bool reserved = ReserveRange(size, request.RangeBegin, request.RangeEnd, offset);
+	if (reserved)
+	{
+		std::memcpy(Mapped + offset, data, static_cast<size_t>(size));
+		request.Dst = dst;
+		request.DstOffset = dstOffset;
+		request.SrcOffset = offset;
+		request.Size = size;
+		request.DstStage = dstStage;
+		request.DstAccess = dstAccess;
+		request.EnqueueTime = std::chrono::high_resolution_clock::now();
+	}
+	else Rejected.fetch_add(1, std::memory_order_relaxed);
+
+	cell->Sequence.store(position + 1, std::memory_order_release);
+	return reserved;
+}
+
+void Vulkan_Engine::VUploadRing::RetireSlot(FrameSlot& slot, bool wait)
+{
+	if (wait) Timeline.Wait(slot.Value);
+	auto now = std::chrono::high_resolution_clock::now();
+
+	//ranges complete out of order, Tail only moves over a contiguous run of them
+	uint64_t tail = Tail.load(std::memory_order_relaxed);
+	for (const auto& range : slot.Ranges) FreedRanges[range.first] = range.second;
+	for (auto it = FreedRanges.find(tail); it != FreedRanges.end(); it = FreedRanges.find(tail))
+	{
+		tail = it->second;
+		FreedRanges.erase(it);
+	}
+	Tail.store(tail, std::memory_order_release);
+
+	//the copies of two slots may overlap in time, only the part after the previous completion is counted as busy time
+	auto busyStart = std::max(slot.SubmitTime, BusyUntil);
+	if (now > busyStart) TransferMs += ElapsedMs(busyStart, now);
+	BusyUntil = std::max(BusyUntil, now);
+
+	double latency = ElapsedMs(slot.OldestEnqueueTime, now);
+	LatencyMs += latency;
+	MaxLatencyMs = std::max(MaxLatencyMs, latency);
+	RetiredBytes += slot.Bytes;
+	RetiredBatches++;
+
+	slot.Ranges.clear();
+	slot.Bytes = 0;
+	slot.Submitted = false;
+}
+
+Vulkan_Engine::FrameUploads Vulkan_Engine::VUploadRing::Flush(uint32_t frame)
+{
+	FrameUploads uploads{};
+	if (Device == VK_NULL_HANDLE) return uploads;
+
+	//completed copies of every slot give their ring space back as early as possible
+	uint64_t completed = Timeline.GetCompletedValue();
+	for (auto& slot : Slots)
+		if (slot.Submitted && slot.Value <= completed) RetireSlot(slot, false);
+	FrameSlot& slot = Slots[frame];
+	if (slot.Submitted) RetireSlot(slot, true);
+
+	std::vector<UploadRequest> batch;
+	for (;;)
+	{
+		RequestCell& cell = Requests[DequeuePosition & RequestMask];
+		if (cell.Sequence.load(std::memory_order_acquire) != DequeuePosition + 1) break;
+		if (cell.Request.Dst != VK_NULL_HANDLE) batch.push_back(cell.Request);
+		cell.Sequence.store(DequeuePosition + RequestMask + 1, std::memory_order_release);
+		DequeuePosition++;
+	}
+	if (batch.empty()) return uploads;
+
+	//one vkCmdCopyBuffer per destination buffer, the uploads of one flush are not ordered between each other
+	std::stable_sort(batch.begin(), batch.end(), [](const UploadRequest& a, const UploadRequest& b) { return a.Dst < b.Dst; });
+
+	VkCommandBufferBeginInfo BeginInfo{};
+	BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkResetCommandBuffer(slot.TransferCommandBuffer, 0);
+	vkBeginCommandBuffer(slot.TransferCommandBuffer, &BeginInfo);
+
+	std::vector<VkBufferCopy> regions;
+	std::vector<VkBufferMemoryBarrier> barriers;
+	slot.OldestEnqueueTime = batch.front().EnqueueTime;
+	for (size_t index = 0; index < batch.size(); index++)
+	{
+		const UploadRequest& request = batch[index];
+		regions.push_back({ request.SrcOffset, request.DstOffset, request.Size });
+		if (index + 1 == batch.size() || batch[index + 1].Dst != request.Dst)
+		{
+			vkCmdCopyBuffer(slot.TransferCommandBuffer, Buffer, request.Dst, static_cast<uint32_t>(regions.size()), regions.data());
+			regions.clear();
+		}
+
+		VkBufferMemoryBarrier Barrier{};
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		Barrier.dstAccessMask = 0;
+		Barrier.srcQueueFamilyIndex = TransferFamily;
+		Barrier.dstQueueFamilyIndex = GraphicsFamily;
+		Barrier.buffer = request.Dst;
+		Barrier.offset = request.DstOffset;
+		Barrier.size = request.Size;
+		barriers.push_back(Barrier);
+
+		uploads.WaitStage |= request.DstStage;
+		uploads.Bytes += request.Size;
+		slot.Ranges.push_back({ request.RangeBegin, request.RangeEnd });
+		slot.OldestEnqueueTime = std::min(slot.OldestEnqueueTime, request.EnqueueTime);
+	}
+	if (uploads.WaitStage == 0) uploads.WaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	//release on the transfer family, the same barriers with the destination access acquire on the graphics family.
+	//on a single family the semaphore alone makes the copies visible to the waiting stages
+	if (IsDedicatedTransfer())
+	{
+		vkCmdPipelineBarrier(slot.TransferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+	}
+	vkEndCommandBuffer(slot.TransferCommandBuffer);
+
+	if (IsDedicatedTransfer())
+	{
+		for (size_t index = 0; index < batch.size(); index++)
+		{
+			barriers[index].srcAccessMask = 0;
+			barriers[index].dstAccessMask = batch[index].DstAccess;
+		}
+		vkResetCommandBuffer(slot.AcquireCommandBuffer, 0);
+		vkBeginCommandBuffer(slot.AcquireCommandBuffer, &BeginInfo);
+		vkCmdPipelineBarrier(slot.AcquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, uploads.WaitStage, 0,
+			0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+		vkEndCommandBuffer(slot.AcquireCommandBuffer);
+		uploads.AcquireCommandBuffer = slot.AcquireCommandBuffer;
+	}
+
+	slot.Value = Timeline.Advance();
+	VkSemaphore TimelineSemaphore = Timeline.GetSemaphore();
+	VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo{};
+	TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	TimelineSubmitInfo.signalSemaphoreValueCount = 1;
+	TimelineSubmitInfo.pSignalSemaphoreValues = &slot.Value;
+
+	VkSubmitInfo SubmitInfo{};
+	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	SubmitInfo.pNext = &TimelineSubmitInfo;
+	SubmitInfo.commandBufferCount = 1;
+	SubmitInfo.pCommandBuffers = &slot.TransferCommandBuffer;
+	SubmitInfo.signalSemaphoreCount = 1;
+	SubmitInfo.pSignalSemaphores = &TimelineSemaphore;
+	if (vkQueueSubmit(TransferQueue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		Platform::SetConsoleColor(HConsole, 12);
+		throw std::runtime_error("ERROR :: Failed to submit the uploads to the transfer queue");
+		Platform::SetConsoleColor(HConsole, 15);
+	}
+	slot.Submitted = true;
+	slot.Bytes = uploads.Bytes;
+	slot.SubmitTime = std::chrono::high_resolution_clock::now();
+
+	Uploads += batch.size();
+	Bytes += uploads.Bytes;
+	Batches++;
+
+	uploads.Semaphore = TimelineSemaphore;
+	uploads.WaitValue = slot.Value;
+	uploads.Uploads = static_cast<uint32_t>(batch.size());
+	return uploads;
+}
+
+void Vulkan_Engine::VUploadRing::WaitIdle()
+{
+	for (auto& slot : Slots)
+		if (slot.Submitted) RetireSlot(slot, true);
+}
+
+void Vulkan_Engine::VUploadRing::GetReadAccess(VkBufferUsageFlags usage, VkPipelineStageFlags& stage, VkAccessFlags& access)
+{
+	stage = 0;
+	access = 0;
+	if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
+		stage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	}
+	if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
+		stage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		access |= VK_ACCESS_INDEX_READ_BIT;
+	}
+	if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+		stage |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		access |= VK_ACCESS_UNIFORM_READ_BIT;
+	}
+	if (usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) {
+		stage |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+		access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	}
+	if (stage == 0) {
+		stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		access = VK_ACCESS_MEMORY_READ_BIT;
+	}
+}
+
+Vulkan_Engine::UploadStatistics Vulkan_Engine::VUploadRing::GetStatistics() const
+{
+	UploadStatistics statistics;
+	statistics.Uploads = Uploads;
+	statistics.Bytes = Bytes;
+	statistics.Batches = Batches;
+	statistics.Rejected = Rejected.load(std::memory_order_relaxed);
+	statistics.ThroughputMBs = TransferMs > 0.0 ? ToMB(RetiredBytes) / (TransferMs / 1000.0) : 0.0;
+	statistics.AverageLatencyMs = RetiredBatches ? LatencyMs / RetiredBatches : 0.0;
+	statistics.MaxLatencyMs = MaxLatencyMs;
+	return statistics;
+}
+
+void Vulkan_Engine::VUploadRing::ResetStatistics()
+{
+	Rejected.store(0, std::memory_order_relaxed);
+	Uploads = Bytes = Batches = RetiredBytes = RetiredBatches = 0;
+	TransferMs = LatencyMs = MaxLatencyMs = 0.0;
+}
+
+void Vulkan_Engine::VUploadRing::PrintStatistics()
+{
+	UploadStatistics statistics = GetStatistics();
+
+	Platform::SetConsoleColor(HConsole, 14);
+	std::cout << "\nUpload ring statistics\n";
+	Platform::SetConsoleColor(HConsole, 15);
+	std::cout << "ring : " << ToMB(Capacity) << " MB\t" << (IsDedicatedTransfer() ? "dedicated transfer queue family " : "graphics queue family ") << TransferFamily << "\n";
+	std::cout << "uploads : " << statistics.Uploads << " in " << statistics.Batches << " batches, " << ToMB(statistics.Bytes) << " MB\t"
+		<< statistics.Rejected << " rejected (ring full)\n";
+	std::cout << "throughput : " << statistics.ThroughputMBs << " MB/s\tlatency : " << statistics.AverageLatencyMs << " ms average, "
+		<< statistics.MaxLatencyMs << " ms max\n";
+}
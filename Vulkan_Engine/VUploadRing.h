@@ -0,0 +1,155 @@
+#pragma once
+
+#include "VPlatform.h"
+#include "VMemoryAllocator.h"
+#include "VTimeline.h"
+
+#include <vector>
+#include <map>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+namespace Vulkan_Engine {
+
+	//what the graphics submit of a frame needs to see the copies flushed for it
+	struct FrameUploads
+	{
+		VkSemaphore Semaphore = VK_NULL_HANDLE;              //transfer timeline, VK_NULL_HANDLE when nothing was flushed
+		uint64_t WaitValue = 0;                              //timeline value the transfer submit signals
+		VkPipelineStageFlags WaitStage = 0;                  //stages reading the uploaded data
+		VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE; //queue family ownership acquire, to run first in the frame submit
+		VkDeviceSize Bytes = 0;
+		uint32_t Uploads = 0;
+	};
+
+	struct UploadStatistics
+	{
+		uint64_t Uploads = 0;
+		uint64_t Bytes = 0;
+		uint64_t Batches = 0;
+		uint64_t Rejected = 0;     //enqueues refused because the ring or the request queue was full
+		double ThroughputMBs = 0.0; //uploaded bytes over the time the copies were in flight
+		double AverageLatencyMs = 0.0; //enqueue to copy completion, per batch, from its oldest upload
+		double MaxLatencyMs = 0.0;
+	};
+
+	//persistently mapped staging ring buffer feeding device local buffers
+	//producers on any thread reserve ring space and publish copy requests without locks, the render thread flushes
+	//every published request of a frame into one command buffer, submitted to the dedicated transfer queue when there is one.
+	//copies on a transfer only family release the written ranges to the graphics family, the frame submit acquires them
+	class VUploadRing
+	{
+	public:
+
+		VUploadRing();
+		~VUploadRing();
+
+		//transferQueue may be the graphics queue, the ownership transfers are skipped when both families are the same
+		void Create(VkDevice device, VMemoryAllocator* allocator, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily,
+			uint32_t frameCount, VkDeviceSize capacity, uint32_t maxRequests);
+		//waits for the pending copies, prints the statistics and destroys everything
+		void Destroy();
+
+		//copies size bytes of data to dst at dstOffset with the next flush, thread safe and lock free
+		//false when the ring or the request queue is full, the caller retries after a flush. The copied range of dst must not
+		//be in use by the GPU, its previous content is discarded on a dedicated transfer family (no release from graphics)
+		bool Enqueue(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+			VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+		//render thread only. Records and submits the published requests for frame slot frame (0..frameCount-1),
+		//the work the previous flush of this slot handed to the graphics queue must be complete.
+		//the graphics submit waits on the returned timeline value (VkTimelineSemaphoreSubmitInfo)
+		FrameUploads Flush(uint32_t frame);
+		//waits for every submitted copy, the ring is empty afterwards except for requests still being written
+		void WaitIdle();
+
+		//stages and accesses the graphics queue reads a buffer of this usage with
+		static void GetReadAccess(VkBufferUsageFlags usage, VkPipelineStageFlags& stage, VkAccessFlags& access);
+
+		VkDeviceSize GetCapacity() const { return Capacity; }
+		bool IsDedicatedTransfer() const { return TransferFamily != GraphicsFamily; }
+		UploadStatistics GetStatistics() const;
+		void ResetStatistics();
+		void PrintStatistics();
+
+	private:
+
+		struct UploadRequest
+		{
+			VkBuffer Dst = VK_NULL_HANDLE; //VK_NULL_HANDLE for a cancelled request
+			VkDeviceSize DstOffset = 0;
+			VkDeviceSize SrcOffset = 0;
+			VkDeviceSize Size = 0;
+			uint64_t RangeBegin = 0; //reserved ring range, wrap padding included, in ring positions (never wrapped)
+			uint64_t RangeEnd = 0;
+			VkPipelineStageFlags DstStage = 0;
+			VkAccessFlags DstAccess = 0;
+			std::chrono::high_resolution_clock::time_point EnqueueTime;
+		};
+
+		//bounded multi producer queue (Vyukov), a cell is readable once its sequence is its position + 1
+		struct RequestCell
+		{
+			std::atomic<uint64_t> Sequence{ 0 };
+			UploadRequest Request;
+		};
+
+		struct FrameSlot
+		{
+			VkCommandBuffer TransferCommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE;
+			uint64_t Value = 0; //transfer timeline value of the last submit
+			bool Submitted = false;
+			std::vector<std::pair<uint64_t, uint64_t>> Ranges; //ring ranges freed when the timeline reaches Value
+			VkDeviceSize Bytes = 0;
+			std::chrono::high_resolution_clock::time_point OldestEnqueueTime;
+			std::chrono::high_resolution_clock::time_point SubmitTime;
+		};
+
+		bool ReserveRange(VkDeviceSize size, uint64_t& rangeBegin, uint64_t& rangeEnd, VkDeviceSize& offset);
+		void RetireSlot(FrameSlot& slot, bool wait);
+
+		VkDevice Device = VK_NULL_HANDLE;
+		VMemoryAllocator* Allocator = nullptr;
+		VkQueue TransferQueue = VK_NULL_HANDLE;
+		uint32_t TransferFamily = 0;
+		uint32_t GraphicsFamily = 0;
+
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		MemoryAllocation Memory;
+		char* Mapped = nullptr;
+		VkDeviceSize Capacity = 0;
+
+		//ring positions only grow, the offset in the buffer is position % Capacity
+		std::atomic<uint64_t> Head{ 0 };
+		std::atomic<uint64_t> Tail{ 0 };
+		std::map<uint64_t, uint64_t> FreedRanges; //completed ranges past Tail, render thread only
+
+		std::unique_ptr<RequestCell[]> Requests;
+		uint64_t RequestMask = 0;
+		std::atomic<uint64_t> EnqueuePosition{ 0 };
+		uint64_t DequeuePosition = 0;
+
+		VkCommandPool TransferCommandPool = VK_NULL_HANDLE;
+		VkCommandPool AcquireCommandPool = VK_NULL_HANDLE;
+		std::vector<FrameSlot> Slots;
+		VTimeline Timeline;
+
+		//statistics, Rejected is written by the producers
+		std::atomic<uint64_t> Rejected{ 0 };
+		uint64_t Uploads = 0;
+		uint64_t Bytes = 0;
+		uint64_t Batches = 0;
+		uint64_t RetiredBytes = 0;
+		uint64_t RetiredBatches = 0;
+		double TransferMs = 0.0;
+		double LatencyMs = 0.0;
+		double MaxLatencyMs = 0.0;
+		std::chrono::high_resolution_clock::time_point BusyUntil;
+
+		Platform::ConsoleHandle HConsole;
+	};
+
+};
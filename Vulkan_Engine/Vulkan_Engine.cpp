@@ -2,16 +2,157 @@
 //
 #include "VRender.h"
 
-int main()
+int main(int argc, char** argv)
 {
-    HANDLE HConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+    Vulkan_Engine::Platform::ConsoleHandle HConsole = Vulkan_Engine::Platform::GetConsole();
+
+    // --headless [frames] : render offscreen without a window and report the raw frame rate
+    // --pipeline-benchmark [count] : compare serial and parallel pipeline compilation before rendering
+    // --shader-load-benchmark : compare loose .spv files and the shader archive for 10, 100 and 1000 shaders
+    // --dynamic-state-report : count the pipelines dynamic state saves over a set of raster state combinations
+    // --memory-benchmark [resources] : alloc/free churn through the memory sub-allocator and through vkAllocateMemory
+    // --geometry-benchmark [frames] : triangles per second of indexed grid meshes from 1K to 10M triangles (implies --headless)
+    // --upload-benchmark [MB] : streams MB through the staging upload ring from several producer threads (implies --headless)
+    // --record-benchmark [draws] : per frame reset and re-recording cost of 8 command buffers, pool reset against per-buffer reset
+    // --parallel-record-benchmark [frames] : frame recording time of 10K to 200K draws on 1 to all the threads
+    // --record-threads count : threads recording the frame into secondary command buffers, 1 records inline
+    // --pin-threads : pin every job system worker to its own core
+    // --frames-in-flight count : frames the CPU may run ahead of the GPU, 1 to 4
+    // --frames-in-flight-benchmark [frames] : frame rate and frame latency with 1 to 4 frames in flight
+    // --present-policy latency|vsync|capped|power : present mode and frame limiter preset, vsync by default
+    // --fps-cap fps : frame limiter target, 0 keeps the policy default (no limit for latency and vsync, 60 for capped, 30 for power)
+    // --render-graph-report : compile a deferred frame graph and print its passes, barriers and transient memory with and without aliasing
+    // --depth-prepass : fill the depth buffer in a depth only pass, the scene pass then shades the visible fragments only
+    // --depth-prepass-benchmark [layers] : shaded fragments and frame time of overlapping full screen layers with and without the pre-pass (implies --headless)
+    bool headless = false;
+    uint32_t headlessFrames = 1000;
+    bool pipelineBenchmark = false;
+    uint32_t benchmarkPipelines = 64;
+    bool shaderLoadBenchmark = false;
+    bool dynamicStateReport = false;
+    bool memoryBenchmark = false;
+    uint32_t benchmarkResources = 5000;
+    bool geometryBenchmark = false;
+    uint32_t geometryFrames = 100;
+    bool uploadBenchmark = false;
+    uint32_t uploadMegabytes = 1024;
+    bool recordBenchmark = false;
+    uint32_t recordDraws = 1000;
+    bool parallelRecordBenchmark = false;
+    uint32_t parallelRecordFrames = 50;
+    uint32_t recordThreads = 1;
+    bool pinThreads = false;
+    uint32_t framesInFlight = 2;
+    bool framesInFlightBenchmark = false;
+    uint32_t framesInFlightFrames = 500;
+    Vulkan_Engine::VRender::PRESENT_POLICY presentPolicy = Vulkan_Engine::VRender::PRESENT_POLICY::VSYNC;
+    bool presentPolicySet = false;
+    uint32_t fpsCap = 0;
+    bool renderGraphReport = false;
+    bool depthPrePass = false;
+    bool depthPrePassBenchmark = false;
+    uint32_t depthPrePassLayers = 8;
+    auto ReadCount = [&](int& i, uint32_t& count) {
+        if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) count = static_cast<uint32_t>(atoi(argv[++i]));
+    };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+            ReadCount(i, headlessFrames);
+        }
+        else if (strcmp(argv[i], "--pipeline-benchmark") == 0) {
+            pipelineBenchmark = true;
+            ReadCount(i, benchmarkPipelines);
+        }
+        else if (strcmp(argv[i], "--shader-load-benchmark") == 0) {
+            shaderLoadBenchmark = true;
+        }
+        else if (strcmp(argv[i], "--dynamic-state-report") == 0) {
+            dynamicStateReport = true;
+        }
+        else if (strcmp(argv[i], "--memory-benchmark") == 0) {
+            memoryBenchmark = true;
+            ReadCount(i, benchmarkResources);
+        }
+        else if (strcmp(argv[i], "--geometry-benchmark") == 0) {
+            geometryBenchmark = true;
+            headless = true;
+            ReadCount(i, geometryFrames);
+        }
+        else if (strcmp(argv[i], "--upload-benchmark") == 0) {
+            uploadBenchmark = true;
+            headless = true;
+            ReadCount(i, uploadMegabytes);
+        }
+        else if (strcmp(argv[i], "--record-benchmark") == 0) {
+            recordBenchmark = true;
+            ReadCount(i, recordDraws);
+        }
+        else if (strcmp(argv[i], "--parallel-record-benchmark") == 0) {
+            parallelRecordBenchmark = true;
+            ReadCount(i, parallelRecordFrames);
+        }
+        else if (strcmp(argv[i], "--record-threads") == 0) {
+            ReadCount(i, recordThreads);
+        }
+        else if (strcmp(argv[i], "--pin-threads") == 0) {
+            pinThreads = true;
+        }
+        else if (strcmp(argv[i], "--frames-in-flight") == 0) {
+            ReadCount(i, framesInFlight);
+        }
+        else if (strcmp(argv[i], "--frames-in-flight-benchmark") == 0) {
+            framesInFlightBenchmark = true;
+            ReadCount(i, framesInFlightFrames);
+        }
+        else if (strcmp(argv[i], "--present-policy") == 0 && i + 1 < argc) {
+            presentPolicySet = true;
+            const char* policy = argv[++i];
+            if (strcmp(policy, "latency") == 0) presentPolicy = Vulkan_Engine::VRender::PRESENT_POLICY::LOWEST_LATENCY;
+            else if (strcmp(policy, "capped") == 0) presentPolicy = Vulkan_Engine::VRender::PRESENT_POLICY::CAPPED_FPS;
+            else if (strcmp(policy, "power") == 0) presentPolicy = Vulkan_Engine::VRender::PRESENT_POLICY::POWER_SAVE;
+            else presentPolicy = Vulkan_Engine::VRender::PRESENT_POLICY::VSYNC;
+        }
+        else if (strcmp(argv[i], "--fps-cap") == 0) {
+            presentPolicySet = true;
+            ReadCount(i, fpsCap);
+        }
+        else if (strcmp(argv[i], "--render-graph-report") == 0) {
+            renderGraphReport = true;
+        }
+        else if (strcmp(argv[i], "--depth-prepass") == 0) {
+            depthPrePass = true;
+        }
+        else if (strcmp(argv[i], "--depth-prepass-benchmark") == 0) {
+            depthPrePassBenchmark = true;
+            headless = true;
+            ReadCount(i, depthPrePassLayers);
+        }
+    }
+
     try {
-        Vulkan_Engine::VRender render;
-        render.Render();
+        Vulkan_Engine::VRender render(headless ? Vulkan_Engine::VRender::RENDER_MODE::HEADLESS : Vulkan_Engine::VRender::RENDER_MODE::WINDOWED, pinThreads);
+        render.SetFramesInFlight(framesInFlight);
+        if (pipelineBenchmark) render.BenchmarkPipelineBuilds(benchmarkPipelines);
+        if (shaderLoadBenchmark) render.BenchmarkShaderLoading({ 10, 100, 1000 });
+        if (dynamicStateReport) render.ReportDynamicStateSavings();
+        if (memoryBenchmark) render.BenchmarkMemoryChurn(benchmarkResources, benchmarkResources * 20);
+        if (geometryBenchmark) render.BenchmarkGeometryThroughput({ 1000, 10000, 100000, 1000000, 10000000 }, geometryFrames);
+        if (uploadBenchmark) render.BenchmarkUploads(std::max(1u, std::thread::hardware_concurrency() / 2), VkDeviceSize(uploadMegabytes) * 1024 * 1024);
+        if (recordBenchmark) render.BenchmarkCommandRecording(8, recordDraws, 1000);
+        if (parallelRecordBenchmark) render.BenchmarkParallelRecording({ 10000, 50000, 100000, 200000 }, parallelRecordFrames);
+        if (framesInFlightBenchmark) render.BenchmarkFramesInFlight(framesInFlightFrames);
+        if (renderGraphReport) render.ReportRenderGraph();
+        if (depthPrePassBenchmark) render.BenchmarkDepthPrePass(depthPrePassLayers, 100);
+        render.SetDepthPrePass(depthPrePass);
+        render.SetRecordingThreads(recordThreads);
+        if (presentPolicySet) render.SetPresentPolicy(presentPolicy, fpsCap);
+        if (headless) render.RenderHeadless(headlessFrames);
+        else render.Render();
     }
     catch (std::exception& e) {
         std::cout << '\n' << e.what() << '\n';
-        SetConsoleTextAttribute(HConsole, 15);
+        Vulkan_Engine::Platform::SetConsoleColor(HConsole, 15);
     }
     return 0;
 }